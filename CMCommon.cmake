@@ -146,6 +146,7 @@ set (
     tads3/vmcoll.h
     tads3/vmconsol.h
     tads3/vmcrc.h
+    tads3/vmlz.h
     tads3/vmcset.h
     tads3/vmdatasrc.h
     tads3/vmdbg.h
@@ -277,6 +278,7 @@ add_library (
     tads3/vmconmor.cpp
     tads3/vmconsol.cpp
     tads3/vmcrc.cpp
+    tads3/vmlz.cpp
     tads3/vmcset.cpp
     tads3/vmdict.cpp
     tads3/vmdynfunc.cpp
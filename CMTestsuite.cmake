@@ -81,6 +81,8 @@ foreach(test asi anon anonfunc anonobj anonvarg badnest bignum bignum2 findrepla
         strcomp2 strbuf substr unicode varmac vector vector2 vector3 testaddr2 testaddr3 testaddr4 strtpl
         listminmax packstr packarr except propset rand3 findall constregex datatypexlat embedfmt clocktime
         testov vecmod listmod idxov newline_spacing nested_embed nested_embed_err inlineobj1 inlineobj2
+        propcache gcgen strrope strindex rexcache rexnfa rexfilter dictkey grammemo savelz restinh undocoal
+        restart propidx
         # date datefmt dateprs
         # hashes
         )
@@ -120,7 +122,7 @@ run_make_test(dynctx cp437 -pre dynctx dynctx dynfunc)
 run_make_test(inkey cp437 -script -nodef inkey inkey)
 
 foreach(test vec_pre symtab enumprop modtobj undef undef2 newembed newembederr triplequote optargs
-        optargs_err optargs_err2)
+        optargs_err optargs_err2 savedelta)
     run_make_test(${test} cp437 -pre ${test} ${test})
 endforeach()
 
@@ -292,6 +294,7 @@ add_executable (
     tads3/indlg_tx3.cpp
     tads3/vmsave.cpp
     tads3/vmcrc.cpp
+    tads3/vmlz.cpp
     tads3/vmbift3.cpp
     tads3/vmbt3_nd.cpp
     tads3/vmregex.cpp
@@ -424,6 +427,7 @@ add_executable (
     tads3/vmbignum.cpp
     tads3/vmsave.cpp
     tads3/vmcrc.cpp
+    tads3/vmlz.cpp
     tads3/vmvec.cpp
     tads3/vmintcls.cpp
     tads3/vmanonfn.cpp
@@ -630,6 +634,7 @@ add_executable (
     tads3/indlg_tx3.cpp
     tads3/vmsave.cpp
     tads3/vmcrc.cpp
+    tads3/vmlz.cpp
     tads3/vmbift3.cpp
     tads3/vmbt3_nd.cpp
     tads3/vmbifnet.cpp
@@ -127,6 +127,10 @@ FrobTadsApplication::fRunTads3( char* filename, int argc, const char* const* arg
     params.saved_state = savedState;
     params.netconfig = netconfig;
     params.cmd_log_file = this->options.cmdLogFile.c_str();
+    if (!this->options.profileFile.empty()) {
+        params.profile_file = this->options.profileFile.c_str();
+    }
+    params.undo_max_bytes = this->options.undoBudget;
 
     // Invoke the VM to run the program.
     int vmRet = vm_run_image(&params);
@@ -53,6 +53,8 @@ class FrobTadsApplication {
         std::string characterSet = "us-ascii";         // Local character set name.
         std::string replayFile;                        // Replay file.
         std::string cmdLogFile;                        // Command input file.
+        std::string profileFile;                       // Sampling profiler output file.
+        size_t undoBudget = 0;                         // T3VM UNDO memory limit (0 = none).
         int seedRand = true; // Enable automatic initial seeding of RNG in interpreter?
     };
 
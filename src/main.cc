@@ -83,8 +83,13 @@ const char helpOutput[] =
 "                       8192kB (default is 512kB)\n"
 "  -r, --restore        Load a saved game position\n"
 "  -R, --replay         Replay commands from the specified file\n"
+"  -P, --profile        Write a sampling profile of the game's execution to\n"
+"                       the specified file, in flame graph folded-stack format\n"
+"                       (T3 games only)\n"
 "  -u, --undo-size      Multiply the availabe T3VM undo buffer by n. Must be\n"
 "                       between 1 and 64 (default is 16; about 100 UNDOs)\n"
+"  -U, --undo-budget    Limit the memory used for T3VM UNDO to n kB, discarding\n"
+"                       the oldest UNDOs as needed (default is no limit)\n"
 "  -k, --character-set  Use given charset as the keyboard and display\n"
 "                       character set.\n"
 "  -i, --interface      Use given screen interface (curses or plain). Default\n"
@@ -171,12 +176,14 @@ int main( int argc, char** argv )
 #endif
         "o|no-defcolors",
         "p|no-pause",
+        "P:profile <filename>",
         "R:replay <filename>",
         "r:restore <filename>",
         "s:safety-level <00..44>",
         "S|no-seed-rand",
         "t:tcolor <0..7>",
         "u:undo-size <1..64>",
+        "U:undo-budget <kB>",
         "v|version",
 #ifdef TADSNET
         "w:webhost <hostname>",
@@ -453,6 +460,21 @@ int main( int argc, char** argv )
         break;
       }
 
+      // --profile
+      case 'P': {
+        if (optionError) break;
+        if (optArg == 0) {
+            // Argument is missing.
+            optionError = true;
+            break;
+        }
+        char absPath[OSFNMAX]{};
+        if (os_get_abs_filename(absPath, OSFNMAX, optArg)) {
+            frobOpts.profileFile = absPath;
+        }
+        break;
+      }
+
       // --undo-size
       case 'u': {
         if (optionError) break;
@@ -478,6 +500,26 @@ int main( int argc, char** argv )
         break;
       }
 
+      // --undo-budget
+      case 'U': {
+        if (optionError) break;
+        unsigned int tmp;
+        if (optArg == 0) {
+            // Argument is missing.
+            optionError = true;
+            break;
+        }
+        if (sscanf(optArg, "%u", &tmp) == 0) {
+            // The argument was not a number.
+            cerr << opts.name() << ": undo budget must be numerical.\n";
+            optionError = true;
+            break;
+        }
+        // Adjust from kB to bytes.
+        frobOpts.undoBudget = (size_t)tmp * 1024;
+        break;
+      }
+
       // --character-set
       case 'k':
         if (optionError) break;
@@ -24,12 +24,17 @@
 #include <fcntl.h>
 #include <unistd.h>
 #include <sys/param.h>
+#include <signal.h>
+#include <sys/time.h>
 #if HAVE_LANGINFO_CODESET
 #include <langinfo.h>
 #endif
 #if HAVE_GLOB_H
 #include <glob.h>
 #endif
+#if HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
 
 
 #include "os.h"
@@ -351,6 +356,51 @@ os_exeseek( const char*, const char* )
 }
 
 
+/* Map part of a file into memory.
+ *
+ * mmap() needs a page-aligned file offset, so we map from the start of
+ * the page containing 'ofs', and return a pointer into the mapping.
+ */
+const char*
+os_map_file( osfildef* fp, long ofs, long len )
+{
+#if HAVE_SYS_MMAN_H
+    if (ofs < 0 or len <= 0)
+        return 0;
+
+    // Make sure the file really is that long.  Touching a mapped page
+    // past the end of the file raises SIGBUS rather than an error.
+    struct stat st;
+    if (fstat(fileno(fp), &st) != 0 or not S_ISREG(st.st_mode)
+        or st.st_size < static_cast<off_t>(ofs) + len)
+        return 0;
+
+    long pagesize = sysconf(_SC_PAGESIZE);
+    long delta = ofs % pagesize;
+    void* mem = mmap(0, len + delta, PROT_READ, MAP_SHARED, fileno(fp),
+                     ofs - delta);
+    if (mem == MAP_FAILED)
+        return 0;
+    return static_cast<const char*>(mem) + delta;
+#else
+    return 0;
+#endif
+}
+
+
+/* Release a mapping created with os_map_file().
+ */
+void
+os_unmap_file( const char* mem, long len )
+{
+#if HAVE_SYS_MMAN_H
+    long pagesize = sysconf(_SC_PAGESIZE);
+    long delta = reinterpret_cast<unsigned long>(mem) % pagesize;
+    munmap(const_cast<char*>(mem - delta), len + delta);
+#endif
+}
+
+
 /* Create and open a temporary file.
  */
 osfildef*
@@ -660,6 +710,52 @@ os_get_sys_clock_ms( void )
 }
 
 
+/* Sampling profiler timer.
+ *
+ * We use the CPU-time interval timer, so that the samples are spread over
+ * the time the interpreter actually spends running, and not over the time
+ * it spends waiting for input.
+ */
+static void (*prof_tick_func)() = nullptr;
+
+static void
+prof_signal_handler( int )
+{
+    if (prof_tick_func != nullptr) {
+        prof_tick_func();
+    }
+}
+
+int
+os_prof_start_timer( long interval_us, void (*tick)() )
+{
+    prof_tick_func = tick;
+
+    struct sigaction sa{};
+    sa.sa_handler = prof_signal_handler;
+    sigemptyset(&sa.sa_mask);
+    sa.sa_flags = SA_RESTART;
+    if (sigaction(SIGPROF, &sa, nullptr) != 0) {
+        return false;
+    }
+
+    struct itimerval tv{};
+    tv.it_interval.tv_sec = interval_us / 1000000;
+    tv.it_interval.tv_usec = interval_us % 1000000;
+    tv.it_value = tv.it_interval;
+    return setitimer(ITIMER_PROF, &tv, nullptr) == 0;
+}
+
+void
+os_prof_stop_timer( void )
+{
+    struct itimerval tv{};
+    setitimer(ITIMER_PROF, &tv, nullptr);
+    signal(SIGPROF, SIG_IGN);
+    prof_tick_func = nullptr;
+}
+
+
 /* Get the time since the Unix Epoch in seconds and nanoseconds.
  */
 void
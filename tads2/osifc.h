@@ -1297,6 +1297,35 @@ void os_fprint(osfildef *fp, const char *str, size_t len);
 /* int os_rename_file(const char *oldname, const char *newname); */
 
 
+/* ------------------------------------------------------------------------ */
+/*
+ *   Memory-mapped files 
+ */
+
+/*
+ *   Map part of a file into memory for reading.  'fp' is a file opened for
+ *   reading, and the mapping covers 'len' bytes starting at byte offset
+ *   'ofs' from the start of the file (regardless of the current seek
+ *   position).  Returns a pointer to the mapped bytes, or null if the file
+ *   can't be mapped.
+ *   
+ *   The memory is read-only.  On systems with virtual memory, processes
+ *   that map the same file share the same physical pages, and pages are
+ *   only read in as they're used.  The mapping remains valid after the file
+ *   is closed, until it's released with os_unmap_file().
+ *   
+ *   This is optional: a system that can't map files can simply return
+ *   null, and callers will read the file in the ordinary way instead.  
+ */
+const char *os_map_file(osfildef *fp, long ofs, long len);
+
+/*
+ *   Release a mapping created with os_map_file().  'mem' and 'len' are the
+ *   pointer that os_map_file() returned and the length passed to it.  
+ */
+void os_unmap_file(const char *mem, long len);
+
+
 /* ------------------------------------------------------------------------ */
 /*
  *   File "stat()" information - mode, size, time stamps 
@@ -31,6 +31,7 @@ Modified
 #include "vmtype.h"
 #include "vmwrtimg.h"
 #include "vmgram.h"
+#include "vmtobj.h"
 #include "vmfile.h"
 #include "tcmain.h"
 #include "tcerr.h"
@@ -2585,6 +2586,8 @@ void CTcGenTarg::write_tads_objects_to_image(CTcDataStream *os,
             size_t write_size;
             ulong next_ofs;
             ulong orig_ofs;
+            char idx_buf[VMTOBJ_IMGIDX_MAX_SIZE];
+            size_t idx_size;
 
             /* if we've reached the end of the stream, we're done */
             if (ofs >= os->get_ofs())
@@ -2646,6 +2649,15 @@ void CTcGenTarg::write_tads_objects_to_image(CTcDataStream *os,
              *   assignments aren't made until link time.
              */
             write_prop_cnt = sort_object_prop_table(os, ofs);
+
+            /* 
+             *   Build the prebuilt property index from the sorted table,
+             *   which sort_object_prop_table() leaves in the sort buffer.
+             *   The index follows the property table in the image file, so
+             *   it counts in the object's data size.  
+             */
+            idx_size = vm_tadsobj_hdr::build_image_index(
+                idx_buf, sort_buf_, write_prop_cnt);
             
             /* note the original property count */
             orig_prop_cnt = CTPNStmObject::get_stream_prop_cnt(os, ofs);
@@ -2662,6 +2674,15 @@ void CTcGenTarg::write_tads_objects_to_image(CTcDataStream *os,
                 CTPNStmObject::set_stream_prop_cnt(os, ofs, write_prop_cnt)
                 + TCT3_META_HEADER_SIZE;
 
+            /* 
+             *   include the index in the data size in the metaclass header,
+             *   as long as the size still fits 
+             */
+            if (write_size - TCT3_META_HEADER_SIZE + idx_size > 65535)
+                idx_size = 0;
+            os->write2_at(ofs + TCT3_META_HEADER_OFS + 4,
+                          write_size - TCT3_META_HEADER_SIZE + idx_size);
+
             /* 
              *   if this is the first object in this block, write the
              *   block header 
@@ -2697,6 +2718,10 @@ void CTcGenTarg::write_tads_objects_to_image(CTcDataStream *os,
                 ofs += avail_len;
                 rem_len -= avail_len;
             }
+
+            /* write the prebuilt property index */
+            if (idx_size != 0)
+                image_writer->write_objs_bytes(idx_buf, idx_size);
                 
             /* count the object */
             ++cnt;
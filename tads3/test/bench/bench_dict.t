@@ -0,0 +1,115 @@
+/*
+ *   Copyright (c) 2026 by the FrobTADS contributors.
+ *
+ *   Please see the accompanying license file, LICENSE.TXT, for information
+ *   on using and copying this software.
+ */
+/*
+Name
+  bench_dict.t - dictionary lookup benchmark
+Function
+  Fills a dictionary with 20,000 made-up words, using a StringComparator
+  with a truncation length of 6 and no case sensitivity, like the adv3
+  library's, and then looks words up with findWord() the way the parser
+  does: exact words, words in other cases, and abbreviations.  Finally it
+  asks for spelling corrections for some misspelled words.
+
+  The StringComparator's hash code is the sum of the characters, so a
+  lot of words share each hash bucket; the lookup times show how well
+  the dictionary copes with that.
+Notes
+  Build and run with the regular tools:
+
+    t3make -nobanner -o bench_dict.t3 bench_dict.t
+    frob -i plain bench_dict.t3
+*/
+
+#include <tads.h>
+#include <dict.h>
+#include <strcomp.h>
+
+/* number of words in the dictionary */
+#define BENCH_WORDS    20000
+
+/* number of lookups of each kind */
+#define BENCH_LOOKUPS  100000
+
+/* number of spelling corrections */
+#define BENCH_CORRECT  300
+
+property noun;
+
+benchObj: object;
+
+/* a simple pseudo-random word generator, so that every run is the same */
+wordGen: object
+    seed = 12345
+    next()
+    {
+        seed = (seed * 75 + 74) % 65537;
+        return seed;
+    }
+    word()
+    {
+        local n = 3 + (next() >> 2) % 8;
+        local s = '';
+        for (local i = 0 ; i < n ; ++i)
+            s += makeString('a'.toUnicode(1) + (next() >> 2) % 26);
+        return s;
+    }
+;
+
+/* run one benchmark, returning its elapsed time in milliseconds */
+runBench(name, func)
+{
+    local t0 = getTime(GetTimeTicks);
+    func();
+    local t = getTime(GetTimeTicks) - t0;
+    "<<name>>: <<t>> ms\n";
+    return t;
+}
+
+/* look up each word in the list, transformed by a function */
+lookUp(d, words, func)
+{
+    local cnt = 0;
+    local n = words.length();
+    for (local i = 0 ; i < BENCH_LOOKUPS ; ++i)
+        cnt += d.findWord(func(words[i % n + 1])).length();
+    return cnt / 2;
+}
+
+main(args)
+{
+    local total = 0;
+    local d = new Dictionary(new StringComparator(6, nil, []));
+    local words = new Vector(BENCH_WORDS);
+    local a, b, c, e;
+
+    total += runBench('add words', new function()
+    {
+        for (local i = 0 ; i < BENCH_WORDS ; ++i)
+        {
+            local w = wordGen.word();
+            words.append(w);
+            d.addWord(benchObj, w, &noun);
+        }
+    });
+
+    total += runBench('find exact', { : a = lookUp(d, words, { w: w }) });
+    total += runBench('find upper case',
+                      { : b = lookUp(d, words, { w: w.toUpper() }) });
+    total += runBench('find abbreviated',
+                      { : c = lookUp(d, words, { w: w.substr(1, 6) }) });
+    total += runBench('correct spelling', new function()
+    {
+        e = 0;
+        for (local i = 0 ; i < BENCH_CORRECT ; ++i)
+            e += d.correctSpelling(words[i * 7 + 1] + 'q', 1).length();
+    });
+
+    /* the lookup counts should be the same from run to run */
+    "matches: <<a>>, <<b>>, <<c>>, corrections: <<e>>\n";
+
+    "total: <<total>> ms\n";
+}
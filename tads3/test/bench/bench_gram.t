@@ -0,0 +1,188 @@
+/*
+ *   Copyright (c) 2026 by the FrobTADS contributors.
+ *
+ *   Please see the accompanying license file, LICENSE.TXT, for information
+ *   on using and copying this software.
+ */
+/*
+Name
+  bench_gram.t - grammar production parsing benchmark
+Function
+  Parses long player commands with several noun phrases against a small
+  command grammar in the style of the adv3 library's.  The grammar is
+  ambiguous in the usual ways: most of the vocabulary words are both
+  nouns and adjectives, nouns can be run together, 'and' can join noun
+  phrases or commands, and noun phrases can be joined with 'of'.  Each command has a lot of possible
+  match trees, and the parser has to try each noun phrase sub-production
+  at each token position many times over while it works through them.
+
+  A second benchmark parses a fixed corpus of short, typical commands
+  100,000 times in all, the way a game parses a command or two on every
+  turn.  Each of these parses is quick, so the time mostly shows the
+  per-parse overhead, such as setting up the parser's working memory.
+
+  The match counts are printed at the end; they should be the same from
+  run to run, and from version to version.
+Notes
+  Build and run with the regular tools:
+
+    t3make -nobanner -o bench_gram.t3 bench_gram.t
+    frob -i plain bench_gram.t3
+*/
+
+#include <tads.h>
+#include <dict.h>
+#include <gramprod.h>
+
+/* number of times to parse each long command */
+#define BENCH_PASSES  50
+
+/* number of times to parse the short command corpus */
+#define CORPUS_PASSES  10000
+
+dictionary gDict;
+dictionary property noun, adjective;
+enum token tokWord;
+
+property dobj_, iobj_, cmd_, rest_, np_, lst_, adj_, of_;
+
+class Match: object;
+
+grammar commandList(single): command->cmd_ : Match;
+grammar commandList(then): command->cmd_ 'then' commandList->rest_ : Match;
+grammar commandList(and): command->cmd_ 'and' commandList->rest_ : Match;
+
+grammar command(take): 'take' nounList->dobj_ : Match;
+grammar command(takeFrom):
+    'take' nounList->dobj_ 'from' nounPhrase->iobj_ : Match;
+grammar command(putIn):
+    'put' nounList->dobj_ ('in' | 'into') nounPhrase->iobj_ : Match;
+grammar command(putOn): 'put' nounList->dobj_ 'on' nounPhrase->iobj_ : Match;
+grammar command(give): 'give' nounList->dobj_ 'to' nounPhrase->iobj_ : Match;
+grammar command(giveTo): 'give' nounPhrase->iobj_ nounList->dobj_ : Match;
+grammar command(look): 'look' 'at' nounList->dobj_ : Match;
+grammar command(putUnder):
+    'put' nounList->dobj_ 'under' nounPhrase->iobj_ : Match;
+grammar command(putBehind):
+    'put' nounList->dobj_ 'behind' nounPhrase->iobj_ : Match;
+grammar command(takeOutOf):
+    'take' nounList->dobj_ 'out' 'of' nounPhrase->iobj_ : Match;
+grammar command(takeOff):
+    'take' nounList->dobj_ 'off' nounPhrase->iobj_ : Match;
+grammar command(show): 'show' nounList->dobj_ 'to' nounPhrase->iobj_ : Match;
+grammar command(showTo): 'show' nounPhrase->iobj_ nounList->dobj_ : Match;
+grammar command(throwAt):
+    'throw' nounList->dobj_ 'at' nounPhrase->iobj_ : Match;
+grammar command(throwTo):
+    'throw' nounList->dobj_ 'to' nounPhrase->iobj_ : Match;
+grammar command(attach):
+    'attach' nounList->dobj_ 'to' nounPhrase->iobj_ : Match;
+grammar command(move): 'move' nounList->dobj_ 'to' nounPhrase->iobj_ : Match;
+grammar command(moveWith):
+    'move' nounList->dobj_ 'with' nounPhrase->iobj_ : Match;
+grammar command(examine): ('examine' | 'x') nounList->dobj_ : Match;
+
+grammar nounList(single): nounPhrase->np_ : Match;
+grammar nounList(and): nounList->lst_ 'and' nounPhrase->np_ : Match;
+grammar nounList(comma): nounList->lst_ ',' nounPhrase->np_ : Match;
+
+grammar nounPhrase(noun): nounSeq->np_ : Match;
+grammar nounPhrase(adj): adjPhrase->adj_ nounSeq->np_ : Match;
+grammar nounPhrase(the): 'the' nounPhrase->np_ : Match;
+grammar nounPhrase(of): nounPhrase->np_ 'of' nounPhrase->of_ : Match;
+grammar nounPhrase(adjOnly): [badness 100] adjPhrase->adj_ : Match;
+grammar nounPhrase(all): 'all' : Match;
+
+grammar nounSeq(single): noun->np_ : Match;
+grammar nounSeq(multi): noun->np_ nounSeq->rest_ : Match;
+
+grammar adjPhrase(single): adjective->adj_ : Match;
+grammar adjPhrase(multi): adjective->adj_ adjPhrase->rest_ : Match;
+
+/* the vocabulary - most words are both nouns and adjectives */
+vocab: object
+    noun = 'box' 'lid' 'key' 'brass' 'book' 'spells' 'chest' 'ball' 'red'
+        'table' 'lamp' 'oil' 'glass' 'door'
+    adjective = 'red' 'box' 'small' 'brass' 'old' 'large' 'wooden' 'glass'
+        'oil' 'lamp' 'key' 'table' 'door'
+;
+
+/* run one benchmark, returning its elapsed time in milliseconds */
+runBench(name, func)
+{
+    local t0 = getTime(GetTimeTicks);
+    func();
+    local t = getTime(GetTimeTicks) - t0;
+    "<<name>>: <<t>> ms\n";
+    return t;
+}
+
+/* turn a command string into a token list */
+tokenize(str)
+{
+    return str.split(' ').mapAll({ w: [w, tokWord, w] });
+}
+
+main(args)
+{
+    local total = 0;
+    local cmds = [
+        'put the red box lid and the small brass key in the large wooden
+            chest',
+        'take the old book of spells and the glass lamp and the oil lamp
+            from the table',
+        'give the red ball and the brass key and the box lid to the old
+            door key',
+        'put the lamp oil and the glass box lid and the brass key on the
+            wooden table then take the red ball',
+        'take the key and the lamp and the ball and the box and look at the
+            glass door of the large wooden chest',
+        'take red box , brass key , glass lamp , oil lamp , wooden table
+            lid',
+        'throw the red ball and the brass key and the glass lamp and the
+            old book at the large wooden door',
+        'show the old book of spells and the small brass key to the red
+            glass lamp then examine the box lid and the oil',
+        'move the large wooden table and the glass box and the red chest
+            with the old brass lamp oil key'
+    ];
+    local toks = cmds.mapAll({ c: tokenize(c.findReplace(
+        R'<space>+', ' ', ReplaceAll)) });
+    local counts = new Vector(cmds.length());
+
+    total += runBench('parse commands', new function()
+    {
+        for (local rep = 0 ; rep < BENCH_PASSES ; ++rep)
+        {
+            for (local i = 1 ; i <= toks.length() ; ++i)
+            {
+                local n = commandList.parseTokens(toks[i], gDict).length();
+                if (rep == 0)
+                    counts.append(n);
+            }
+        }
+    });
+
+    /* a corpus of short commands */
+    local corpus = [
+        'take the box', 'x lamp', 'put key in chest', 'look at the door',
+        'take all', 'give ball to the old key', 'examine red box lid',
+        'take lamp and oil', 'put the book on the table',
+        'throw ball at door'
+    ].mapAll({ c: tokenize(c) });
+    local ccnt = 0;
+
+    total += runBench('parse corpus', new function()
+    {
+        for (local rep = 0 ; rep < CORPUS_PASSES ; ++rep)
+        {
+            for (local i = 1 ; i <= corpus.length() ; ++i)
+                ccnt += commandList.parseTokens(corpus[i], gDict).length();
+        }
+    });
+
+    /* the match counts should be the same from run to run */
+    "matches: <<counts.join(', ')>>; corpus: <<ccnt / CORPUS_PASSES>>\n";
+
+    "total: <<total>> ms\n";
+}
@@ -0,0 +1,103 @@
+/* 
+ *   Copyright (c) 2026 by the FrobTADS contributors.
+ *   
+ *   Please see the accompanying license file, LICENSE.TXT, for information
+ *   on using and copying this software.  
+ */
+/*
+Name
+  bench_ops.t - opcode throughput benchmark
+Function
+  Runs a handful of tight loops that exercise the most common VM
+  instructions (local variable access, integer arithmetic, conditional
+  jumps, property evaluation, method calls, list indexing), and reports
+  the elapsed time for each.  This is meant for comparing bytecode
+  dispatch strategies in CVmRun::run(), so the loops deliberately avoid
+  anything that would spend its time in native code.
+Notes
+  Build and run with the regular tools:
+
+    t3make -nobanner -o bench_ops.t3 bench_ops.t
+    frob -i plain bench_ops.t3
+
+  To compare switch dispatch against threaded dispatch, build the VM once
+  with -DENABLE_T3_COMPUTED_GOTO=OFF and once with it ON, and run the same
+  .t3 file with each.
+*/
+
+#include <tads.h>
+
+/* number of iterations for each loop */
+#define BENCH_ITERS  2000000
+
+class Counter: object
+    cnt = 0
+    step = 1
+    bump() { cnt += step; return cnt; }
+;
+
+counter: Counter;
+
+/* run one benchmark, returning its elapsed time in milliseconds */
+runBench(name, func)
+{
+    local t0 = getTime(GetTimeTicks);
+    func();
+    local t = getTime(GetTimeTicks) - t0;
+    "<<name>>: <<t>> ms\n";
+    return t;
+}
+
+main(args)
+{
+    local total = 0;
+
+    total += runBench('locals and arithmetic', function()
+    {
+        local a = 0, b = 3;
+        for (local i = 0 ; i < BENCH_ITERS ; ++i)
+            a = (a + b * 7 - i) % 1000;
+        return a;
+    });
+
+    total += runBench('conditionals', function()
+    {
+        local n = 0;
+        for (local i = 0 ; i < BENCH_ITERS ; ++i)
+        {
+            if (i % 3 == 0)
+                ++n;
+            else if (i % 3 == 1)
+                n += 2;
+            else if (n > 100)
+                n = 0;
+        }
+        return n;
+    });
+
+    total += runBench('property evaluation', function()
+    {
+        local n = 0;
+        for (local i = 0 ; i < BENCH_ITERS ; ++i)
+            n += counter.step;
+        return n;
+    });
+
+    total += runBench('method calls', function()
+    {
+        for (local i = 0 ; i < BENCH_ITERS ; ++i)
+            counter.bump();
+        return counter.cnt;
+    });
+
+    total += runBench('list indexing', function()
+    {
+        local lst = [1, 2, 3, 4, 5, 6, 7, 8, 9, 10];
+        local n = 0;
+        for (local i = 0 ; i < BENCH_ITERS ; ++i)
+            n += lst[i % 10 + 1];
+        return n;
+    });
+
+    "total: <<total>> ms\n";
+}
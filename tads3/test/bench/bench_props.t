@@ -0,0 +1,198 @@
+/*
+ *   Copyright (c) 2026 by the FrobTADS contributors.
+ *
+ *   Please see the accompanying license file, LICENSE.TXT, for information
+ *   on using and copying this software.
+ */
+/*
+Name
+  bench_props.t - TadsObject property table benchmark
+Function
+  Creates a population of objects and times property reads and writes
+  against them.  There are two populations: "small" objects with only a
+  few properties of their own (which are stored inline and searched
+  linearly), and "large" objects with a couple dozen properties (which
+  are found through the open-addressed property index).  Each population
+  is timed for reads of the object's own properties, for reads that
+  miss on the instance and are inherited from the class, and for writes
+  to existing properties.
+Notes
+  Build and run with the regular tools:
+
+    t3make -nobanner -o bench_props.t3 bench_props.t
+    frob -i plain bench_props.t3
+
+  Each loop makes BENCH_PASSES passes over BENCH_OBJS objects.  The
+  objects are visited through a local variable rather than a constant,
+  so property evaluation goes through the generic object lookup path.
+  A Vector can't hold more than 65535 elements, so the population is
+  kept in chunks of BENCH_CHUNK objects.
+*/
+
+#include <tads.h>
+
+/* number of objects in each population */
+#define BENCH_OBJS    100000
+
+/* number of objects per population chunk */
+#define BENCH_CHUNK   50000
+
+/* number of passes over the population in each timed loop */
+#define BENCH_PASSES  5
+
+property p1, p2, p3, p4, q1, q2, q3, q4, q5, q6, q7, q8, q9, q10,
+    q11, q12, q13, q14, q15, q16, q17, q18, q19, q20;
+
+class SmallObj: object
+    inh1 = 1
+    inh2 = 2
+;
+
+class LargeObj: object
+    inh1 = 1
+    inh2 = 2
+;
+
+/* run one benchmark, returning its elapsed time in milliseconds */
+runBench(name, func)
+{
+    local t0 = getTime(GetTimeTicks);
+    func();
+    local t = getTime(GetTimeTicks) - t0;
+    "<<name>>: <<t>> ms\n";
+    return t;
+}
+
+/* create a population of objects */
+makeSmall()
+{
+    local v = new Vector(BENCH_OBJS / BENCH_CHUNK);
+    local chunk;
+    for (local i = 0 ; i < BENCH_OBJS ; ++i)
+    {
+        if (i % BENCH_CHUNK == 0)
+            v.append(chunk = new Vector(BENCH_CHUNK));
+
+        local obj = new SmallObj();
+        obj.p1 = i;
+        obj.p2 = i + 1;
+        obj.p3 = i + 2;
+        obj.p4 = i + 3;
+        chunk.append(obj);
+    }
+    return v;
+}
+
+makeLarge()
+{
+    local v = new Vector(BENCH_OBJS / BENCH_CHUNK);
+    local chunk;
+    for (local i = 0 ; i < BENCH_OBJS ; ++i)
+    {
+        if (i % BENCH_CHUNK == 0)
+            v.append(chunk = new Vector(BENCH_CHUNK));
+
+        local obj = new LargeObj();
+        obj.p1 = i;
+        obj.p2 = i + 1;
+        obj.p3 = i + 2;
+        obj.p4 = i + 3;
+        obj.q1 = i;
+        obj.q2 = i;
+        obj.q3 = i;
+        obj.q4 = i;
+        obj.q5 = i;
+        obj.q6 = i;
+        obj.q7 = i;
+        obj.q8 = i;
+        obj.q9 = i;
+        obj.q10 = i;
+        obj.q11 = i;
+        obj.q12 = i;
+        obj.q13 = i;
+        obj.q14 = i;
+        obj.q15 = i;
+        obj.q16 = i;
+        obj.q17 = i;
+        obj.q18 = i;
+        obj.q19 = i;
+        obj.q20 = i;
+        chunk.append(obj);
+    }
+    return v;
+}
+
+/* time reads, inherited reads, and writes against a population */
+benchPopulation(label, v)
+{
+    local total = 0;
+
+    total += runBench(label + ' get own', function()
+    {
+        local n = 0;
+        for (local rep = 0 ; rep < BENCH_PASSES ; ++rep)
+        {
+            foreach (local chunk in v)
+            {
+                for (local i = 1 ; i <= BENCH_CHUNK ; ++i)
+                {
+                    local obj = chunk[i];
+                    n += obj.p4 - obj.p1;
+                }
+            }
+        }
+        return n;
+    });
+
+    total += runBench(label + ' get inherited', function()
+    {
+        local n = 0;
+        for (local rep = 0 ; rep < BENCH_PASSES ; ++rep)
+        {
+            foreach (local chunk in v)
+            {
+                for (local i = 1 ; i <= BENCH_CHUNK ; ++i)
+                {
+                    local obj = chunk[i];
+                    n += obj.inh1 + obj.inh2;
+                }
+            }
+        }
+        return n;
+    });
+
+    total += runBench(label + ' set', function()
+    {
+        for (local rep = 0 ; rep < BENCH_PASSES ; ++rep)
+        {
+            foreach (local chunk in v)
+            {
+                for (local i = 1 ; i <= BENCH_CHUNK ; ++i)
+                {
+                    local obj = chunk[i];
+                    obj.p2 = rep;
+                    obj.p3 = i;
+                }
+            }
+        }
+        return nil;
+    });
+
+    return total;
+}
+
+main(args)
+{
+    local total = 0;
+    local v;
+
+    total += runBench('create small', { : v = makeSmall() });
+    total += benchPopulation('small', v);
+    v = nil;
+    t3RunGC();
+
+    total += runBench('create large', { : v = makeLarge() });
+    total += benchPopulation('large', v);
+
+    "total: <<total>> ms\n";
+}
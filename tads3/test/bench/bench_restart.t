@@ -0,0 +1,113 @@
+/*
+ *   Copyright (c) 2026 by the FrobTADS contributors.
+ *
+ *   Please see the accompanying license file, LICENSE.TXT, for information
+ *   on using and copying this software.
+ */
+/*
+Name
+  bench_restart.t - game restart benchmark
+Function
+  Restarts a game with a large initial state over and over.  Preinit
+  builds 50,000 objects, each with a few properties, including a string
+  and a list, so the image file has about 150,000 objects in all, as a big
+  library-based game does.  Each "session" changes some of the objects and
+  creates some new ones, and then restarts, the way a server starts a new
+  session for each player.
+
+  After the restarts, we touch every object once, to make sure the
+  restarted state is the initial state; the checksum printed at the end
+  should be the same from run to run.
+Notes
+  Build (with preinit) and run with the regular tools:
+
+    t3make -nobanner -o bench_restart.t3 bench_restart.t
+    frob -i plain bench_restart.t3
+*/
+
+#include <tads.h>
+
+/* number of objects to create */
+#define BENCH_OBJECTS  50000
+
+/* number of restarts */
+#define BENCH_RESTARTS 20
+
+class Item: object
+    name = nil
+    weight = 0
+    contents = nil
+    owner = nil
+;
+
+/* the game state, built during preinit */
+game: PreinitObject
+    items = nil
+    sessions = 0
+    execute()
+    {
+        local v = new Vector(BENCH_OBJECTS);
+        for (local i = 0 ; i < BENCH_OBJECTS ; ++i)
+        {
+            local it = new Item();
+            it.name = 'item ' + i;
+            it.weight = i;
+            it.contents = [i, i + 1, 'x'];
+            it.owner = v.length() > 0 ? v[v.length()] : nil;
+            v.append(it);
+        }
+        items = v;
+    }
+;
+
+/* run one benchmark, returning its elapsed time in milliseconds */
+runBench(name, func)
+{
+    local t0 = getTime(GetTimeTicks);
+    func();
+    local t = getTime(GetTimeTicks) - t0;
+    "<<name>>: <<t>> ms\n";
+    return t;
+}
+
+/* play a session: change some objects and create some new ones */
+playSession(n)
+{
+    local v = game.items;
+    for (local i = 1 ; i <= 1000 ; ++i)
+    {
+        local it = v[(i * 37 + n) % BENCH_OBJECTS + 1];
+        it.weight = -1;
+        it.contents = [n];
+        local x = new Item();
+        x.owner = it;
+        it.owner = x;
+    }
+    ++game.sessions;
+}
+
+main(args)
+{
+    local total = 0;
+
+    total += runBench('restart', new function()
+    {
+        for (local i = 0 ; i < BENCH_RESTARTS ; ++i)
+        {
+            playSession(i);
+            restartGame();
+        }
+    });
+
+    /* touch every object */
+    local sum = 0;
+    total += runBench('touch all', new function()
+    {
+        foreach (local it in game.items)
+            sum += it.weight + it.contents[2] + it.name.length();
+    });
+
+    "sessions after restart: <<game.sessions>>\n";
+    "checksum: <<sum>>\n";
+    "total: <<total>> ms\n";
+}
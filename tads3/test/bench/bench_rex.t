@@ -0,0 +1,181 @@
+/*
+ *   Copyright (c) 2026 by the FrobTADS contributors.
+ *
+ *   Please see the accompanying license file, LICENSE.TXT, for information
+ *   on using and copying this software.
+ */
+/*
+Name
+  bench_rex.t - regular expression string pattern benchmark
+Function
+  Runs rexMatch(), rexSearch() and rexReplace() with patterns given as
+  strings, cycling through a set of patterns on every call, the way a
+  parser or output filter checks the same text against several patterns
+  in turn.  The same searches are then run with precompiled RexPattern
+  objects for comparison; the string pattern times should come close to
+  these when compiled patterns are cached.
+
+  The last benchmark fails to match a pattern with a nested closure,
+  "(a|a)*b", against a run of a's.  A backtracking matcher tries every way
+  of dividing up the a's, which takes time exponential in the length of
+  the run; the automaton engine takes time proportional to it.
+
+  The long text benchmarks search a transcript of about 11K, where the
+  matches are few and far between, with rexSearch(), rexSearchLast() and
+  String.findReplace().  Most of the time goes to skipping over the text
+  where no match can start.
+Notes
+  Build and run with the regular tools:
+
+    t3make -nobanner -o bench_rex.t3 bench_rex.t
+    frob -i plain bench_rex.t3
+*/
+
+#include <tads.h>
+
+/* number of calls per benchmark */
+#define BENCH_CALLS   200000
+
+property pats, objs;
+
+benchData: object
+    pats = [
+        '<nocase>(take|get|pick up)<space>+(<alpha>+)',
+        '(drop|put down)<space>+(<alpha>+)',
+        '<nocase>^(n|s|e|w|ne|nw|se|sw|u|d)$',
+        '(%d+)<space>*(gold|silver|copper)<space>+coins?',
+        '"([^"]*)"',
+        '(<alpha>+)<space>+(in|on|under|behind)<space>+(<alpha>+)',
+        '<nocase>(x|examine|look at)<space>+(.*)',
+        '(%w+)@(%w+)%.(com|org|net)'
+    ]
+    objs = nil
+;
+
+/* the subject text */
+#define BENCH_TEXT  'please put the 25 gold coins under the "old" lamp now'
+
+/* length of the run of a's for the nested closure benchmark */
+#define BENCH_NESTED  22
+
+/* number of calls per long text benchmark */
+#define BENCH_LONG_CALLS  2000
+
+/* build the long text: a transcript with a few interesting bits */
+makeLongText()
+{
+    local lines = [
+        'You are standing in a small room with white walls.\n',
+        'A passage leads north, and a door opens to the east.\n',
+        '>look at the table\n',
+        'It\'s an ordinary wooden table, covered in dust.\n',
+        '>go north\n',
+        'You walk down the passage for a while.\n'
+    ];
+    local s = '';
+    for (local i = 0 ; i < 300 ; ++i)
+    {
+        s += lines[i % lines.length() + 1];
+        if (i == 10)
+            s += 'You see a rusty key here.\n';
+    }
+    return s + 'You see a sword of Aldor here.\n';
+}
+
+/* run one benchmark, returning its elapsed time in milliseconds */
+runBench(name, func)
+{
+    local t0 = getTime(GetTimeTicks);
+    func();
+    local t = getTime(GetTimeTicks) - t0;
+    "<<name>>: <<t>> ms\n";
+    return t;
+}
+
+/* run the searches with the given pattern list */
+searchAll(pats)
+{
+    local cnt = 0;
+    local n = pats.length();
+    for (local i = 0 ; i < BENCH_CALLS ; ++i)
+    {
+        local p = pats[i % n + 1];
+        if (rexSearch(p, BENCH_TEXT) != nil)
+            ++cnt;
+        if (rexMatch(p, BENCH_TEXT) != nil)
+            ++cnt;
+    }
+    return cnt;
+}
+
+/* run replacements with the given pattern list */
+replaceAll(pats)
+{
+    local len = 0;
+    local n = pats.length();
+    for (local i = 0 ; i < BENCH_CALLS / 4 ; ++i)
+        len += rexReplace(pats[i % n + 1], BENCH_TEXT, '[%1]',
+                          ReplaceAll).length();
+    return len;
+}
+
+/* run the long text searches */
+searchLong(txt)
+{
+    local cnt = 0;
+    for (local i = 0 ; i < BENCH_LONG_CALLS ; ++i)
+    {
+        local m = rexSearch('(sword|shield)<space>+of<space>+(<alpha>+)',
+                            txt);
+        if (m != nil)
+            cnt += m[1];
+        m = rexSearchLast('rusty<space>+(<alpha>+)', txt);
+        if (m != nil)
+            cnt += m[1];
+    }
+    return cnt;
+}
+
+/* run the long text replacements */
+replaceLong(txt)
+{
+    local len = 0;
+    for (local i = 0 ; i < BENCH_LONG_CALLS ; ++i)
+        len += txt.findReplace(R'%<(key|sword)%>', '[%1]', ReplaceAll)
+            .length();
+    return len;
+}
+
+/* fail to match a nested closure */
+nestedClosure()
+{
+    local s = '';
+    for (local i = 0 ; i < BENCH_NESTED ; ++i)
+        s += 'a';
+    return rexMatch('(a|a)*b', s);
+}
+
+main(args)
+{
+    local total = 0;
+    local strs = benchData.pats;
+    local objs = strs.mapAll({ p: new RexPattern(p) });
+    local a, b, c, d;
+
+    total += runBench('string search', { : a = searchAll(strs) });
+    total += runBench('string replace', { : b = replaceAll(strs) });
+    total += runBench('RexPattern search', { : c = searchAll(objs) });
+    total += runBench('RexPattern replace', { : d = replaceAll(objs) });
+    total += runBench('nested closure', { : nestedClosure() });
+
+    local txt = makeLongText();
+    local e, f;
+    total += runBench('long text search', { : e = searchLong(txt) });
+    total += runBench('long text replace', { : f = replaceLong(txt) });
+
+    /* the results should be the same either way */
+    "matches: <<a>>/<<c>>, replaced length: <<b>>/<<d>>\n";
+    "long text: <<txt.length()>> chars, checks: <<e>>, <<f>>\n";
+
+    "total: <<total>> ms\n";
+}
@@ -0,0 +1,128 @@
+/*
+ *   Copyright (c) 2026 by the FrobTADS contributors.
+ *
+ *   Please see the accompanying license file, LICENSE.TXT, for information
+ *   on using and copying this software.
+ */
+/*
+Name
+  bench_save.t - save file benchmark
+Function
+  Saves the game over and over, the way a game that autosaves every turn
+  does.  Preinit builds a large LookupTable and Vector, which end up in the
+  image file, as a library's preinit-time indexes do.  Each "turn" changes
+  a few objects and then saves.  Most turns leave the big collections
+  alone; a save only needs to include them when they've changed from their
+  image file state.
+
+  The save file sizes are printed at the end; they should be the same from
+  run to run.
+Notes
+  Build (with preinit) and run with the regular tools:
+
+    t3make -nobanner -o bench_save.t3 bench_save.t
+    frob -i plain bench_save.t3
+*/
+
+#include <tads.h>
+#include <file.h>
+
+/* number of entries in the big collections */
+#define BENCH_ENTRIES  20000
+
+/* number of saves */
+#define BENCH_SAVES    200
+
+/* the game state */
+class Room: object
+    visits = 0
+;
+
+room1: Room;
+room2: Room;
+room3: Room;
+
+player: object
+    location = room1
+    score = 0
+;
+
+/* a big index, built during preinit */
+index: PreinitObject
+    tab = nil
+    vec = nil
+    execute()
+    {
+        tab = new LookupTable(BENCH_ENTRIES / 4, BENCH_ENTRIES);
+        vec = new Vector(BENCH_ENTRIES);
+        for (local i = 0 ; i < BENCH_ENTRIES ; ++i)
+        {
+            tab['word' + i] = i;
+            vec.append(i * 2);
+        }
+    }
+;
+
+/* run one benchmark, returning its elapsed time in milliseconds */
+runBench(name, func)
+{
+    local t0 = getTime(GetTimeTicks);
+    func();
+    local t = getTime(GetTimeTicks) - t0;
+    "<<name>>: <<t>> ms\n";
+    return t;
+}
+
+/* get the size of a file */
+fileSize(name)
+{
+    local f = File.openRawFile(name, FileAccessRead);
+    local siz = f.getFileSize();
+    f.closeFile();
+    return siz;
+}
+
+/* play a turn: move the player and score a point */
+turn(n)
+{
+    local rooms = [room1, room2, room3];
+    player.location = rooms[n % 3 + 1];
+    player.location.visits++;
+    player.score++;
+}
+
+main(args)
+{
+    local total = 0;
+    local size1, size2;
+
+    total += runBench('save unchanged index', new function()
+    {
+        for (local i = 0 ; i < BENCH_SAVES ; ++i)
+        {
+            turn(i);
+            saveGame('bench_save.t3v');
+        }
+    });
+    size1 = fileSize('bench_save.t3v');
+
+    /* change the index, so that it has to be saved too */
+    local t = index.tab, v = index.vec;
+    t['word1'] = -1;
+    v[1] = -1;
+
+    total += runBench('save changed index', new function()
+    {
+        for (local i = 0 ; i < BENCH_SAVES ; ++i)
+        {
+            turn(i);
+            saveGame('bench_save.t3v');
+        }
+    });
+    size2 = fileSize('bench_save.t3v');
+
+    /* the file sizes should be the same from run to run */
+    "save sizes: <<size1>>, <<size2>>\n";
+
+    "total: <<total>> ms\n";
+}
@@ -0,0 +1,85 @@
+/*
+ *   Copyright (c) 2026 by the FrobTADS contributors.
+ *
+ *   Please see the accompanying license file, LICENSE.TXT, for information
+ *   on using and copying this software.
+ */
+/*
+Name
+  bench_startup.t - image loading benchmark
+Function
+  Measures how long it takes to load a large image file.  Preinit builds
+  60,000 objects, each with a dozen properties, including a string and a
+  list, so the image file is several megabytes, as a big library-based
+  game's is.  The game itself only looks at a few of the objects and quits,
+  so nearly all of the run time is spent loading the image.
+
+  Run it several times and compare the wall-clock time and peak memory
+  use (for example, with "/usr/bin/time -v"), and with several copies
+  running at once to see how much memory they share.
+Notes
+  Build (with preinit) and run with the regular tools:
+
+    t3make -nobanner -o bench_startup.t3 bench_startup.t
+    frob -i plain bench_startup.t3
+*/
+
+#include <tads.h>
+
+/* number of objects to create */
+#define BENCH_OBJECTS  60000
+
+class Item: object
+    name = nil
+    weight = 0
+    bulk = 0
+    contents = nil
+    owner = nil
+    location = nil
+    isListed = true
+    isLit = nil
+    isOpen = nil
+    isLocked = nil
+    vocabWords = nil
+    sightSize = nil
+;
+
+/* the game state, built during preinit */
+game: PreinitObject
+    items = nil
+    execute()
+    {
+        local v = new Vector(BENCH_OBJECTS);
+        for (local i = 0 ; i < BENCH_OBJECTS ; ++i)
+        {
+            local it = new Item();
+            it.name = 'item ' + i + ' of a rather long list of items';
+            it.weight = i;
+            it.contents = [i, i + 1, 'x'];
+            it.owner = v.length() > 0 ? v[v.length()] : nil;
+            it.bulk = i % 7;
+            it.location = it.owner;
+            it.isListed = (i % 3 != 0);
+            it.isLit = (i % 5 == 0);
+            it.isOpen = (i % 2 == 0);
+            it.isLocked = nil;
+            it.vocabWords = 'item';
+            it.sightSize = i % 4;
+            v.append(it);
+        }
+        items = v;
+    }
+;
+
+main(args)
+{
+    /* look at a few objects, so we know the image loaded correctly */
+    local sum = 0;
+    for (local i = 1 ; i <= BENCH_OBJECTS ; i += 997)
+    {
+        local it = game.items[i];
+        sum += it.weight + it.contents[2] + it.name.length() + it.bulk
+            + it.sightSize + (it.isListed ? 1 : 0);
+    }
+    "checksum: <<sum>>\n";
+}
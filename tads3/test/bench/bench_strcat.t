@@ -0,0 +1,104 @@
+/*
+ *   Copyright (c) 2026 by the FrobTADS contributors.
+ *
+ *   Please see the accompanying license file, LICENSE.TXT, for information
+ *   on using and copying this software.
+ */
+/*
+Name
+  bench_strcat.t - string concatenation benchmark
+Function
+  Builds long strings with "s += chunk" loops, 10 bytes per append, the
+  way a game builds up output text.  Without ropes, each append copies the
+  whole string built so far, so the loop is quadratic in the final length.
+  Appending is timed on its own, then flattening the results through an
+  indexed access, then the same text is built with a StringBuffer for
+  comparison.
+Notes
+  Build and run with the regular tools:
+
+    t3make -nobanner -o bench_strcat.t3 bench_strcat.t
+    frob -i plain bench_strcat.t3
+
+  A single string is limited to 65535 bytes, so rather than one 1MB
+  string, we build a series of strings just under the limit, totalling
+  1MB of appended text.
+*/
+
+#include <tads.h>
+#include <strbuf.h>
+
+/* bytes per string, and number of strings (1MB total) */
+#define BENCH_STRLEN  65530
+#define BENCH_STRS    16
+
+/* the chunk we append - 10 bytes */
+#define BENCH_CHUNK   'abcdefghij'
+
+property strs;
+
+benchData: object
+    strs = nil
+;
+
+/* run one benchmark, returning its elapsed time in milliseconds */
+runBench(name, func)
+{
+    local t0 = getTime(GetTimeTicks);
+    func();
+    local t = getTime(GetTimeTicks) - t0;
+    "<<name>>: <<t>> ms\n";
+    return t;
+}
+
+/* build the strings by appending */
+appendStrings()
+{
+    local v = new Vector(BENCH_STRS);
+    for (local i = 0 ; i < BENCH_STRS ; ++i)
+    {
+        local s = '';
+        for (local n = 0 ; n + 10 <= BENCH_STRLEN ; n += 10)
+            s += BENCH_CHUNK;
+        v.append(s);
+    }
+    benchData.strs = v;
+}
+
+/* index into each string, which flattens it */
+indexStrings()
+{
+    local cnt = 0;
+    foreach (local s in benchData.strs)
+        cnt += s.substr(-10) == BENCH_CHUNK ? 1 : 0;
+    return cnt;
+}
+
+/* build the strings with a StringBuffer */
+bufferStrings()
+{
+    for (local i = 0 ; i < BENCH_STRS ; ++i)
+    {
+        local b = new StringBuffer(BENCH_STRLEN);
+        for (local n = 0 ; n + 10 <= BENCH_STRLEN ; n += 10)
+            b.append(BENCH_CHUNK);
+        toString(b);
+    }
+}
+
+main(args)
+{
+    local total = 0;
+
+    total += runBench('append', { : appendStrings() });
+    total += runBench('index', { : indexStrings() });
+    total += runBench('StringBuffer', { : bufferStrings() });
+
+    /* make sure we built what we meant to */
+    local len = 0;
+    foreach (local s in benchData.strs)
+        len += s.length();
+    "bytes: <<len>>, intact: <<indexStrings()>>\n";
+
+    "total: <<total>> ms\n";
+}
@@ -0,0 +1,142 @@
+#include <tads.h>
+#include <dict.h>
+#include <strcomp.h>
+
+/*
+ *   Dictionary lookup index tests.  Lookups go through an index on the
+ *   comparator's folded form of each word, which has to find every word
+ *   that the comparator would match: truncated input, other cases,
+ *   character mappings, and case folding to several characters.  We check
+ *   lookups after adding and removing words, after undo, and after changing
+ *   the comparator, with enough words to make the index grow.
+ */
+
+property noun, adjective;
+
+class Thing: object
+    name = 'thing'
+;
+
+lamp: Thing name = 'lamp';
+key: Thing name = 'key';
+street: Thing name = 'street';
+table: Thing name = 'table';
+filler: Thing name = 'filler';
+
+/* show a word, writing out non-ASCII characters as code points */
+show(s)
+{
+    local r = '';
+    foreach (local c in s.toUnicode())
+        r += (c > 127 ? '\\u' + toString(c, 16) : makeString(c));
+    return r;
+}
+
+/* show the objects and match flags in a findWord() result */
+showFind(d, w, prop?)
+{
+    local lst = (prop == nil ? d.findWord(w) : d.findWord(w, prop));
+    local r = '';
+    for (local i = 1 ; i <= lst.length() ; i += 2)
+    {
+        if (r != '')
+            r += ' ';
+        r += lst[i].name + '/' + toString(lst[i+1], 16);
+    }
+    return '[' + r + ']';
+}
+
+/* show the lookups for a list of words */
+tryWords(title, d, words)
+{
+    "<<title>>:";
+    foreach (local w in words)
+        " <<show(w)>>=<<showFind(d, w)>>";
+    "\n";
+}
+
+/* make up the n-th filler word */
+fillerWord(n)
+{
+    local s = '';
+    for (local i = 0 ; i < 4 ; ++i)
+    {
+        s += makeString('a'.toUnicode(1) + n % 26);
+        n /= 26;
+    }
+    return s + 'ixes';
+}
+
+main(args)
+{
+    local words = ['lamp', 'LAMP', 'lam', 'lantern', 'lamps', 'lampshade',
+                   'key', 'keys', 'Key', 'street', 'stree', 'streetlight',
+                   'table', 'tab', 'tables', 'tablecloth', 'xyzzy', ''];
+
+    /* truncation and case folding */
+    local d = new Dictionary(new StringComparator(4, nil, []));
+    d.addWord(lamp, 'lantern', &noun);
+    d.addWord(lamp, 'lamp', &noun);
+    d.addWord(key, 'key', &noun);
+    d.addWord(street, 'street', &noun);
+    d.addWord(table, 'table', &noun);
+    d.addWord(table, 'wooden', &adjective);
+    tryWords('trunc 4, nocase', d, words);
+    "lamp noun: <<showFind(d, 'lamp', &noun)>>,
+        wood adjective: <<showFind(d, 'wood', &adjective)>>,
+        wooden noun: <<showFind(d, 'wooden', &noun)>>\n";
+    "defined: <<d.isWordDefined('tabl') ? 'yes' : 'no'>>
+        <<d.isWordDefined('tabs') ? 'yes' : 'no'>>
+        <<d.isWordDefined('STREETS', {x: x == 0}) ? 'yes' : 'no'>>\n";
+
+    /* remove words, and put them back with undo */
+    savepoint();
+    d.removeWord(lamp, 'lamp', &noun);
+    d.removeWord(key, 'key', &noun);
+    d.addWord(key, 'keys', &noun);
+    tryWords('after remove', d, words);
+    undo();
+    tryWords('after undo', d, words);
+
+    /* case sensitive, no truncation */
+    d.setComparator(new StringComparator(0, true, []));
+    tryWords('exact case', d, words);
+
+    /* no comparator at all */
+    d.setComparator(nil);
+    tryWords('no comparator', d, words);
+
+    /* character mappings and multi-character case folding */
+    d = new Dictionary(new StringComparator(
+        5, nil, [['\u00e4', 'ae', 0x100, 0x200], ['\u00df', 'ss', 0, 0]]));
+    d.addWord(street, 'stra\u00dfe', &noun);
+    d.addWord(table, 'k\u00e4se', &noun);
+    d.addWord(key, 'STRASSENBAHN', &noun);
+    tryWords('mappings', d, ['strasse', 'STRASSE', 'stra\u00dfe',
+        'STRA\u00dfE', 'strassenbahn', 'strass', 'kaese', 'k\u00e4se',
+        'K\u00c4SE', 'KAESE', 'kase', 'stras']);
+
+    /* lots of words, so that the index has to grow */
+    d = new Dictionary(new StringComparator(6, nil, []));
+    d.addWord(lamp, 'lamp', &noun);
+    local found = 0, extra = 0;
+    "before filling: <<showFind(d, 'lamp')>>\n";
+    for (local i = 0 ; i < 3000 ; ++i)
+        d.addWord(filler, fillerWord(i * 7), &noun);
+    for (local i = 0 ; i < 3000 ; ++i)
+    {
+        local w = fillerWord(i * 7);
+        if (d.findWord(w).length() == 2)
+            ++found;
+        if (d.findWord(w.substr(1, 6).toUpper()).length() == 2)
+            ++extra;
+    }
+    "filled: <<found>> found, <<extra>> found truncated,
+        lamp=<<showFind(d, 'lamp')>>\n";
+    for (local i = 0 ; i < 3000 ; i += 2)
+        d.removeWord(filler, fillerWord(i * 7), &noun);
+    found = 0;
+    for (local i = 0 ; i < 3000 ; ++i)
+        found += d.findWord(fillerWord(i * 7)).length() / 2;
+    "after removing half: <<found>> found\n";
+}
@@ -0,0 +1,108 @@
+#include <tads.h>
+
+/*
+ *   Generational garbage collector tests.  We set up some long-lived
+ *   containers and force a full collection, so that they're in the old
+ *   generation.  We then store newly created objects into them in all of
+ *   the ways that go through the write barrier, while allocating enough
+ *   garbage to trigger a series of minor collections, and finally check
+ *   that everything stored is still intact.
+ */
+
+property ref, tag;
+
+class Item: object
+    construct(t) { tag = t; }
+;
+
+class Finalized: object
+    finalize() { ++gcState.finalizeCount; }
+;
+
+gcState: object
+    finalizeCount = 0
+;
+
+holder: object
+    ref = nil
+;
+
+/* allocate enough garbage to trigger a few collections */
+churn()
+{
+    local x;
+    for (local i = 0 ; i < 30000 ; ++i)
+        x = new Item(i);
+    return x.tag;
+}
+
+/* describe an item, or whatever we find in its place */
+desc(x)
+{
+    if (dataType(x) == TypeObject && x.ofKind(Item))
+        return x.tag;
+    return '(bad)';
+}
+
+main(args)
+{
+    local vec = new Vector(10);
+    local tab = new LookupTable();
+    local inner = new Vector(10);
+    local weak = new WeakRefLookupTable();
+
+    /* put the inner vector where it's only reachable through an object */
+    holder.ref = [inner];
+    inner = nil;
+
+    /* make everything old */
+    t3RunGC();
+
+    /* store new objects through each barrier path */
+    holder.tag = new Item('prop');
+    vec.append(new Item('append'));
+    vec.prepend(new Item('prepend'));
+    vec.insertAt(2, new Item('insert'));
+    vec.appendAll([new Item('all1'), new Item('all2')]);
+    vec.splice(1, 0, new Item('splice'));
+    vec[vec.length() + 1] = new Item('extend');
+    vec[1] = new Item('index');
+    tab['key'] = new Item('tabval');
+    tab[new Item('tabkey')] = 'value';
+    tab.setDefaultValue(new Item('default'));
+    holder.ref[1].append(new Item('inner'));
+    weak['strong'] = new Item('weakval');
+
+    /* generate enough garbage to run several collections */
+    churn();
+
+    "Property: <<desc(holder.tag)>>\n";
+    "Vector: ";
+    foreach (local x in vec)
+        "<<desc(x)>> ";
+    "\n";
+    "Table value: <<desc(tab['key'])>>\n";
+    tab.forEachAssoc(function(k, v) {
+        if (dataType(k) == TypeObject)
+            "Table key: <<desc(k)>>\n";
+    });
+    "Table default: <<desc(tab['missing'])>>\n";
+    "Inner vector: <<desc(holder.ref[1][1])>>\n";
+    "Weak table: <<weak['strong'] == nil ? 'gone' : 'present'>>\n";
+
+    /* undo should restore references that are only held in undo records */
+    holder.tag = new Item('before');
+    savepoint();
+    holder.tag = new Item('after');
+    churn();
+    undo();
+    churn();
+    "After undo: <<desc(holder.tag)>>\n";
+
+    /* unreachable finalizable objects are finalized by a full collection */
+    for (local i = 0 ; i < 10 ; ++i)
+        new Finalized();
+    churn();
+    t3RunGC();
+    "Finalized: <<gcState.finalizeCount>>\n";
+}
@@ -0,0 +1,173 @@
+#include <tads.h>
+#include <dict.h>
+#include <gramprod.h>
+
+/*
+ *   Grammar sub-production memo tests.  The parser parses each
+ *   sub-production only once at each token position, and replays the
+ *   results for every other rule that asks for the same sub-production at
+ *   the same position.  The replayed results have to be the same as
+ *   parsing the sub-production again: the same match trees, in the same
+ *   order.  We parse ambiguous commands where several rules share noun
+ *   phrase sub-productions, with circular (left-recursive) rules, rules
+ *   with badness that only match when nothing better does, and '*' rules,
+ *   and show every match tree in the order parseTokens() returns them.
+ *
+ *   We also parse from inside a dictionary comparator that is itself called
+ *   during a parse, which has to leave the outer parse's working memory
+ *   intact.
+ */
+
+dictionary gDict;
+dictionary property noun, adjective;
+enum token tokWord;
+
+property dobj_, iobj_, cmd_, rest_, np_, lst_, adj_, of_, txt_;
+
+/* match objects show themselves as trees */
+class Match: object
+    name = ''
+    props = []
+    show()
+    {
+        local r = name + '(';
+        local first = true;
+        foreach (local p in props)
+        {
+            local v = self.(p);
+            if (!first)
+                r += ' ';
+            first = nil;
+            if (v == nil)
+                r += '-';
+            else if (dataType(v) == TypeSString)
+                r += v;
+            else
+                r += v.show();
+        }
+        return r + ')';
+    }
+;
+
+grammar commandList(single): command->cmd_
+    : Match name = 'cmd' props = [&cmd_];
+grammar commandList(then): command->cmd_ 'then' commandList->rest_
+    : Match name = 'then' props = [&cmd_, &rest_];
+grammar commandList(and): command->cmd_ 'and' commandList->rest_
+    : Match name = 'and' props = [&cmd_, &rest_];
+
+grammar command(take): 'take' nounList->dobj_
+    : Match name = 'take' props = [&dobj_];
+grammar command(takeFrom): 'take' nounList->dobj_ 'from' nounPhrase->iobj_
+    : Match name = 'takeFrom' props = [&dobj_, &iobj_];
+grammar command(putIn): 'put' nounList->dobj_ 'in' nounPhrase->iobj_
+    : Match name = 'putIn' props = [&dobj_, &iobj_];
+grammar command(putOn): 'put' nounList->dobj_ 'on' nounPhrase->iobj_
+    : Match name = 'putOn' props = [&dobj_, &iobj_];
+grammar command(give): 'give' nounList->dobj_ 'to' nounPhrase->iobj_
+    : Match name = 'give' props = [&dobj_, &iobj_];
+grammar command(giveTo): 'give' nounPhrase->iobj_ nounList->dobj_
+    : Match name = 'giveTo' props = [&iobj_, &dobj_];
+grammar command(say): 'say' *
+    : Match name = 'say' props = [];
+grammar command(badTake): [badness 50] 'take' miscWords->dobj_
+    : Match name = 'badTake' props = [&dobj_];
+
+grammar nounList(single): nounPhrase->np_
+    : Match name = 'np' props = [&np_];
+grammar nounList(and): nounList->lst_ 'and' nounPhrase->np_
+    : Match name = 'list' props = [&lst_, &np_];
+
+grammar nounPhrase(noun): noun->np_
+    : Match name = 'n' props = [&np_];
+grammar nounPhrase(adj): adjective->adj_ nounPhrase->np_
+    : Match name = 'adj' props = [&adj_, &np_];
+grammar nounPhrase(the): 'the' nounPhrase->np_
+    : Match name = 'the' props = [&np_];
+grammar nounPhrase(of): nounPhrase->np_ 'of' nounPhrase->of_
+    : Match name = 'of' props = [&np_, &of_];
+grammar nounPhrase(adjOnly): [badness 100] adjective->adj_
+    : Match name = 'adjOnly' props = [&adj_];
+grammar nounPhrase(misc): [badness 200] miscWords->txt_
+    : Match name = 'misc' props = [&txt_];
+
+grammar miscWords(one): tokWord->txt_
+    : Match name = 'w' props = [&txt_];
+grammar miscWords(more): tokWord->txt_ miscWords->rest_
+    : Match name = 'w' props = [&txt_, &rest_];
+
+vocab: object
+    noun = 'box' 'lid' 'key' 'brass' 'book' 'spells' 'chest' 'ball' 'red'
+    adjective = 'red' 'box' 'small' 'brass' 'old' 'large'
+;
+
+/*
+ *   A comparator that parses a command every time it's asked for a hash
+ *   value, which happens in the middle of an enclosing parse.  
+ */
+nestedComparator: object
+    dict = nil
+    depth = 0
+    nestedCnt = 0
+    calcHash(s)
+    {
+        if (depth == 0)
+        {
+            ++depth;
+            try
+            {
+                nestedCnt += commandList.parseTokens(
+                    [['take', tokWord, 'take'], ['box', tokWord, 'box']],
+                    dict).length();
+            }
+            finally
+            {
+                --depth;
+            }
+        }
+        return s.length();
+    }
+    matchValues(a, b) { return a == b ? 1 : 0; }
+;
+
+main(args)
+{
+    local cmds = [
+        'take box',
+        'take red box lid',
+        'put the red box and the brass key in the chest',
+        'put red box and brass key on old book of spells',
+        'give the box to the key and take the ball',
+        'give red box lid brass key',
+        'take the book of spells of the box from the chest then take key',
+        'take small',
+        'put small and large in box',
+        'take the xyzzy',
+        'put xyzzy in frotz',
+        'say box and anything else',
+        'take box and say hello',
+        'give the plugh plover'
+    ];
+
+    foreach (local c in cmds)
+    {
+        local toks = c.split(' ').mapAll({ w: [w, tokWord, w] });
+        local m = commandList.parseTokens(toks, gDict);
+        "<<c>>: <<m.length()>>\n";
+        foreach (local x in m)
+            "\ \ <<x.show()>> [<<x.firstTokenIndex>>-<<x.lastTokenIndex>>]\n";
+    }
+
+    /* parse with nested parses from the comparator */
+    local d = nestedComparator.dict = new Dictionary(nestedComparator);
+    gDict.forEachWord({ obj, str, prop: d.addWord(obj, str, prop) });
+    foreach (local c in cmds.sublist(1, 4))
+    {
+        local toks = c.split(' ').mapAll({ w: [w, tokWord, w] });
+        local m = commandList.parseTokens(toks, d);
+        "nested <<c>>: <<m.length()>>\n";
+        foreach (local x in m)
+            "\ \ <<x.show()>> [<<x.firstTokenIndex>>-<<x.lastTokenIndex>>]\n";
+    }
+    "nested parses found <<nestedComparator.nestedCnt>> matches\n";
+}
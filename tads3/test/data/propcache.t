@@ -0,0 +1,77 @@
+#include <tads.h>
+
+/*
+ *   Inline property cache tests.  Each helper function below evaluates a
+ *   property from a single instruction, so that repeated calls go through
+ *   the same cache entry; we then change the class tree in various ways and
+ *   make sure the next evaluation sees the change.
+ */
+
+property color;
+
+class Base: object
+    name = 'Base'
+    greet() { return 'hello from Base'; }
+;
+
+class Mid: Base
+;
+
+class Other: object
+    name = 'Other'
+    greet() { return 'hello from Other'; }
+;
+
+a1: Mid;
+a2: Mid;
+o1: Other;
+
+propName(obj) { return obj.name; }
+propColor(obj) { return obj.color; }
+callGreet(obj) { return obj.greet(); }
+
+main(args)
+{
+    "Initial: <<propName(a1)>>, <<propName(a2)>>, <<propName(o1)>>\n";
+    "Polymorphic: ";
+    foreach (local obj in [a1, o1, a2, o1, a1])
+        "<<callGreet(obj)>>; ";
+    "\n";
+
+    /* change the value of an inherited property in the defining class */
+    Base.name = 'Base (changed)';
+    "After changing Base.name: <<propName(a1)>>, <<propName(a2)>>\n";
+
+    /* override the property in an intermediate class */
+    Mid.name = 'Mid';
+    "After adding Mid.name: <<propName(a1)>>, <<propName(a2)>>\n";
+
+    /* override it in one instance */
+    a2.name = 'a2';
+    "After adding a2.name: <<propName(a1)>>, <<propName(a2)>>\n";
+
+    /* add a property to a class, then undo it */
+    "Color before: <<propColor(a1)>>\n";
+    savepoint();
+    Base.color = 'red';
+    "Color after adding Base.color: <<propColor(a1)>>\n";
+    undo();
+    "Color after undo: <<propColor(a1) == nil ? 'nil' : propColor(a1)>>\n";
+
+    /* change the superclass list */
+    a1.setSuperclassList([Other]);
+    "After a1.setSuperclassList([Other]): <<propName(a1)>>,
+        <<callGreet(a1)>>\n";
+    a1.setSuperclassList([Mid]);
+    "After a1.setSuperclassList([Mid]): <<propName(a1)>>,
+        <<callGreet(a1)>>\n";
+
+    /* change a class's superclass list out from under its instances */
+    Mid.setSuperclassList([Other]);
+    "After Mid.setSuperclassList([Other]): <<propName(o1)>>,
+        <<callGreet(a1)>>\n";
+
+    /* dynamically created instances */
+    local d = new Mid();
+    "New Mid: <<propName(d)>>, <<callGreet(d)>>\n";
+}
@@ -0,0 +1,171 @@
+#include <tads.h>
+
+/*
+ *   Prebuilt property index tests.  The compiler stores a prebuilt property
+ *   index with each object that's large enough to need one, and the VM
+ *   adopts it at load time instead of building the index itself.  Every
+ *   property has to be found through the adopted index, including after
+ *   the object is changed, expanded, and reset by a restart.
+ */
+
+small: object
+    p1 = 101
+    p2 = 102
+    p3 = 103
+    p4 = 104
+    p5 = 105
+    p6 = 106
+    p7 = 107
+    p8 = 108
+;
+
+medium: object
+    p1 = 201
+    p2 = 202
+    p3 = 203
+    p4 = 204
+    p5 = 205
+    p6 = 206
+    p7 = 207
+    p8 = 208
+    p9 = 209
+;
+
+large: object
+    p1 = 301
+    p2 = 302
+    p3 = 303
+    p4 = 304
+    p5 = 305
+    p6 = 306
+    p7 = 307
+    p8 = 308
+    p9 = 309
+    p10 = 310
+    p11 = 311
+    p12 = 312
+    p13 = 313
+    p14 = 314
+    p15 = 315
+    p16 = 316
+    p17 = 317
+;
+
+huge: object
+    p1 = 401
+    p2 = 402
+    p3 = 403
+    p4 = 404
+    p5 = 405
+    p6 = 406
+    p7 = 407
+    p8 = 408
+    p9 = 409
+    p10 = 410
+    p11 = 411
+    p12 = 412
+    p13 = 413
+    p14 = 414
+    p15 = 415
+    p16 = 416
+    p17 = 417
+    p18 = 418
+    p19 = 419
+    p20 = 420
+    p21 = 421
+    p22 = 422
+    p23 = 423
+    p24 = 424
+    p25 = 425
+    p26 = 426
+    p27 = 427
+    p28 = 428
+    p29 = 429
+    p30 = 430
+    p31 = 431
+    p32 = 432
+    p33 = 433
+    p34 = 434
+    p35 = 435
+    p36 = 436
+    p37 = 437
+    p38 = 438
+    p39 = 439
+    p40 = 440
+;
+
+/* a class with an index, and an instance that inherits from it */
+class Big: object
+    p1 = 501  p2 = 502  p3 = 503  p4 = 504  p5 = 505  p6 = 506
+    p7 = 507  p8 = 508  p9 = 509  p10 = 510  p11 = 511  p12 = 512
+;
+
+kid: Big
+    p3 = 603  p9 = 609  p20 = 620
+;
+
+/* all of the test properties, in order */
+allProps: object
+    lst = [&p1, &p2, &p3, &p4, &p5, &p6, &p7, &p8, &p9, &p10, &p11, &p12,
+           &p13, &p14, &p15, &p16, &p17, &p18, &p19, &p20, &p21, &p22, &p23,
+           &p24, &p25, &p26, &p27, &p28, &p29, &p30, &p31, &p32, &p33, &p34,
+           &p35, &p36, &p37, &p38, &p39, &p40, &p41]
+;
+
+/* the restart count survives restarts, since it's transient */
+transient restarts: object
+    cnt = 0
+;
+
+/* check that we can find each property p1..pN of an object */
+check(obj, n)
+{
+    local sum = 0, found = 0;
+    for (local i = 1 ; i <= n ; ++i)
+    {
+        local prop = allProps.lst[i];
+        if (obj.propDefined(prop, PropDefDirectly))
+        {
+            ++found;
+            sum += obj.(prop);
+        }
+    }
+    "<<found>> found, sum=<<sum>>, p41 <<
+      obj.propDefined(&p41, PropDefDirectly) ? 'defined' : 'undefined'>>";
+}
+
+show(label)
+{
+    "<<label>>:\n";
+    "small: "; check(small, 8); "\n";
+    "medium: "; check(medium, 9); "\n";
+    "large: "; check(large, 17); "\n";
+    "huge: "; check(huge, 40); "\n";
+    "kid: p1=<<kid.p1>> p3=<<kid.p3>> p9=<<kid.p9>> p12=<<kid.p12>>
+    p20=<<kid.p20>>\n";
+}
+
+main(args)
+{
+    show('initial');
+
+    for (local round = 1 ; round <= 2 ; ++round)
+    {
+        /* change some properties and add new ones, expanding the objects */
+        for (local i = 1 ; i <= 30 ; ++i)
+        {
+            local prop = allProps.lst[i];
+            medium.(prop) = -i;
+            large.(prop) = -i;
+        }
+        huge.p41 = 441;
+        huge.p1 = 0;
+        kid.p12 = 0;
+        show('changed');
+
+        /* restart, which takes everything back to the image file state */
+        restartGame();
+        ++restarts.cnt;
+        show('restart ' + restarts.cnt);
+    }
+}
@@ -0,0 +1,136 @@
+#include <tads.h>
+
+/*
+ *   Restart tests.  The first restart resets everything to the image file
+ *   state and runs the static initializers again; later restarts restore a
+ *   snapshot of the state that the first one left.  Every restart has to
+ *   come out the same, including objects and collections created by the
+ *   static initializers, objects whose superclass lists were changed, and
+ *   saved games restored between restarts.
+ */
+
+class Item: object
+    construct(n) { name = n; }
+    name = nil
+    weight = 1
+    link = nil
+;
+
+class Other: object
+    other = true
+;
+
+box: Item
+    name = 'box'
+    weight = 10
+    pal = static new Item('pal')
+    tab = static makeTable()
+    vec = static new Vector([1, 2, 3])
+    makeTable()
+    {
+        local t = new LookupTable(8, 16);
+        t['a'] = 'apple';
+        t['b'] = pal;
+        return t;
+    }
+;
+
+ball: Item
+    name = 'ball'
+;
+
+/* an object that inherits from ball, to check its inheritance path */
+kid: ball
+    name = 'kid'
+;
+
+/* an object whose class is defined after it */
+early: Late
+;
+
+class Late: object
+    late = 'late'
+;
+
+/* the restart count survives restarts, since it's transient */
+transient restarts: object
+    cnt = 0
+;
+
+/* count the instances of Item */
+countItems()
+{
+    local n = 0;
+    for (local o = firstObj(Item) ; o != nil ; o = nextObj(o, Item))
+        ++n;
+    return n;
+}
+
+/* show the state */
+show(label)
+{
+    local keys = box.tab.keysToList().sort();
+    "<<label>>: box=<<box.name>>/<<box.weight>>
+    pal=<<box.pal.name>>/<<box.pal.weight>>
+    link=<<box.link == nil ? 'nil' : box.link.name>>
+    ball.other=<<ball.other == nil ? 'nil' : 'yes'>>
+    ofKind(Other)=<<ball.ofKind(Other) ? 'yes' : 'no'>>
+    kid.other=<<kid.other == nil ? 'nil' : 'yes'>> early=<<early.late>>
+    tab=[";
+    foreach (local k in keys)
+    {
+        local v = box.tab[k];
+        "<<k == keys[1] ? '' : ' '>><<k>>=<<dataType(v) == TypeObject
+          ? v.name : v>>";
+    }
+    "] tab[b]==pal: <<box.tab['b'] == box.pal ? 'yes' : 'no'>>
+    vec=<<box.vec.join(',')>> items=<<countItems()>>\n";
+}
+
+/* change everything */
+changeAll(n)
+{
+    local t = box.tab, v = box.vec;
+    box.name = 'crate ' + n;
+    box.weight = n;
+    box.pal.weight = n * 100;
+    box.link = new Item('new ' + n);
+    box.link.link = new Item('newer ' + n);
+    ball.setSuperclassList([Item, Other]);
+    t['a'] = 'apricot';
+    t['c'] = 'cherry';
+    t.removeElement('b');
+    v[1] = n;
+    v.append(n);
+    savepoint();
+}
+
+main(args)
+{
+    show('initial');
+
+    /* restart several times; each one should bring back the initial state */
+    for (local i = 1 ; i <= 3 ; ++i)
+    {
+        changeAll(i);
+        show('changed');
+        restartGame();
+        ++restarts.cnt;
+        show('restart ' + restarts.cnt);
+        "undo after restart: <<undo() ? 'yes' : 'no'>>\n";
+    }
+
+    /* save a changed state, restart, and restore it */
+    changeAll(4);
+    saveGame('restart.t3v');
+    restartGame();
+    show('restart before restore');
+    restoreGame('restart.t3v');
+    show('restored');
+
+    /* restart from the restored state */
+    restartGame();
+    show('restart after restore');
+    t3RunGC();
+    show('after gc');
+}
@@ -0,0 +1,92 @@
+#include <tads.h>
+#include <file.h>
+
+/*
+ *   Restored inheritance tests.  Restoring sets up each restored object's
+ *   superclass list, including superclasses that are themselves dynamic
+ *   objects that haven't been restored yet at that point (because they
+ *   come later in the saved state).  We check that inheritance works
+ *   through all of these after restoring, including superclass lists that
+ *   were changed at run time.
+ */
+
+class Base: object
+    name = 'base'
+    describe() { return name + '/' + color + '/' + size; }
+    color = 'none'
+    size = 'medium'
+;
+
+class Other: object
+    size = 'large'
+    weight = 5
+;
+
+/* show an object's inherited properties */
+show(label, obj)
+{
+    "<<label>>: <<obj.describe()>> weight=<<obj.weight>>
+    ofKind(Base)=<<obj.ofKind(Base) ? 'yes' : 'no'>>
+    ofKind(Other)=<<obj.ofKind(Other) ? 'yes' : 'no'>>\n";
+}
+
+game: object
+    objs = []
+;
+
+main(args)
+{
+    /*
+     *   Create a chain of dynamic objects, each inheriting from the one
+     *   created before it.  
+     */
+    local a = new Base();
+    a.color = 'red';
+    local b = a.createInstance();
+    b.name = 'b';
+    local c = b.createInstance();
+    c.size = 'small';
+
+    /*
+     *   Create an object first, and then give it a superclass created
+     *   after it, so that its superclass comes later in the saved state.  
+     */
+    local d = new Base();
+    local e = new Base();
+    e.color = 'green';
+    e.name = 'e';
+    d.setSuperclassList([e, Other]);
+
+    game.objs = [a, b, c, d, e];
+    show('a', a);
+    show('b', b);
+    show('c', c);
+    show('d', d);
+
+    saveGame('restinh.t3v');
+
+    /* change things around */
+    a.color = 'blue';
+    d.setSuperclassList([Base]);
+    game.objs = [];
+
+    /* restore, and check inheritance through the restored objects */
+    restoreGame('restinh.t3v');
+    "restored\n";
+    show('a', game.objs[1]);
+    show('b', game.objs[2]);
+    show('c', game.objs[3]);
+    show('d', game.objs[4]);
+
+    /* changes to a restored superclass show up in its subclasses */
+    game.objs[1].color = 'yellow';
+    game.objs[5].size = 'tiny';
+    show('c', game.objs[3]);
+    show('d', game.objs[4]);
+
+    /* restore again, from a different state */
+    restoreGame('restinh.t3v');
+    "restored again\n";
+    show('c', game.objs[3]);
+    show('d', game.objs[4]);
+}
@@ -0,0 +1,64 @@
+#include <tads.h>
+
+/*
+ *   Regular expression pattern cache tests.  String patterns are compiled
+ *   through a cache of limited size, so we run more distinct patterns than
+ *   the cache holds, in alternation, and check that each one keeps giving
+ *   the right answer.  We also run searches with many other patterns from
+ *   inside a rexReplace() callback, which pushes the replace's own pattern
+ *   toward eviction while it's still in use.
+ */
+
+/* a pattern that matches only the number n */
+numPat(n) { return '%<' + n + '%>'; }
+
+main(args)
+{
+    local subj = '';
+    for (local i = 0 ; i < 50 ; ++i)
+        subj += toString(i) + ' ';
+
+    /* alternate among more patterns than the cache holds */
+    local ok = true;
+    for (local rep = 0 ; rep < 3 ; ++rep)
+    {
+        for (local i = 0 ; i < 50 ; ++i)
+        {
+            local fwd = rexSearch(numPat(i), subj);
+            local back = rexSearchLast(numPat(i), subj);
+            if (fwd == nil || fwd[3] != toString(i)
+                || back == nil || back[1] != fwd[1]
+                || rexMatch(numPat(i), toString(i)) != toString(i).length())
+                ok = nil;
+        }
+    }
+    "Alternating patterns: <<ok ? 'ok' : 'bad'>>\n";
+
+    /* groups, case folding, and options in the pattern text */
+    "Group: <<rexSearch('(%w+)-(%w+)', 'abc def-ghi')[3]>>,
+        <<rexGroup(1)[3]>>, <<rexGroup(2)[3]>>\n";
+    "Case: <<rexMatch('<nocase>abc', 'ABC')>>,
+        <<rexMatch('abc', 'ABC') == nil ? 'nil' : 'match'>>\n";
+    "Replace nocase: <<rexReplace('b+', 'aBbBa', '-', ReplaceAll
+                                  | ReplaceIgnoreCase)>>\n";
+    "Replace case: <<rexReplace('b+', 'aBbBa', '-', ReplaceAll)>>\n";
+
+    /* an unclosed group, twice in a row */
+    "Unclosed group: <<rexSearch('(abc', 'abc') == nil ? 'nil' : 'found'>>,
+        <<rexSearch('(abc', 'abc') == nil ? 'nil' : 'found'>>\n";
+
+    /* run lots of other patterns while the replace is using its own */
+    local res = rexReplace('%d+', subj, function(m) {
+        local n = toInteger(m);
+        for (local j = 0 ; j < 40 ; ++j)
+            rexMatch(numPat(j + 100), 'x');
+        return rexMatch(numPat(n), m) != nil ? 'x' : '?';
+    }, ReplaceAll);
+    "Callback replace: <<res.length()>> <<res.find('?') == nil
+                                           ? 'ok' : 'bad'>>\n";
+
+    /* several patterns at once, repeated */
+    for (local i = 0 ; i < 3 ; ++i)
+        "List replace: <<rexReplace(['a', 'b', 'c'], 'abcabc',
+                                    ['1', '2', '3'], ReplaceAll)>>\n";
+}
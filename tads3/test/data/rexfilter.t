@@ -0,0 +1,121 @@
+#include <tads.h>
+
+/*
+ *   Regular expression search filter tests.  Searches skip over the parts
+ *   of the subject string where no match can start, based on the bytes
+ *   that can begin a match.  We search a longer string with patterns that
+ *   start in various ways - literals, strings, classes, case-folded
+ *   characters, zero-width assertions, and patterns that can match empty
+ *   strings - forwards and backwards, and with findReplace(), to make sure
+ *   that the filter never skips over a real match.
+ */
+
+/*
+ *   show a string, writing out markup characters so that they aren't taken
+ *   as HTML, and non-ASCII characters as code points
+ */
+show(s)
+{
+    local r = '';
+    foreach (local c in s.toUnicode())
+    {
+        if (c > 127)
+            r += '\\u' + toString(c, 16);
+        else if (c == '<'.toUnicode(1))
+            r += '&lt;';
+        else if (c == '&'.toUnicode(1))
+            r += '&amp;';
+        else if (c == '\n'.toUnicode(1))
+            r += '\\n';
+        else
+            r += makeString(c);
+    }
+    return r;
+}
+
+/* show a match result, with or without its index */
+showMatch(m, idx)
+{
+    if (m == nil)
+        return 'nil';
+    else if (idx)
+        return show(m[3]) + '@' + m[1];
+    else
+        return show(m[3]);
+}
+
+/* run a pattern over the subject every way we can */
+tryPat(pat, str)
+{
+    local cnt = 0, first = nil, last = nil;
+    local i = 1;
+
+    /* find every match going forwards */
+    for (;;)
+    {
+        local m = rexSearch(pat, str, i);
+        if (m == nil)
+            break;
+        if (first == nil)
+            first = m;
+        ++cnt;
+        i = m[1] + (m[2] == 0 ? 1 : m[2]);
+        if (i > str.length() + 1)
+            break;
+    }
+
+    /* and the last one going backwards */
+    last = rexSearchLast(pat, str);
+
+    "'<<show(pat)>>': <<cnt>> matches, first <<showMatch(first, true)>>,
+        last <<showMatch(last, nil)>>, replaced length
+        <<str.findReplace(new RexPattern(pat), '[%*]', ReplaceAll)
+          .length()>>\n";
+}
+
+main(args)
+{
+    /* build a subject string with a few things to find in a lot of text */
+    local str = '';
+    for (local i = 0 ; i < 40 ; ++i)
+    {
+        str += 'the quick brown fox jumps over the lazy dog. ';
+        if (i == 7)
+            str += 'Stra\u00dfe STRASSE 42 ';
+        if (i == 19)
+            str += '\u212aelvin \u00e9t\u00e9 (x) ';
+        if (i == 31)
+            str += 'zebra! ';
+    }
+
+    tryPat('zebra', str);
+    tryPat('z', str);
+    tryPat('Zebra', str);
+    tryPat('<nocase>zEBRA', str);
+    tryPat('<nocase>kelvin', str);
+    tryPat('<nocase>k', str);
+    tryPat('<nocase>strasse', str);
+    tryPat('<nocase>stra\u00dfe', str);
+    tryPat('<nocase>\u00df', str);
+    tryPat('\u00e9t', str);
+    tryPat('<nocase>\u00c9T\u00c9', str);
+    tryPat('%d+', str);
+    tryPat('[0-9]', str);
+    tryPat('<nocase>[x-z]', str);
+    tryPat('[^a-z ]+', str);
+    tryPat('<upper>+', str);
+    tryPat('<punct>', str);
+    tryPat('%(x%)', str);
+    tryPat('(fox|dog)%.', str);
+    tryPat('(lazy|dog)?!', str);
+    tryPat('%<z', str);
+    tryPat('(?=zeb)z', str);
+    tryPat('(?<=a)!', str);
+    tryPat('^the', str);
+    tryPat('%. $', str);
+    tryPat('x*', 'abc');
+    tryPat('(a|b*)c', str);
+    tryPat('.!', str);
+    tryPat('(z)%1', 'zzz zz');
+    tryPat('z{2}', 'zzz zz');
+}
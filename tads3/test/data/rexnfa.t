@@ -0,0 +1,118 @@
+#include <tads.h>
+
+/*
+ *   Regular expression engine selection tests.  Patterns without
+ *   back-references, assertions, or counted intervals are handed over to
+ *   the automaton engine when the backtracking matcher takes too long.  We
+ *   run a variety of them through rexMatch(), rexSearch(), rexSearchLast()
+ *   and rexReplace() and show the match and group results, which must be
+ *   the same either way, and then run some patterns that take exponential
+ *   time with backtracking, so that the automaton has to finish them.
+ */
+
+/* 
+ *   show a string, writing out markup characters so that they aren't taken
+ *   as HTML, and non-ASCII characters as code points 
+ */
+show(s)
+{
+    local r = '';
+    foreach (local c in s.toUnicode())
+    {
+        if (c > 127)
+            r += '\\u' + toString(c, 16);
+        else if (c == '<'.toUnicode(1))
+            r += '&lt;';
+        else if (c == '&'.toUnicode(1))
+            r += '&amp;';
+        else
+            r += makeString(c);
+    }
+    return r;
+}
+
+/* show the groups from the last match */
+showGroups()
+{
+    for (local i = 1 ; i <= 3 ; ++i)
+    {
+        local g = rexGroup(i);
+        if (g != nil)
+            " g<<i>>=<<show(g[3])>>@<<g[1]>>";
+    }
+}
+
+/* run a pattern every way we can */
+tryPat(pat, str)
+{
+    "'<<show(pat)>>' ~ '<<show(str)>>':";
+
+    local m = rexMatch(pat, str);
+    " match=<<m == nil ? 'nil' : toString(m)>>";
+    if (m != nil)
+        showGroups();
+
+    local s = rexSearch(pat, str);
+    if (s == nil)
+        " search=nil";
+    else
+    {
+        " search=<<show(s[3])>>@<<s[1]>>";
+        showGroups();
+    }
+
+    local b = rexSearchLast(pat, str);
+    if (b == nil)
+        " last=nil";
+    else
+    {
+        " last=<<show(b[3])>>@<<b[1]>>";
+        showGroups();
+    }
+
+    " replace=<<show(rexReplace(pat, str, '[%1]', ReplaceAll))>>\n";
+}
+
+main(args)
+{
+    tryPat('a*', 'aaab');
+    tryPat('(a|ab)(c|bcd)(d*)', 'abcd');
+    tryPat('(a+)(a*)', 'aaaa');
+    tryPat('<min>(a+)(a*)', 'aaaa');
+    tryPat('(x|xy)*z', 'xyxxyzq');
+    tryPat('<firstend>(b+|ab)', 'aabbb');
+    tryPat('<firstend><min>(a+b|b)', 'aab');
+    tryPat('%<(%w+)%>', 'the quick brown fox');
+    tryPat('(%w+)%b*$', 'the end  ');
+    tryPat('^(th|the)(e?)', 'the end');
+    tryPat('[a-c]+(d|e)?', 'xxabcabf');
+    tryPat('<nocase>(ab)+', 'xABaBabX');
+    tryPat('<nocase>stra\u00dfe', 'STRASSE strasse');
+    tryPat('<nocase>(s+)', 'x\u00dfss');
+    tryPat('<alpha>+<space>+(<digit>+)', 'take 25 coins');
+    tryPat('(a|)+b', 'aab');
+    tryPat('((a)|(b))*', 'abba');
+    tryPat('.(.)', '\u00e9\u20acx');
+    tryPat('(a*)*b', 'aab');
+    tryPat('', 'abc');
+
+    /* nested closures that make a backtracking matcher take forever */
+    local s = '';
+    for (local i = 0 ; i < 200 ; ++i)
+        s += 'a';
+    "Nested closure match: <<rexMatch('(a|a)*b', s) == nil ? 'nil' : 'found'>>\n";
+    "Nested closure search: <<rexSearch('(a|aa)*b', s) == nil
+                              ? 'nil' : 'found'>>\n";
+    "Nested closure success: <<rexMatch('(a|a)*', s)>>\n";
+    "Nested closure last: <<rexSearchLast('(a|a)*b', s) == nil
+                            ? 'nil' : 'found'>>\n";
+
+    /* the same, with matches, so that the groups come from the automaton */
+    local m = rexSearch('(a|aa)*(b)', 'xx' + s + 'b');
+    "Nested closure groups: <<m[1]>>, <<m[2]>>, <<rexGroup(1)[1]>>,
+        <<rexGroup(2)[1]>>\n";
+    m = rexSearch('<firstend>(a|aa)*(c)', s + 'c');
+    "Nested closure first end: <<m[1]>>, <<m[2]>>, <<rexGroup(2)[1]>>\n";
+    "Nested closure replace: <<rexReplace('(a|a)*(c)', s + 'cc', '[%2]',
+                                          ReplaceAll)>>\n";
+}
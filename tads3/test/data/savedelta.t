@@ -0,0 +1,143 @@
+#include <tads.h>
+#include <file.h>
+
+/*
+ *   Save file delta tests.  Saving leaves out Vectors, LookupTables, and
+ *   ByteArrays from the image file that are still in their image file
+ *   state, since restoring resets them to that state anyway.  We check that
+ *   the save file shrinks when these objects are unchanged (including after
+ *   being changed and changed back), and that restoring brings back the
+ *   right contents either way.
+ */
+
+data: object
+    vec = static new Vector([1, 'two', nil, true, &vec, data])
+    tab = static makeTable()
+    bytes = static makeBytes()
+    makeTable()
+    {
+        local t = new LookupTable(16, 32);
+        t['a'] = 1;
+        t['b'] = 'bee';
+        t[3] = data;
+        return t;
+    }
+    makeBytes()
+    {
+        local b = new ByteArray(8);
+        b.fillValue(7);
+        return b;
+    }
+;
+
+/* show the contents of the objects */
+show()
+{
+    local keys = data.tab.keysToList().sort(SortAsc, { a, b:
+        toString(a).compareTo(toString(b)) });
+    "vec=[";
+    for (local i = 1 ; i <= data.vec.length() ; ++i)
+    {
+        local v = data.vec[i];
+        "<<i > 1 ? ' ' : ''>><<dataType(v) == TypeObject ? 'obj'
+          : dataType(v) == TypeProp ? 'prop' : toString(v)>>";
+    }
+    "] tab=[";
+    foreach (local k in keys)
+    {
+        local v = data.tab[k];
+        "<<k == keys[1] ? '' : ' '>><<k>>=<<dataType(v) == TypeObject
+          ? 'obj' : toString(v)>>";
+    }
+    "] bytes=[";
+    for (local i = 1 ; i <= data.bytes.length() ; ++i)
+        "<<i > 1 ? ' ' : ''>><<data.bytes[i]>>";
+    "]\n";
+}
+
+/* get the size of a file */
+fileSize(name)
+{
+    local f = File.openRawFile(name, FileAccessRead);
+    local siz = f.getFileSize();
+    f.closeFile();
+    return siz;
+}
+
+/* 
+ *   Change everything.  Note that we modify the objects through locals:
+ *   assigning to an element of data.vec would also store the vector back
+ *   into data.vec, which would modify 'data' itself.  
+ */
+changeAll()
+{
+    local v = data.vec, t = data.tab, b = data.bytes;
+    v[2] = 'deux';
+    v.append(7);
+    t['b'] = 'bumblebee';
+    t['c'] = 'sea';
+    b[3] = 99;
+}
+
+main(args)
+{
+    "initial: "; show();
+
+    /* save with nothing changed */
+    saveGame('delta0.t3v');
+    local size0 = fileSize('delta0.t3v');
+
+    /* change everything and save again */
+    changeAll();
+    "changed: "; show();
+    saveGame('delta1.t3v');
+    local size1 = fileSize('delta1.t3v');
+    "changed save is larger: <<size1 > size0 ? 'yes' : 'no'>>\n";
+
+    /* change everything back, and save again */
+    local v = data.vec, t = data.tab, b = data.bytes;
+    v[2] = 'two';
+    v.removeElementAt(v.length());
+    t['b'] = 'bee';
+    b[3] = 7;
+    t.removeElement('c');
+    "changed back: "; show();
+    saveGame('delta2.t3v');
+    local size2 = fileSize('delta2.t3v');
+    "changed-back save is smaller: <<size2 < size1 ? 'yes' : 'no'>>\n";
+
+    /*
+     *   put back the exact table layout, by restoring the unchanged save,
+     *   and make a change that we undo within the same slots
+     */
+    restoreGame('delta0.t3v');
+    "restored unchanged: "; show();
+    v = data.vec;
+    t = data.tab;
+    b = data.bytes;
+    v[1] = 100;
+    saveGame('delta4.t3v');
+    local size4 = fileSize('delta4.t3v');
+    "save with one changed element is larger than unchanged:
+        <<size4 > size0 ? 'yes' : 'no'>>\n";
+    v[1] = 1;
+    t['a'] = 100;
+    t['a'] = 1;
+    b[1] = 100;
+    b[1] = 7;
+    saveGame('delta3.t3v');
+    "reverted save is smaller than with one changed element:
+        <<fileSize('delta3.t3v') < size4 ? 'yes' : 'no'>>\n";
+
+    /* restore each save in turn */
+    restoreGame('delta1.t3v');
+    "restored changed: "; show();
+    restoreGame('delta2.t3v');
+    "restored changed back: "; show();
+    changeAll();
+    restoreGame('delta3.t3v');
+    "restored reverted: "; show();
+    changeAll();
+    restoreGame('delta0.t3v');
+    "restored unchanged again: "; show();
+}
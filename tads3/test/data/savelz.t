@@ -0,0 +1,105 @@
+#include <tads.h>
+#include <file.h>
+
+/*
+ *   Compressed save file tests.  The object data in a saved state file is
+ *   compressed, and restoring decompresses it as it goes.  We save a lot of
+ *   repetitive data (which compresses well), along with data that doesn't
+ *   repeat (which doesn't), and check that restoring brings back all of it
+ *   exactly, and that the file is much smaller than the data it holds.
+ */
+
+data: object
+    vec = nil
+    bytes = nil
+    str = nil
+;
+
+/* a simple pseudo-random number generator, so the results are repeatable */
+rng: object
+    seed = 12345
+    next()
+    {
+        seed = (seed * 75 + 74) % 65537;
+        return seed;
+    }
+;
+
+/* get the size of a file */
+fileSize(name)
+{
+    local f = File.openRawFile(name, FileAccessRead);
+    local siz = f.getFileSize();
+    f.closeFile();
+    return siz;
+}
+
+/* read the signature from a saved state file */
+fileSig(name)
+{
+    local f = File.openRawFile(name, FileAccessRead);
+    local b = new ByteArray(14);
+    f.readBytes(b);
+    f.closeFile();
+    return b.mapToString();
+}
+
+/* compute a simple checksum of everything in the data object */
+checksum()
+{
+    local sum = 0;
+    for (local i = 1 ; i <= data.vec.length() ; ++i)
+    {
+        local s = data.vec[i];
+        sum = (sum * 31 + s.length() + s.toUnicode(s.length())) % 1000003;
+    }
+    for (local i = 1 ; i <= data.bytes.length() ; ++i)
+        sum = (sum * 31 + data.bytes[i]) % 1000003;
+    sum = (sum * 31 + data.str.length()) % 1000003;
+    return sum;
+}
+
+main(args)
+{
+    /* build the data: repetitive strings, and random bytes */
+    local v = new Vector(20000);
+    for (local i = 0 ; i < 20000 ; ++i)
+        v.append('entry number ' + (i % 100));
+    data.vec = v;
+
+    local b = new ByteArray(100000);
+    for (local i = 1 ; i <= 100000 ; ++i)
+        b[i] = rng.next() & 0xff;
+    data.bytes = b;
+
+    data.str = makeString('abc', 10000);
+
+    local sum = checksum();
+    "checksum before save: <<sum>>\n";
+
+    /* save */
+    saveGame('savelz.t3v');
+    "signature: <<fileSig('savelz.t3v')>>\n";
+
+    /*
+     *   Uncompressed, the object data comes to about 850k.  The bytes are
+     *   mostly random and don't compress, but everything else does, so we
+     *   should come in at well under half of that.
+     */
+    local siz = fileSize('savelz.t3v');
+    "file is compressed: <<siz < 425000 ? 'yes' : 'no (' + siz + ')'>>\n";
+
+    /* change everything */
+    data.vec = new Vector(['changed']);
+    data.bytes = new ByteArray(1);
+    data.str = 'changed';
+    "checksum after change: <<checksum()>>\n";
+
+    /* restore, and make sure we got everything back */
+    restoreGame('savelz.t3v');
+    "checksum after restore: <<checksum()>>\n";
+    "restored correctly: <<checksum() == sum ? 'yes' : 'no'>>\n";
+    "vector length: <<data.vec.length()>>, last: <<data.vec[20000]>>\n";
+    "byte array length: <<data.bytes.length()>>\n";
+    "string length: <<data.str.length()>>\n";
+}
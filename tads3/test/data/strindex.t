@@ -0,0 +1,82 @@
+#include <tads.h>
+
+/*
+ *   String character index tests.  Long strings get a character index, so
+ *   the character-position methods work differently on them than on short
+ *   strings.  We run the same operations over a pure ASCII string and over
+ *   strings with two- and three-byte characters, at positions around the
+ *   index checkpoints and at both ends, and print a checksum of the
+ *   results so that any difference shows up.
+ */
+
+property sum;
+
+acc: object
+    sum = 0
+    add(x)
+    {
+        if (x == nil)
+            sum = (sum * 3 + 7) % 1000003;
+        else if (dataType(x) == TypeSString)
+            sum = (sum * 31 + x.length() * 7 + (x == '' ? 0 : x.toUnicode(1)))
+                  % 1000003;
+        else
+            sum = (sum * 31 + x) % 1000003;
+    }
+;
+
+/* build a test string of about n characters from the given alphabet */
+makeStr(alpha, n)
+{
+    local s = '';
+    for (local i = 0 ; i < n ; ++i)
+        s += alpha.substr(i % alpha.length() + 1, 1);
+    return s;
+}
+
+/* run the character-position methods at a series of positions */
+exercise(name, s)
+{
+    local n = s.length();
+    local pos = [1, 2, 63, 64, 65, 66, 127, 128, 129, n - 1, n, n + 1,
+                 n + 5, 0, -1, -2, -64, -65, -n, -n - 1, -n - 5];
+
+    acc.sum = 0;
+    foreach (local i in pos)
+    {
+        acc.add(s.substr(i));
+        acc.add(s.substr(i, 3));
+        acc.add(s.substr(i, 70));
+        acc.add(s.substr(i, -2));
+        acc.add(s.substr(i, -70));
+        acc.add(s.toUnicode(i));
+        acc.add(s.find(s.substr(100, 2), i));
+        acc.add(s.find(s.substr(-3), i));
+        acc.add(s.find('no such text', i));
+        acc.add(s.findLast(s.substr(100, 2), i));
+        acc.add(s.findLast(s.substr(2, 1), i));
+        acc.add(s.find(R'<alpha>', i));
+    }
+    acc.add(s.findLast(s.substr(100, 2)));
+    acc.add(s.findLast(s.substr(2, 1)));
+
+    /* walk the whole string a character at a time */
+    local ok = true;
+    local u = s.toUnicode();
+    for (local i = 1 ; i <= n ; ++i)
+    {
+        if (s.substr(i, 1).toUnicode(1) != u[i] || s.toUnicode(i) != u[i])
+            ok = nil;
+    }
+
+    "<<name>>: length <<n>>, checksum <<acc.sum>>, walk <<ok ? 'ok' : 'bad'>>\n";
+}
+
+main(args)
+{
+    exercise('ascii', makeStr('abcdefghijklmnopqrstuvwxyz', 500));
+    exercise('two-byte', makeStr('ab\u00e9c\u00f1d', 500));
+    exercise('three-byte', makeStr('a\u20acb\u2022\u00e9', 500));
+    exercise('stride', makeStr('\u20ac', 128));
+    exercise('short', makeStr('x\u00e9y', 40));
+}
@@ -0,0 +1,103 @@
+#include <tads.h>
+#include <strbuf.h>
+
+/*
+ *   Rope string tests.  Long concatenations are built as ropes and
+ *   flattened the first time the text is needed, so we build strings in
+ *   all of the ways that produce ropes - appending, prepending, joining two
+ *   ropes, appending non-string values - and check the results through the
+ *   various operations that flatten them.
+ */
+
+property val;
+
+holder: object
+    val = nil
+;
+
+/* build a string by appending numbered chunks */
+appendChunks(n)
+{
+    local s = '';
+    for (local i = 0 ; i < n ; ++i)
+        s += '[' + i + ']';
+    return s;
+}
+
+/* build the same string in reverse, by prepending */
+prependChunks(n)
+{
+    local s = '';
+    for (local i = n - 1 ; i >= 0 ; --i)
+        s = '[' + i + ']' + s;
+    return s;
+}
+
+/* build the same string with a StringBuffer, for comparison */
+bufferChunks(n)
+{
+    local b = new StringBuffer();
+    for (local i = 0 ; i < n ; ++i)
+        b.append('[' + i + ']');
+    return toString(b);
+}
+
+main(args)
+{
+    local a = appendChunks(1000);
+    local p = prependChunks(1000);
+    local b = bufferChunks(1000);
+
+    "Lengths: <<a.length()>> <<p.length()>> <<b.length()>>\n";
+    "Append equals buffer: <<a == b ? 'yes' : 'no'>>\n";
+    "Prepend equals buffer: <<p == b ? 'yes' : 'no'>>\n";
+
+    /* indexed access on fresh ropes */
+    a = appendChunks(500);
+    "Substr: <<a.substr(1000, 12)>>\n";
+    a = appendChunks(500);
+    "Find: <<a.find('[250]')>>\n";
+    a = appendChunks(500);
+    "Ends: <<a.endsWith('[499]') ? 'yes' : 'no'>>\n";
+
+    /* joining two ropes, and ropes that share operands */
+    local x = appendChunks(100);
+    local y = appendChunks(100);
+    local xy = x + y;
+    local xx = x + x;
+    "Joined: <<xy.length()>> <<xy == xx ? 'yes' : 'no'>>\n";
+    "Operand still intact: <<x.length()>> <<x.substr(1, 7)>>\n";
+
+    /* appending non-string values */
+    local s = appendChunks(100);
+    s = s + 12345 + nil + true + [1, 2, 3];
+    "Mixed: <<s.substr(-16)>>\n";
+
+    /* hashing - a rope key finds the flat string's entry */
+    local tab = new LookupTable();
+    tab[bufferChunks(200)] = 'found';
+    "Hash: <<tab[appendChunks(200)]>>\n";
+
+    /* comparison */
+    "Compare: <<appendChunks(200) < appendChunks(200) + 'x' ? 'yes' : 'no'>>\n";
+
+    /* unflattened ropes survive garbage collection */
+    holder.val = appendChunks(300);
+    for (local i = 0 ; i < 20000 ; ++i)
+        x = 'garbage ' + i;
+    t3RunGC();
+    "After GC: <<holder.val == bufferChunks(300) ? 'yes' : 'no'>>\n";
+
+    /* the length limit still applies */
+    try
+    {
+        s = appendChunks(10);
+        for (local i = 0 ; i < 20 ; ++i)
+            s += s;
+        "Too long: no error\n";
+    }
+    catch (RuntimeError e)
+    {
+        "Too long: <<e.errno_>>\n";
+    }
+}
@@ -0,0 +1,146 @@
+#include <tads.h>
+
+/*
+ *   Undo coalescing tests.  LookupTable and ByteArray keep only the oldest
+ *   undo record for each table entry or byte that's changed repeatedly
+ *   within one savepoint.  Undo has to restore the same state it did when
+ *   every change had its own record, including when entries are deleted and
+ *   added back within the savepoint, when the table expands, and when a
+ *   garbage collection runs in the middle of the changes.
+ */
+
+data: object
+    tab = static makeTable()
+    bytes = static new ByteArray(8)
+    makeTable()
+    {
+        local t = new LookupTable(4, 8);
+        t['a'] = 1;
+        t['b'] = 2;
+        t['c'] = 3;
+        return t;
+    }
+;
+
+/* show the contents of the objects */
+show(label)
+{
+    local t = data.tab, b = data.bytes;
+    local keys = t.keysToList().sort(SortAsc, { a, b:
+        toString(a).compareTo(toString(b)) });
+    "<<label>>: tab=[";
+    foreach (local k in keys)
+        "<<k == keys[1] ? '' : ' '>><<k>>=<<t[k]>>";
+    "] bytes=[";
+    for (local i = 1 ; i <= b.length() ; ++i)
+        "<<i > 1 ? ' ' : ''>><<b[i]>>";
+    "]\n";
+}
+
+main(args)
+{
+    local t = data.tab, b = data.bytes;
+
+    show('initial');
+
+    /* change the same entries and bytes over and over */
+    savepoint();
+    for (local i = 1 ; i <= 100 ; ++i)
+    {
+        t['a'] = i;
+        t['b'] += 1;
+        b[1] = i;
+        b[2] = i * 2;
+    }
+    show('changed');
+    undo();
+    show('undo repeated');
+
+    /* delete entries and add them back, sometimes under other keys */
+    savepoint();
+    t['a'] = 10;
+    t.removeElement('a');
+    t['a'] = 20;
+    t['a'] = 30;
+    t.removeElement('b');
+    t['x'] = 40;
+    t['x'] = 50;
+    t['c'] = 60;
+    t.removeElement('c');
+    t['y'] = 70;
+    t['y'] = 80;
+    show('changed');
+    undo();
+    show('undo delete/add');
+
+    /* expand the table while changing the original entries */
+    savepoint();
+    t['a'] = 100;
+    for (local i = 1 ; i <= 50 ; ++i)
+    {
+        t['k' + i] = i;
+        t['a'] = t['a'] + 1;
+        t['c'] = i;
+    }
+    "expanded to <<t.getEntryCount()>> entries\n";
+    undo();
+    show('undo expand');
+
+    /* garbage collection between changes */
+    savepoint();
+    t['b'] = new Vector(1);
+    t['b'] = 'bee';
+    b[3] = 33;
+    t3RunGC();
+    t['b'] = 'buzz';
+    b[3] = 44;
+    undo();
+    show('undo gc');
+
+    /* several savepoints, each changing the same entries */
+    savepoint();
+    t['a'] = 'one';
+    b[4] = 1;
+    savepoint();
+    t['a'] = 'two';
+    t['a'] = 'three';
+    b[4] = 2;
+    b[4] = 3;
+    savepoint();
+    t['a'] = 'four';
+    b[4] = 4;
+    local src = new ByteArray(3);
+    src.fillValue(9);
+    b.copyFrom(src, 1, 3, 3);
+    b[4] = 5;
+    show('three savepoints');
+    undo();
+    show('undo 3');
+    t['a'] = 'five';
+    b[4] = 6;
+    show('changed 2');
+    undo();
+    show('undo 2');
+    undo();
+    show('undo 1');
+
+    /* 
+     *   Change one entry and one byte 5000 times per savepoint.  Without
+     *   coalescing, each savepoint would fill the whole undo log, and only
+     *   the last one would survive.  
+     */
+    for (local sp = 1 ; sp <= 10 ; ++sp)
+    {
+        savepoint();
+        for (local i = 1 ; i <= 5000 ; ++i)
+        {
+            t['a'] = sp * 10000 + i;
+            b[1] = i & 255;
+        }
+    }
+    local n = 0;
+    while (undo())
+        ++n;
+    "undo levels kept: <<n>>\n";
+    show('undo all');
+}
@@ -189,6 +189,10 @@ void CVmImageLoader::discard_synth_exports()
 {
 }
 
+void CVmImageLoader::set_restart_state(class CVmStream *)
+{
+}
+
 vm_prop_id_t CVmImageLoader::alloc_new_prop(VMG0_)
 {
     return VM_INVALID_PROP;
@@ -65,6 +65,7 @@ CVmBifTADSGlobals::CVmBifTADSGlobals(VMG0_)
     /* allocate our regular expression parser */
     rex_parser = new CRegexParser();
     rex_searcher = new CRegexSearcherSimple(rex_parser);
+    rex_cache = new CRegexCache(rex_parser);
 
     /* 
      *   Allocate a global variable to hold the most recent regular
@@ -104,8 +105,9 @@ CVmBifTADSGlobals::CVmBifTADSGlobals(VMG0_)
  */
 CVmBifTADSGlobals::~CVmBifTADSGlobals()
 {
-    /* delete our regular expression searcher and parser */
+    /* delete our regular expression searcher, pattern cache, and parser */
     delete rex_searcher;
+    delete rex_cache;
     delete rex_parser;
 
     /* 
@@ -2517,10 +2519,29 @@ void CVmBifTADS::re_match(VMG_ uint argc)
     }
     else
     {
-        /* match the pattern to the regular expression string */
-        match_len = G_bif_tads_globals->rex_searcher->
-                    compile_and_match(pat_str + VMB_LEN, vmb_get_len(pat_str),
-                                      str + VMB_LEN, p.getptr(), len);
+        /* 
+         *   get the compiled pattern for the regular expression string from
+         *   the cache; if it doesn't compile, it doesn't match anything 
+         */
+        CRegexCache *cache = G_bif_tads_globals->rex_cache;
+        re_compiled_pattern *pat = cache->get(
+            pat_str + VMB_LEN, vmb_get_len(pat_str));
+        match_len = -1;
+        if (pat != 0)
+        {
+            err_try
+            {
+                /* match the compiled pattern */
+                match_len = G_bif_tads_globals->rex_searcher->
+                            match_pattern(pat, str + VMB_LEN, p.getptr(), len);
+            }
+            err_finally
+            {
+                /* done with the pattern */
+                cache->release(pat);
+            }
+            err_end;
+        }
     }
 
     /* check for a match */
@@ -2627,15 +2648,34 @@ template<int dir> inline void CVmBifTADS::re_search_common(VMG_ uint argc)
     }
     else
     {
-        /* try finding the regular expression string pattern */
-        match_idx =
-            (dir > 0
-             ? G_bif_tads_globals->rex_searcher->compile_and_search(
-                 pat_str + VMB_LEN, vmb_get_len(pat_str),
-                 str + VMB_LEN, p.getptr(), len, &match_len)
-             : G_bif_tads_globals->rex_searcher->compile_and_search_back(
-                 pat_str + VMB_LEN, vmb_get_len(pat_str),
-                 str + VMB_LEN, p.getptr(), len, &match_len));
+        /* 
+         *   get the compiled pattern for the regular expression string from
+         *   the cache; if it doesn't compile, it doesn't match anything 
+         */
+        CRegexCache *cache = G_bif_tads_globals->rex_cache;
+        re_compiled_pattern *pat = cache->get(
+            pat_str + VMB_LEN, vmb_get_len(pat_str));
+        match_idx = -1;
+        if (pat != 0)
+        {
+            err_try
+            {
+                /* try finding the compiled pattern */
+                match_idx =
+                    (dir > 0
+                     ? G_bif_tads_globals->rex_searcher->search_for_pattern(
+                         pat, str + VMB_LEN, p.getptr(), len, &match_len)
+                     : G_bif_tads_globals->rex_searcher
+                       ->search_back_for_pattern(
+                           pat, str + VMB_LEN, p.getptr(), len, &match_len));
+            }
+            err_finally
+            {
+                /* done with the pattern */
+                cache->release(pat);
+            }
+            err_end;
+        }
     }
 
     /* check for a match */
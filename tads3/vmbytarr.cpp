@@ -880,25 +880,34 @@ public:
 /*
  *   Save undo for a change to a range of the array 
  */
-void CVmObjByteArray::save_undo(VMG_ vm_obj_id_t self,
-                                unsigned long start_idx,
-                                unsigned long cnt)
+int CVmObjByteArray::save_undo(VMG_ vm_obj_id_t self,
+                               unsigned long start_idx,
+                               unsigned long cnt)
 {
     bytearray_undo_rec *rec;
     vm_val_t oldval;
+    size_t siz;
     
     /* create our key record - this contains the entire original value */
     rec = new bytearray_undo_rec(this, start_idx, cnt);
 
+    /* figure the memory it takes: the record plus the saved byte blocks */
+    siz = sizeof(*rec) + cnt
+          + (cnt + 32767)/32768 * sizeof(bytearray_undo_bytes);
+
     /* we don't use the old value for anything; use nil as a dummy */
     oldval.set_nil();
 
     /* add the undo record */
-    if (!G_undo->add_new_record_ptr_key(vmg_ self, rec, &oldval))
+    if (!G_undo->add_new_record_ptr_key(vmg_ self, rec, &oldval, siz))
     {
         /* failed to save the undo - discard our private key record */
         delete rec;
+        return FALSE;
     }
+
+    /* the record was saved */
+    return TRUE;
 }
 
 /*
@@ -1021,6 +1030,45 @@ void CVmObjByteArray::load_image_data(VMG_ const char *ptr, size_t siz)
     }
 }
 
+/*
+ *   Determine if we still match our image file data 
+ */
+int CVmObjByteArray::matches_image_data(VMG_ const char *ptr,
+                                        size_t siz) const
+{
+    unsigned long cnt = t3rp4u(ptr);
+    unsigned long idx;
+
+    /* 
+     *   we must have the same size, and the image data must supply all of
+     *   the bytes (if it's short, don't bother checking) 
+     */
+    if (cnt != get_element_count() || siz < 4 + cnt)
+        return FALSE;
+
+    /* compare the bytes, a chunk at a time */
+    for (ptr += 4, idx = 1 ; idx <= cnt ; )
+    {
+        size_t avail;
+        const unsigned char *p = get_ele_ptr(idx, &avail);
+
+        /* limit this chunk to the remaining size */
+        if (avail > cnt - idx + 1)
+            avail = (size_t)(cnt - idx + 1);
+
+        /* compare this chunk */
+        if (memcmp(p, ptr, avail) != 0)
+            return FALSE;
+
+        /* advance past this chunk */
+        idx += avail;
+        ptr += avail;
+    }
+
+    /* everything matches */
+    return TRUE;
+}
+
 /* ------------------------------------------------------------------------ */
 /* 
  *   save to a file 
@@ -1154,8 +1202,14 @@ int CVmObjByteArray::set_index_val_q(VMG_ vm_val_t *new_container,
     if (idx < 1 || (uint32_t)idx > get_element_count())
         err_throw(VMERR_INDEX_OUT_OF_RANGE);
 
-    /* save undo for the change */
-    save_undo(vmg_ self, idx, 1);
+    /* 
+     *   Save undo for the change, unless we already have undo for this
+     *   byte in the current savepoint - the older record will restore the
+     *   byte to its value as of the savepoint, so there's no need for
+     *   another one.  
+     */
+    if (!G_undo->is_key_saved(self, idx) && save_undo(vmg_ self, idx, 1))
+        G_undo->note_key_saved(self, idx);
 
     /* get the new value as an integer */
     int32_t new_byte = new_val->num_to_int(vmg0_);
@@ -203,6 +203,9 @@ public:
      */
     int is_changed_since_load() const { return TRUE; }
 
+    /* check to see if we still match our image file data */
+    int matches_image_data(VMG_ const char *ptr, size_t siz) const;
+
     /* get the number of elements in the array */
     unsigned long get_element_count() const
         { return t3rp4u(get_ext_ptr()); }
@@ -431,9 +434,12 @@ protected:
                          class CVmObjString *str, size_t str_len,
                          class CCharmapToUni *mapper);
     
-    /* save undo for a change to a range of the array */
-    void save_undo(VMG_ vm_obj_id_t self, unsigned long start_idx,
-                   unsigned long cnt);
+    /* 
+     *   save undo for a change to a range of the array; returns true if we
+     *   saved an undo record, false if undo isn't being kept 
+     */
+    int save_undo(VMG_ vm_obj_id_t self, unsigned long start_idx,
+                  unsigned long cnt);
 
     /* set the number of bytes in the array */
     void set_element_count(unsigned long cnt)
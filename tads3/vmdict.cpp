@@ -245,6 +245,9 @@ CVmObjDict::CVmObjDict(VMG0_)
     /* no Trie yet */
     get_ext()->trie_ = 0;
 
+    /* no key index yet */
+    get_ext()->keyidx_ = 0;
+
     /* no non-image entries yet */
     get_ext()->modified_ = FALSE;
 
@@ -270,6 +273,10 @@ void CVmObjDict::notify_delete(VMG_ int /*in_root_set*/)
         if (get_ext()->trie_ != 0)
             delete get_ext()->trie_;
 
+        /* free our key index */
+        if (get_ext()->keyidx_ != 0)
+            delete get_ext()->keyidx_;
+
         /* free the extension */
         G_mem->get_var_heap()->free_mem(ext_);
     }
@@ -386,6 +393,16 @@ void CVmObjDict::create_hash_table(VMG0_)
         get_ext()->trie_ = 0;
     }
 
+    /* 
+     *   likewise the key index - the key hashes depend on the comparator,
+     *   so we'll have to rebuild it from scratch 
+     */
+    if (get_ext()->keyidx_ != 0)
+    {
+        delete get_ext()->keyidx_;
+        get_ext()->keyidx_ = 0;
+    }
+
     /* store the new hash table in the extension */
     get_ext()->hashtab_ = new_tab;
 }
@@ -857,7 +874,6 @@ int CVmObjDict::getp_find(VMG_ vm_obj_id_t, vm_val_t *val, uint *argc)
     const char *strp;
     size_t strl;
     vm_prop_id_t voc_prop;
-    unsigned int hash;
 
     /* check arguments */
     if (get_prop_check_argc(val, argc, &desc))
@@ -888,12 +904,9 @@ int CVmObjDict::getp_find(VMG_ vm_obj_id_t, vm_val_t *val, uint *argc)
     else
         err_throw(VMERR_PROPPTR_VAL_REQD);
 
-    /* calculate the hash value */
-    hash = calc_str_hash(vmg_ arg0, strp, strl);
-
-    /* enumerate everything that matches the string's hash code */
+    /* enumerate everything that could match the string */
     find_ctx ctx(vmg_ this, arg0, strp, strl, voc_prop);
-    get_ext()->hashtab_->enum_hash_matches(hash, &find_cb, &ctx);
+    enum_word_matches(vmg_ arg0, strp, strl, &find_cb, &ctx);
 
     /* build a list out of the results, and return the list */
     val->set_obj(ctx.results_to_list(vmg0_));
@@ -1213,7 +1226,6 @@ int CVmObjDict::getp_is_defined(VMG_ vm_obj_id_t self, vm_val_t *val,
     const char *strp;
     size_t strl;
     vm_val_t filter;
-    unsigned int hash;
     
     /* check arguments */
     if (get_prop_check_argc(val, argc, &desc))
@@ -1243,13 +1255,10 @@ int CVmObjDict::getp_is_defined(VMG_ vm_obj_id_t self, vm_val_t *val,
         filter.set_nil();
     }
 
-    /* calculate the hash code */
-    hash = calc_str_hash(vmg_ arg0, strp, strl);
-
     /* enumerate matches for the string */
     isdef_ctx ctx(vmg_ this, &filter, arg0, strp, strl);
     ctx.rc.init(vmg_ "Dict.isDefined", self, 5, arg0, orig_argc);
-    get_ext()->hashtab_->enum_hash_matches(hash, &isdef_cb, &ctx);
+    enum_word_matches(vmg_ arg0, strp, strl, &isdef_cb, &ctx);
 
     /* if we found any matches, return true; otherwise, return nil */
     val->set_logical(ctx.found);
@@ -1854,7 +1863,8 @@ void CVmObjDict::add_undo_rec(VMG_ vm_obj_id_t self, dict_undo_rec *rec)
 
     /* add the record with an empty value */
     val.set_empty();
-    if (!G_undo->add_new_record_ptr_key(vmg_ self, rec, &val))
+    if (!G_undo->add_new_record_ptr_key(
+        vmg_ self, rec, &val, sizeof(dict_undo_rec) + rec->len))
     {
         /* 
          *   we didn't add an undo record, so our extra undo information
@@ -2060,6 +2070,7 @@ void CVmObjDict::remove_weak_ref_cb(void *ctx0, CVmHashEntry *entry0)
 
             /* delete the entry */
             entry->del_entry(ctx->dict->get_ext()->hashtab_,
+                             ctx->dict->get_ext()->keyidx_,
                              cur->obj_, cur->prop_);
         }
     }
@@ -2347,6 +2358,241 @@ void vmdict_TrieNode::del_word(const char *str, size_t len)
 }
 
 
+/* ------------------------------------------------------------------------ */
+/*
+ *   Key index operations 
+ */
+
+/* create, with room for the given number of entries */
+vmdict_KeyIndex::vmdict_KeyIndex(size_t cnt)
+{
+    size_t i;
+
+    /* use a power of two at least as large as the count, with a minimum */
+    for (size = 256 ; size < cnt ; size <<= 1) ;
+
+    /* allocate and clear the buckets */
+    tab = new CVmHashEntryDict *[size];
+    for (i = 0 ; i < size ; ++i)
+        tab[i] = 0;
+
+    /* no entries yet */
+    this->cnt = 0;
+}
+
+/* 
+ *   Add an entry.  The hash table adds new entries at the head of the
+ *   bucket, so we do the same; that way, entries with the same key are in
+ *   the same order here as in the hash table, and we find matches in the
+ *   same order the hash table would.  
+ */
+void vmdict_KeyIndex::add(CVmHashEntryDict *entry, unsigned int key)
+{
+    /* link it at the head of its bucket */
+    CVmHashEntryDict **b = &tab[key & (size - 1)];
+    entry->key_ = key;
+    entry->key_nxt_ = *b;
+    *b = entry;
+
+    /* count it */
+    ++cnt;
+}
+
+/* 
+ *   Add an entry at the end of its bucket.  We use this when building the
+ *   index from the hash table, to keep entries in their hash table order.  
+ */
+void vmdict_KeyIndex::append(CVmHashEntryDict *entry, unsigned int key)
+{
+    /* find the end of the bucket and link it there */
+    CVmHashEntryDict **b;
+    for (b = &tab[key & (size - 1)] ; *b != 0 ; b = &(*b)->key_nxt_) ;
+    entry->key_ = key;
+    entry->key_nxt_ = 0;
+    *b = entry;
+
+    /* count it */
+    ++cnt;
+}
+
+/* remove an entry */
+void vmdict_KeyIndex::remove(CVmHashEntryDict *entry)
+{
+    /* find the entry in its bucket and unlink it */
+    for (CVmHashEntryDict **b = &tab[entry->key_ & (size - 1)] ; *b != 0 ;
+         b = &(*b)->key_nxt_)
+    {
+        if (*b == entry)
+        {
+            *b = entry->key_nxt_;
+            --cnt;
+            break;
+        }
+    }
+}
+
+/* enumerate the entries with the given key hash */
+void vmdict_KeyIndex::enum_matches(unsigned int key,
+                                   void (*cb)(void *, CVmHashEntry *),
+                                   void *cbctx)
+{
+    CVmHashEntryDict *cur, *nxt;
+
+    /* 
+     *   run through the bucket, skipping entries that just happen to share
+     *   the bucket; note the next entry before each callback, in case the
+     *   callback deletes the current one 
+     */
+    for (cur = tab[key & (size - 1)] ; cur != 0 ; cur = nxt)
+    {
+        nxt = cur->key_nxt_;
+        if (cur->key_ == key)
+            (*cb)(cbctx, cur);
+    }
+}
+
+/* grow the bucket array if it's getting full */
+void vmdict_KeyIndex::check_size()
+{
+    size_t i, new_size;
+
+    /* if we have no more entries than buckets, we're fine as we are */
+    if (cnt <= size)
+        return;
+
+    /* double the size until we have room */
+    for (new_size = size ; new_size < cnt ; new_size <<= 1) ;
+
+    /* allocate and clear the new buckets */
+    CVmHashEntryDict **new_tab = new CVmHashEntryDict *[new_size];
+    for (i = 0 ; i < new_size ; ++i)
+        new_tab[i] = 0;
+
+    /* 
+     *   move each entry to the end of its bucket in the new array, which
+     *   keeps entries with the same key in the same order 
+     */
+    for (i = 0 ; i < size ; ++i)
+    {
+        CVmHashEntryDict *cur, *nxt, **b;
+        for (cur = tab[i] ; cur != 0 ; cur = nxt)
+        {
+            nxt = cur->key_nxt_;
+            for (b = &new_tab[cur->key_ & (new_size - 1)] ; *b != 0 ;
+                 b = &(*b)->key_nxt_) ;
+            cur->key_nxt_ = 0;
+            *b = cur;
+        }
+    }
+
+    /* replace the old array */
+    delete [] tab;
+    tab = new_tab;
+    size = new_size;
+}
+
+/*
+ *   Callback context for key-index-building enumeration 
+ */
+struct keyidx_cb_ctx
+{
+    CVmObjDict *dict;
+    vmdict_KeyIndex *idx;
+    size_t cnt;
+};
+
+/* hash table enumeration callback for counting entries */
+static void keyidx_count_cb(void *ctx0, CVmHashEntry *)
+{
+    ((keyidx_cb_ctx *)ctx0)->cnt += 1;
+}
+
+/* hash table enumeration callback for building the key index */
+void CVmObjDict::keyidx_cb(void *ctx0, CVmHashEntry *entry0)
+{
+    keyidx_cb_ctx *ctx = (keyidx_cb_ctx *)ctx0;
+    CVmHashEntryDict *entry = (CVmHashEntryDict *)entry0;
+
+    /* add this entry to the index, in hash table order */
+    ctx->idx->append(entry, ctx->dict->calc_key_hash(
+        entry->getstr(), entry->getlen()));
+}
+
+/*
+ *   Build the key index from the hash table 
+ */
+void CVmObjDict::build_key_index(VMG0_)
+{
+    keyidx_cb_ctx ctx;
+
+    /* if we already have an index, there's nothing to do */
+    if (get_ext()->keyidx_ != 0)
+        return;
+
+    /* count the entries, so that we can size the index to fit */
+    ctx.dict = this;
+    ctx.cnt = 0;
+    get_ext()->hashtab_->enum_entries(keyidx_count_cb, &ctx);
+
+    /* create the index and add each entry */
+    ctx.idx = get_ext()->keyidx_ = new vmdict_KeyIndex(ctx.cnt);
+    get_ext()->hashtab_->enum_entries(keyidx_cb, &ctx);
+}
+
+/*
+ *   Calculate the key hash for a string.  With a StringComparator, the
+ *   comparator does the work, since it knows which strings match.  With no
+ *   comparator, strings only match if they're identical, so we simply hash
+ *   the bytes (with FNV-1a).  
+ */
+unsigned int CVmObjDict::calc_key_hash(const char *str, size_t len) const
+{
+    if (get_ext()->comparator_type_ == VMDICT_COMP_STRCOMP)
+    {
+        return ((CVmObjStrComp *)get_ext()->comparator_obj_)->calc_key_hash(
+            str, len);
+    }
+    else
+    {
+        unsigned int key = 2166136261U;
+        for ( ; len != 0 ; ++str, --len)
+        {
+            key ^= (unsigned char)*str;
+            key *= 16777619U;
+        }
+        return key;
+    }
+}
+
+/*
+ *   Enumerate the hash table entries that could match a string 
+ */
+void CVmObjDict::enum_word_matches(VMG_ const vm_val_t *strval,
+                                   const char *str, size_t len,
+                                   void (*cb)(void *, CVmHashEntry *),
+                                   void *cbctx)
+{
+    /* 
+     *   with a generic comparator, all we can do is enumerate the entries
+     *   that share the string's hash code in the hash table 
+     */
+    if (get_ext()->comparator_type_ == VMDICT_COMP_GENERIC)
+    {
+        get_ext()->hashtab_->enum_hash_matches(
+            calc_str_hash(vmg_ strval, str, len), cb, cbctx);
+        return;
+    }
+
+    /* build the key index if we haven't already, or make sure it fits */
+    if (get_ext()->keyidx_ == 0)
+        build_key_index(vmg0_);
+    else
+        get_ext()->keyidx_->check_size();
+
+    /* enumerate the entries with the string's key hash */
+    get_ext()->keyidx_->enum_matches(calc_key_hash(str, len), cb, cbctx);
+}
+
 /* ------------------------------------------------------------------------ */
 /*
  *   Add an entry 
@@ -2372,6 +2618,10 @@ int CVmObjDict::add_hash_entry(VMG_ const char *p, size_t len, int copy,
         /* if we have a trie, add it to the trie */
         if (get_ext()->trie_ != 0)
             get_ext()->trie_->add_word(p, len);
+
+        /* if we have a key index, add it to the index */
+        if (get_ext()->keyidx_ != 0)
+            get_ext()->keyidx_->add(entry, calc_key_hash(p, len));
     }
 
     /* add the obj/prop to the entry's item list */
@@ -2398,7 +2648,8 @@ int CVmObjDict::del_hash_entry(VMG_ const char *str, size_t len,
             get_ext()->trie_->del_word(str, len);
         
         /* delete the hash table entry */
-        return entry->del_entry(get_ext()->hashtab_, obj, voc_prop);
+        return entry->del_entry(get_ext()->hashtab_, get_ext()->keyidx_,
+                                obj, voc_prop);
     }
 
     /* we didn't find anything to delete */
@@ -2428,6 +2679,13 @@ void CVmObjDict::reset_to_image(VMG_ vm_obj_id_t self)
         get_ext()->trie_ = 0;
     }
 
+    /* delete the key index */
+    if (get_ext()->keyidx_ != 0)
+    {
+        delete get_ext()->keyidx_;
+        get_ext()->keyidx_ = 0;
+    }
+
     /* rebuild the hash table from the image file data */
     build_hash_from_image(vmg0_);
 
@@ -2580,6 +2838,13 @@ void CVmObjDict::restore_from_file(VMG_ vm_obj_id_t self,
         get_ext()->trie_ = 0;
     }
 
+    /* delete the key index if we have one */
+    if (get_ext()->keyidx_ != 0)
+    {
+        delete get_ext()->keyidx_;
+        get_ext()->keyidx_ = 0;
+    }
+
     /* 
      *   Read the comparator and fix it up to the new object numbering
      *   scheme, but do not install it (as it might not be loaded yet).  
@@ -2720,7 +2985,6 @@ void CVmObjDict::enum_word_props(VMG_
                                  const char *strp, size_t strl)
 {
     enum_word_props_ctx ctx;
-    unsigned int hash;
 
     /* set up the enumeration callback context */
     ctx.strval = strval;
@@ -2731,10 +2995,7 @@ void CVmObjDict::enum_word_props(VMG_
     ctx.globals = VMGLOB_ADDR;
     ctx.dict = this;
 
-    /* calculate the hash code */
-    hash = calc_str_hash(vmg_ strval, strp, strl);
-
     /* enumerate the matches */
-    get_ext()->hashtab_->enum_hash_matches(hash, &enum_word_props_cb, &ctx);
+    enum_word_matches(vmg_ strval, strp, strl, &enum_word_props_cb, &ctx);
 }
 
@@ -121,6 +121,9 @@ struct vm_dict_ext
 
     /* Trie of our entries, for spelling correction */
     struct vmdict_TrieNode *trie_;
+
+    /* index of our entries by key hash, for lookups */
+    struct vmdict_KeyIndex *keyidx_;
 };
 
 
@@ -199,6 +202,61 @@ struct vmdict_TrieNode
 };
 
 
+/* ------------------------------------------------------------------------ */
+/*
+ *   For lookups, we also index the hash table entries by key hash.  The
+ *   hash table's own hash codes come from the comparator's calcHash(),
+ *   which for a StringComparator is simply the sum of the characters up to
+ *   the truncation length.  That sends a lot of different words to the
+ *   same bucket - all of the anagrams, for a start - and a lookup has to
+ *   run the comparator against every word in the bucket.  The key hash
+ *   covers the same folded and truncated characters, so every word that
+ *   matches a given string still has the same key hash as the string, but
+ *   it mixes the characters properly, so there are very few collisions.
+ *   
+ *   We can't compute key hashes with a generic comparator, since all we
+ *   know about its hash codes is what its calcHash() method tells us, so
+ *   we only build the index with a StringComparator or with no
+ *   comparator.  Like the Trie, we build the index the first time we need
+ *   it, and then keep it up to date as words are added and removed.  
+ */
+struct vmdict_KeyIndex
+{
+    vmdict_KeyIndex(size_t cnt);
+    ~vmdict_KeyIndex() { delete [] tab; }
+
+    /* add an entry with the given key hash, at the head of its bucket */
+    void add(class CVmHashEntryDict *entry, unsigned int key);
+
+    /* add an entry with the given key hash, at the end of its bucket */
+    void append(class CVmHashEntryDict *entry, unsigned int key);
+
+    /* remove an entry */
+    void remove(class CVmHashEntryDict *entry);
+
+    /* enumerate the entries with the given key hash */
+    void enum_matches(unsigned int key,
+                      void (*cb)(void *cbctx, class CVmHashEntry *entry),
+                      void *cbctx);
+
+    /* 
+     *   Grow the bucket array if we have more entries than buckets.  We do
+     *   this before each lookup rather than on each addition, so that the
+     *   buckets never get rearranged in the middle of an enumeration.  
+     */
+    void check_size();
+
+    /* the bucket array */
+    class CVmHashEntryDict **tab;
+
+    /* number of buckets (always a power of two) */
+    size_t size;
+
+    /* number of entries */
+    size_t cnt;
+};
+
+
 /* ------------------------------------------------------------------------ */
 /*
  *   Dictionary object interface 
@@ -365,6 +423,22 @@ protected:
     /* build the Trie from the hash table */
     void build_trie(VMG0_);
 
+    /* build the key index from the hash table */
+    void build_key_index(VMG0_);
+
+    /* calculate the key hash for a string, for the key index */
+    unsigned int calc_key_hash(const char *str, size_t len) const;
+
+    /* 
+     *   Enumerate the hash table entries that could match a string.  This
+     *   uses the key index if we can, otherwise the hash table.  'strval'
+     *   can be null, as in calc_str_hash().  
+     */
+    void enum_word_matches(VMG_ const vm_val_t *strval,
+                           const char *str, size_t len,
+                           void (*cb)(void *cbctx, class CVmHashEntry *entry),
+                           void *cbctx);
+
     /* property evaluation - undefined property */
     int getp_undef(VMG_ vm_obj_id_t, vm_val_t *, uint *) { return FALSE; }
 
@@ -377,6 +451,9 @@ protected:
     /* enumeration callback for enum_word_props */
     static void enum_word_props_cb(void *ctx, class CVmHashEntry *entry);
 
+    /* enumeration callback for build_key_index */
+    static void keyidx_cb(void *ctx, class CVmHashEntry *entry);
+
     /* property evaluation - set the comparator object */
     int getp_set_comparator(VMG_ vm_obj_id_t, vm_val_t *val, uint *argc);
 
@@ -474,12 +551,18 @@ struct vm_dict_entry
  */
 class CVmHashEntryDict: public CVmHashEntryCS
 {
+    friend struct vmdict_KeyIndex;
+
 public:
     CVmHashEntryDict(const char *str, size_t len, int copy, int from_image)
         : CVmHashEntryCS(str, len, copy || from_image)
     {
         /* nothing in our item list yet */
         list_ = 0;
+
+        /* we're not in a key index yet */
+        key_ = 0;
+        key_nxt_ = 0;
     }
 
     ~CVmHashEntryDict()
@@ -561,9 +644,12 @@ public:
 
     /* 
      *   Delete all entries matching a given object ID from our list.
-     *   Returns true if any entries were deleted, false if not. 
+     *   Returns true if any entries were deleted, false if not.  If this
+     *   leaves our list empty, we remove ourselves from the table and from
+     *   the key index, if there is one.  
      */
-    int del_entry(CVmHashTable *table, vm_obj_id_t obj, vm_prop_id_t prop)
+    int del_entry(CVmHashTable *table, vmdict_KeyIndex *keyidx,
+                  vm_obj_id_t obj, vm_prop_id_t prop)
     {
         vm_dict_entry *cur;
         vm_dict_entry *nxt;
@@ -597,8 +683,10 @@ public:
         /* if our list is now empty, delete myself from the table */
         if (list_ == 0)
         {
-            /* remove myself from the table */
+            /* remove myself from the table and the key index */
             table->remove(this);
+            if (keyidx != 0)
+                keyidx->remove(this);
 
             /* delete myself */
             delete this;
@@ -611,6 +699,10 @@ public:
 protected:
     /* list of associated objects */
     vm_dict_entry *list_;
+
+    /* our key hash, and the next entry in our key index bucket */
+    unsigned int key_;
+    CVmHashEntryDict *key_nxt_;
 };
 
 
@@ -29,6 +29,12 @@ Modified
 /*
  *   VM external file interface.  The VM uses this interface for
  *   manipulating files that contain program images and saved state. 
+ *   
+ *   A file object normally works directly on an OS file handle, but it can
+ *   also be set up to read and write through a generic stream (see
+ *   CVmStream below) instead.  This lets code written in terms of CVmFile,
+ *   such as the saved state readers and writers, work on memory buffers
+ *   and filtered streams.  
  */
 
 class CVmFile
@@ -39,6 +45,7 @@ public:
     {
         /* no file yet */
         fp_ = 0;
+        stream_ = 0;
 
         /* presume the base seek position is at the start of the file */
         seek_base_ = 0;
@@ -47,9 +54,21 @@ public:
     CVmFile(osfildef *fp, long seek_base)
     {
         fp_ = fp;
+        stream_ = 0;
         seek_base_ = seek_base;
     }
 
+    /* 
+     *   create a file object that reads and writes through a stream; the
+     *   caller retains ownership of the stream 
+     */
+    CVmFile(class CVmStream *stream)
+    {
+        fp_ = 0;
+        stream_ = stream;
+        seek_base_ = 0;
+    }
+
     /* 
      *   Duplicate the file handle, a la stdio freopen().  'mode' is a
      *   simplified fopen()-style mode string, with the same syntax as used
@@ -57,6 +76,10 @@ public:
      */
     CVmFile *dup(const char *mode)
     {
+        /* we can't duplicate a stream */
+        if (stream_ != 0)
+            return 0;
+
         /* duplicate our file handle */
         osfildef *fpdup = osfdup(fp_, mode);
         if (fpdup == 0)
@@ -103,6 +126,13 @@ public:
         fp_ = 0;
     }
 
+    /* 
+     *   Get the underlying OS file handle and the base seek position.  The
+     *   file handle is null if we're working through a stream.  
+     */
+    osfildef *get_osfp() const { return fp_; }
+    long get_seek_base() const { return seek_base_; }
+
     /* 
      *   Open an existing file for reading.  Throws an error if the file
      *   does not exist.  
@@ -118,14 +148,15 @@ public:
     /* close the underlying file */
     void close()
     {
-        osfcls(fp_);
+        if (fp_ != 0)
+            osfcls(fp_);
         fp_ = 0;
     }
 
     /* flush buffers */
     void flush()
     {
-        if (osfflush(fp_))
+        if (stream_ == 0 && osfflush(fp_))
             err_throw(VMERR_WRITE_FILE);
     }
 
@@ -142,7 +173,9 @@ public:
     /* read bytes - throws an error if all of the bytes cannot be read */
     void read_bytes(char *buf, size_t buflen)
     {
-        if (buflen != 0 && osfrb(fp_, buf, buflen))
+        if (stream_ != 0)
+            stream_read_bytes(buf, buflen);
+        else if (buflen != 0 && osfrb(fp_, buf, buflen))
             err_throw(VMERR_READ_FILE);
     }
 
@@ -156,12 +189,18 @@ public:
      */
     size_t read_nbytes(char *buf, size_t buflen)
     {
+        if (stream_ != 0)
+            return stream_read_nbytes(buf, buflen);
         return buflen == 0 ? 0 : osfrbc(fp_, buf, buflen);
     }
 
     /* read a line (fgets semantics) */
     char *read_line(char *buf, size_t buflen)
-        { return osfgets(buf, buflen, fp_); }
+    {
+        if (stream_ != 0)
+            return stream_read_line(buf, buflen);
+        return osfgets(buf, buflen, fp_);
+    }
 
     /* 
      *   read a string with a one-byte length prefix, adding a null
@@ -256,30 +295,67 @@ public:
     /* write bytes - throws an error if the bytes cannot be written */
     void write_bytes(const char *buf, size_t buflen)
     {
-        if (buflen != 0 && osfwb(fp_, buf, buflen))
+        if (stream_ != 0)
+            stream_write_bytes(buf, buflen);
+        else if (buflen != 0 && osfwb(fp_, buf, buflen))
             err_throw(VMERR_WRITE_FILE);
     }
 
     /* get the current seek position */
-    long get_pos() const { return osfpos(fp_) - seek_base_; }
+    long get_pos() const
+    {
+        if (stream_ != 0)
+            return stream_get_pos();
+        return osfpos(fp_) - seek_base_;
+    }
 
     /* seek to a new position */
     void set_pos(long seekpos)
     {
         /* seek relative to the base seek position */
-        osfseek(fp_, seekpos + seek_base_, OSFSK_SET);
+        if (stream_ != 0)
+            stream_set_pos(seekpos);
+        else
+            osfseek(fp_, seekpos + seek_base_, OSFSK_SET);
     }
 
     /* seek to a position relative to the end of the file */
-    void set_pos_from_eof(long pos) { osfseek(fp_, pos, OSFSK_END); }
+    void set_pos_from_eof(long pos)
+    {
+        if (stream_ != 0)
+            stream_set_pos(stream_get_len() + pos);
+        else
+            osfseek(fp_, pos, OSFSK_END);
+    }
 
     /* seek to a position relative to the current file position */
-    void set_pos_from_cur(long pos) { osfseek(fp_, pos, OSFSK_CUR); }
+    void set_pos_from_cur(long pos)
+    {
+        if (stream_ != 0)
+            stream_set_pos(stream_get_pos() + pos);
+        else
+            osfseek(fp_, pos, OSFSK_CUR);
+    }
 
 protected:
+    /* 
+     *   Stream operations.  These simply call the corresponding CVmStream
+     *   methods; they're defined below, after CVmStream.  
+     */
+    void stream_read_bytes(char *buf, size_t buflen);
+    size_t stream_read_nbytes(char *buf, size_t buflen);
+    char *stream_read_line(char *buf, size_t buflen);
+    void stream_write_bytes(const char *buf, size_t buflen);
+    long stream_get_pos() const;
+    void stream_set_pos(long pos);
+    long stream_get_len() const;
+
     /* our underlying OS file handle */
     osfildef *fp_;
 
+    /* our underlying stream, if we're working through a stream */
+    class CVmStream *stream_;
+
     /* 
      *   Base seek position - this is useful for virtual byte streams that
      *   are embedded in larger files (resource files, for example).
@@ -376,6 +452,24 @@ public:
     virtual long get_len() = 0;
 };
 
+/*
+ *   CVmFile stream operations 
+ */
+inline void CVmFile::stream_read_bytes(char *buf, size_t buflen)
+    { stream_->read_bytes(buf, buflen); }
+inline size_t CVmFile::stream_read_nbytes(char *buf, size_t buflen)
+    { return stream_->read_nbytes(buf, buflen); }
+inline char *CVmFile::stream_read_line(char *buf, size_t buflen)
+    { return stream_->read_line(buf, buflen); }
+inline void CVmFile::stream_write_bytes(const char *buf, size_t buflen)
+    { stream_->write_bytes(buf, buflen); }
+inline long CVmFile::stream_get_pos() const
+    { return stream_->get_seek_pos(); }
+inline void CVmFile::stream_set_pos(long pos)
+    { stream_->set_seek_pos(pos); }
+inline long CVmFile::stream_get_len() const
+    { return stream_->get_len(); }
+
 /*
  *   Implementation of the generic stream with an underlying CVmFile object 
  */
@@ -941,28 +1035,25 @@ public:
             /* at start of file */
             pos = 0;
         }
-        else if (pos >= len_)
+        else if (pos > len_)
         {
-            /* 
-             *   At end of file.  This is a special case for setting the
-             *   block pointer, because we could be positioned at the last
-             *   byte of the last block, which we won't find in our scan.
-             *   Explicitly set the position here.  
-             */
+            /* past end of file - limit it to the end of file */
             pos = len_;
-            cur_block_ = last_block_;
-            cur_block_ofs_ = pos - last_block_->ofs;
-
-            /* we've set the block position, so skip the usual search */
-            return;
         }
 
-        /* find the block containing the seek offset */
+        /* 
+         *   Find the block containing the seek offset.  Note that we could
+         *   be positioned just past the last byte of the last block, which
+         *   is part of no block; we use the last block for that.  We can't
+         *   simply use the last block for any position at end of file,
+         *   since we might have allocated blocks in advance that are past
+         *   the end of the data.  
+         */
         CVmExpandableMemoryStreamBlock *b;
         for (b = first_block_ ; b != 0 ; b = b->nxt)
         {
             /* if the offset is within this block, we're done */
-            if (pos >= b->ofs && pos < b->ofs + BlockLen)
+            if (pos >= b->ofs && (pos < b->ofs + BlockLen || b->nxt == 0))
             {
                 /* set the current pointers */
                 cur_block_ = b;
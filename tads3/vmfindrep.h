@@ -71,6 +71,7 @@ struct re_replace_arg
     {
         s = 0;
         pat = 0;
+        cache = 0;
         pat_str = 0;
         rpl_func.set_nil();
         match_valid = FALSE;
@@ -78,9 +79,9 @@ struct re_replace_arg
 
     ~re_replace_arg()
     {
-        /* if we created the pattern object, delete it */
-        if (pat != 0 && our_pat)
-            CRegexParser::free_pattern(pat);
+        /* if we got the pattern from the pattern cache, release it */
+        if (pat != 0 && cache != 0)
+            cache->release(pat);
         if (s != 0)
             delete s;
     }
@@ -102,9 +103,6 @@ struct re_replace_arg
             /* it's a pattern object - get its compiled pattern structure */
             pat = ((CVmObjPattern *)vm_objp(vmg_ patv->val.obj))
                   ->get_pattern(vmg0_);
-
-            /* we didn't create the pattern object */
-            our_pat = FALSE;
         }
         else if ((str = patv->get_as_string(vmg0_)) != 0)
         {
@@ -114,17 +112,13 @@ struct re_replace_arg
                 /* create the searcher */
                 create_searcher(vmg0_);
 
-                /* we treat strings as regular expressions - compile it */
-                re_status_t stat;
-                stat = G_bif_tads_globals->rex_parser->compile_pattern(
-                    str + VMB_LEN, vmb_get_len(str), &pat);
-
-                /* if that failed, we don't have a pattern */
-                if (stat != RE_STATUS_SUCCESS)
-                    pat = 0;
-
-                /* make a note that we allocated the pattern */
-                our_pat = TRUE;
+                /* 
+                 *   we treat strings as regular expressions - get the
+                 *   compiled pattern from the cache (this leaves 'pat' null
+                 *   if it doesn't compile) 
+                 */
+                cache = G_bif_tads_globals->rex_cache;
+                pat = cache->get(str + VMB_LEN, vmb_get_len(str));
             }
             else
             {
@@ -272,8 +266,11 @@ struct re_replace_arg
     /* our search string, or null if we're searching for a pattern */
     const char *pat_str;
 
-    /* Did we create the pattern?  If so, delete it on destruction. */
-    int our_pat;
+    /* 
+     *   the pattern cache we got the pattern from, if any; we release the
+     *   pattern back to the cache on destruction 
+     */
+    class CRegexCache *cache;
 
     /* our replacement string, or null if it's a callback function */
     const char *rpl_str;
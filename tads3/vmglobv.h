@@ -121,6 +121,9 @@ VM_GLOBALS_BEGIN
     /* TadsObject inheritance path analysis queue */
     VM_GLOBAL_PREOBJDEF(class CVmObjTadsInhQueue, tadsobj_queue)
 
+    /* TadsObject inline property cache */
+    VM_GLOBAL_PREOBJDEF(class CVmObjTadsPropCache, tadsobj_ic)
+
     /* dynamic compiler */
     VM_GLOBAL_OBJDEF(class CVmDynamicCompiler, dyncomp)
 
@@ -161,6 +164,12 @@ VM_GLOBALS_BEGIN
    /* time zone cache */
    VM_GLOBAL_OBJDEF(class CVmTimeZoneCache, tzcache)
 
+   /* string character index cache */
+   VM_GLOBAL_OBJDEF(class CVmStrIndexCache, str_index)
+
+   /* grammar production parsing arena */
+   VM_GLOBAL_OBJDEF(class CVmGramProdMem, gram_arena)
+
     /* size of header of each method's debug table */
    VM_GLOBAL_VARDEF(size_t, dbg_hdr_size)
 
@@ -80,167 +80,6 @@ struct vmgram_undo_rec
 };
 
 
-/* ------------------------------------------------------------------------ */
-/*
- *   Grammar production object - memory pool.  This is a simple
- *   suballocator that obtains large blocks from the system allocator,
- *   then hands out pieces of those blocks.  Allocating is very cheap
- *   (just a pointer increment in most cases), and we don't track
- *   individual allocations and deletions but just throw away all
- *   suballocated memory at once.  
- */
-
-/* size of each memory block */
-const size_t VMGRAMPROD_MEM_BLOCK_SIZE = 16*1024;
-
-/*
- *   memory pool block 
- */
-struct CVmGramProdMemBlock
-{
-    /* next block in chain */
-    CVmGramProdMemBlock *nxt_;
-
-    /* bytes of the block */
-    char buf_[VMGRAMPROD_MEM_BLOCK_SIZE];
-};
-
-/*
- *   memory pool object 
- */
-class CVmGramProdMem
-{
-public:
-    CVmGramProdMem()
-    {
-        /* no memory blocks yet */
-        block_head_ = 0;
-        block_cur_ = 0;
-
-        /* we don't yet have a block */
-        cur_rem_ = 0;
-        cur_free_ = 0;
-    }
-
-    ~CVmGramProdMem()
-    {
-        /* delete each of our blocks */
-        while (block_head_ != 0)
-        {
-            CVmGramProdMemBlock *nxt;
-            
-            /* remember the next block */
-            nxt = block_head_->nxt_;
-            
-            /* delete this block */
-            t3free(block_head_);
-
-            /* move on to the next */
-            block_head_ = nxt;
-        }
-    }
-
-    /* reset - delete all previously sub-allocated memory */
-    void reset()
-    {
-        /* start over with the first block */
-        block_cur_ = block_head_;
-
-        /* initialize the free pointer for the new block, if we have one */
-        if (block_cur_ != 0)
-        {
-            /* start at the beginning of the new block */
-            cur_free_ = block_cur_->buf_;
-
-            /* this entire block is available */
-            cur_rem_ = VMGRAMPROD_MEM_BLOCK_SIZE;
-        }
-        else
-        {
-            /* there are no blocks, so there's no memory available yet */
-            cur_rem_ = 0;
-            cur_free_ = 0;
-        }
-    }
-
-    /* allocate memory */
-    void *alloc(size_t siz)
-    {
-        void *ret;
-        
-        /* round the size to the local hardware boundary */
-        siz = osrndsz(siz);
-
-        /* if it exceeds the block size, fail */
-        if (siz > VMGRAMPROD_MEM_BLOCK_SIZE)
-            return 0;
-
-        /* if we don't have enough space in this block, go to the next */
-        if (siz > cur_rem_)
-        {
-            /* allocate a new block if necessary */
-            if (block_cur_ == 0)
-            {
-                /* there's nothing in the list yet - set up the first block */
-                block_head_ = (CVmGramProdMemBlock *)
-                              t3malloc(sizeof(CVmGramProdMemBlock));
-
-                /* activate the new block */
-                block_cur_ = block_head_;
-
-                /* there's nothing after this block */
-                block_cur_->nxt_ = 0;
-            }
-            else if (block_cur_->nxt_ == 0)
-            {
-                /* we're at the end of the list - add a block */
-                block_cur_->nxt_ = (CVmGramProdMemBlock *)
-                                   t3malloc(sizeof(CVmGramProdMemBlock));
-
-                /* advance to the new block */
-                block_cur_ = block_cur_->nxt_;
-
-                /* the new block is the last in the chain */
-                block_cur_->nxt_ = 0;
-            }
-            else
-            {
-                /* another block follows - advance to it */
-                block_cur_ = block_cur_->nxt_;
-            }
-
-            /* start at the beginning of the new block */
-            cur_free_ = block_cur_->buf_;
-
-            /* this entire block is available */
-            cur_rem_ = VMGRAMPROD_MEM_BLOCK_SIZE;
-        }
-
-        /* the return value will be the current free pointer */
-        ret = cur_free_;
-
-        /* consume the space */
-        cur_free_ += siz;
-        cur_rem_ -= siz;
-
-        /* return the block location */
-        return ret;
-    }
-
-private:
-    /* head of block list */
-    CVmGramProdMemBlock *block_head_;
-
-    /* block we're currently suballocating out of */
-    CVmGramProdMemBlock *block_cur_;
-
-    /* current free pointer in current block */
-    char *cur_free_;
-
-    /* amount of space remaining in current block */
-    size_t cur_rem_;
-};
-
 /* ------------------------------------------------------------------------ */
 /*
  *   Alternative object 
@@ -384,6 +223,99 @@ struct CVmGramProdMatchEntry
     CVmGramProdMatchEntry *nxt_;
 };
 
+/*
+ *   Sub-production memo.  The first time a state asks for a given
+ *   production at a given token position, we parse the production the
+ *   ordinary way, but we keep a log of everything the parse does that
+ *   anyone outside of the production can see: each time one of the
+ *   production's alternatives matches, and each time a state within the
+ *   production's parse goes into the badness queue.  The production's
+ *   parse is finished once every work queue entry that it added has been
+ *   processed.  After that, any other state that asks for the same
+ *   production at the same position gets the log replayed, rather than
+ *   parsing the production all over again.
+ *   
+ *   Replaying has to give exactly the same results as a new parse,
+ *   including the order of the results.  The work queue is a stack, so
+ *   when an alternative matches, the enclosing state goes on top of the
+ *   queue, and we finish with it and everything it leads to before we go
+ *   back to the rest of the production.  A replay does the same thing: it
+ *   continues the caller with one match at a time, and leaves a cursor
+ *   state in the queue under the caller to pick up the log after that.
+ *   States that went to the badness queue are copied, with the caller
+ *   substituted for the original enclosing state.
+ */
+struct CVmGramProdMemoEvent
+{
+    /* 
+     *   the match, for a match event; null for an event that put a state
+     *   in the badness queue 
+     */
+    const CVmGramProdMatch *match_;
+
+    /* token position and '*' flag at the end of the match */
+    size_t tok_pos_;
+    int matched_star_;
+
+    /* for a badness event, a copy of the state as we first enqueued it */
+    struct CVmGramProdState *state_;
+
+    /* next event in the log */
+    CVmGramProdMemoEvent *nxt_;
+};
+
+struct CVmGramProdMemo
+{
+    /* production object and starting token position */
+    vm_obj_id_t prod_obj_;
+    size_t tok_pos_;
+
+    /* 
+     *   the work queue entry that was on top of the queue when we started
+     *   the production - when it's back on top, we're done 
+     */
+    struct CVmGramProdState *below_;
+
+    /* flag: the production's parse is finished, so the log is complete */
+    int done_;
+
+    /* event log */
+    CVmGramProdMemoEvent *first_;
+    CVmGramProdMemoEvent *last_;
+
+    /* next memo in the hash chain */
+    CVmGramProdMemo *nxt_;
+
+    /* next memo in the stack of unfinished memos */
+    CVmGramProdMemo *open_nxt_;
+
+    /* add an event to the log */
+    void add_event(CVmGramProdMem *mem, const CVmGramProdMatch *match,
+                   size_t tok_pos, int matched_star,
+                   struct CVmGramProdState *state)
+    {
+        CVmGramProdMemoEvent *ev;
+
+        /* set up the event */
+        ev = (CVmGramProdMemoEvent *)mem->alloc(sizeof(*ev));
+        ev->match_ = match;
+        ev->tok_pos_ = tok_pos;
+        ev->matched_star_ = matched_star;
+        ev->state_ = state;
+        ev->nxt_ = 0;
+
+        /* link it at the end of the log */
+        if (last_ != 0)
+            last_->nxt_ = ev;
+        else
+            first_ = ev;
+        last_ = ev;
+    }
+};
+
+/* size of the memo hash table */
+const size_t VMGRAMPROD_MEMO_BUCKETS = 256;
+
 /*
  *   Parsing state object.  At any given time, we will have one or more of
  *   these state objects in our processing queue.  A state object tracks a
@@ -451,17 +383,40 @@ struct CVmGramProdState
 
         /* we're not in the queue yet */
         nxt_ = 0;
+
+        /* we're not part of a memorized sub-production, or a replay */
+        memo_ = 0;
+        replay_ = 0;
     }
 
     /* clone the state */
     CVmGramProdState *clone(CVmGramProdMem *mem)
+    {
+        /* clone our enclosing state, and then clone ourselves onto it */
+        return clone_onto(mem, enclosing_ != 0 ? enclosing_->clone(mem) : 0);
+    }
+
+    /*
+     *   Clone the state and its enclosing states up to the state that
+     *   started the given memorized sub-production, substituting a clone of
+     *   'caller' for the enclosing state of that first state.  
+     */
+    CVmGramProdState *clone_for_caller(CVmGramProdMem *mem,
+                                       const CVmGramProdMemo *memo,
+                                       CVmGramProdState *caller)
+    {
+        return clone_onto(mem, memo_ == memo
+                               ? caller->clone(mem)
+                               : enclosing_->clone_for_caller(
+                                   mem, memo, caller));
+    }
+
+    /* clone the state, with the given enclosing state */
+    CVmGramProdState *clone_onto(CVmGramProdMem *mem,
+                                 CVmGramProdState *new_enclosing)
     {
         CVmGramProdState *new_state;
-        CVmGramProdState *new_enclosing;
 
-        /* clone our enclosing state */
-        new_enclosing = (enclosing_ != 0 ? enclosing_->clone(mem) : 0);
-        
         /* create a new state object */
         new_state = alloc(mem, tok_pos_, alt_pos_, new_enclosing,
                           altp_, prod_obj_, circular_alt_);
@@ -480,6 +435,9 @@ struct CVmGramProdState
         /* set the '*' flag in the cloned state */
         new_state->matched_star_ = matched_star_;
 
+        /* copy the memo */
+        new_state->memo_ = memo_;
+
         /* return the clone */
         return new_state;
     }
@@ -523,6 +481,19 @@ struct CVmGramProdState
     /* the production contains circular alternatives */
     int circular_alt_;
 
+    /* 
+     *   The memorized sub-production that we're an alternative of, if any.
+     *   This is set only for the states that start the sub-production's
+     *   alternatives, not for the states nested within them.  
+     */
+    CVmGramProdMemo *memo_;
+
+    /* 
+     *   For a replay cursor, the next event to replay from memo_'s log.
+     *   The enclosing state is the caller we're replaying for.  
+     */
+    CVmGramProdMemoEvent *replay_;
+
     /* 
      *   Match list.  This list is allocated with enough space for one
      *   match for each of our items (the number of items is given by
@@ -548,6 +519,89 @@ struct CVmGramProdQueue
         work_queue_ = 0;
         badness_queue_ = 0;
         success_list_ = 0;
+        memo_tab_ = 0;
+        memo_open_ = 0;
+    }
+
+    /* find the memo for a production at a token position */
+    CVmGramProdMemo *find_memo(vm_obj_id_t prod_obj, size_t tok_pos)
+    {
+        CVmGramProdMemo *memo;
+
+        /* if we don't have a table yet, there's nothing to find */
+        if (memo_tab_ == 0)
+            return 0;
+
+        /* search the hash chain */
+        for (memo = memo_tab_[memo_hash(prod_obj, tok_pos)] ; memo != 0 ;
+             memo = memo->nxt_)
+        {
+            if (memo->prod_obj_ == prod_obj && memo->tok_pos_ == tok_pos)
+                return memo;
+        }
+
+        /* not found */
+        return 0;
+    }
+
+    /* 
+     *   add a memo for a production at a token position, and make it the
+     *   innermost unfinished memo 
+     */
+    CVmGramProdMemo *add_memo(CVmGramProdMem *mem,
+                              vm_obj_id_t prod_obj, size_t tok_pos)
+    {
+        CVmGramProdMemo *memo;
+        size_t h;
+
+        /* create the hash table on the first memo */
+        if (memo_tab_ == 0)
+        {
+            memo_tab_ = (CVmGramProdMemo **)mem->alloc(
+                VMGRAMPROD_MEMO_BUCKETS * sizeof(memo_tab_[0]));
+            memset(memo_tab_, 0, VMGRAMPROD_MEMO_BUCKETS*sizeof(memo_tab_[0]));
+        }
+
+        /* set up the memo */
+        memo = (CVmGramProdMemo *)mem->alloc(sizeof(*memo));
+        memo->prod_obj_ = prod_obj;
+        memo->tok_pos_ = tok_pos;
+        memo->below_ = work_queue_;
+        memo->done_ = FALSE;
+        memo->first_ = memo->last_ = 0;
+
+        /* link it into its hash chain */
+        h = memo_hash(prod_obj, tok_pos);
+        memo->nxt_ = memo_tab_[h];
+        memo_tab_[h] = memo;
+
+        /* it's the innermost memo still in progress */
+        memo->open_nxt_ = memo_open_;
+        memo_open_ = memo;
+
+        /* return the new memo */
+        return memo;
+    }
+
+    /* 
+     *   Mark finished memos.  A memo is finished when the work queue entry
+     *   that was on top when we started it is on top again.  The
+     *   unfinished memos nest, since the work queue is a stack.  
+     */
+    void finish_memos()
+    {
+        while (memo_open_ != 0 && memo_open_->below_ == work_queue_)
+        {
+            memo_open_->done_ = TRUE;
+            memo_open_ = memo_open_->open_nxt_;
+        }
+    }
+
+    /* memo hash table bucket for a production and token position */
+    static size_t memo_hash(vm_obj_id_t prod_obj, size_t tok_pos)
+    {
+        return ((size_t)prod_obj * 31 + tok_pos)
+            & (VMGRAMPROD_MEMO_BUCKETS - 1);
     }
 
     /* head of work queue */
@@ -558,6 +612,12 @@ struct CVmGramProdQueue
 
     /* head of success list */
     CVmGramProdMatchEntry *success_list_;
+
+    /* sub-production memo hash table */
+    CVmGramProdMemo **memo_tab_;
+
+    /* innermost unfinished memo */
+    CVmGramProdMemo *memo_open_;
 };
 
 /* ------------------------------------------------------------------------ */
@@ -654,9 +714,6 @@ CVmObjGramProd::CVmObjGramProd(VMG0_)
     /* presume we have no circular rules */
     get_ext()->has_circular_alt = FALSE;
 
-    /* create our memory pool */
-    get_ext()->mem_ = new CVmGramProdMem();
-
     /* 
      *   allocate initial property enumeration space (we'll expand this as
      *   needed, so the initial size is just a guess) 
@@ -686,9 +743,6 @@ void CVmObjGramProd::notify_delete(VMG_ int /*in_root_set*/)
             t3free(alts);
         }
 
-        /* delete our memory pool */
-        delete get_ext()->mem_;
-
         /* delete our property enumeration space */
         t3free(get_ext()->prop_enum_arr_);
         
@@ -1301,25 +1355,15 @@ int CVmObjGramProd::getp_parse(VMG_ vm_obj_id_t self,
     vm_val_t dictval;
     CVmObjDict *dict;
     int tok_cnt;
-    int i;
-    vmgramprod_tok *tok;
     int orig_argc = (argc != 0 ? *argc : 0);
-    CVmGramProdQueue queues;
-    CVmObjList *lst;
-    int succ_cnt;
-    CVmGramProdMatchEntry *match;
+    CVmGramProdMem *mem = G_gram_arena;
+    CVmGramProdMemMark mark;
     static CVmNativeCodeDesc desc(2);
     
     /* check arguments */
     if (get_prop_check_argc(retval, argc, &desc))
         return TRUE;
 
-    /* reset our memory pool */
-    get_ext()->mem_->reset();
-
-    /* clear the work queues */
-    queues.clear();
-
     /* 
      *   get the tokenList argument and make sure it's a list; leave it on
      *   the stack for now so it remains reachable for the garbage
@@ -1365,12 +1409,55 @@ int CVmObjGramProd::getp_parse(VMG_ vm_obj_id_t self,
         dict = 0;
     }
 
+    /* 
+     *   Start the parse in the parsing arena.  Make sure we leave the arena
+     *   even if an error occurs, so that it's properly reset for the next
+     *   parse.  
+     */
+    mem->enter(&mark);
+    err_try
+    {
+        /* parse the tokens */
+        parse_tokens(vmg_ self, mem, retval, tokval, tok_cnt, dict);
+    }
+    err_finally
+    {
+        /* we're done with the arena */
+        mem->leave(&mark);
+    }
+    err_end;
+
+    /* discard arguments */
+    G_stk->discard(orig_argc);
+
+    /* evaluation successful */
+    return TRUE;
+}
+
+/*
+ *   Parse a token list, starting at this production.  This carries out the
+ *   parseTokens method, after we've checked the arguments. 
+ */
+void CVmObjGramProd::parse_tokens(VMG_ vm_obj_id_t self,
+                                  CVmGramProdMem *mem, vm_val_t *retval,
+                                  const vm_val_t *tokval, int tok_cnt,
+                                  CVmObjDict *dict)
+{
+    int i;
+    vmgramprod_tok *tok;
+    CVmGramProdQueue queues;
+    CVmObjList *lst;
+    int succ_cnt;
+    CVmGramProdMatchEntry *match;
+
+    /* clear the work queues */
+    queues.clear();
+
     /* 
      *   For quick and easy access, make our own private copy of the token
      *   and type lists.  First, allocate an array of token structures.  
      */
-    tok = (vmgramprod_tok *)get_ext()->mem_
-          ->alloc(tok_cnt * sizeof(vmgramprod_tok));
+    tok = (vmgramprod_tok *)mem->alloc(tok_cnt * sizeof(vmgramprod_tok));
 
     /* copy the token string references and types into our list */
     for (i = 0 ; i < tok_cnt ; ++i)
@@ -1449,8 +1536,7 @@ int CVmObjGramProd::getp_parse(VMG_ vm_obj_id_t self,
                     /* allocate space for the list */
                     tok[i].match_cnt_ = ctx.cnt;
                     tok[i].matches_ =
-                        (vmgram_match_info *)get_ext()->mem_
-                        ->alloc(ctx.cnt * sizeof(vmgram_match_info));
+                        (vmgram_match_info *)mem->alloc(ctx.cnt * sizeof(vmgram_match_info));
                     
                     /* copy the list */
                     memcpy(tok[i].matches_, get_ext()->prop_enum_arr_,
@@ -1467,11 +1553,11 @@ int CVmObjGramProd::getp_parse(VMG_ vm_obj_id_t self,
     }
 
     /* enqueue a match state item for each of our alternatives */
-    enqueue_alts(vmg_ get_ext()->mem_, tok, tok_cnt, 0, 0,
-                 &queues, self, FALSE, 0, dict);
+    enqueue_alts(vmg_ mem, tok, tok_cnt, 0, 0,
+                 &queues, self, FALSE, 0, dict, 0);
 
     /* process the work queue */
-    process_work_queue(vmg_ get_ext()->mem_, tok, tok_cnt,
+    process_work_queue(vmg_ mem, tok, tok_cnt,
                        &queues, dict);
 
     /* count the entries in the success list */
@@ -1533,12 +1619,6 @@ int CVmObjGramProd::getp_parse(VMG_ vm_obj_id_t self,
 
     /* discard the gc protection */
     G_stk->discard();
-
-    /* discard arguments */
-    G_stk->discard(orig_argc);
-
-    /* evaluation successful */
-    return TRUE;
 }
 
 /*
@@ -1758,6 +1838,9 @@ void CVmObjGramProd::process_work_queue(VMG_ CVmGramProdMem *mem,
     /* keep going until the work queue and badness queue are empty */
     for (;;)
     {
+        /* note any sub-production memos we've finished */
+        queues->finish_memos();
+
         /* 
          *   If the work queue is empty, fall back on the badness queue.
          *   Ignore the badness queue if we have any successful matches,
@@ -1851,6 +1934,13 @@ void CVmObjGramProd::process_work_queue_head(VMG_ CVmGramProdMem *mem,
     queues->work_queue_ = state->nxt_;
     state->nxt_ = 0;
 
+    /* if it's a replay cursor, carry on with the replay */
+    if (state->replay_ != 0)
+    {
+        replay_memo(mem, state, queues);
+        return;
+    }
+
     /* get the token pointer for the next active entry in the alternative */
     tokp = state->altp_->toks + state->alt_pos_;
 
@@ -1897,9 +1987,8 @@ void CVmObjGramProd::process_work_queue_head(VMG_ CVmGramProdMem *mem,
                 state->sub_target_prop_ = tokp->prop;
                 
                 /* enqueue the alternatives for the sub-production */
-                sub_objp->enqueue_alts(vmg_ mem, tok, tok_cnt,
-                                       state->tok_pos_, state, queues,
-                                       sub_obj_id, FALSE, 0, dict);
+                sub_objp->enqueue_sub(vmg_ mem, tok, tok_cnt, state, queues,
+                                      sub_obj_id, dict);
             }
 
             /* 
@@ -2100,9 +2189,18 @@ void CVmObjGramProd::process_work_queue_head(VMG_ CVmGramProdMem *mem,
          */
         prod_objp->enqueue_alts(vmg_ mem, tok, tok_cnt, state->tok_pos_,
                                 state->enclosing_, queues, prod_obj_id,
-                                TRUE, match, dict);
+                                TRUE, match, dict, state->memo_);
     }
 
+    /* 
+     *   if we're an alternative of a memorized sub-production that's still
+     *   in progress, log the match, so that we can replay it for other
+     *   states that want the same sub-production 
+     */
+    if (state->memo_ != 0 && !state->memo_->done_)
+        state->memo_->add_event(mem, match, state->tok_pos_,
+                                state->matched_star_, 0);
+
     /* check for an enclosing state to pop */
     if (state->enclosing_ != 0)
     {
@@ -2167,7 +2265,7 @@ void CVmObjGramProd::enqueue_alts(VMG_ CVmGramProdMem *mem,
                                   CVmGramProdQueue *queues, vm_obj_id_t self,
                                   int circ_only,
                                   CVmGramProdMatch *circ_match,
-                                  CVmObjDict *dict)
+                                  CVmObjDict *dict, CVmGramProdMemo *memo)
 {
     vmgram_alt_info *const *altp;
     size_t i;
@@ -2450,34 +2548,14 @@ void CVmObjGramProd::enqueue_alts(VMG_ CVmGramProdMem *mem,
             && ((!circ_only && !is_circ)
                 || (circ_only && is_circ)))
         {
-            CVmGramProdState *state;
-            
-            /* create and enqueue the new state */
-            state = enqueue_new_state(mem, start_tok_pos, enclosing_state,
-                                      *altp, self, &need_to_clone, queues,
-                                      has_circ);
-
             /* 
-             *   if we are enqueuing circular references, we already have
-             *   a match for the first (circular) token, so fill it in 
+             *   create and enqueue the new state; if we are enqueuing
+             *   circular references, we already have a match for the first
+             *   (circular) token 
              */
-            if (circ_only)
-            {
-                CVmGramProdMatch *match;
-                
-                /* create a match for the alternative */
-                match = CVmGramProdMatch::
-                        alloc(mem, 0, 0, FALSE, first_tokp->prop,
-                              circ_match->proc_obj_,
-                              circ_match->sub_match_list_,
-                              circ_match->sub_match_cnt_);
-
-                /* set the first match in the token */
-                state->match_list_[0] = match;
-
-                /* set up at the second token */
-                state->alt_pos_ = 1;
-            }
+            enqueue_new_state(mem, start_tok_pos, enclosing_state,
+                              *altp, self, &need_to_clone, queues,
+                              has_circ, circ_only ? circ_match : 0, memo);
         }
     }
 }
@@ -2528,13 +2606,28 @@ CVmGramProdState *CVmObjGramProd::
                      CVmGramProdState *enclosing_state,
                      const vmgram_alt_info *altp, vm_obj_id_t self,
                      int *need_to_clone, CVmGramProdQueue *queues,
-                     int circular_alt)
+                     int circular_alt, const CVmGramProdMatch *circ_match,
+                     CVmGramProdMemo *memo)
 {
     CVmGramProdState *state;
 
     /* create the new state */
     state = create_new_state(mem, start_tok_pos, enclosing_state,
-                             altp, self, need_to_clone, circular_alt);
+                             altp, self, need_to_clone, circular_alt, memo);
+
+    /* 
+     *   if we have a match for the first (circular) token, fill it in, and
+     *   start at the second token 
+     */
+    if (circ_match != 0)
+    {
+        state->match_list_[0] = CVmGramProdMatch::
+                                alloc(mem, 0, 0, FALSE, altp->toks[0].prop,
+                                      circ_match->proc_obj_,
+                                      circ_match->sub_match_list_,
+                                      circ_match->sub_match_cnt_);
+        state->alt_pos_ = 1;
+    }
     
     /* 
      *   Add the item to the appropriate queue.  If the item has an
@@ -2548,8 +2641,7 @@ CVmGramProdState *CVmObjGramProd::
          *   we don't want to process it until we entirely exhaust better
          *   possibilities 
          */
-        state->nxt_ = queues->badness_queue_;
-        queues->badness_queue_ = state;
+        enqueue_badness(mem, state, queues);
     }
     else
     {
@@ -2568,8 +2660,11 @@ CVmGramProdState *CVmObjGramProd::
    create_new_state(CVmGramProdMem *mem, size_t start_tok_pos,
                     CVmGramProdState *enclosing_state,
                     const vmgram_alt_info *altp, vm_obj_id_t self,
-                    int *need_to_clone, int circular_alt)
+                    int *need_to_clone, int circular_alt,
+                    CVmGramProdMemo *memo)
 {
+    CVmGramProdState *state;
+
     /* 
      *   if necessary, clone the enclosing state; we need to do this if we
      *   enqueue more than one nested alternative, since each nested
@@ -2586,9 +2681,15 @@ CVmGramProdState *CVmObjGramProd::
     *need_to_clone = TRUE;
 
     /* create a new state object for the alternative */
-    return CVmGramProdState::alloc(mem, start_tok_pos, 0,
-                                   enclosing_state, altp, self,
-                                   circular_alt);
+    state = CVmGramProdState::alloc(mem, start_tok_pos, 0,
+                                    enclosing_state, altp, self,
+                                    circular_alt);
+
+    /* note the memorized sub-production it belongs to, if any */
+    state->memo_ = memo;
+
+    /* return the new state */
+    return state;
 }
 
 /*
@@ -2602,6 +2703,159 @@ void CVmObjGramProd::enqueue_state(CVmGramProdState *state,
     queues->work_queue_ = state;
 }
 
+/*
+ *   Add a state to the badness queue 
+ */
+void CVmObjGramProd::enqueue_badness(CVmGramProdMem *mem,
+                                     CVmGramProdState *state,
+                                     CVmGramProdQueue *queues)
+{
+    CVmGramProdState *cur;
+    CVmGramProdState *copy;
+
+    /* add it to the badness queue */
+    state->nxt_ = queues->badness_queue_;
+    queues->badness_queue_ = state;
+
+    /* 
+     *   Log the state with each memorized sub-production in progress that
+     *   it's part of.  The state is part of a sub-production if one of the
+     *   sub-production's alternatives is among its enclosing states.  Log a
+     *   copy, since the state will change when we get around to it.  
+     */
+    for (cur = state, copy = 0 ; cur != 0 ; cur = cur->enclosing_)
+    {
+        if (cur->memo_ != 0 && !cur->memo_->done_)
+        {
+            /* make the copy, if we haven't already */
+            if (copy == 0)
+                copy = state->clone(mem);
+
+            /* log it */
+            cur->memo_->add_event(mem, 0, 0, FALSE, copy);
+        }
+    }
+}
+
+/*
+ *   Enqueue the alternatives for a sub-production match, for the given
+ *   enclosing state.  If we've already parsed this sub-production at the
+ *   same token position, we replay the results from the memo rather than
+ *   parsing it again.  
+ */
+void CVmObjGramProd::enqueue_sub(VMG_ CVmGramProdMem *mem,
+                                 const vmgramprod_tok *tok, size_t tok_cnt,
+                                 CVmGramProdState *state,
+                                 CVmGramProdQueue *queues,
+                                 vm_obj_id_t self, CVmObjDict *dict)
+{
+    CVmGramProdMemo *memo;
+
+    /* look for a memo */
+    memo = queues->find_memo(self, state->tok_pos_);
+    if (memo == 0)
+    {
+        /* it's the first time - parse it, and memorize the results */
+        memo = queues->add_memo(mem, self, state->tok_pos_);
+        enqueue_alts(vmg_ mem, tok, tok_cnt, state->tok_pos_, state, queues,
+                     self, FALSE, 0, dict, memo);
+    }
+    else if (memo->done_)
+    {
+        /* 
+         *   we have the complete results - replay them, if there's
+         *   anything to replay 
+         */
+        if (memo->first_ != 0)
+        {
+            CVmGramProdState *cursor;
+
+            /* set up a replay cursor for the state */
+            cursor = CVmGramProdState::alloc(
+                mem, state->tok_pos_, 0, state, state->altp_,
+                state->prod_obj_, FALSE);
+            cursor->memo_ = memo;
+            cursor->replay_ = memo->first_;
+
+            /* start replaying */
+            replay_memo(mem, cursor, queues);
+        }
+    }
+    else
+    {
+        /* 
+         *   We're asking for the sub-production again while we're still
+         *   working on it, which can only happen in the middle of one of
+         *   its matches (an empty one).  We don't have all of its results
+         *   yet, so parse it again.  
+         */
+        enqueue_alts(vmg_ mem, tok, tok_cnt, state->tok_pos_, state, queues,
+                     self, FALSE, 0, dict, 0);
+    }
+}
+
+/*
+ *   Replay a memorized sub-production's log for a caller, starting at the
+ *   cursor's current event.  We replay everything up to and including the
+ *   next match; at the match, we enqueue the cursor, and then the caller
+ *   with the match on top of it, so that we finish with the caller before
+ *   we continue with the log.  
+ */
+void CVmObjGramProd::replay_memo(CVmGramProdMem *mem,
+                                 CVmGramProdState *cursor,
+                                 CVmGramProdQueue *queues)
+{
+    CVmGramProdMemoEvent *ev;
+    CVmGramProdState *caller;
+
+    /* the cursor's enclosing state is the caller */
+    caller = cursor->enclosing_;
+
+    /* replay events */
+    for (ev = cursor->replay_ ; ev != 0 ; ev = ev->nxt_)
+    {
+        CVmGramProdState *state;
+        
+        /* if it's a badness event, copy the state for the caller */
+        if (ev->match_ == 0)
+        {
+            enqueue_badness(mem, ev->state_->clone_for_caller(
+                mem, cursor->memo_, caller), queues);
+            continue;
+        }
+
+        /* 
+         *   It's a match.  If there's more to the log, put the cursor back
+         *   in the queue to come back to it; then use a copy of the caller,
+         *   so that we leave the original intact for the next match.  If
+         *   this is the last event, we can use the caller itself.  
+         */
+        if (ev->nxt_ != 0)
+        {
+            cursor->replay_ = ev->nxt_;
+            enqueue_state(cursor, queues);
+            state = caller->clone(mem);
+        }
+        else
+            state = caller;
+
+        /* add the match, with the caller's target property */
+        state->match_list_[state->alt_pos_] = CVmGramProdMatch::alloc(
+            mem, ev->match_->tok_pos_, 0, FALSE, caller->sub_target_prop_,
+            ev->match_->proc_obj_, ev->match_->sub_match_list_,
+            ev->match_->sub_match_cnt_);
+        state->alt_pos_++;
+
+        /* move the caller past the match, just as for a new match */
+        state->tok_pos_ = ev->tok_pos_;
+        state->matched_star_ = ev->matched_star_;
+
+        /* enqueue the caller, and stop here */
+        enqueue_state(state, queues);
+        return;
+    }
+}
+
 /*
  *   Determine if a token from the input matches a literal token, allowing
  *   the input token to be a truncated version of the literal token if the
@@ -3198,7 +3452,7 @@ void CVmObjGramProd::delete_alt_undo(VMG_ vm_obj_id_t self, int idx)
         VMGRAM_UNDO_DELETED, idx, get_ext()->alts_[idx]);
 
     /* save the record */
-    if (!G_undo->add_new_record_ptr_key(vmg_ self, rec))
+    if (!G_undo->add_new_record_ptr_key(vmg_ self, rec, sizeof(*rec)))
         delete rec;
     
     /* remove the alternative from the array */
@@ -3477,7 +3731,7 @@ void CVmObjGramProd::add_alt(VMG_ vm_obj_id_t self, CTcGramProdAlt *alt,
 
     /* create and add an undo record */
     vmgram_undo_rec *rec = new vmgram_undo_rec(VMGRAM_UNDO_ADDED, idx, 0);
-    if (!G_undo->add_new_record_ptr_key(vmg_ self, rec))
+    if (!G_undo->add_new_record_ptr_key(vmg_ self, rec, sizeof(*rec)))
         delete rec;
 }
 
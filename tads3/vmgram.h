@@ -155,9 +155,6 @@ struct vm_gram_ext
      */
     uint has_circular_alt : 1;
 
-    /* private memory pool - we use this to make allocation cheaper */
-    class CVmGramProdMem *mem_;
-
     /*
      *   Property list enumeration space.  We use this to build a list of
      *   properties for which a dictionary word is defined.  We'll expand
@@ -288,6 +285,280 @@ struct vmgram_tok_info
     } typinfo;
 };
 
+/* ------------------------------------------------------------------------ */
+/*
+ *   Grammar production parsing arena.  This is a simple suballocator that
+ *   obtains large blocks from the system allocator, then hands out pieces
+ *   of those blocks.  Allocating is very cheap (just a pointer increment in
+ *   most cases), and we don't track individual allocations and deletions
+ *   but just throw away all suballocated memory at once.
+ *   
+ *   There's one arena for the whole VM (G_gram_arena), which all parses
+ *   share.  A parse calls enter() when it starts and leave() when it's
+ *   done.  An outermost parse starts over at the beginning of the arena,
+ *   keeping the blocks from earlier parses, so once the arena has grown to
+ *   fit the largest parse, parsing doesn't allocate any system memory at
+ *   all.  A parse can start while another is in progress (a dictionary
+ *   comparator written in byte code can call parseTokens(), for example);
+ *   the inner parse allocates above the outer one's memory, and leave()
+ *   releases only the inner parse's memory.  
+ */
+
+/* size of each memory block */
+const size_t VMGRAMPROD_MEM_BLOCK_SIZE = 16*1024;
+
+/*
+ *   memory pool block 
+ */
+struct CVmGramProdMemBlock
+{
+    /* next block in chain */
+    CVmGramProdMemBlock *nxt_;
+
+    /* bytes of the block */
+    char buf_[VMGRAMPROD_MEM_BLOCK_SIZE];
+};
+
+/*
+ *   Arena position, for releasing the memory allocated by a nested parse 
+ */
+struct CVmGramProdMemMark
+{
+    CVmGramProdMemBlock *block_cur_;
+    char *cur_free_;
+    size_t cur_rem_;
+    size_t used_;
+};
+
+/*
+ *   Arena statistics, as reported by CVmGramProdMem::get_stats() 
+ */
+struct vmgram_arena_stats
+{
+    /* number of parses, and how many of them were nested in another */
+    ulong parse_cnt;
+    ulong nested_cnt;
+
+    /* number of blocks we've obtained from the system allocator */
+    size_t block_cnt;
+
+    /* bytes in use by the current parse(s) */
+    size_t bytes_used;
+
+    /* most bytes ever in use at once (the high-water mark) */
+    size_t bytes_hwm;
+};
+
+/*
+ *   parsing arena 
+ */
+class CVmGramProdMem
+{
+public:
+    CVmGramProdMem()
+    {
+        /* no memory blocks yet */
+        block_head_ = 0;
+        block_cur_ = 0;
+
+        /* we don't yet have a block */
+        cur_rem_ = 0;
+        cur_free_ = 0;
+
+        /* no parses yet */
+        depth_ = 0;
+        memset(&stats_, 0, sizeof(stats_));
+    }
+
+    ~CVmGramProdMem()
+    {
+        /* delete each of our blocks */
+        while (block_head_ != 0)
+        {
+            CVmGramProdMemBlock *nxt;
+            
+            /* remember the next block */
+            nxt = block_head_->nxt_;
+            
+            /* delete this block */
+            t3free(block_head_);
+
+            /* move on to the next */
+            block_head_ = nxt;
+        }
+    }
+
+    /* 
+     *   Start a parse.  If this is the outermost parse, we reset the arena;
+     *   otherwise we leave the enclosing parse's memory alone.  Fills in
+     *   'mark' with the position to pass to leave() at the end of the
+     *   parse.  
+     */
+    void enter(CVmGramProdMemMark *mark)
+    {
+        /* count the parse */
+        ++stats_.parse_cnt;
+
+        /* reset the arena for an outermost parse */
+        if (depth_++ == 0)
+            reset();
+        else
+            ++stats_.nested_cnt;
+
+        /* note the current position */
+        mark->block_cur_ = block_cur_;
+        mark->cur_free_ = cur_free_;
+        mark->cur_rem_ = cur_rem_;
+        mark->used_ = stats_.bytes_used;
+    }
+
+    /* 
+     *   End a parse.  For a nested parse, this releases the memory the
+     *   parse allocated, going back to the position saved in enter().  The
+     *   outermost parse's memory stays valid until the next parse starts.  
+     */
+    void leave(const CVmGramProdMemMark *mark)
+    {
+        if (--depth_ != 0)
+        {
+            block_cur_ = mark->block_cur_;
+            cur_free_ = mark->cur_free_;
+            cur_rem_ = mark->cur_rem_;
+            stats_.bytes_used = mark->used_;
+        }
+    }
+
+    /* reset - delete all previously sub-allocated memory */
+    void reset()
+    {
+        /* start over with the first block */
+        block_cur_ = block_head_;
+
+        /* initialize the free pointer for the new block, if we have one */
+        if (block_cur_ != 0)
+        {
+            /* start at the beginning of the new block */
+            cur_free_ = block_cur_->buf_;
+
+            /* this entire block is available */
+            cur_rem_ = VMGRAMPROD_MEM_BLOCK_SIZE;
+        }
+        else
+        {
+            /* there are no blocks, so there's no memory available yet */
+            cur_rem_ = 0;
+            cur_free_ = 0;
+        }
+
+        /* nothing is in use */
+        stats_.bytes_used = 0;
+    }
+
+    /* allocate memory */
+    void *alloc(size_t siz)
+    {
+        void *ret;
+        
+        /* round the size to the local hardware boundary */
+        siz = osrndsz(siz);
+
+        /* if it exceeds the block size, fail */
+        if (siz > VMGRAMPROD_MEM_BLOCK_SIZE)
+            return 0;
+
+        /* if we don't have enough space in this block, go to the next */
+        if (siz > cur_rem_)
+        {
+            /* count the unused end of this block as used */
+            stats_.bytes_used += cur_rem_;
+
+            /* allocate a new block if necessary */
+            if (block_cur_ == 0 && block_head_ != 0)
+            {
+                /* 
+                 *   we're going back to a position before the first block
+                 *   was allocated - start over at the first block 
+                 */
+                block_cur_ = block_head_;
+            }
+            else if (block_cur_ == 0)
+            {
+                /* there's nothing in the list yet - set up the first block */
+                block_head_ = (CVmGramProdMemBlock *)
+                              t3malloc(sizeof(CVmGramProdMemBlock));
+                ++stats_.block_cnt;
+
+                /* activate the new block */
+                block_cur_ = block_head_;
+
+                /* there's nothing after this block */
+                block_cur_->nxt_ = 0;
+            }
+            else if (block_cur_->nxt_ == 0)
+            {
+                /* we're at the end of the list - add a block */
+                block_cur_->nxt_ = (CVmGramProdMemBlock *)
+                                   t3malloc(sizeof(CVmGramProdMemBlock));
+                ++stats_.block_cnt;
+
+                /* advance to the new block */
+                block_cur_ = block_cur_->nxt_;
+
+                /* the new block is the last in the chain */
+                block_cur_->nxt_ = 0;
+            }
+            else
+            {
+                /* another block follows - advance to it */
+                block_cur_ = block_cur_->nxt_;
+            }
+
+            /* start at the beginning of the new block */
+            cur_free_ = block_cur_->buf_;
+
+            /* this entire block is available */
+            cur_rem_ = VMGRAMPROD_MEM_BLOCK_SIZE;
+        }
+
+        /* the return value will be the current free pointer */
+        ret = cur_free_;
+
+        /* consume the space */
+        cur_free_ += siz;
+        cur_rem_ -= siz;
+
+        /* count it, and note the new high-water mark if applicable */
+        stats_.bytes_used += siz;
+        if (stats_.bytes_used > stats_.bytes_hwm)
+            stats_.bytes_hwm = stats_.bytes_used;
+
+        /* return the block location */
+        return ret;
+    }
+
+    /* get the statistics */
+    void get_stats(vmgram_arena_stats *stats) const { *stats = stats_; }
+
+private:
+    /* head of block list */
+    CVmGramProdMemBlock *block_head_;
+
+    /* block we're currently suballocating out of */
+    CVmGramProdMemBlock *block_cur_;
+
+    /* current free pointer in current block */
+    char *cur_free_;
+
+    /* amount of space remaining in current block */
+    size_t cur_rem_;
+
+    /* number of parses in progress */
+    int depth_;
+
+    /* statistics */
+    vmgram_arena_stats stats_;
+};
+
 /* ------------------------------------------------------------------------ */
 /*
  *   Grammar-Production object interface 
@@ -432,6 +703,11 @@ protected:
     /* property evaluation - parseTokens */
     int getp_parse(VMG_ vm_obj_id_t self, vm_val_t *val, uint *argc);
 
+    /* parse a token list, for parseTokens */
+    void parse_tokens(VMG_ vm_obj_id_t self, class CVmGramProdMem *mem,
+                      vm_val_t *retval, const vm_val_t *tokval, int tok_cnt,
+                      class CVmObjDict *dict);
+
     /* property evaluation - getGrammarInfo */
     int getp_get_gram_info(VMG_ vm_obj_id_t self, vm_val_t *val, uint *argc);
 
@@ -463,7 +739,8 @@ protected:
                       struct CVmGramProdQueue *queues,
                       vm_obj_id_t self, int circ_only,
                       struct CVmGramProdMatch *circ_match,
-                      class CVmObjDict *dict);
+                      class CVmObjDict *dict,
+                      struct CVmGramProdMemo *memo);
 
     /* create and enqueue a new state */
     static struct CVmGramProdState *
@@ -473,7 +750,9 @@ protected:
                           const vmgram_alt_info *altp, vm_obj_id_t self,
                           int *need_to_clone,
                           struct CVmGramProdQueue *queues,
-                          int circular_alt);
+                          int circular_alt,
+                          const struct CVmGramProdMatch *circ_match,
+                          struct CVmGramProdMemo *memo);
     
     /* create a new state */
     static struct CVmGramProdState *
@@ -481,12 +760,30 @@ protected:
                          size_t start_tok_pos,
                          struct CVmGramProdState *enclosing_state,
                          const vmgram_alt_info *altp, vm_obj_id_t self,
-                         int *need_to_clone, int circular_alt);
+                         int *need_to_clone, int circular_alt,
+                         struct CVmGramProdMemo *memo);
     
     /* enqueue a state */
     static void enqueue_state(struct CVmGramProdState *state,
                               struct CVmGramProdQueue *queues);
 
+    /* add a state to the badness queue */
+    static void enqueue_badness(class CVmGramProdMem *mem,
+                                struct CVmGramProdState *state,
+                                struct CVmGramProdQueue *queues);
+
+    /* enqueue our alternatives for a sub-production match, using the memo */
+    void enqueue_sub(VMG_ class CVmGramProdMem *mem,
+                     const struct vmgramprod_tok *tok, size_t tok_cnt,
+                     struct CVmGramProdState *state,
+                     struct CVmGramProdQueue *queues,
+                     vm_obj_id_t self, class CVmObjDict *dict);
+
+    /* replay memorized sub-production events for a new caller */
+    static void replay_memo(class CVmGramProdMem *mem,
+                            struct CVmGramProdState *cursor,
+                            struct CVmGramProdQueue *queues);
+
     /* process the work queue */
     static void process_work_queue(VMG_ CVmGramProdMem *mem,
                                    const struct vmgramprod_tok *tok,
@@ -170,6 +170,9 @@ CVmImageLoader::CVmImageLoader(CVmImageFile *fp, const char *fname,
     /* create the synthesized exports hash table */
     synth_exports_ = new CVmHashTable(16, new CVmHashFuncCS(), TRUE);
 
+    /* we haven't taken a restart snapshot yet */
+    restart_state_ = 0;
+
     /* no static initializer pages yet */
     static_head_ = static_tail_ = 0;
 
@@ -202,6 +205,9 @@ CVmImageLoader::~CVmImageLoader()
     delete exports_;
     delete synth_exports_;
 
+    /* delete the restart snapshot */
+    set_restart_state(0);
+
     /* delete the static initializer pages */
     while (static_head_ != 0)
     {
@@ -946,6 +952,12 @@ void CVmImageLoader::run(VMG_ const char *const *argv, int argc,
     }
     err_finally
     {
+        /* 
+         *   discard the restart snapshot, since it refers to objects that
+         *   won't survive beyond this run 
+         */
+        set_restart_state(0);
+
         /* forget the image loader */
         G_image_loader = 0;
 
@@ -2413,6 +2425,18 @@ void CVmImageLoader::discard_synth_exports()
     synth_exports_->delete_all_entries();
 }
 
+/* ------------------------------------------------------------------------ */
+/*
+ *   Set the restart snapshot 
+ */
+void CVmImageLoader::set_restart_state(CVmStream *str)
+{
+    /* delete any old snapshot, and remember the new one */
+    if (restart_state_ != 0)
+        delete restart_state_;
+    restart_state_ = str;
+}
+
 /* ------------------------------------------------------------------------ */
 /*
  *   Callback context for enumerating the synthesized export symbols for
@@ -3144,16 +3168,76 @@ const char *CVmImageFileMem::alloc_and_read(size_t len, uchar xor_mask,
     pos_ += len;
 
     /* 
-     *   we can't apply an xor mask to an in-memory page - if the mask is
-     *   non-zero, it's an error 
+     *   we can't apply an xor mask to the in-memory data, so if there's a
+     *   mask, unmask the data into a copy 
      */
     if (xor_mask != 0)
-        err_throw(VMERR_XOR_MASK_BAD_IN_MEM);
+    {
+        char *mem;
+
+        /* allocate the copy */
+        mem = (char *)t3malloc(len);
+        if (mem == 0)
+            err_throw(VMERR_OUT_OF_MEMORY);
+
+        /* copy and unmask the data */
+        memcpy(mem, ret, len);
+        CVmImagePool::apply_xor_mask(mem, len, xor_mask);
+
+        /* return the copy */
+        return mem;
+    }
 
     /* return the pointer */
     return ret;
 }
 
+/* ------------------------------------------------------------------------ */
+/*
+ *   Image file interface - memory-mapped disk file implementation 
+ */
+
+/*
+ *   map a file 
+ */
+CVmImageFileMap *CVmImageFileMap::create(CVmFile *fp)
+{
+    osfildef *osfp;
+    long base;
+    long len;
+    const char *mem;
+
+    /* we can only map a real OS file */
+    osfp = fp->get_osfp();
+    if (osfp == 0)
+        return 0;
+
+    /* the image runs from the base seek position to the end of the file */
+    base = fp->get_seek_base();
+    if (osfseek(osfp, 0, OSFSK_END))
+        return 0;
+    len = osfpos(osfp) - base;
+
+    /* go back to the start of the image */
+    fp->set_pos(0);
+
+    /* map the file; if we can't, let the caller read it instead */
+    mem = os_map_file(osfp, base, len);
+    if (mem == 0)
+        return 0;
+
+    /* create the image file object */
+    return new CVmImageFileMap(mem, len);
+}
+
+/*
+ *   release the mapping 
+ */
+CVmImageFileMap::~CVmImageFileMap()
+{
+    os_unmap_file(mem_, len_);
+}
+
 /* ------------------------------------------------------------------------ */
 /*
  *   Generic stream implementation for an image file block 
@@ -337,6 +337,13 @@ public:
      */
     vm_obj_id_t get_reflection_symtab() const { return reflection_symtab_; }
 
+    /* 
+     *   get the run-time global symbol table, if the image has one (it
+     *   only has one if it was compiled with debugging information) 
+     */
+    class CVmRuntimeSymbols *get_runtime_symtab() const
+        { return runtime_symtab_; }
+
     /* get the object ID of the LookupTable with the macro table */
     vm_obj_id_t get_reflection_macros() const { return reflection_macros_; }
 
@@ -362,6 +369,14 @@ public:
     int restore_synth_exports(VMG_ class CVmFile *fp,
                               class CVmObjFixup *fixups);
 
+    /* 
+     *   Get/set the snapshot of the initial program state that
+     *   CVmSaveFile::reset() takes for restarts.  We take ownership of the
+     *   stream, and delete it when we're done running the program.  
+     */
+    class CVmStream *get_restart_state() const { return restart_state_; }
+    void set_restart_state(class CVmStream *str);
+
     /* get the starting offset of static initializers in the code pool */
     ulong get_static_cs_ofs() const { return static_cs_ofs_; }
 
@@ -508,6 +523,9 @@ private:
      */
     class CVmHashTable *synth_exports_;
 
+    /* snapshot of the initial program state for restarts, if we have one */
+    class CVmStream *restart_state_;
+
     /*
      *   The runtime global symbol table, if we have one.  We'll build this
      *   from the debug records if we find any, or from the records passed
@@ -901,7 +919,11 @@ public:
     /* copy data to the caller's buffer */
     void copy_data(char *buf, size_t len);
 
-    /* allocate memory for and read data */
+    /* 
+     *   Allocate memory for and read data.  Unmasked data are returned
+     *   directly from the underlying memory block; data with an XOR mask
+     *   have to be unmasked into a copy, which we allocate separately.  
+     */
     const char *alloc_and_read(size_t len, uchar xor_mask,
                                ulong remaining_in_page);
 
@@ -912,12 +934,15 @@ public:
     virtual int allow_write_to_alloc() { return FALSE; }
 
     /* 
-     *   Free memory allocated by alloc_and_read.  Since our underlying
-     *   file is entirely in memory to start with, we don't actually ever
-     *   allocate any memory; hence, we don't actually need to free any
-     *   memory here.
+     *   Free memory allocated by alloc_and_read.  Most blocks point
+     *   directly into the underlying memory block, so there's nothing to
+     *   free; only the unmasked copies were actually allocated.  
      */
-    void free_mem(const char *) { }
+    void free_mem(const char *mem)
+    {
+        if (mem < mem_ || mem >= mem_ + len_)
+            t3free((char *)mem);
+    }
 
     /* seek to a new file position */
     void seek(long pos) { pos_ = pos; }
@@ -928,7 +953,7 @@ public:
     /* skip the given number of bytes */
     void skip_ahead(long len) { pos_ += len; }
 
-private:
+protected:
     /* the underlying memory block */
     const char *mem_;
 
@@ -939,6 +964,34 @@ private:
     long pos_;
 };
 
+/* ------------------------------------------------------------------------ */
+/*
+ *   Image file interface - memory-mapped disk file.  This maps the image
+ *   file into memory with the OS file mapping layer, so that code pages and
+ *   object data are used directly from the mapped file rather than being
+ *   read into allocated memory.  Pages are only read from disk when
+ *   they're first used, and several interpreters running the same game
+ *   share the same physical memory for the image.  
+ */
+class CVmImageFileMap: public CVmImageFileMem
+{
+public:
+    /* 
+     *   Map the image file that 'fp' reads, from its base seek position to
+     *   the end of the file.  Returns null if the file can't be mapped, in
+     *   which case the caller should read the file through a
+     *   CVmImageFileExt instead.  The file can be closed once it's mapped.
+     */
+    static CVmImageFileMap *create(class CVmFile *fp);
+
+    /* release the mapping */
+    ~CVmImageFileMap();
+
+protected:
+    CVmImageFileMap(const char *mem, long len)
+        : CVmImageFileMem(mem, len) { }
+};
+
 
 #endif /* VMIMAGE_H */
 
@@ -798,16 +798,17 @@ void CVmObjList::convert_to_const_data(VMG_ CVmConstMapper *mapper,
 ulong CVmObjString::rebuild_image(VMG_ char *buf, ulong buflen)
 {
     size_t copy_size;
+    const char *str = get_as_string(vmg0_);
 
     /* calculate how much space we need to store the data */
-    copy_size = vmb_get_len(ext_) + VMB_LEN;
+    copy_size = vmb_get_len(str) + VMB_LEN;
 
     /* make sure we have room for our data */
     if (copy_size > buflen)
         return copy_size;
 
     /* copy the data */
-    memcpy(buf, ext_, copy_size);
+    memcpy(buf, str, copy_size);
 
     /* return the size */
     return copy_size;
@@ -821,7 +822,8 @@ void CVmObjString::reserve_const_data(VMG_ CVmConstMapper *mapper,
                                       vm_obj_id_t self)
 {
     /* reserve the space for our string data */
-    mapper->alloc_pool_space(self, vmb_get_len(ext_) + VMB_LEN);
+    mapper->alloc_pool_space(
+        self, vmb_get_len(get_as_string(vmg0_)) + VMB_LEN);
 }
 
 
@@ -838,7 +840,10 @@ void CVmObjString::convert_to_const_data(VMG_ CVmConstMapper *mapper,
      *   value 
      */
     if (mapper->get_pool_addr(self))
-        mapper->store_data(self, ext_, vmb_get_len(ext_) + VMB_LEN);
+    {
+        const char *str = get_as_string(vmg0_);
+        mapper->store_data(self, str, vmb_get_len(str) + VMB_LEN);
+    }
 }
 
 
@@ -875,11 +880,13 @@ ulong CVmObjTads::rebuild_image(VMG_ char *buf, ulong buflen)
      *   actually need fewer, since some of the slots could be empty by
      *   virtue of having been undone.  We need space for our own header
      *   (UINT2 superclass count, UINT2 property count, UINT2 flags), plus a
-     *   UINT4 per superclass, plus a (UINT2 + DATAHOLDER) per property.  
+     *   UINT4 per superclass, plus a (UINT2 + DATAHOLDER) per property,
+     *   plus room for a prebuilt property index.  
      */
     size_t max_size = (2 + 2 + 2)
                       + get_sc_count() * 4
-                      + (get_hdr()->prop_entry_free * 7);
+                      + (get_hdr()->prop_entry_free * 7)
+                      + VMTOBJ_IMGIDX_MAX_SIZE;
 
     /* if it's more than we have available, ask for more space */
     if (max_size > buflen)
@@ -927,6 +934,9 @@ ulong CVmObjTads::rebuild_image(VMG_ char *buf, ulong buflen)
     /* sort the new table */
     qsort(props, prop_cnt, 7, &prop_compare);
 
+    /* add the prebuilt property index */
+    p += vm_tadsobj_hdr::build_image_index(p, props, prop_cnt);
+
     /* return the final size */
     return p - buf;
 }
@@ -50,6 +50,8 @@ Modified
 #include "osifcnet.h"
 #include "vmhash.h"
 #include "vmtz.h"
+#include "vmstr.h"
+#include "vmgram.h"
 
 
 
@@ -121,12 +123,14 @@ void vm_init_base(vm_globals **vmg, const vm_init_options *opts)
      *   is faster than the standard C++ run-time library's allocator on many
      *   platforms, so use it instead of hte basic 'malloc' allocator. 
      */
-    G_varheap = new CVmVarHeapHybrid(G_obj_table);
+    G_varheap = new CVmVarHeapSlab(G_obj_table);
+    // G_varheap = new CVmVarHeapHybrid(G_obj_table); for the older cell heap
     // G_varheap = new CVmVarHeapMalloc(); to use the system 'malloc' instead
     G_mem = new CVmMemory(vmg_ G_varheap);
 
     /* create the undo manager */
-    G_undo = new CVmUndo(VM_UNDO_MAX_RECORDS, VM_UNDO_MAX_SAVEPTS);
+    G_undo = new CVmUndo(VM_UNDO_MAX_RECORDS, VM_UNDO_MAX_SAVEPTS,
+                         VM_UNDO_MAX_BYTES);
 
     /* create the metafile and function set tables */
     G_meta_table = new CVmMetaTable(5);
@@ -135,6 +139,12 @@ void vm_init_base(vm_globals **vmg, const vm_init_options *opts)
     /* create the time zone cache */
     G_tzcache = new CVmTimeZoneCache();
 
+    /* create the string character index cache */
+    G_str_index = new CVmStrIndexCache();
+
+    /* create the grammar production parsing arena */
+    G_gram_arena = new CVmGramProdMem();
+
     /* initialize the metaclass registration tables */
     vm_register_metaclasses();
 
@@ -365,6 +375,14 @@ void vm_terminate(vm_globals *vmg__, CVmMainClientIfc *clientifc)
     /* delete the time zone cache */
     delete G_tzcache;
 
+    /* delete the string character index cache */
+    delete G_str_index;
+    G_str_index = 0;
+
+    /* delete the grammar production parsing arena */
+    delete G_gram_arena;
+    G_gram_arena = 0;
+
     /* delete the error context */
     err_terminate();
 
@@ -694,6 +694,72 @@ void CVmObjLookupTable::load_image_data(VMG_ const char *ptr, size_t siz)
     }
 }
 
+/*
+ *   Determine if we still match our image file data.  Since our extension
+ *   mirrors the image file layout, we simply compare it slot by slot: the
+ *   buckets, the value pool (including the free list), and the default
+ *   value.  This is stricter than necessary, since the same keys and values
+ *   could be arranged differently, but the arrangement determines the
+ *   iteration order, so it's part of our state.  
+ */
+int CVmObjLookupTable::matches_image_data(VMG_ const char *ptr,
+                                          size_t siz) const
+{
+    vm_lookup_ext *ext = get_ext();
+    const char *ibp;
+    vm_lookup_val **bp;
+    vm_lookup_val *val;
+    char buf[VMB_DATAHOLDER];
+    uint i;
+
+    /* the table sizes and free list head must match */
+    if (ext->bucket_cnt != osrp2(ptr)
+        || ext->value_cnt != osrp2(ptr + 2)
+        || ext->val_to_img_idx(ext->first_free) != osrp2(ptr + 4)
+        || siz < 6 + ext->bucket_cnt*2 + ext->value_cnt*VMLOOKUP_VALUE_SIZE)
+        return FALSE;
+
+    /* compare the buckets */
+    for (i = ext->bucket_cnt, ibp = ptr + 6, bp = ext->buckets ;
+         i != 0 ; --i, ibp += 2, ++bp)
+    {
+        if (ext->val_to_img_idx(*bp) != osrp2(ibp))
+            return FALSE;
+    }
+
+    /* compare the values */
+    for (i = ext->value_cnt, val = ext->idx_to_val(0) ;
+         i != 0 ; --i, ibp += VMLOOKUP_VALUE_SIZE, ++val)
+    {
+        /* compare the key */
+        vmb_put_dh(buf, &val->key);
+        if (!vmb_dh_same(buf, ibp))
+            return FALSE;
+
+        /* compare the value */
+        vmb_put_dh(buf, &val->val);
+        if (!vmb_dh_same(buf, ibp + VMB_DATAHOLDER))
+            return FALSE;
+
+        /* compare the chain link */
+        if (ext->val_to_img_idx(val->nxt) != osrp2(ibp + VMB_DATAHOLDER*2))
+            return FALSE;
+    }
+
+    /* compare the default value, which is nil if the image omits it */
+    if (ibp + VMB_DATAHOLDER <= ptr + siz)
+    {
+        vmb_put_dh(buf, &ext->default_value);
+        if (!vmb_dh_same(buf, ibp))
+            return FALSE;
+    }
+    else if (ext->default_value.typ != VM_NIL)
+        return FALSE;
+
+    /* everything matches */
+    return TRUE;
+}
+
 /* 
  *   save to a file 
  */
@@ -860,10 +926,10 @@ void CVmObjLookupTable::new_live_iterator(VMG_ vm_val_t *retval,
 /*
  *   add an undo record 
  */
-void CVmObjLookupTable::add_undo_rec(VMG_ vm_obj_id_t self,
-                                     lookuptab_undo_action action,
-                                     const vm_val_t *key,
-                                     const vm_val_t *old_entry_val)
+int CVmObjLookupTable::add_undo_rec(VMG_ vm_obj_id_t self,
+                                    lookuptab_undo_action action,
+                                    const vm_val_t *key,
+                                    const vm_val_t *old_entry_val)
 {
     lookuptab_undo_rec *rec;
     vm_val_t nil_val;
@@ -883,7 +949,8 @@ void CVmObjLookupTable::add_undo_rec(VMG_ vm_obj_id_t self,
     rec->key = *key;
 
     /* add the record to the global undo stream */
-    if (!G_undo->add_new_record_ptr_key(vmg_ self, rec, old_entry_val))
+    if (!G_undo->add_new_record_ptr_key(vmg_ self, rec, old_entry_val,
+                                        sizeof(lookuptab_undo_rec)))
     {
         /* 
          *   we didn't add an undo record, so our extra undo information
@@ -891,7 +958,11 @@ void CVmObjLookupTable::add_undo_rec(VMG_ vm_obj_id_t self,
          *   must delete our extra information 
          */
         t3free(rec);
+        return FALSE;
     }
+
+    /* the record was added */
+    return TRUE;
 }
 
 /*
@@ -940,6 +1011,10 @@ void CVmObjLookupTable::add_entry_undo(VMG_ vm_obj_id_t self,
     
     /* add the entry */
     add_entry(vmg_ key, val);
+
+    /* tell the garbage collector about the new references */
+    G_obj_table->note_ref_store(self, key);
+    G_obj_table->note_ref_store(self, val);
 }
 
 
@@ -1009,11 +1084,24 @@ void CVmObjLookupTable::set_entry_val_undo(VMG_ vm_obj_id_t self,
                                            vm_lookup_val *entry,
                                            const vm_val_t *val)
 {
-    /* generate undo for the change */
-    add_undo_rec(vmg_ self, LOOKUPTAB_UNDO_MOD, &entry->key, &entry->val);
+    /* 
+     *   Generate undo for the change, unless we already have undo for this
+     *   entry in the current savepoint.  We identify the entry by its index
+     *   in the value pool, which stays the same when the table expands.  An
+     *   entry's key can't change without deleting the old key and adding
+     *   the new one, and each addition saves its own undo, so an older
+     *   record for the same entry always restores the entry (or removes
+     *   it) as of the savepoint.  
+     */
+    uint idx = get_ext()->val_to_idx(entry);
+    if (!G_undo->is_key_saved(self, idx)
+        && add_undo_rec(vmg_ self, LOOKUPTAB_UNDO_MOD,
+                        &entry->key, &entry->val))
+        G_undo->note_key_saved(self, idx);
 
     /* update the entry */
     entry->val = *val;
+    G_obj_table->note_ref_store(self, val);
 }
 
 /*
@@ -1652,6 +1740,7 @@ int CVmObjLookupTable::getp_set_def_val(VMG_ vm_obj_id_t self,
 
     /* set the default value to the argument value */
     G_stk->pop(&get_ext()->default_value);
+    G_obj_table->note_ref_store(self, &get_ext()->default_value);
 
     /* return self */
     retval->set_obj(self);
@@ -357,6 +357,9 @@ public:
     void remove_stale_weak_refs(VMG0_) { }
     void remove_stale_undo_weak_ref(VMG_ struct CVmUndoRecord *) { }
 
+    /* we notify the object table of reference stores */
+    int has_write_barrier() const { return TRUE; }
+
     /* load from an image file */
     void load_from_image(VMG_ vm_obj_id_t self, const char *ptr, size_t siz);
 
@@ -381,6 +384,9 @@ public:
      */
     int is_changed_since_load() const { return TRUE; }
 
+    /* check to see if we still match our image file data */
+    int matches_image_data(VMG_ const char *ptr, size_t siz) const;
+
     /* get an entry; returns true if the entry exists, false if not */
     int index_check(VMG_ vm_val_t *result, const vm_val_t *index_val);
 
@@ -580,8 +586,11 @@ protected:
     void make_list(VMG_ vm_val_t *retval, int store_keys,
                    int (*filter)(VMG_ const vm_val_t *, const vm_val_t *));
 
-    /* add a record to the global undo stream */
-    void add_undo_rec(VMG_ vm_obj_id_t self,
+    /* 
+     *   add a record to the global undo stream; returns true if we added
+     *   the record, false if undo isn't being kept 
+     */
+    int add_undo_rec(VMG_ vm_obj_id_t self,
                       enum lookuptab_undo_action action,
                       const vm_val_t *key,
                       const vm_val_t *old_entry_val);
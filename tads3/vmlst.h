@@ -197,6 +197,12 @@ public:
      */
     void remove_stale_weak_refs(VMG0_) { }
 
+    /* 
+     *   lists are immutable once constructed, so they never need to notify
+     *   the object table of reference stores 
+     */
+    int has_write_barrier() const { return TRUE; }
+
     /* load from an image file */
     void load_from_image(VMG_ vm_obj_id_t, const char *ptr, size_t)
         { ext_ = (char *)ptr; }
@@ -0,0 +1,524 @@
+/*
+ *   Copyright (c) 2026 by the FrobTADS contributors.
+ *
+ *   Please see the accompanying license file, LICENSE.TXT, for information
+ *   on using and copying this software.
+ */
+/*
+Name
+  vmlz.cpp - LZ compressed data streams
+Function
+  Implements the LZ compressing and decompressing streams.  See vmlz.h for
+  the data format.
+Notes
+
+Modified
+  10/18/26 FrobTADS contributors - Creation
+*/
+
+#include <string.h>
+
+#include "t3std.h"
+#include "vmerr.h"
+#include "vmfile.h"
+#include "vmlz.h"
+
+
+/* ------------------------------------------------------------------------ */
+/*
+ *   Match finder parameters.  We hash the first VMLZ_MIN_MATCH bytes at
+ *   each position, and look back through at most VMLZ_MAX_CHAIN earlier
+ *   positions with the same hash for the longest match.
+ */
+const int VMLZ_HASH_BITS = 14;
+const size_t VMLZ_HASH_SIZE = (1 << VMLZ_HASH_BITS);
+const int VMLZ_MAX_CHAIN = 4;
+
+/* 
+ *   After a run of 2^VMLZ_SKIP_SHIFT positions without a match, we start
+ *   skipping ahead by more than one position at a time. 
+ */
+const int VMLZ_SKIP_SHIFT = 5;
+
+/* the farthest back a match can reach, given the two-byte offset */
+const size_t VMLZ_MAX_OFFSET = 65535;
+
+/*
+ *   Maximum size of a block's stored data.  In the worst case there are no
+ *   matches at all, and the block is one long literal run with an extended
+ *   literal count.
+ */
+const size_t VMLZ_MAX_STORED = VMLZ_BLOCK_SIZE + VMLZ_BLOCK_SIZE/255 + 16;
+
+/* 
+ *   load the VMLZ_MIN_MATCH bytes at the given position as a 32-bit value,
+ *   in the native byte order, for comparing and hashing 
+ */
+static inline uint32_t lz_load(const unsigned char *p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+/* hash the VMLZ_MIN_MATCH bytes at the given position */
+static inline size_t lz_hash(const unsigned char *p)
+{
+    return (size_t)((lz_load(p) * 2654435761U) >> (32 - VMLZ_HASH_BITS));
+}
+
+/* write an extended count */
+static inline unsigned char *lz_put_ext(unsigned char *op, size_t n)
+{
+    for ( ; n >= 255 ; n -= 255)
+        *op++ = 255;
+    *op++ = (unsigned char)n;
+    return op;
+}
+
+/*
+ *   Write a sequence: the literal run starting at 'lit' of length 'nlit',
+ *   followed by a match of length 'mlen' at distance 'ofs'.  If 'mlen' is
+ *   zero, this is the last sequence in the block, so it has no match.
+ */
+static unsigned char *lz_put_seq(unsigned char *op,
+                                 const unsigned char *lit, size_t nlit,
+                                 size_t ofs, size_t mlen)
+{
+    /* leave room for the token */
+    unsigned char *tok = op++;
+
+    /* write the literal count and the literals */
+    unsigned int t = (unsigned int)(nlit >= 15 ? 15 : nlit) << 4;
+    if (nlit >= 15)
+        op = lz_put_ext(op, nlit - 15);
+    memcpy(op, lit, nlit);
+    op += nlit;
+
+    /* write the match, if there is one */
+    if (mlen != 0)
+    {
+        size_t m = mlen - VMLZ_MIN_MATCH;
+        oswp2(op, (unsigned int)ofs);
+        op += 2;
+        t |= (m >= 15 ? 15 : m);
+        if (m >= 15)
+            op = lz_put_ext(op, m - 15);
+    }
+
+    /* fill in the token */
+    *tok = (unsigned char)t;
+    return op;
+}
+
+/* read an extended count */
+static size_t lz_get_ext(const unsigned char **ipp, const unsigned char *iend)
+{
+    size_t n = 0;
+    for (;;)
+    {
+        /* make sure there's another byte */
+        if (*ipp >= iend)
+            err_throw(VMERR_READ_FILE);
+
+        /* add it in; a byte of 255 means another byte follows */
+        unsigned char b = *(*ipp)++;
+        n += b;
+        if (b != 255)
+            return n;
+    }
+}
+
+
+/* ------------------------------------------------------------------------ */
+/*
+ *   Compressing write stream
+ */
+CVmLZWriteStream::CVmLZWriteStream(CVmFile *fp)
+{
+    /* remember the file */
+    fp_ = fp;
+
+    /* allocate our buffers */
+    buf_ = (char *)t3malloc(VMLZ_BLOCK_SIZE);
+    out_ = (char *)t3malloc(VMLZ_MAX_STORED);
+    head_ = (int32_t *)t3malloc(VMLZ_HASH_SIZE * sizeof(head_[0]));
+    prev_ = (int32_t *)t3malloc(VMLZ_BLOCK_SIZE * sizeof(prev_[0]));
+
+    /* nothing written yet */
+    len_ = 0;
+    total_ = 0;
+}
+
+CVmLZWriteStream::~CVmLZWriteStream()
+{
+    t3free(buf_);
+    t3free(out_);
+    t3free(head_);
+    t3free(prev_);
+}
+
+/*
+ *   write bytes
+ */
+void CVmLZWriteStream::write_bytes(const char *buf, size_t len)
+{
+    while (len != 0)
+    {
+        /* copy as much as fits into the current block */
+        size_t cur = VMLZ_BLOCK_SIZE - len_;
+        if (cur > len)
+            cur = len;
+        memcpy(buf_ + len_, buf, cur);
+
+        /* advance past the copied data */
+        len_ += cur;
+        total_ += cur;
+        buf += cur;
+        len -= cur;
+
+        /* if the block is full, write it out */
+        if (len_ == VMLZ_BLOCK_SIZE)
+            write_block();
+    }
+}
+
+/*
+ *   finish the stream
+ */
+void CVmLZWriteStream::finish()
+{
+    /* write out any partial block */
+    if (len_ != 0)
+        write_block();
+
+    /* write the end-of-stream marker */
+    fp_->write_uint4(0);
+}
+
+/*
+ *   compress and write out the current block
+ */
+void CVmLZWriteStream::write_block()
+{
+    const unsigned char *src = (const unsigned char *)buf_;
+    unsigned char *op = (unsigned char *)out_;
+    size_t n = len_;
+    size_t lit = 0;
+    size_t i = 0;
+
+    /* clear the hash table - each block is independent */
+    memset(head_, 0xff, VMLZ_HASH_SIZE * sizeof(head_[0]));
+
+    /* look for matches at each position that has room for one */
+    if (n >= VMLZ_MIN_MATCH)
+    {
+        size_t limit = n - VMLZ_MIN_MATCH;
+        while (i <= limit)
+        {
+            size_t h = lz_hash(src + i);
+            size_t best_len = 0;
+            size_t best_pos = 0;
+            int32_t cand;
+            int depth;
+
+            /* search the hash chain for the longest match */
+            for (cand = head_[h], depth = VMLZ_MAX_CHAIN ;
+                 cand >= 0 && depth > 0 && i - cand <= VMLZ_MAX_OFFSET ;
+                 cand = prev_[cand], --depth)
+            {
+                /*
+                 *   it can only beat the best so far if it matches at the
+                 *   best length; check that and the first bytes quickly
+                 */
+                if (src[cand + best_len] != src[i + best_len]
+                    || lz_load(src + cand) != lz_load(src + i))
+                    continue;
+
+                /* see how far the match goes */
+                size_t max = n - i;
+                size_t l = VMLZ_MIN_MATCH;
+                while (l < max && src[cand + l] == src[i + l])
+                    ++l;
+
+                /* keep the longest match */
+                if (l > best_len)
+                {
+                    best_len = l;
+                    best_pos = cand;
+
+                    /* we can't do better than matching to the end */
+                    if (l == max)
+                        break;
+                }
+            }
+
+            /* add this position to its hash chain */
+            prev_[i] = head_[h];
+            head_[h] = (int32_t)i;
+
+            /* 
+             *   If we didn't find a match, move on.  The longer we go
+             *   without finding a match, the farther ahead we move, so that
+             *   we don't waste much time on data that doesn't compress.  
+             */
+            if (best_len < VMLZ_MIN_MATCH)
+            {
+                i += 1 + ((i - lit) >> VMLZ_SKIP_SHIFT);
+                continue;
+            }
+
+            /* write the pending literals and the match */
+            op = lz_put_seq(op, src + lit, i - lit, i - best_pos, best_len);
+
+            /* 
+             *   Skip past the match.  To save time, we don't add the
+             *   positions within the match to the hash chains, except for
+             *   the one just before the end, which is the likeliest to start
+             *   a match with what follows.  
+             */
+            i += best_len;
+            lit = i;
+            if (i - 2 <= limit)
+            {
+                h = lz_hash(src + i - 2);
+                prev_[i - 2] = head_[h];
+                head_[h] = (int32_t)(i - 2);
+            }
+        }
+    }
+
+    /* write the final literals */
+    op = lz_put_seq(op, src + lit, n - lit, 0, 0);
+
+    /*
+     *   write the block header, and the compressed data, or the original
+     *   data if compressing didn't make it any smaller
+     */
+    size_t stored = op - (unsigned char *)out_;
+    fp_->write_uint4((uint)n);
+    if (stored < n)
+    {
+        fp_->write_uint4((uint)stored);
+        fp_->write_bytes(out_, stored);
+    }
+    else
+    {
+        fp_->write_uint4((uint)n);
+        fp_->write_bytes(buf_, n);
+    }
+
+    /* the block is now empty */
+    len_ = 0;
+}
+
+
+/* ------------------------------------------------------------------------ */
+/*
+ *   Decompressing read stream
+ */
+CVmLZReadStream::CVmLZReadStream(CVmFile *fp)
+{
+    /* remember the file */
+    fp_ = fp;
+
+    /* allocate our buffers */
+    buf_ = (char *)t3malloc(VMLZ_BLOCK_SIZE);
+    in_ = (char *)t3malloc(VMLZ_MAX_STORED);
+
+    /* we don't have a block yet */
+    len_ = idx_ = 0;
+    pos_ = 0;
+    eof_ = FALSE;
+}
+
+CVmLZReadStream::~CVmLZReadStream()
+{
+    t3free(buf_);
+    t3free(in_);
+}
+
+/*
+ *   read and decompress the next block
+ */
+int CVmLZReadStream::read_block()
+{
+    /* if we've already reached the end, there's nothing more to read */
+    if (eof_)
+        return FALSE;
+
+    /* read the block header; a zero length marks the end of the stream */
+    size_t raw = fp_->read_uint4();
+    if (raw == 0)
+    {
+        eof_ = TRUE;
+        return FALSE;
+    }
+    size_t stored = fp_->read_uint4();
+
+    /* make sure the sizes are sensible */
+    if (raw > VMLZ_BLOCK_SIZE || stored > VMLZ_MAX_STORED)
+        err_throw(VMERR_READ_FILE);
+
+    /* if the block is stored as is, just read it */
+    if (stored == raw)
+    {
+        fp_->read_bytes(buf_, raw);
+    }
+    else
+    {
+        const unsigned char *ip = (const unsigned char *)in_;
+        const unsigned char *iend = ip + stored;
+        unsigned char *out = (unsigned char *)buf_;
+        unsigned char *op = out;
+        unsigned char *oend = out + raw;
+
+        /* read the compressed data */
+        fp_->read_bytes(in_, stored);
+
+        /* decode the sequences */
+        for (;;)
+        {
+            /* read the token */
+            if (ip >= iend)
+                err_throw(VMERR_READ_FILE);
+            unsigned int t = *ip++;
+
+            /* copy the literals */
+            size_t nlit = t >> 4;
+            if (nlit == 15)
+                nlit += lz_get_ext(&ip, iend);
+            if (nlit > (size_t)(iend - ip) || nlit > (size_t)(oend - op))
+                err_throw(VMERR_READ_FILE);
+            memcpy(op, ip, nlit);
+            op += nlit;
+            ip += nlit;
+
+            /* the last sequence ends at the end of the data */
+            if (ip == iend)
+                break;
+
+            /* read the match offset and length */
+            if (iend - ip < 2)
+                err_throw(VMERR_READ_FILE);
+            size_t ofs = osrp2(ip);
+            ip += 2;
+            size_t mlen = t & 15;
+            if (mlen == 15)
+                mlen += lz_get_ext(&ip, iend);
+            mlen += VMLZ_MIN_MATCH;
+
+            /* make sure the match is within the block */
+            if (ofs == 0 || ofs > (size_t)(op - out)
+                || mlen > (size_t)(oend - op))
+                err_throw(VMERR_READ_FILE);
+
+            /*
+             *   copy the match - a byte at a time, since it can overlap the
+             *   bytes it's producing
+             */
+            for (const unsigned char *mp = op - ofs ; mlen != 0 ; --mlen)
+                *op++ = *mp++;
+        }
+
+        /* the block has to decode to exactly its original size */
+        if (op != oend)
+            err_throw(VMERR_READ_FILE);
+    }
+
+    /* start reading at the beginning of the new block */
+    len_ = raw;
+    idx_ = 0;
+    return TRUE;
+}
+
+/*
+ *   read bytes; throws an error if we reach the end of the stream first
+ */
+void CVmLZReadStream::read_bytes(char *buf, size_t len)
+{
+    if (read_nbytes(buf, len) != len)
+        err_throw(VMERR_READ_FILE);
+}
+
+/*
+ *   read bytes, returning the number of bytes read
+ */
+size_t CVmLZReadStream::read_nbytes(char *buf, size_t len)
+{
+    size_t total = 0;
+    while (len != 0)
+    {
+        /* if we've exhausted the current block, read the next one */
+        if (idx_ == len_ && !read_block())
+            break;
+
+        /* copy as much as we can from the current block */
+        size_t cur = len_ - idx_;
+        if (cur > len)
+            cur = len;
+        memcpy(buf, buf_ + idx_, cur);
+
+        /* advance past the copied data */
+        idx_ += cur;
+        pos_ += (long)cur;
+        buf += cur;
+        len -= cur;
+        total += cur;
+    }
+
+    /* return the number of bytes we read */
+    return total;
+}
+
+/*
+ *   read a line, with fgets semantics
+ */
+char *CVmLZReadStream::read_line(char *buf, size_t len)
+{
+    size_t i;
+
+    /* read characters until we reach a newline or fill the buffer */
+    for (i = 0 ; i + 1 < len ; )
+    {
+        char c;
+        if (read_nbytes(&c, 1) == 0)
+            break;
+        buf[i++] = c;
+        if (c == '\n')
+            break;
+    }
+
+    /* if we didn't read anything, we're at the end of the stream */
+    if (i == 0)
+        return 0;
+
+    /* null-terminate the line */
+    buf[i] = '\0';
+    return buf;
+}
+
+/*
+ *   seek forward, by skipping data
+ */
+void CVmLZReadStream::set_seek_pos(long pos)
+{
+    /* we can't go back */
+    if (pos < pos_)
+        err_throw(VMERR_READ_FILE);
+
+    /* skip ahead */
+    while (pos > pos_)
+    {
+        /* if we've exhausted the current block, read the next one */
+        if (idx_ == len_ && !read_block())
+            err_throw(VMERR_READ_FILE);
+
+        /* skip as much as we can in the current block */
+        size_t cur = len_ - idx_;
+        if ((long)cur > pos - pos_)
+            cur = (size_t)(pos - pos_);
+        idx_ += cur;
+        pos_ += (long)cur;
+    }
+}
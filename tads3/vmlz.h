@@ -0,0 +1,192 @@
+/*
+ *   Copyright (c) 2026 by the FrobTADS contributors.
+ *
+ *   Please see the accompanying license file, LICENSE.TXT, for information
+ *   on using and copying this software.
+ */
+/*
+Name
+  vmlz.h - LZ compressed data streams
+Function
+  Provides a simple, fast LZ77-style compressor and decompressor, packaged
+  as generic streams (CVmStream) layered over an underlying file.  The
+  write stream compresses everything written to it into the file; the read
+  stream decompresses the file's contents incrementally as the caller
+  reads.  We use these for saved state files.
+Notes
+  The compressed data is a series of blocks, each holding up to
+  VMLZ_BLOCK_SIZE bytes of the original data:
+
+.    UINT4      - number of original bytes in the block, or 0 for the end
+.                 of the stream
+.    UINT4      - number of stored bytes that follow
+.    <? bytes>  - the stored bytes
+
+  If the stored size equals the original size, the block is stored as is,
+  because compression didn't make it any smaller.  Otherwise the stored
+  bytes are a series of sequences, each of which copies some literal bytes
+  and then repeats some earlier bytes from the same block:
+
+.    BYTE       - token: the high four bits are the literal count, and the
+.                 low four bits are the match length minus VMLZ_MIN_MATCH
+.    <? bytes>  - more of the literal count, if the high bits are 15
+.    <? bytes>  - the literal bytes
+.    UINT2      - match offset - the distance back to the bytes to repeat
+.    <? bytes>  - more of the match length, if the low bits are 15
+
+  An extended count is a series of bytes that are added to the count; each
+  byte of 255 means another byte follows.  The last sequence in a block has
+  only literals, and ends at the end of the stored data.
+
+  Each block is independent of the others, so the decompressor only needs
+  one block's worth of memory.
+Modified
+  10/18/26 FrobTADS contributors - Creation
+*/
+
+#ifndef VMLZ_H
+#define VMLZ_H
+
+#include "t3std.h"
+#include "vmfile.h"
+
+/* maximum number of original bytes in a block */
+const size_t VMLZ_BLOCK_SIZE = 65536;
+
+/* minimum match length - shorter repeats are stored as literals */
+const size_t VMLZ_MIN_MATCH = 4;
+
+
+/* ------------------------------------------------------------------------ */
+/*
+ *   Compressing write stream.  Everything written to the stream is
+ *   compressed and written to the underlying file.  The caller must call
+ *   finish() after writing the last byte, to flush the last block and write
+ *   the end-of-stream marker.
+ *
+ *   This stream is write-only, and can't seek, since the compressed data
+ *   can't be changed after the fact.
+ */
+class CVmLZWriteStream: public CVmStream
+{
+public:
+    CVmLZWriteStream(CVmFile *fp);
+    ~CVmLZWriteStream();
+
+    /* finish the stream */
+    void finish();
+
+    /* we can't clone a compressor */
+    virtual CVmStream *clone(VMG_ const char *) { return 0; }
+
+    /* we're write-only */
+    virtual void read_bytes(char *, size_t) { err_throw(VMERR_READ_FILE); }
+    virtual size_t read_nbytes(char *, size_t) { return 0; }
+    virtual char *read_line(char *, size_t) { return 0; }
+
+    /* write bytes */
+    virtual void write_bytes(const char *buf, size_t len);
+
+    /* the seek position is the number of bytes written so far */
+    virtual long get_seek_pos() const { return total_; }
+
+    /* we can only "seek" to where we already are */
+    virtual void set_seek_pos(long pos)
+    {
+        if (pos != total_)
+            err_throw(VMERR_WRITE_FILE);
+    }
+
+    /* the length is the number of bytes written so far */
+    virtual long get_len() { return total_; }
+
+protected:
+    /* compress and write out the current block */
+    void write_block();
+
+    /* the underlying file */
+    CVmFile *fp_;
+
+    /* the current block of original data, and the number of bytes in it */
+    char *buf_;
+    size_t len_;
+
+    /* the output buffer for compressing a block */
+    char *out_;
+
+    /*
+     *   The match finder's tables.  head_[h] is the most recent position in
+     *   the block with hash value h, and prev_[i] is the previous position
+     *   with the same hash value as position i.  Both use -1 for "none".
+     */
+    int32_t *head_;
+    int32_t *prev_;
+
+    /* total number of bytes written */
+    long total_;
+};
+
+
+/* ------------------------------------------------------------------------ */
+/*
+ *   Decompressing read stream.  Reads compressed data from the underlying
+ *   file, a block at a time, as the caller reads from the stream.
+ *
+ *   This stream is read-only.  It can only seek forward, by skipping bytes.
+ */
+class CVmLZReadStream: public CVmStream
+{
+public:
+    CVmLZReadStream(CVmFile *fp);
+    ~CVmLZReadStream();
+
+    /* we can't clone a decompressor */
+    virtual CVmStream *clone(VMG_ const char *) { return 0; }
+
+    /* read bytes */
+    virtual void read_bytes(char *buf, size_t len);
+    virtual size_t read_nbytes(char *buf, size_t len);
+    virtual char *read_line(char *buf, size_t len);
+
+    /* we're read-only */
+    virtual void write_bytes(const char *, size_t)
+        { err_throw(VMERR_WRITE_FILE); }
+
+    /* the seek position is the number of bytes read so far */
+    virtual long get_seek_pos() const { return pos_; }
+
+    /* seek forward */
+    virtual void set_seek_pos(long pos);
+
+    /*
+     *   We don't know the length until we reach the end, so we simply
+     *   report the data we've decompressed so far.
+     */
+    virtual long get_len() { return pos_ + (long)(len_ - idx_); }
+
+protected:
+    /*
+     *   read and decompress the next block; returns false at the end of the
+     *   stream
+     */
+    int read_block();
+
+    /* the underlying file */
+    CVmFile *fp_;
+
+    /* the current decompressed block, its length, and our read index */
+    char *buf_;
+    size_t len_;
+    size_t idx_;
+
+    /* the compressed data for the current block */
+    char *in_;
+
+    /* current seek position (number of bytes read so far) */
+    long pos_;
+
+    /* have we reached the end-of-stream marker? */
+    int eof_;
+};
+
+#endif /* VMLZ_H */
@@ -50,6 +50,7 @@ Modified
 #include "sha2.h"
 #include "vmnet.h"
 #include "vmtz.h"
+#include "vmundo.h"
 
 
 /* ------------------------------------------------------------------------ */
@@ -146,6 +147,13 @@ int vm_run_image(const vm_run_image_params *params)
         /* set the local time zone, if specified */
         if (params->timezone)
             G_tzcache->set_local_zone(params->timezone);
+
+        /* set the number of garbage collector threads */
+        G_obj_table->set_gc_threads(params->gc_threads);
+
+        /* set the undo byte budget, if specified */
+        if (params->undo_max_bytes != 0)
+            G_undo->set_max_bytes(vmg_ params->undo_max_bytes);
         
         /* tell the client system to initialize */
         params->clientifc->client_init(
@@ -176,8 +184,12 @@ int vm_run_image(const vm_run_image_params *params)
             fp->open_read(G_os_gamename, OSFTT3IMG);
         }
 
-        /* create the loader */
-        imagefp = new CVmImageFileExt(fp);
+        /* 
+         *   create the loader - map the image file into memory if we can,
+         *   otherwise read it from the file 
+         */
+        if ((imagefp = CVmImageFileMap::create(fp)) == 0)
+            imagefp = new CVmImageFileExt(fp);
         loader = new CVmImageLoader(imagefp, G_os_gamename, image_file_base);
 
         /* load the image */
@@ -206,6 +218,13 @@ int vm_run_image(const vm_run_image_params *params)
         }
 #endif /* TADSNET */
 
+        /* if desired, start the sampling profiler */
+        if (params->profile_file != 0
+            && !G_interpreter->start_sampling(vmg_ params->profile_file))
+            params->clientifc->display_error(
+                VMGLOB_ADDR, 0, "The profiler isn't available on this system.",
+                FALSE);
+
         /* run the program from the main entrypoint */
         loader->run(vmg_ params->prog_argv, params->prog_argc,
                     0, 0, params->saved_state);
@@ -238,6 +257,26 @@ int vm_run_image(const vm_run_image_params *params)
     }
     err_end;
 
+#ifdef VM_OPSTATS
+    /* write the opcode statistics, if desired */
+    if (params->opstats_file != 0
+        && !G_interpreter->write_opstats(params->opstats_file))
+        params->clientifc->display_error(
+            VMGLOB_ADDR, 0, "Unable to write the opcode statistics file.",
+            FALSE);
+#endif
+
+    /* 
+     *   if we were profiling, write the profile - do this before unloading
+     *   the image, since we need its symbols to name the functions 
+     */
+    if (params->profile_file != 0
+        && !G_interpreter->end_sampling(
+            vmg_ loader != 0 ? loader->get_runtime_symtab() : 0))
+        params->clientifc->display_error(
+            VMGLOB_ADDR, 0, "Unable to write the profiler output file.",
+            FALSE);
+
     /* done with the file base path and sandbox path */
     lib_free_str(G_file_path);
     lib_free_str(G_sandbox_path);
@@ -565,6 +604,20 @@ int vm_run_image_main(CVmMainClientIfc *clientifc,
             break;
 
         case 'o':
+            /* -opstats=file - write opcode statistics */
+            if (strncmp(argv[curarg], "-opstats=", 9) == 0
+                && argv[curarg][9] != '\0')
+            {
+#ifdef VM_OPSTATS
+                params.opstats_file = argv[curarg] + 9;
+#else
+                clientifc->display_error(
+                    0, 0, "Warning: this interpreter wasn't built with "
+                    "opcode statistics; -opstats ignored.", FALSE);
+#endif
+                break;
+            }
+
             /* log commands to file */
             params.cmd_log_file = get_opt_arg(argc, argv, &curarg, 2);
             if (params.cmd_log_file == 0)
@@ -579,6 +632,13 @@ int vm_run_image_main(CVmMainClientIfc *clientifc,
                 clientifc->set_plain_mode();
                 break;
             }
+            else if (strncmp(argv[curarg], "-profile=", 9) == 0
+                     && argv[curarg][9] != '\0')
+            {
+                /* run the sampling profiler, writing to the given file */
+                params.profile_file = argv[curarg] + 9;
+                break;
+            }
             else
                 goto opt_error;
             break;
@@ -617,6 +677,22 @@ int vm_run_image_main(CVmMainClientIfc *clientifc,
                 goto opt_error;
             break;
 
+        case 'g':
+            /* -gcthreads - set the number of garbage collector threads */
+            if (strcmp(argv[curarg], "-gcthreads") == 0 && curarg+1 < argc)
+                params.gc_threads = atoi(argv[++curarg]);
+            else
+                goto opt_error;
+            break;
+
+        case 'u':
+            /* -undobytes - set the undo byte budget */
+            if (strcmp(argv[curarg], "-undobytes") == 0 && curarg+1 < argc)
+                params.undo_max_bytes = (size_t)atol(argv[++curarg]);
+            else
+                goto opt_error;
+            break;
+
         case 't':
             /* -tz - set local timezone */
             if (strcmp(argv[curarg], "-tz") == 0 && curarg+1 < argc)
@@ -811,6 +887,8 @@ int vm_run_image_main(CVmMainClientIfc *clientifc,
                     "and display\n"
                     "  -csl xxx - use character set 'xxx' for log files\n"
                     "  -d path - set default directory for file operations\n"
+                    "  -gcthreads n - use n threads for garbage collection "
+                    "(0 = automatic)\n"
                     "  -i file - read command input from file (quiet mode)\n"
                     "  -I file - read command input from file (echo mode)\n"
                     "  -l file - log all console input/output to file\n"
@@ -820,8 +898,14 @@ int vm_run_image_main(CVmMainClientIfc *clientifc,
                     "            0 to 2 - 0 is the least restrictive, 2 "
                     "allows no network access)\n"
                     "  -o file - log console input to file\n"
+                    "  -opstats=file - write opcode execution statistics "
+                    "to file (only in\n"
+                    "            interpreters built with VM_OPSTATS)\n"
                     "  -plain  - run in plain mode (no cursor positioning, "
                     "colors, etc.)\n"
+                    "  -profile=file - write a sampling profile of the "
+                    "program's execution to\n"
+                    "            file, in flame graph folded-stack format\n"
                     "  -r file - restore saved state from file\n"
                     "  -R dir  - set directory for external resources\n"
                     "  -s##    - set file safety level for read & write "
@@ -832,6 +916,8 @@ int vm_run_image_main(CVmMainClientIfc *clientifc,
                     "safety restrictions\n"
                     "  -tz z   - set the local time zone to 'z' (e.g., "
                     "America/New_York)\n"
+                    "  -undobytes n - limit the memory used for undo to n "
+                    "bytes\n"
                     "\n"
                     "If provided, the optional extra arguments are passed "
                     "to the program's\n"
@@ -1131,10 +1217,10 @@ int vm_get_game_arg(int argc, const char *const *argv,
 
         case 'u':
             /* 
-             *   tads 2 "-uSize" - argument required, so consume the next
-             *   vector item if necessary 
+             *   tads 2 "-uSize" or tads 3 "-undobytes n" - argument
+             *   required, so consume the next vector item if necessary 
              */
-            if (argv[i][2] == '\0')
+            if (argv[i][2] == '\0' || strcmp(argv[i], "-undobytes") == 0)
                 ++i;
             break;
 
@@ -1163,6 +1249,12 @@ int vm_get_game_arg(int argc, const char *const *argv,
             }
             break;
 
+        case 'g':
+            /* tads 3 "-gcthreads n" - consume an argument */
+            if (strcmp(argv[i], "-gcthreads") == 0)
+                ++i;
+            break;
+
         case 'i':
             /* tads 2/3 "-iFile" - consume an argument */
             if (argv[i][2] == '\0')
@@ -1182,7 +1274,10 @@ int vm_get_game_arg(int argc, const char *const *argv,
             break;
 
         case 'p':
-            /* tads 2/3 "-plain"; tads 2 "-p[+-]" - no arguments */
+            /* 
+             *   tads 2/3 "-plain"; tads 3 "-profile=file"; tads 2 "-p[+-]" -
+             *   no separate arguments 
+             */
             break;
 
         case 'R':
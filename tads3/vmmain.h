@@ -161,6 +161,18 @@ struct vm_run_image_params
 
         /* assume we'll get the local time zone from the operating system */
         timezone = 0;
+
+        /* choose the number of garbage collector threads automatically */
+        gc_threads = 0;
+
+        /* use the default undo memory limit */
+        undo_max_bytes = 0;
+
+        /* assume we won't run the sampling profiler */
+        profile_file = 0;
+
+        /* assume we won't write opcode statistics */
+        opstats_file = 0;
     }
     
     /* 
@@ -288,6 +300,37 @@ struct vm_run_image_params
      *   operating system or environment.
      */
     const char *timezone;
+
+    /*
+     *   Number of threads to use for marking in full garbage collections.
+     *   Zero lets the VM choose based on the number of processors; 1 forces
+     *   single-threaded collection. 
+     */
+    int gc_threads;
+
+    /*
+     *   Undo byte budget.  If this is non-zero, it limits the memory used
+     *   for undo to this many bytes, overriding the compiled-in default
+     *   (VM_UNDO_MAX_BYTES); the oldest savepoints are discarded as needed
+     *   to stay within it.  
+     */
+    size_t undo_max_bytes;
+
+    /*
+     *   Sampling profiler output file.  If this is non-null, we run the
+     *   sampling profiler while the program executes, and write the sampled
+     *   call stacks to this file, in the "folded" format read by flame
+     *   graph tools, when the program terminates.
+     */
+    const char *profile_file;
+
+    /*
+     *   Opcode statistics output file.  If this is non-null, and the VM was
+     *   built with opcode statistics (VM_OPSTATS - see vmprof.h), we write
+     *   the per-opcode execution counts and times to this file when the
+     *   program terminates.  This is ignored in other builds.
+     */
+    const char *opstats_file;
 };
 
 /*
@@ -1495,6 +1495,14 @@ void CVmObjTable::init(VMG0_)
     /* enable the garbage collector */
     gc_enabled_ = TRUE;
 
+    /* start out with no generational state */
+    gc_minor_ = FALSE;
+    gc_reset_generations();
+
+    /* choose the number of marking threads automatically */
+    gc_threads_ = 0;
+    gc_par_ = 0;
+
     /* there are no saved image data pointers yet */
     image_ptr_head_ = 0;
     image_ptr_tail_ = 0;
@@ -1526,6 +1534,7 @@ void CVmObjTable::init(VMG0_)
     obj0->in_undo_ = FALSE;
     obj0->transient_ = FALSE;
     obj0->requested_post_load_init_ = FALSE;
+    obj0->matches_image_ = FALSE;
     obj0->can_have_refs_ = FALSE;
     obj0->can_have_weak_refs_ = FALSE;
 }
@@ -1591,6 +1600,11 @@ void CVmObjTable::delete_obj_table(VMG0_)
     allocs_since_gc_ = 0;
     bytes_since_gc_ = 0;
 
+    /* release the generational GC lists */
+    gc_young_.reset();
+    gc_remembered_.reset();
+    gc_scan_always_.reset();
+
     /* delete each object image data pointer page */
     for (vm_image_ptr_page *ip_page = image_ptr_head_, *ip_next = 0 ;
          ip_page != 0 ; ip_page = ip_next)
@@ -1688,9 +1702,23 @@ void CVmObjTable::gc_before_alloc(VMG0_)
     /* count it if in statistics mode */
     IF_GC_STATS(gc_stats.begin_pass());
 
-    /* run a full garbage collection pass */
-    gc_pass_init(vmg0_);
-    gc_pass_finish(vmg0_);
+    /* 
+     *   Run a minor collection if we can, otherwise a full collection.  We
+     *   periodically run a full pass even when minor collections are
+     *   possible, since that's the only way to reclaim old objects.  
+     */
+    if (!gc_need_full_ && gc_minor_cnt_ < VM_GC_MINOR_PER_FULL)
+    {
+        /* run a minor collection */
+        gc_minor(vmg0_);
+        ++gc_minor_cnt_;
+    }
+    else
+    {
+        /* run a full garbage collection pass */
+        gc_pass_init(vmg0_);
+        gc_pass_finish(vmg0_);
+    }
 
     /* count it if in statistics mode */
     IF_GC_STATS(gc_stats.end_pass());
@@ -1757,6 +1785,9 @@ void CVmObjTable::init_entry_for_alloc(vm_obj_id_t id,
     /* presume it won't need post-load initialization */
     entry->requested_post_load_init_ = FALSE;
 
+    /* it's not marked as matching its image data */
+    entry->matches_image_ = FALSE;
+
     /* set the GC characteristics as requested */
     entry->can_have_refs_ = can_have_refs;
     entry->can_have_weak_refs_ = can_have_weak_refs;
@@ -1775,6 +1806,15 @@ void CVmObjTable::init_entry_for_alloc(vm_obj_id_t id,
     entry->reachable_ = VMOBJ_UNREACHABLE;
     entry->finalize_state_ = VMOBJ_UNFINALIZABLE;
 
+    /* 
+     *   Root set objects are permanently in the old generation.  Anything
+     *   else starts out in the nursery. 
+     */
+    entry->old_ = in_root_set;
+    entry->remembered_ = FALSE;
+    if (!in_root_set)
+        gc_young_.append(id);
+
     /* add it to the GC work queue for the next GC pass */
     if (in_root_set)
         add_to_gc_queue(id, entry, VMOBJ_REACHABLE);
@@ -2104,9 +2144,11 @@ void CVmObjTable::gc_pass_finish(VMG0_)
      *   Make sure we're done processing the work queue -- keep calling
      *   gc_pass_continue() until it indicates that it's finished.  If
      *   we're skipping finalizers, stop as soon as the state structure
-     *   indicates that we've started running finalizers.  
+     *   indicates that we've started running finalizers.  Everything in
+     *   the queue at this point is simply reachable, so this is where we
+     *   can use parallel marking.  
      */
-    gc_trace_work_queue(vmg_ TRUE);
+    gc_trace_work_queue_par(vmg0_);
 
     /*
      *   We've now marked everything that's reachable from the root set as
@@ -2252,36 +2294,740 @@ void CVmObjTable::gc_pass_finish(VMG0_)
                      *   we're properly set up for the next GC pass 
                      */
                     gc_set_init_conditions(id, entry);
+
+                    /* it's survived a collection, so it's now old */
+                    entry->old_ = TRUE;
+                    entry->remembered_ = FALSE;
+                }
+            }
+        }
+    }
+    
+    /*
+     *   Go through the undo records and clear any stale weak references
+     *   contained in the undo list.  
+     */
+    G_undo->gc_remove_stale_weak_refs(vmg0_);
+
+    /* 
+     *   everything that's left is now in the old generation, so start over
+     *   with an empty nursery 
+     */
+    gc_reset_generations();
+
+    /* let the heap manager clean up after the objects we've deleted */
+    G_varheap->finish_gc_pass();
+
+    /*
+     *   All of the finalizable objects are now in the finalizer queue.  Run
+     *   through the finalizer queue and run each such object's finalizer. 
+     */
+    run_finalizers(vmg0_);
+}
+
+/*
+ *   Reset the generational state 
+ */
+void CVmObjTable::gc_reset_generations()
+{
+    /* 
+     *   empty the nursery and the remembered set (the caller is responsible
+     *   for clearing the 'remembered' flags in the objects themselves) 
+     */
+    gc_young_.clear();
+    gc_remembered_.clear();
+
+    /* the set of old objects without write barriers might have changed */
+    gc_scan_always_.clear();
+    gc_scan_always_valid_ = FALSE;
+
+    /* we're starting a new series of minor collections */
+    gc_minor_cnt_ = 0;
+    gc_need_full_ = FALSE;
+}
+
+/*
+ *   Run a minor collection.  This only considers objects in the nursery -
+ *   those allocated since the last collection - for deletion.  Every old
+ *   object is treated as reachable without being traced, so the roots of
+ *   the nursery are the ordinary roots (stack, imports, globals, undo),
+ *   plus the old objects that might refer to nursery objects: those in the
+ *   remembered set, and those whose metaclasses don't implement the write
+ *   barrier.
+ *   
+ *   A nursery object with a finalizer is never deleted here, even if it's
+ *   unreachable; we simply promote it (along with everything it refers to)
+ *   and leave it to the next full collection to finalize it.  Likewise, we
+ *   don't run finalizers here.  Everything that survives is promoted to
+ *   the old generation, so the nursery is empty when we're done.  
+ */
+void CVmObjTable::gc_minor(VMG0_)
+{
+    size_t i, cnt;
+
+    /* reset the allocation counters, as for a full pass */
+    allocs_since_gc_ = 0;
+    bytes_since_gc_ = 0;
+
+    /* 
+     *   Set aside the main work queue.  Between collections, this holds the
+     *   root set objects in preparation for the next full pass; we mustn't
+     *   trace those, and we have to leave the queue intact when we're done.
+     */
+    vm_obj_id_t main_queue = gc_queue_head_;
+    gc_queue_head_ = VM_INVALID_OBJ;
+
+    /* we're now in a minor collection */
+    gc_minor_ = TRUE;
+
+    /* 
+     *   if necessary, build the list of old objects without write barriers
+     *   (we only have to do this once after each full collection, since we
+     *   add newly promoted objects to the list as we promote them) 
+     */
+    if (!gc_scan_always_valid_)
+    {
+        CVmObjPageEntry **pg;
+        vm_obj_id_t id;
+        for (id = 0, i = pages_used_, pg = pages_ ; i > 0 ; ++pg, --i)
+        {
+            CVmObjPageEntry *entry;
+            size_t j;
+            for (j = VM_OBJ_PAGE_CNT, entry = *pg ; j > 0 ;
+                 --j, ++entry, ++id)
+            {
+                if (!entry->free_ && entry->old_ && entry->can_have_refs_
+                    && !entry->get_vm_obj()->has_write_barrier())
+                    gc_scan_always_.append(id);
+            }
+        }
+        gc_scan_always_valid_ = TRUE;
+    }
+
+    /* 
+     *   trace the ordinary roots (this adds old objects directly referenced
+     *   from the roots to the remembered set) 
+     */
+    gc_trace_stack(vmg0_);
+    gc_trace_imports(vmg0_);
+    gc_trace_globals(vmg0_);
+    G_undo->gc_mark_refs(vmg0_);
+
+    /* trace the remembered set */
+    for (i = 0, cnt = gc_remembered_.get_count() ; i < cnt ; ++i)
+    {
+        CVmObjPageEntry *entry = get_entry(gc_remembered_.get(i));
+        if (entry->can_have_refs_)
+            entry->get_vm_obj()->mark_refs(vmg_ VMOBJ_REACHABLE);
+    }
+
+    /* trace the old objects that don't have write barriers */
+    for (i = 0, cnt = gc_scan_always_.get_count() ; i < cnt ; ++i)
+    {
+        CVmObjPageEntry *entry = get_entry(gc_scan_always_.get(i));
+        if (!entry->free_ && !entry->remembered_)
+            entry->get_vm_obj()->mark_refs(vmg_ VMOBJ_REACHABLE);
+    }
+
+    /* trace everything reachable from the roots */
+    gc_trace_work_queue(vmg_ TRUE);
+
+    /* 
+     *   Keep unreachable nursery objects with finalizers, along with
+     *   everything they refer to.  The next full pass will finalize them. 
+     */
+    for (i = 0, cnt = gc_young_.get_count() ; i < cnt ; ++i)
+    {
+        vm_obj_id_t id = gc_young_.get(i);
+        CVmObjPageEntry *entry = get_entry(id);
+        if (!entry->free_ && entry->reachable_ == VMOBJ_UNREACHABLE
+            && entry->get_vm_obj()->has_finalizer(vmg_ id))
+            add_to_gc_queue(id, entry, VMOBJ_REACHABLE);
+    }
+    gc_trace_work_queue(vmg_ TRUE);
+
+    /* 
+     *   Everything in the nursery that's still unreachable is garbage.
+     *   Mark these objects as finalized, so that they're deletable for the
+     *   purposes of the weak reference checks below.  
+     */
+    for (i = 0, cnt = gc_young_.get_count() ; i < cnt ; ++i)
+    {
+        CVmObjPageEntry *entry = get_entry(gc_young_.get(i));
+        if (!entry->free_ && entry->reachable_ == VMOBJ_UNREACHABLE)
+        {
+            entry->finalize_state_ = VMOBJ_FINALIZED;
+            IF_GC_STATS(gc_stats.count_free());
+        }
+    }
+
+    /* 
+     *   Remove weak references to the objects we're about to delete.  Only
+     *   nursery survivors and old objects that could have acquired
+     *   references since the last collection can have such references. 
+     */
+    for (i = 0, cnt = gc_young_.get_count() ; i < cnt ; ++i)
+    {
+        CVmObjPageEntry *entry = get_entry(gc_young_.get(i));
+        if (!entry->free_ && entry->reachable_ != VMOBJ_UNREACHABLE
+            && entry->can_have_weak_refs_)
+            entry->get_vm_obj()->remove_stale_weak_refs(vmg0_);
+    }
+    for (i = 0, cnt = gc_remembered_.get_count() ; i < cnt ; ++i)
+    {
+        CVmObjPageEntry *entry = get_entry(gc_remembered_.get(i));
+        if (entry->can_have_weak_refs_)
+            entry->get_vm_obj()->remove_stale_weak_refs(vmg0_);
+    }
+    for (i = 0, cnt = gc_scan_always_.get_count() ; i < cnt ; ++i)
+    {
+        CVmObjPageEntry *entry = get_entry(gc_scan_always_.get(i));
+        if (!entry->free_ && !entry->remembered_ && entry->can_have_weak_refs_)
+            entry->get_vm_obj()->remove_stale_weak_refs(vmg0_);
+    }
+    G_undo->gc_remove_stale_weak_refs(vmg0_);
+
+    /* delete the garbage, and promote the survivors */
+    for (i = 0, cnt = gc_young_.get_count() ; i < cnt ; ++i)
+    {
+        vm_obj_id_t id = gc_young_.get(i);
+        CVmObjPageEntry *entry = get_entry(id);
+        if (entry->free_)
+            continue;
+
+        if (entry->reachable_ == VMOBJ_UNREACHABLE)
+        {
+            /* it's garbage - delete it */
+            delete_entry(vmg_ id, entry);
+        }
+        else
+        {
+            /* 
+             *   It survived, so promote it.  Reset it to the initial
+             *   conditions for the next pass (it can't be in the root set,
+             *   so this just marks it unreachable).  
+             */
+            gc_set_init_conditions(id, entry);
+            entry->old_ = TRUE;
+
+            /* 
+             *   if it doesn't have a write barrier, we'll have to rescan it
+             *   on each minor collection from now on 
+             */
+            if (entry->can_have_refs_
+                && !entry->get_vm_obj()->has_write_barrier())
+                gc_scan_always_.append(id);
+        }
+    }
+
+    /* clear the remembered set */
+    for (i = 0, cnt = gc_remembered_.get_count() ; i < cnt ; ++i)
+        get_entry(gc_remembered_.get(i))->remembered_ = FALSE;
+    gc_remembered_.clear();
+
+    /* the nursery is now empty */
+    gc_young_.clear();
+
+    /* let the heap manager clean up after the objects we've deleted */
+    G_varheap->finish_gc_pass();
+
+    /* restore the main work queue */
+    gc_queue_head_ = main_queue;
+    gc_minor_ = FALSE;
+}
+
+/*
+ *   Trace all objects reachable from the work queue. 
+ */
+void CVmObjTable::gc_trace_work_queue(VMG_ int trace_transient)
+{
+    /* 
+     *   trace everything reachable directly from the work queue, until we
+     *   exhaust the queue 
+     */
+    while (gc_pass_continue(vmg_ trace_transient)) ;
+}
+
+/* ------------------------------------------------------------------------ */
+/*
+ *   Parallel marking.
+ *   
+ *   Each marking thread has a vm_gc_marker, which holds its mark queue.
+ *   The queue is in two parts: a small private stack, which only the owner
+ *   thread touches, and a shared deque protected by a mutex.  The owner
+ *   pushes and pops on its private stack, spilling batches to its shared
+ *   deque when the stack fills up (or when the shared deque is empty, so
+ *   that idle threads have something to steal).  When a thread runs out of
+ *   work entirely, it refills from its own shared deque, and failing that
+ *   steals a batch from the head of another thread's deque.
+ *   
+ *   Marking has to be atomic, since two threads can reach the same object
+ *   at the same time.  The object table entry's 'reachable_' field is a
+ *   bit field sharing its word with other flags, so we can't update it
+ *   atomically; instead, we keep a separate bit vector of marked objects
+ *   for the duration of the mark, and an object's entry is updated only
+ *   by the thread that wins the race to set its bit.
+ *   
+ *   The marking threads don't allocate memory through t3malloc(), since
+ *   the debug version of the allocator isn't thread-safe, and they never
+ *   throw errors.  If a thread can't expand its queue, it simply stops
+ *   marking and sets a failure flag; the main thread then redoes the mark
+ *   serially from everything marked so far, which is always correct since
+ *   re-tracing an object is harmless.  
+ */
+#ifdef VMOBJ_GC_THREADS
+
+#include <thread>
+#include <mutex>
+#include <atomic>
+
+/* size of the private stack, and the number of entries we move at once */
+const size_t VM_GC_PAR_LOCAL = 256;
+const size_t VM_GC_PAR_BATCH = 128;
+
+/*
+ *   Marking thread state 
+ */
+struct vm_gc_marker
+{
+    vm_gc_marker()
+    {
+        local_cnt = 0;
+        shared = 0;
+        shared_head = shared_tail = shared_alloc = 0;
+        shared_cnt = 0;
+        par = 0;
+        idx = 0;
+    }
+
+    ~vm_gc_marker()
+    {
+        if (shared != 0)
+            osfree(shared);
+    }
+
+    /* 
+     *   Add entries to the tail of the shared deque.  The caller must hold
+     *   the mutex.  Returns false if we can't allocate memory.  
+     */
+    int shared_add(const vm_obj_id_t *ids, size_t n)
+    {
+        /* if there's not enough room at the tail, make some */
+        if (shared_tail + n > shared_alloc)
+        {
+            /* slide the live entries down to the start of the array */
+            size_t live = shared_tail - shared_head;
+            if (shared_head != 0)
+            {
+                memmove(shared, shared + shared_head, live * sizeof(*shared));
+                shared_head = 0;
+                shared_tail = live;
+            }
+
+            /* if that's still not enough, expand the array */
+            if (live + n > shared_alloc)
+            {
+                size_t new_alloc = shared_alloc + shared_alloc/2 + n + 1024;
+                vm_obj_id_t *p = (vm_obj_id_t *)osrealloc(
+                    shared, new_alloc * sizeof(*shared));
+                if (p == 0)
+                    return FALSE;
+                shared = p;
+                shared_alloc = new_alloc;
+            }
+        }
+
+        /* add the entries */
+        memcpy(shared + shared_tail, ids, n * sizeof(*shared));
+        shared_tail += n;
+        shared_cnt.store(shared_tail - shared_head, std::memory_order_relaxed);
+        return TRUE;
+    }
+
+    /* private stack - only the owning thread touches this */
+    vm_obj_id_t local[VM_GC_PAR_LOCAL];
+    size_t local_cnt;
+
+    /* 
+     *   shared deque - the owner takes entries from the tail, thieves from
+     *   the head; 'shared_cnt' is a hint for checking whether the deque is
+     *   empty without taking the lock 
+     */
+    std::mutex mu;
+    vm_obj_id_t *shared;
+    size_t shared_head;
+    size_t shared_tail;
+    size_t shared_alloc;
+    std::atomic<size_t> shared_cnt;
+
+    /* the overall marking state, and our index in its marker array */
+    struct vm_gc_par_state *par;
+    int idx;
+};
+
+/*
+ *   Overall parallel marking state 
+ */
+struct vm_gc_par_state
+{
+    /* marking threads */
+    vm_gc_marker markers[VM_GC_MAX_THREADS];
+    int nmarkers;
+
+    /* 
+     *   Mark bits, one per object ID.  An object is marked when its bit is
+     *   set; the thread that sets the bit owns the object's entry until
+     *   the mark is finished.  
+     */
+    std::atomic<unsigned int> *bits;
+
+    /* 
+     *   Number of objects that have been queued but not yet traced.  When
+     *   this reaches zero, the mark is done: an object's referents are
+     *   counted before the object itself is uncounted. 
+     */
+    std::atomic<long> pending;
+
+    /* flag: a thread ran out of memory */
+    std::atomic<int> failed;
+
+    /* 
+     *   flag: all threads have been launched.  The threads wait for this
+     *   before starting work, so that none of them can exit (and free its
+     *   thread resources) while the main thread is still allocating more
+     *   threads; the debug heap isn't thread-safe.  
+     */
+    std::atomic<int> started;
+};
+
+/* the marker for the current thread */
+static thread_local vm_gc_marker *S_gc_marker = 0;
+
+/*
+ *   Trace the work queue, with multiple threads if possible. 
+ */
+void CVmObjTable::gc_trace_work_queue_par(VMG0_)
+{
+    /* figure the number of threads to use */
+    int nthreads = gc_threads_;
+    if (nthreads == 0)
+    {
+        /* 
+         *   automatic - use one per processor, but only if the heap is big
+         *   enough for this to be worth the trouble 
+         */
+        nthreads = (int)std::thread::hardware_concurrency();
+        if (nthreads > VM_GC_MAX_THREADS)
+            nthreads = VM_GC_MAX_THREADS;
+        if ((size_t)pages_used_ * VM_OBJ_PAGE_CNT < VM_GC_PAR_MIN_OBJS)
+            nthreads = 1;
+    }
+
+    /* 
+     *   if we're only using one thread, or the queue is empty, there's
+     *   nothing to be gained from the parallel tracer 
+     */
+    if (nthreads <= 1 || gc_queue_head_ == VM_INVALID_OBJ)
+    {
+        gc_trace_work_queue(vmg_ TRUE);
+        return;
+    }
+
+    /* 
+     *   everything in the queue must be marked simply reachable; if not,
+     *   use the serial tracer, which handles the other states 
+     */
+    vm_obj_id_t id;
+    for (id = gc_queue_head_ ; id != VM_INVALID_OBJ ;
+         id = get_entry(id)->next_obj_)
+    {
+        if (get_entry(id)->reachable_ != VMOBJ_REACHABLE)
+        {
+            gc_trace_work_queue(vmg_ TRUE);
+            return;
+        }
+    }
+
+    /* set up the marking state */
+    vm_gc_par_state *par = new vm_gc_par_state();
+    par->nmarkers = nthreads;
+    par->pending.store(0);
+    par->failed.store(FALSE);
+    par->started.store(FALSE);
+
+    /* 
+     *   allocate the mark bits, and set the bit for each object that's
+     *   already marked 
+     */
+    size_t nbits = (size_t)pages_used_ * VM_OBJ_PAGE_CNT;
+    size_t nwords = (nbits + 31) / 32;
+    par->bits = new std::atomic<unsigned int>[nwords];
+    CVmObjPageEntry **pg;
+    size_t i, w;
+    for (w = 0 ; w < nwords ; ++w)
+        par->bits[w].store(0, std::memory_order_relaxed);
+    for (id = 0, i = pages_used_, pg = pages_ ; i > 0 ; ++pg, --i)
+    {
+        CVmObjPageEntry *entry;
+        size_t j;
+        for (j = VM_OBJ_PAGE_CNT, entry = *pg ; j > 0 ; --j, ++entry, ++id)
+        {
+            if (!entry->free_ && entry->reachable_ != VMOBJ_UNREACHABLE)
+                par->bits[id / 32].fetch_or(1U << (id % 32),
+                                            std::memory_order_relaxed);
+        }
+    }
+
+    /* 
+     *   deal out the work queue to the markers' shared deques (rather than
+     *   their private stacks, so that the work can be stolen if a thread
+     *   fails to start) 
+     */
+    int m;
+    for (m = 0 ; m < nthreads ; ++m)
+    {
+        par->markers[m].par = par;
+        par->markers[m].idx = m;
+    }
+    for (m = 0, id = gc_queue_head_ ; id != VM_INVALID_OBJ ;
+         id = get_entry(id)->next_obj_, m = (m + 1) % nthreads)
+    {
+        if (!par->markers[m].shared_add(&id, 1))
+            par->failed.store(TRUE);
+        par->pending.fetch_add(1, std::memory_order_relaxed);
+    }
+    gc_queue_head_ = VM_INVALID_OBJ;
+
+    /* 
+     *   start the threads - we run the first marker on this thread, and the
+     *   rest on new threads 
+     */
+    gc_par_ = par;
+    std::thread *threads[VM_GC_MAX_THREADS];
+    int nlaunched = 0;
+    if (!par->failed.load())
+    {
+        for (m = 1 ; m < nthreads ; ++m)
+        {
+            try
+            {
+                threads[nlaunched] = new std::thread(
+                    gc_par_thread_main, vmg_ &par->markers[m]);
+                ++nlaunched;
+            }
+            catch (...)
+            {
+                /* 
+                 *   couldn't start the thread - this thread will pick up
+                 *   its work by stealing it 
+                 */
+            }
+        }
+        par->started.store(TRUE);
+        gc_par_thread_main(vmg_ &par->markers[0]);
+    }
+
+    /* wait for the threads to finish */
+    for (m = 0 ; m < nlaunched ; ++m)
+    {
+        threads[m]->join();
+        delete threads[m];
+    }
+    gc_par_ = 0;
+
+    /* 
+     *   If a thread ran out of memory, some marked objects might not have
+     *   been traced.  Finish the job serially, by requeuing everything
+     *   marked so far - re-tracing an object that's already been traced is
+     *   harmless.  
+     */
+    if (par->failed.load())
+    {
+        for (id = 0, i = pages_used_, pg = pages_ ; i > 0 ; ++pg, --i)
+        {
+            CVmObjPageEntry *entry;
+            size_t j;
+            for (j = VM_OBJ_PAGE_CNT, entry = *pg ; j > 0 ;
+                 --j, ++entry, ++id)
+            {
+                if (!entry->free_ && entry->can_have_refs_
+                    && entry->reachable_ != VMOBJ_UNREACHABLE)
+                {
+                    entry->next_obj_ = gc_queue_head_;
+                    gc_queue_head_ = id;
                 }
             }
         }
-    }
-    
-    /*
-     *   Go through the undo records and clear any stale weak references
-     *   contained in the undo list.  
-     */
-    G_undo->gc_remove_stale_weak_refs(vmg0_);
+        gc_trace_work_queue(vmg_ TRUE);
+    }
+
+    /* done with the marking state */
+    delete [] par->bits;
+    delete par;
+}
+
+/*
+ *   Parallel marking thread entrypoint 
+ */
+void CVmObjTable::gc_par_thread_main(VMG_ vm_gc_marker *m)
+{
+    /* wait until all of the threads are running */
+    while (!m->par->started.load())
+        std::this_thread::yield();
+
+    /* note our marker for gc_par_mark() */
+    S_gc_marker = m;
+
+    /* do the work */
+    G_obj_table->gc_par_work(vmg_ m);
+
+    /* we're no longer marking */
+    S_gc_marker = 0;
+}
+
+/*
+ *   Parallel marking work loop 
+ */
+void CVmObjTable::gc_par_work(VMG_ vm_gc_marker *m)
+{
+    vm_gc_par_state *par = m->par;
+    for (;;)
+    {
+        /* if another thread failed, stop */
+        if (par->failed.load(std::memory_order_relaxed))
+            break;
+
+        /* if the private stack is empty, try to refill it */
+        if (m->local_cnt == 0)
+        {
+            /* take a batch from the tail of our own shared deque */
+            if (m->shared_cnt.load(std::memory_order_relaxed) != 0)
+            {
+                std::lock_guard<std::mutex> lock(m->mu);
+                size_t n = m->shared_tail - m->shared_head;
+                if (n > VM_GC_PAR_BATCH)
+                    n = VM_GC_PAR_BATCH;
+                m->shared_tail -= n;
+                memcpy(m->local, m->shared + m->shared_tail,
+                       n * sizeof(m->local[0]));
+                m->local_cnt = n;
+                m->shared_cnt.store(m->shared_tail - m->shared_head,
+                                    std::memory_order_relaxed);
+            }
+
+            /* failing that, steal half of another thread's deque */
+            for (int i = 1 ; m->local_cnt == 0 && i < par->nmarkers ; ++i)
+            {
+                vm_gc_marker *v =
+                    &par->markers[(m->idx + i) % par->nmarkers];
+                if (v->shared_cnt.load(std::memory_order_relaxed) == 0)
+                    continue;
+
+                std::lock_guard<std::mutex> lock(v->mu);
+                size_t n = (v->shared_tail - v->shared_head + 1) / 2;
+                if (n > VM_GC_PAR_BATCH)
+                    n = VM_GC_PAR_BATCH;
+                memcpy(m->local, v->shared + v->shared_head,
+                       n * sizeof(m->local[0]));
+                v->shared_head += n;
+                m->local_cnt = n;
+                v->shared_cnt.store(v->shared_tail - v->shared_head,
+                                    std::memory_order_relaxed);
+            }
+
+            /* 
+             *   if we still have nothing, we're done if nothing is pending
+             *   anywhere; otherwise another thread is still working and
+             *   might give us something to steal 
+             */
+            if (m->local_cnt == 0)
+            {
+                if (par->pending.load() == 0)
+                    break;
+                std::this_thread::yield();
+                continue;
+            }
+        }
+
+        /* trace the next object */
+        vm_obj_id_t id = m->local[--m->local_cnt];
+        get_entry(id)->get_vm_obj()->mark_refs(vmg_ VMOBJ_REACHABLE);
+        par->pending.fetch_sub(1);
+    }
+}
+
+/*
+ *   Mark an object from a parallel marking thread 
+ */
+void CVmObjTable::gc_par_mark(vm_obj_id_t id, CVmObjPageEntry *entry)
+{
+    vm_gc_par_state *par = gc_par_;
+    vm_gc_marker *m = S_gc_marker;
+
+    /* set the mark bit; if it was already set, there's nothing to do */
+    unsigned int bit = 1U << (id % 32);
+    if ((par->bits[id / 32].fetch_or(bit) & bit) != 0)
+        return;
+
+    /* we won the race, so the entry is ours to update */
+    entry->reachable_ = VMOBJ_REACHABLE;
+
+    /* if it can refer to other objects, queue it for tracing */
+    if (entry->can_have_refs_)
+    {
+        /* count it as pending before it can be taken */
+        par->pending.fetch_add(1);
+
+        /* 
+         *   if the private stack is full, or if our shared deque has run
+         *   dry and there's enough to share, move the oldest half of the
+         *   stack to the shared deque 
+         */
+        if (m->local_cnt == VM_GC_PAR_LOCAL
+            || (m->local_cnt >= VM_GC_PAR_BATCH / 4
+                && m->shared_cnt.load(std::memory_order_relaxed) == 0))
+        {
+            size_t n = m->local_cnt / 2;
+            int ok;
+            {
+                std::lock_guard<std::mutex> lock(m->mu);
+                ok = m->shared_add(m->local, n);
+            }
+            if (!ok)
+            {
+                /* 
+                 *   out of memory - give up; the main thread will redo
+                 *   the mark serially 
+                 */
+                par->failed.store(TRUE);
+                return;
+            }
+            memmove(m->local, m->local + n,
+                    (m->local_cnt - n) * sizeof(m->local[0]));
+            m->local_cnt -= n;
+        }
 
-    /*
-     *   All of the finalizable objects are now in the finalizer queue.  Run
-     *   through the finalizer queue and run each such object's finalizer. 
-     */
-    run_finalizers(vmg0_);
+        /* push it */
+        m->local[m->local_cnt++] = id;
+    }
 }
 
+#else /* VMOBJ_GC_THREADS */
+
 /*
- *   Trace all objects reachable from the work queue. 
+ *   No thread support - always use the serial tracer 
  */
-void CVmObjTable::gc_trace_work_queue(VMG_ int trace_transient)
+void CVmObjTable::gc_trace_work_queue_par(VMG0_)
+{
+    gc_trace_work_queue(vmg_ TRUE);
+}
+
+void CVmObjTable::gc_par_mark(vm_obj_id_t, CVmObjPageEntry *)
 {
-    /* 
-     *   trace everything reachable directly from the work queue, until we
-     *   exhaust the queue 
-     */
-    while (gc_pass_continue(vmg_ trace_transient)) ;
 }
 
+#endif /* VMOBJ_GC_THREADS */
+
 /*
  *   Garbage collection: trace objects reachable from the stack 
  */
@@ -2316,7 +3062,7 @@ void CVmObjTable::gc_trace_stack(VMG0_)
          */
         val = G_stk->get(i);
         if (val->typ == VM_OBJ && val->val.obj != VM_INVALID_OBJ)
-            add_to_gc_queue(val->val.obj, VMOBJ_REACHABLE);
+            gc_mark_root(val->val.obj);
     }
 }
 
@@ -2331,7 +3077,7 @@ void CVmObjTable::gc_trace_imports(VMG0_)
      */
 #define VM_IMPORT_OBJ(sym, mem) \
     if (G_predef->mem != VM_INVALID_OBJ) \
-        add_to_gc_queue(G_predef->mem, VMOBJ_REACHABLE);
+        gc_mark_root(G_predef->mem);
 #define VM_NOIMPORT_OBJ(sym, mem) VM_IMPORT_OBJ(sym, mem)
 #include "vmimport.h"
 }
@@ -2355,21 +3101,21 @@ void CVmObjTable::gc_trace_globals(VMG0_)
         for (objp = pg->objs_, i = pg->used_ ; i != 0 ; ++objp, --i)
         {
             /* trace this global */
-            add_to_gc_queue(*objp, VMOBJ_REACHABLE);
+            gc_mark_root(*objp);
         }
     }
 
     /* the return value register (R0) is a machine global */
     val = G_interpreter->get_r0();
     if (val->typ == VM_OBJ && val->val.obj != VM_INVALID_OBJ)
-        add_to_gc_queue(val->val.obj, VMOBJ_REACHABLE);
+        gc_mark_root(val->val.obj);
 
     /* trace the global variables defined by other subsystems */
     for (var = global_var_head_ ; var != 0 ; var = var->nxt)
     {
         /* if this global variable contains an object, trace it */
         if (var->val.typ == VM_OBJ && var->val.val.obj != VM_INVALID_OBJ)
-            add_to_gc_queue(var->val.val.obj, VMOBJ_REACHABLE);
+            gc_mark_root(var->val.val.obj);
     }
 }
 
@@ -2508,7 +3254,18 @@ void CVmObjTable::apply_undo(VMG_ CVmUndoRecord *rec)
 {
     /* tell the object to apply the undo */
     if (rec->obj != VM_INVALID_OBJ)
+    {
+        /* 
+         *   Undo can restore references the object held at the savepoint;
+         *   those objects might have been reachable only through the undo
+         *   record since then, so treat this as a store for the write
+         *   barrier. 
+         */
+        remember_obj(rec->obj);
+
+        /* apply the record */
         get_obj(rec->obj)->apply_undo(vmg_ rec);
+    }
 }
 
 
@@ -2559,6 +3316,11 @@ CVmObjFixup::CVmObjFixup(ulong entry_cnt)
     
     /* no entries are used yet */
     used_ = 0;
+
+    /* we don't have a direct index yet */
+    index_ = 0;
+    index_base_ = VM_INVALID_OBJ;
+    index_cnt_ = 0;
     
     /* if we have no entries, there's nothing to do */
     if (cnt_ == 0)
@@ -2599,6 +3361,10 @@ CVmObjFixup::~CVmObjFixup()
 {
     uint i;
 
+    /* delete the direct index, if we built one */
+    if (index_ != 0)
+        t3free(index_);
+
     /* if we never allocated an array, there's nothing to do */
     if (arr_ == 0)
         return;
@@ -2626,6 +3392,42 @@ void CVmObjFixup::add_fixup(vm_obj_id_t old_id, vm_obj_id_t new_id)
     entry->new_id = new_id;
 }
 
+/*
+ *   build the direct index 
+ */
+void CVmObjFixup::build_index()
+{
+    /* if there are no entries, there's nothing to index */
+    if (used_ == 0)
+        return;
+
+    /* 
+     *   figure the range of old ID's - the entries are in ascending order,
+     *   so the first and last entries give us the bounds 
+     */
+    vm_obj_id_t lo = get_entry(0)->old_id;
+    ulong cnt = (ulong)(get_entry(used_ - 1)->old_id - lo) + 1;
+
+    /* 
+     *   if the ID's are too sparse, the index would waste too much memory,
+     *   so just stick with the binary search 
+     */
+    if (cnt > used_ * 4 + 1024)
+        return;
+
+    /* allocate the index, with every slot initially empty */
+    index_ = (ulong *)t3malloc(cnt * sizeof(index_[0]));
+    if (index_ == 0)
+        return;
+    memset(index_, 0, cnt * sizeof(index_[0]));
+    index_base_ = lo;
+    index_cnt_ = cnt;
+
+    /* fill in the slot for each entry */
+    for (ulong i = 0 ; i < used_ ; ++i)
+        index_[get_entry(i)->old_id - lo] = i + 1;
+}
+
 /*
  *   translate an ID 
  */
@@ -2655,6 +3457,18 @@ vm_obj_id_t CVmObjFixup::get_new_id(VMG_ vm_obj_id_t old_id)
  */
 obj_fixup_entry *CVmObjFixup::find_entry(vm_obj_id_t old_id)
 {
+    /* if we have a direct index, look up the entry there */
+    if (index_ != 0)
+    {
+        /* if it's outside the index's range, there's no entry */
+        if (old_id < index_base_ || old_id - index_base_ >= index_cnt_)
+            return 0;
+
+        /* get the entry, if there is one */
+        ulong idx = index_[old_id - index_base_];
+        return (idx != 0 ? get_entry(idx - 1) : 0);
+    }
+
     /* do a binary search for the entry */
     ulong cur;
     ulong lo = 0;
@@ -2828,6 +3642,13 @@ void CVmObjTable::save(VMG_ CVmFile *fp)
     gc_trace_globals(vmg0_);
     gc_trace_work_queue(vmg_ FALSE);
 
+    /* 
+     *   Find the saveable objects that are still in their image file state.
+     *   Restoring resets every object to its image file state before
+     *   reading the saved objects, so we can leave these out of the file. 
+     */
+    mark_image_matches(vmg0_);
+
     /*
      *   Before we save the objects themselves, save a table of contents of
      *   the dynamically-allocated objects to be saved.  This table of
@@ -2878,8 +3699,11 @@ void CVmObjTable::save(VMG_ CVmFile *fp)
                 ++toc_cnt;
             }
 
-            /* if it's saveable, count it among the saveable objects */
-            if (entry->is_saveable())
+            /* 
+             *   if it's saveable, and it's not still in its image file
+             *   state, count it among the objects to save 
+             */
+            if (entry->is_saveable() && !entry->matches_image_)
                 ++save_cnt;
         }
     }
@@ -2899,8 +3723,11 @@ void CVmObjTable::save(VMG_ CVmFile *fp)
         /* scan all objects on this page */
         for (j = VM_OBJ_PAGE_CNT, entry = *pg ; j > 0 ; -- j, ++entry, ++id)
         {
-            /* if this object is saveable, save it */
-            if (entry->is_saveable())
+            /* 
+             *   if this object is saveable, and it's not still in its image
+             *   file state, save it 
+             */
+            if (entry->is_saveable() && !entry->matches_image_)
             {
                 uint idx;
                 char buf[2];
@@ -2930,6 +3757,46 @@ void CVmObjTable::save(VMG_ CVmFile *fp)
              *   effect on the VM's state 
              */
             gc_set_init_conditions(id, entry);
+            entry->matches_image_ = FALSE;
+        }
+    }
+}
+
+/*
+ *   Mark the saveable objects that are still in their image file state 
+ */
+void CVmObjTable::mark_image_matches(VMG0_)
+{
+    vm_image_ptr_page *ip_page;
+
+    /* go through the objects with saved image data */
+    for (ip_page = image_ptr_head_ ; ip_page != 0 ; ip_page = ip_page->next_)
+    {
+        size_t cnt;
+        vm_image_ptr *slot;
+
+        /* 
+         *   get the count for this page - every page but the last is full,
+         *   as in reset_to_image() 
+         */
+        if (ip_page->next_ == 0)
+            cnt = image_ptr_last_cnt_;
+        else
+            cnt = VM_IMAGE_PTRS_PER_PAGE;
+
+        /* check each object on the page */
+        for (slot = ip_page->ptrs_ ; cnt != 0 ; --cnt, ++slot)
+        {
+            /* 
+             *   We only need to ask objects we'd otherwise save.  Note that
+             *   unchanged objects that track their own changes (such as
+             *   TadsObjects) aren't saveable in the first place.  
+             */
+            CVmObjPageEntry *entry = get_entry(slot->obj_id_);
+            if (entry->is_saveable()
+                && entry->get_vm_obj()->matches_image_data(
+                    vmg_ slot->image_data_ptr_, slot->image_data_len_))
+                entry->matches_image_ = TRUE;
         }
     }
 }
@@ -2995,6 +3862,9 @@ int CVmObjTable::restore(VMG_ CVmFile *fp, CVmObjFixup **fixups)
          */
         (*fixups)->add_fixup(old_id, new_id);
     }
+
+    /* we've added all of the fixups, so index them for fast lookup */
+    (*fixups)->build_index();
     
     /* read the number of saved objects */
     cnt = fp->read_uint4();
@@ -3123,6 +3993,13 @@ void CVmObjTable::reset_to_image(VMG0_)
      */
     G_undo->drop_undo(vmg0_);
 
+    /* 
+     *   Resetting (and any subsequent restore) rewrites object state
+     *   wholesale, without going through the write barrier, so the next
+     *   collection has to be a full one. 
+     */
+    gc_need_full_ = TRUE;
+
     /* delete all of the globals */
     if (globals_ != 0)
     {
@@ -3189,6 +4066,9 @@ void CVmObjTable::reset_to_image(VMG0_)
             }
         }
     }
+
+    /* let the heap manager know about the reset */
+    G_varheap->reset_to_image();
 }
 
 /*
@@ -3749,3 +4629,397 @@ void CVmVarHeapHybrid::free_mem(void *mem)
     hdr->block->free(hdr);
 }
 
+/* ------------------------------------------------------------------------ */
+/*
+ *   Size-class slab heap manager 
+ */
+
+/* the largest block size in each class */
+static const size_t S_slab_class_sizes[VM_SLAB_CLASS_CNT] =
+{
+    16, 32, 48, 64, 96, 128, 192, 256,
+    384, 512, 768, 1024, 1536, 2048, 3072, 4096
+};
+
+/*
+ *   construct 
+ */
+CVmVarHeapSlab::CVmVarHeapSlab(CVmObjTable *objtab)
+{
+    int i;
+    size_t j;
+
+    /* remember my object table */
+    objtab_ = objtab;
+
+    /* release all empty slabs on reset by default */
+    arena_reset_ = TRUE;
+
+    /* set up the size classes */
+    for (i = 0 ; i < VM_SLAB_CLASS_CNT ; ++i)
+    {
+        CVmVarHeapSlab_class *cls = &classes_[i];
+
+        /* 
+         *   figure the cell size: the block size plus our header, rounded
+         *   to the worst-case alignment 
+         */
+        cls->siz = S_slab_class_sizes[i];
+        cls->cell_size = osrndsz(cls->siz
+                                 + osrndsz(sizeof(CVmVarHeapSlab_hdr)));
+
+        /* fit as many cells as we can in a slab, but at least a few */
+        cls->cells_per_slab =
+            (VM_SLAB_SIZE - osrndsz(sizeof(CVmVarHeapSlab_slab)))
+            / cls->cell_size;
+        if (cls->cells_per_slab < 8)
+            cls->cells_per_slab = 8;
+
+        /* no slabs yet */
+        cls->avail = 0;
+        cls->full = 0;
+        cls->slab_cnt = 0;
+
+        /* no statistics yet */
+        cls->alloc_cnt = cls->free_cnt = 0;
+        cls->bytes_alloc = cls->bytes_freed = 0;
+    }
+
+    /* build the size lookup table */
+    for (i = 0, j = 0 ; j <= VM_SLAB_MAX_SIZE/16 ; ++j)
+    {
+        /* advance to the first class big enough for this size */
+        while (S_slab_class_sizes[i] < j*16)
+            ++i;
+        size_class_[j] = (unsigned char)i;
+    }
+
+    /* no large blocks yet */
+    large_alloc_cnt_ = large_free_cnt_ = 0;
+    large_bytes_alloc_ = large_bytes_freed_ = 0;
+}
+
+/*
+ *   delete 
+ */
+CVmVarHeapSlab::~CVmVarHeapSlab()
+{
+    int i;
+
+    /* 
+     *   Release all of the slabs.  The object table frees each object's
+     *   memory before deleting us, but not every block is necessarily
+     *   owned by an object, so release the slabs whether or not they're
+     *   empty. 
+     */
+    for (i = 0 ; i < VM_SLAB_CLASS_CNT ; ++i)
+    {
+        CVmVarHeapSlab_slab *lists[2] = { classes_[i].avail,
+                                          classes_[i].full };
+        for (int j = 0 ; j < 2 ; ++j)
+        {
+            CVmVarHeapSlab_slab *slab, *nxt;
+            for (slab = lists[j] ; slab != 0 ; slab = nxt)
+            {
+                nxt = slab->nxt;
+                t3free(slab);
+            }
+        }
+    }
+}
+
+/*
+ *   allocate memory 
+ */
+void *CVmVarHeapSlab::alloc_mem(size_t siz, CVmObject *)
+{
+    CVmVarHeapSlab_hdr *hdr;
+
+    /* count the gc statistics if desired */
+    IF_GC_STATS(gc_stats.count_alloc_bytes(siz));
+
+    /* count the allocation */
+    objtab_->count_alloc(siz);
+
+    /* allocate from the size class, or as a large block if it's too big */
+    if (siz <= VM_SLAB_MAX_SIZE)
+        hdr = alloc_cell(&classes_[size_to_class(siz)]);
+    else
+        hdr = alloc_large(siz);
+
+    /* return the caller-visible part, which follows the header */
+    return (void *)(hdr + 1);
+}
+
+/*
+ *   reallocate memory 
+ */
+void *CVmVarHeapSlab::realloc_mem(size_t siz, void *mem, CVmObject *)
+{
+    /* get the block header, which immediately precedes the block */
+    CVmVarHeapSlab_hdr *hdr = ((CVmVarHeapSlab_hdr *)mem) - 1;
+
+    /* count the allocation (see CVmVarHeapHybrid::realloc_mem) */
+    objtab_->count_alloc(siz);
+
+    /* figure the current capacity of the block */
+    size_t old_siz = (hdr->slab != 0 ? hdr->slab->cls->siz : large_size(hdr));
+
+    /* count the gc statistics if desired */
+    IF_GC_STATS(gc_stats.count_realloc_bytes(old_siz, siz));
+
+    /* 
+     *   if it's a slab block, and the new size still fits, keep the block
+     *   as it is - but move it to a smaller class if it's shrinking a lot,
+     *   so that we don't waste the space 
+     */
+    if (hdr->slab != 0 && siz <= old_siz
+        && (siz > old_siz/2 || size_to_class(siz) == 0))
+        return mem;
+
+    /* allocate a new block, copy the old contents, and free the old one */
+    CVmVarHeapSlab_hdr *new_hdr = (siz <= VM_SLAB_MAX_SIZE
+                                   ? alloc_cell(&classes_[size_to_class(siz)])
+                                   : alloc_large(siz));
+    memcpy(new_hdr + 1, mem, siz < old_siz ? siz : old_siz);
+    if (hdr->slab != 0)
+        free_cell(hdr);
+    else
+        free_large(hdr);
+
+    /* return the new block */
+    return (void *)(new_hdr + 1);
+}
+
+/*
+ *   free memory 
+ */
+void CVmVarHeapSlab::free_mem(void *mem)
+{
+    /* get the block header, which immediately precedes the block */
+    CVmVarHeapSlab_hdr *hdr = ((CVmVarHeapSlab_hdr *)mem) - 1;
+
+    /* count the gc statistics if desired */
+    IF_GC_STATS(gc_stats.count_free_bytes(
+        hdr->slab != 0 ? hdr->slab->cls->siz : large_size(hdr)));
+
+    /* free it */
+    if (hdr->slab != 0)
+        free_cell(hdr);
+    else
+        free_large(hdr);
+}
+
+/*
+ *   Allocate a cell from a size class 
+ */
+CVmVarHeapSlab_hdr *CVmVarHeapSlab::alloc_cell(CVmVarHeapSlab_class *cls)
+{
+    CVmVarHeapSlab_slab *slab;
+    CVmVarHeapSlab_hdr *hdr;
+
+    /* if there's no slab with free space, allocate a new one */
+    if ((slab = cls->avail) == 0)
+    {
+        size_t slab_hdr_siz = osrndsz(sizeof(CVmVarHeapSlab_slab));
+        slab = (CVmVarHeapSlab_slab *)t3malloc(
+            slab_hdr_siz + cls->cells_per_slab * cls->cell_size);
+        if (slab == 0)
+            err_throw(VMERR_OUT_OF_MEMORY);
+
+        /* set it up with all of its cells unused */
+        slab->cls = cls;
+        slab->first_free = 0;
+        slab->unused = (char *)slab + slab_hdr_siz;
+        slab->unused_cnt = cls->cells_per_slab;
+        slab->live = 0;
+        slab->list = 0;
+
+        /* add it to the class */
+        ++cls->slab_cnt;
+        link_slab(slab, &cls->avail);
+    }
+
+    /* take a cell from the free list, or failing that, an unused cell */
+    if (slab->first_free != 0)
+    {
+        hdr = (CVmVarHeapSlab_hdr *)slab->first_free;
+        slab->first_free = *(void **)(hdr + 1);
+    }
+    else
+    {
+        hdr = (CVmVarHeapSlab_hdr *)slab->unused;
+        slab->unused += cls->cell_size;
+        --slab->unused_cnt;
+    }
+
+    /* count it */
+    ++slab->live;
+    ++cls->alloc_cnt;
+    cls->bytes_alloc += cls->cell_size;
+
+    /* if the slab is now full, move it to the full list */
+    if (slab->first_free == 0 && slab->unused_cnt == 0)
+        link_slab(slab, &cls->full);
+
+    /* point the block back to its slab */
+    hdr->slab = slab;
+    return hdr;
+}
+
+/*
+ *   Free a slab cell 
+ */
+void CVmVarHeapSlab::free_cell(CVmVarHeapSlab_hdr *hdr)
+{
+    CVmVarHeapSlab_slab *slab = hdr->slab;
+    CVmVarHeapSlab_class *cls = slab->cls;
+
+    /* 
+     *   link it into the slab's free list - the link goes in the data area
+     *   after the header, since we need to keep the header's slab pointer
+     *   intact for the statistics 
+     */
+    *(void **)(hdr + 1) = slab->first_free;
+    slab->first_free = hdr;
+
+    /* count it */
+    --slab->live;
+    ++cls->free_cnt;
+    cls->bytes_freed += cls->cell_size;
+
+    /* 
+     *   if the slab was full, it's now available again; we'll release it
+     *   if it's empty at the end of the next gc pass 
+     */
+    if (slab->list != &cls->avail)
+        link_slab(slab, &cls->avail);
+}
+
+/*
+ *   Allocate a large block directly from the system heap.  The block size
+ *   goes in a size_t before the header. 
+ */
+CVmVarHeapSlab_hdr *CVmVarHeapSlab::alloc_large(size_t siz)
+{
+    size_t pre = osrndsz(sizeof(size_t) + sizeof(CVmVarHeapSlab_hdr))
+                 - sizeof(CVmVarHeapSlab_hdr);
+    char *p = (char *)t3malloc(pre + sizeof(CVmVarHeapSlab_hdr) + siz);
+    if (p == 0)
+        err_throw(VMERR_OUT_OF_MEMORY);
+
+    /* set up the size and header */
+    CVmVarHeapSlab_hdr *hdr = (CVmVarHeapSlab_hdr *)(p + pre);
+    ((size_t *)hdr)[-1] = siz;
+    hdr->slab = 0;
+
+    /* count it */
+    ++large_alloc_cnt_;
+    large_bytes_alloc_ += siz;
+
+    /* return the header */
+    return hdr;
+}
+
+/*
+ *   Free a large block 
+ */
+void CVmVarHeapSlab::free_large(CVmVarHeapSlab_hdr *hdr)
+{
+    size_t pre = osrndsz(sizeof(size_t) + sizeof(CVmVarHeapSlab_hdr))
+                 - sizeof(CVmVarHeapSlab_hdr);
+
+    /* count it */
+    ++large_free_cnt_;
+    large_bytes_freed_ += large_size(hdr);
+
+    /* free the underlying memory block */
+    t3free((char *)hdr - pre);
+}
+
+/*
+ *   Move a slab into the given list (or just remove it from its current
+ *   list, if 'list' is null) 
+ */
+void CVmVarHeapSlab::link_slab(CVmVarHeapSlab_slab *slab,
+                               CVmVarHeapSlab_slab **list)
+{
+    /* unlink it from its current list, if any */
+    if (slab->list != 0)
+    {
+        if (slab->prv != 0)
+            slab->prv->nxt = slab->nxt;
+        else
+            *slab->list = slab->nxt;
+        if (slab->nxt != 0)
+            slab->nxt->prv = slab->prv;
+    }
+
+    /* link it at the head of the new list */
+    slab->list = list;
+    if (list != 0)
+    {
+        slab->prv = 0;
+        slab->nxt = *list;
+        if (*list != 0)
+            (*list)->prv = slab;
+        *list = slab;
+    }
+}
+
+/*
+ *   Release empty slabs, keeping up to 'keep' spare empty slabs per class.
+ */
+void CVmVarHeapSlab::release_empty_slabs(size_t keep)
+{
+    int i;
+    for (i = 0 ; i < VM_SLAB_CLASS_CNT ; ++i)
+    {
+        CVmVarHeapSlab_class *cls = &classes_[i];
+        CVmVarHeapSlab_slab *slab, *nxt;
+        size_t kept;
+
+        /* empty slabs always have free cells, so they're all in the list */
+        for (slab = cls->avail, kept = 0 ; slab != 0 ; slab = nxt)
+        {
+            /* remember the next slab, in case we delete this one */
+            nxt = slab->nxt;
+
+            /* if it's empty and we have enough spares, release it */
+            if (slab->live == 0 && kept++ >= keep)
+            {
+                link_slab(slab, 0);
+                --cls->slab_cnt;
+                t3free(slab);
+            }
+        }
+    }
+}
+
+/*
+ *   Get statistics for a size class 
+ */
+void CVmVarHeapSlab::get_class_stats(int idx,
+                                     vm_varheap_class_stats *stats) const
+{
+    if (idx < VM_SLAB_CLASS_CNT)
+    {
+        const CVmVarHeapSlab_class *cls = &classes_[idx];
+        stats->siz = cls->siz;
+        stats->alloc_cnt = cls->alloc_cnt;
+        stats->free_cnt = cls->free_cnt;
+        stats->bytes_alloc = cls->bytes_alloc;
+        stats->bytes_freed = cls->bytes_freed;
+        stats->slab_cnt = cls->slab_cnt;
+    }
+    else
+    {
+        stats->siz = 0;
+        stats->alloc_cnt = large_alloc_cnt_;
+        stats->free_cnt = large_free_cnt_;
+        stats->bytes_alloc = large_bytes_alloc_;
+        stats->bytes_freed = large_bytes_freed_;
+        stats->slab_cnt = 0;
+    }
+}
+
@@ -106,6 +106,34 @@ Modified
  */
 const int VM_GC_WORK_INCREMENT = 500;
 
+/*
+ *   Number of minor (nursery-only) collections to run between full
+ *   collections.  A minor collection only reclaims objects created since
+ *   the previous collection, so garbage among older objects accumulates
+ *   until the next full pass; this bounds how long that can go on.  Set
+ *   this to zero to disable generational collection, so that every
+ *   collection is a full one.  
+ */
+const int VM_GC_MINOR_PER_FULL = 8;
+
+/*
+ *   Parallel marking.  When the compiler provides C++11 threads, a full
+ *   collection can trace the object graph with several threads, each with
+ *   its own mark queue, stealing work from the others when it runs dry.
+ *   Define VMOBJ_NO_GC_THREADS to build without this, in which case the
+ *   serial tracer is always used.
+ *   
+ *   VM_GC_MAX_THREADS is the largest number of marking threads we'll use.
+ *   By default, we use one thread per processor, up to that limit, but
+ *   only when the object table has at least VM_GC_PAR_MIN_OBJS entries in
+ *   use, since starting the threads isn't worth it for a small heap.  
+ */
+#if __cplusplus >= 201103L && !defined(VMOBJ_NO_GC_THREADS)
+#define VMOBJ_GC_THREADS
+#endif
+const int VM_GC_MAX_THREADS = 8;
+const size_t VM_GC_PAR_MIN_OBJS = 65536;
+
 
 
 /* ------------------------------------------------------------------------ */
@@ -348,6 +376,17 @@ public:
                          vm_obj_id_t self, vm_obj_id_t *source_obj,
                          uint *argc);
 
+    /*
+     *   Get a property value on behalf of a property evaluation instruction.
+     *   This is the same as get_prop(), but 'site' identifies the byte code
+     *   instruction doing the lookup, which a metaclass can use as a key for
+     *   caching lookup results.  By default, we simply call get_prop().
+     */
+    virtual int get_prop_at_site(VMG_ vm_prop_id_t prop, vm_val_t *val,
+                                 vm_obj_id_t self, vm_obj_id_t *source_obj,
+                                 uint *argc, const uchar * /*site*/)
+        { return get_prop(vmg_ prop, val, self, source_obj, argc); }
+
     /*
      *   Get the invocation routine.  This retrieves the bytecode location to
      *   invoke when calling the object as though it were a function.  If the
@@ -429,6 +468,23 @@ public:
      */
     virtual void remove_stale_weak_refs(VMG0_) = 0;
 
+    /*
+     *   Does this metaclass participate in the generational collector's
+     *   write barrier?  A metaclass that returns true promises to call
+     *   CVmObjTable::note_ref_store() (or remember_obj()) whenever it
+     *   stores an object reference into an existing instance, other than
+     *   while the instance is first being constructed.  Immutable
+     *   metaclasses (whose references never change after construction) can
+     *   also return true.
+     *   
+     *   Objects of a metaclass that returns false are conservatively
+     *   rescanned on every minor collection once they've been promoted to
+     *   the old generation, which is always correct but costs time in
+     *   proportion to the number of such objects.  That's the default, so
+     *   a metaclass that ignores the write barrier entirely still works.  
+     */
+    virtual int has_write_barrier() const { return FALSE; }
+
     /*
      *   Receive notification that the undo manager is creating a new
      *   savepoint.  
@@ -544,6 +600,21 @@ public:
      */
     virtual int is_changed_since_load() const { return FALSE; }
 
+    /*
+     *   Determine if the object's current state is identical to the given
+     *   image file data, which is the data the object was loaded from.
+     *   Metaclasses that can't keep track of changes on their own (and so
+     *   always claim to have changed since load) can override this to
+     *   compare their current contents against the image data instead.
+     *   When this returns true, saving the game skips the object, since
+     *   restoring resets it to the image file state anyway.
+     *   
+     *   This must only return true if the object is indistinguishable from
+     *   a fresh reload of the image data; when in doubt, return false.  
+     */
+    virtual int matches_image_data(VMG_ const char *ptr, size_t siz) const
+        { return FALSE; }
+
     /* 
      *   save this object to a file, so that it can be restored to its
      *   current state via restore_from_file 
@@ -1383,6 +1454,13 @@ struct obj_fixup_entry
  *   The objects must be added to the table IN ASCENDING ORDER OF OLD ID.
  *   We assume this sorting order to perform a binary lookup when asked to
  *   map an ID.  
+ *   
+ *   Once all of the entries have been added, the caller can build a direct
+ *   index on the old ID's, which turns each lookup into a simple array
+ *   reference.  A large saved game can have millions of object references
+ *   to translate, so this makes a noticeable difference in restore time.
+ *   We only build the index when the old ID's are reasonably dense, since
+ *   the index needs a slot for every ID in the range.  
  */
 
 /* fixup table subarray size */
@@ -1397,6 +1475,9 @@ public:
     /* add a fixup to the table */
     void add_fixup(vm_obj_id_t old_id, vm_obj_id_t new_id);
 
+    /* build the direct index, after all of the fixups have been added */
+    void build_index();
+
     /* 
      *   Translate from the file numbering system to the new numbering
      *   system.  If the object isn't found, it must be a static object and
@@ -1438,6 +1519,15 @@ private:
 
     /* number of entries used so far */
     ulong used_;
+
+    /* 
+     *   Direct index, if we've built one.  index_[id - index_base_] is one
+     *   more than the entry index for old ID 'id', or zero if 'id' has no
+     *   entry.  
+     */
+    ulong *index_;
+    vm_obj_id_t index_base_;
+    ulong index_cnt_;
 };
 
 
@@ -1510,6 +1600,72 @@ public:
     vm_obj_id_t objs_[30];
 };
 
+/* ------------------------------------------------------------------------ */
+/*
+ *   Simple growable array of object IDs.  The generational collector uses
+ *   these to keep its lists of young objects and remembered old objects. 
+ */
+class CVmObjIdArray
+{
+public:
+    CVmObjIdArray()
+    {
+        arr_ = 0;
+        cnt_ = 0;
+        alloc_ = 0;
+    }
+
+    ~CVmObjIdArray() { reset(); }
+
+    /* forget all entries and release the memory */
+    void reset()
+    {
+        if (arr_ != 0)
+            t3free(arr_);
+        arr_ = 0;
+        cnt_ = 0;
+        alloc_ = 0;
+    }
+
+    /* add an entry */
+    void append(vm_obj_id_t obj)
+    {
+        /* expand the array if necessary */
+        if (cnt_ == alloc_)
+        {
+            if (arr_ == 0)
+            {
+                alloc_ = 1024;
+                arr_ = (vm_obj_id_t *)t3malloc(alloc_ * sizeof(arr_[0]));
+            }
+            else
+            {
+                alloc_ += alloc_/2;
+                arr_ = (vm_obj_id_t *)t3realloc(
+                    arr_, alloc_ * sizeof(arr_[0]));
+            }
+            if (arr_ == 0)
+                err_throw(VMERR_OUT_OF_MEMORY);
+        }
+
+        /* add the entry */
+        arr_[cnt_++] = obj;
+    }
+
+    /* forget all entries (but keep the memory for reuse) */
+    void clear() { cnt_ = 0; }
+
+    /* get the number of entries, and the entry at a given index */
+    size_t get_count() const { return cnt_; }
+    vm_obj_id_t get(size_t i) const { return arr_[i]; }
+
+private:
+    /* the array, the number of entries in use, and the allocated size */
+    vm_obj_id_t *arr_;
+    size_t cnt_;
+    size_t alloc_;
+};
+
 /* ------------------------------------------------------------------------ */
 /*
  *   Object Header Manager 
@@ -1640,6 +1796,14 @@ struct CVmObjPageEntry
     /* flag: the object has requested post-load initialization */
     uint requested_post_load_init_ : 1;
 
+    /*
+     *   Flag: the object is in exactly its image file state, as determined
+     *   by matches_image_data(), so it doesn't need to be written to the
+     *   saved state file we're currently writing.  This is only set during
+     *   a save.  
+     */
+    uint matches_image_ : 1;
+
     /*
      *   Garbage collection hint flags.  These flags provide hints on how the
      *   object's metaclass interacts with the garbage collector.  These do
@@ -1686,6 +1850,18 @@ struct CVmObjPageEntry
     uint can_have_refs_ : 1;
     uint can_have_weak_refs_ : 1;
 
+    /*
+     *   Generational GC flags.  'old_' is set when the object has survived
+     *   a collection (or was loaded as part of the root set); objects
+     *   without it are in the nursery, and are the only objects a minor
+     *   collection can delete.  'remembered_' is set while an old object
+     *   is in the object table's remembered set, meaning that a reference
+     *   has been stored into it since the last collection, so it might
+     *   refer to nursery objects.  
+     */
+    uint old_ : 1;
+    uint remembered_ : 1;
+
     /* 
      *   An entry is deletable if it's unreachable and has been finalized.
      *   If the entry is marked as free, it's already been deleted, hence
@@ -1883,8 +2059,19 @@ public:
          *   has indeed already been deleted; otherwise, it's deletable if
          *   its object table entry is deletable.  
          */
-        return (obj == VM_INVALID_OBJ
-                || get_entry(obj)->is_deletable());
+        if (obj == VM_INVALID_OBJ)
+            return TRUE;
+
+        /* 
+         *   during a minor collection, old objects aren't being considered
+         *   for deletion at all, whatever their marking says 
+         */
+        CVmObjPageEntry *entry = get_entry(obj);
+        if (gc_minor_ && entry->old_ && !entry->free_)
+            return FALSE;
+
+        /* ask the entry */
+        return entry->is_deletable();
     }
 
     /*
@@ -2214,6 +2401,50 @@ public:
     /* count an allocation */
     void count_alloc(size_t siz) { bytes_since_gc_ += siz; }
 
+    /*
+     *   Set the number of threads to use for marking during full garbage
+     *   collections.  Zero selects the number automatically based on the
+     *   number of processors and the size of the heap; 1 forces the serial
+     *   tracer.  Values above VM_GC_MAX_THREADS are limited to that value.
+     *   This has no effect if the VM was built without thread support.  
+     */
+    void set_gc_threads(int n)
+    {
+        if (n < 0)
+            n = 0;
+        else if (n > VM_GC_MAX_THREADS)
+            n = VM_GC_MAX_THREADS;
+        gc_threads_ = n;
+    }
+
+    /*
+     *   Generational GC write barrier.  Metaclasses that claim
+     *   has_write_barrier() call this when storing a value into an existing
+     *   object 'obj'.  If the value is an object reference and 'obj' is in
+     *   the old generation, we add 'obj' to the remembered set, so that the
+     *   next minor collection will trace it.  
+     */
+    void note_ref_store(vm_obj_id_t obj, const vm_val_t *val)
+    {
+        if ((val->typ == VM_OBJ || val->typ == VM_OBJX)
+            && val->val.obj != VM_INVALID_OBJ)
+            remember_obj(obj);
+    }
+
+    /* 
+     *   Unconditionally add an old object to the remembered set.  This is
+     *   for stores where it's inconvenient to check the values involved. 
+     */
+    void remember_obj(vm_obj_id_t obj)
+    {
+        CVmObjPageEntry *entry = get_entry(obj);
+        if (entry->old_ && !entry->remembered_)
+        {
+            entry->remembered_ = TRUE;
+            gc_remembered_.append(obj);
+        }
+    }
+
 private:
     /* rebuild the image, writing only transient or only persistent objects */
     void rebuild_image(VMG_ int meta_dep_idx, CVmImageWriter *writer,
@@ -2272,7 +2503,18 @@ private:
          *   objects in the queue in order to trace into the objects they
          *   reference, so an object that can't reference any other objects
          *   doesn't need to go in the queue.  
+         *   
+         *   During a minor collection, old objects are treated as reachable
+         *   without being traced, so we simply ignore them.  During a
+         *   parallel mark, the marking threads have their own queues.  
          */
+        if (gc_minor_ && entry->old_)
+            return;
+        if (gc_par_ != 0)
+        {
+            gc_par_mark(id, entry);
+            return;
+        }
         if (entry->can_have_refs_ && entry->reachable_ == VMOBJ_UNREACHABLE)
         {
             /* add it to the work queue */
@@ -2347,6 +2589,52 @@ private:
      */
     void gc_before_alloc(VMG0_);
 
+    /* 
+     *   Mark a root object as reachable.  In a full collection, this simply
+     *   adds the object to the work queue.  In a minor collection, an old
+     *   root object won't be traced through the queue, so we add it to the
+     *   remembered set instead, to trace its references directly.  This
+     *   covers objects that are still under construction (and so haven't
+     *   gone through the write barrier) when a collection is triggered.  
+     */
+    void gc_mark_root(vm_obj_id_t id)
+    {
+        CVmObjPageEntry *entry = get_entry(id);
+        if (gc_minor_ && entry->old_)
+        {
+            if (entry->can_have_refs_)
+                remember_obj(id);
+        }
+        else
+            add_to_gc_queue(id, entry, VMOBJ_REACHABLE);
+    }
+
+    /* run a minor (nursery-only) collection */
+    void gc_minor(VMG0_);
+
+    /* 
+     *   Trace the work queue with multiple threads, if possible; falls
+     *   back on the serial tracer if not.  This can only be used for the
+     *   main tracing phase of a full collection, where everything in the
+     *   queue is marked VMOBJ_REACHABLE.  
+     */
+    void gc_trace_work_queue_par(VMG0_);
+
+    /* mark an object reachable from a parallel marking thread */
+    void gc_par_mark(vm_obj_id_t id, CVmObjPageEntry *entry);
+
+    /* parallel marking thread entrypoint */
+    static void gc_par_thread_main(VMG_ struct vm_gc_marker *m);
+
+    /* run a parallel marking thread's work loop */
+    void gc_par_work(VMG_ struct vm_gc_marker *m);
+
+    /* 
+     *   reset the generational state after a full collection, or after
+     *   anything that invalidates it 
+     */
+    void gc_reset_generations();
+
     /* garbage collection: trace objects reachable from the stack */
     void gc_trace_stack(VMG0_);
 
@@ -2362,6 +2650,14 @@ private:
     /* continue a GC pass */
     int gc_pass_continue(VMG_ int trace_transient);
 
+    /*
+     *   Mark the objects that are still in their image file state, for
+     *   saving.  We ask each saveable object with saved image data whether
+     *   it still matches that data, and set the matches_image_ flag in its
+     *   page entry if so. 
+     */
+    void mark_image_matches(VMG0_);
+
     /* 
      *   set the initial GC conditions for an object -- this puts the
      *   object into the appropriate queue and sets the appropriate
@@ -2456,8 +2752,47 @@ private:
     uint max_allocs_between_gc_;
     ulong max_bytes_between_gc_;
 
+    /*
+     *   Generational collection state.  'gc_young_' lists the objects
+     *   allocated since the last collection (the nursery).  'gc_remembered_'
+     *   is the remembered set: old objects that have had references stored
+     *   into them since the last collection.  'gc_scan_always_' lists the
+     *   old objects whose metaclasses don't implement the write barrier,
+     *   which we must rescan on every minor collection; we rebuild it
+     *   lazily when 'gc_scan_always_valid_' is cleared.  
+     */
+    CVmObjIdArray gc_young_;
+    CVmObjIdArray gc_remembered_;
+    CVmObjIdArray gc_scan_always_;
+
+    /* number of minor collections since the last full collection */
+    int gc_minor_cnt_;
+
+    /* 
+     *   Number of marking threads to use for full collections: zero means
+     *   that we choose automatically, 1 means we always use the serial
+     *   tracer. 
+     */
+    int gc_threads_;
+
+    /* parallel marking state - non-null only while a parallel mark runs */
+    struct vm_gc_par_state *gc_par_;
+
     /* garbage collection enabled */
     uint gc_enabled_ : 1;
+
+    /* flag: a minor collection is in progress */
+    uint gc_minor_ : 1;
+
+    /* 
+     *   flag: the next collection must be a full one, because the
+     *   generational invariants might not hold (for example, after the
+     *   whole object state has been reset or restored) 
+     */
+    uint gc_need_full_ : 1;
+
+    /* flag: gc_scan_always_ is up to date */
+    uint gc_scan_always_valid_ : 1;
 };
 
 /* ------------------------------------------------------------------------ */
@@ -2581,31 +2916,23 @@ public:
      */
     virtual void free_mem(void *varpart) = 0;
 
-#if 0
-    /* 
-     *   This is not currently used by the heap implementation (and doesn't
-     *   even have any theoretical reason to exist at the moment, since the
-     *   adoption of a non-moveable heap policy and the removal of
-     *   move_var_part()), so it's been removed to avoid the unnecessary
-     *   overhead of calling an empty method. 
-     */
-    
     /*
      *   Receive notification of the completion of a garbage collection
-     *   pass.  If the heap manager is capable of closing gaps in memory
-     *   by moving objects around, this is a good time to perform this
-     *   work, since we have just deleted all unreachable objects.
-     *   
-     *   If any object moves during processing here, we must call the
-     *   associated CVmObject's move_var_part() routine to tell it about
-     *   its new location.
-     *   
-     *   This routine isn't required to do anything at all.  It's simply
-     *   provided as a notification for heap managers that can take
-     *   advantage of the opportunity to compact the heap.  
+     *   pass.  The object table calls this after it has deleted all of the
+     *   unreachable objects (and so freed their variable parts), which
+     *   makes it a good time for the heap manager to do any bulk cleanup,
+     *   such as returning empty pages to the system.  The heap can't move
+     *   any blocks, since the heap is non-moveable.  This isn't required
+     *   to do anything at all.  
      */
-    virtual void finish_gc_pass() = 0;
-#endif
+    virtual void finish_gc_pass() { }
+
+    /*
+     *   Receive notification that the object table has reset the root set
+     *   to its initial image file state, as part of a restart or a restore.
+     *   This isn't required to do anything.  
+     */
+    virtual void reset_to_image() { }
 };
 
 
@@ -2697,17 +3024,6 @@ public:
          */
         t3free(hdr);
     }
-
-#if 0
-    /* removed with the removal of move_var_part() */
-    
-    /* 
-     *   complete garbage collection pass - we don't have to do anything
-     *   here, since we can't move objects around to consolidate free
-     *   space 
-     */
-    void finish_gc_pass() { }
-#endif
     
 private:
 };
@@ -2912,17 +3228,6 @@ public:
 
     /* free memory */
     void free_mem(void *varpart);
-
-#if 0
-    /* removed with the removal of move_var_part() */
-    
-    /* 
-     *   complete garbage collection pass - we don't have to do anything
-     *   here, since we can't move objects around to consolidate free
-     *   space 
-     */
-    void finish_gc_pass() { }
-#endif
     
 private:
     /* 
@@ -2952,6 +3257,222 @@ private:
     CVmObjTable *objtab_;
 };
 
+/* ------------------------------------------------------------------------ */
+/*
+ *   Size-class slab heap allocator.  This heap manager segregates blocks
+ *   into a set of size classes, and allocates each class's blocks from
+ *   "slabs": large arrays of cells of the class's size.  Each slab keeps
+ *   its own free list and count of cells in use, so when a slab empties
+ *   out, we can return it to the system.  We don't do that immediately
+ *   when the last block is freed, since the sweep phase of a collection
+ *   tends to empty a slab only to have the program refill it right away;
+ *   instead, we release empty slabs in bulk at the end of each garbage
+ *   collection pass, keeping one spare per class.  Blocks too large for
+ *   the largest class go directly to the system heap.
+ *   
+ *   We keep allocation counters for each size class, for tuning and
+ *   diagnostics.  
+ */
+
+/* number of slab size classes */
+const int VM_SLAB_CLASS_CNT = 16;
+
+/* largest block size (not counting our header) allocated from slabs */
+const size_t VM_SLAB_MAX_SIZE = 4096;
+
+/* target size of each slab, in bytes */
+const size_t VM_SLAB_SIZE = 64*1024;
+
+/*
+ *   Block header.  Each block, whether in a slab or not, is preceded by
+ *   one of these.  For a large block, 'slab' is null, and the block's
+ *   size is stored in a size_t immediately before the header. 
+ */
+struct CVmVarHeapSlab_hdr
+{
+    /* the slab containing the block, or null for a large block */
+    struct CVmVarHeapSlab_slab *slab;
+};
+
+/*
+ *   Slab.  The cells follow the slab structure in memory. 
+ */
+struct CVmVarHeapSlab_slab
+{
+    /* the size class this slab belongs to */
+    struct CVmVarHeapSlab_class *cls;
+
+    /* 
+     *   links in the class's list of slabs with free cells or its list of
+     *   full slabs, and the head of the list we're in 
+     */
+    CVmVarHeapSlab_slab *prv;
+    CVmVarHeapSlab_slab *nxt;
+    CVmVarHeapSlab_slab **list;
+
+    /* head of the list of freed cells in this slab */
+    void *first_free;
+
+    /* 
+     *   Next never-used cell, and the number of never-used cells remaining.
+     *   We carve cells out of a new slab on demand rather than building a
+     *   free list of the whole slab up front. 
+     */
+    char *unused;
+    size_t unused_cnt;
+
+    /* number of cells currently allocated */
+    size_t live;
+};
+
+/*
+ *   Size class 
+ */
+struct CVmVarHeapSlab_class
+{
+    /* the largest block size in this class, and the size of each cell */
+    size_t siz;
+    size_t cell_size;
+
+    /* number of cells per slab */
+    size_t cells_per_slab;
+
+    /* slabs with free cells, and slabs without */
+    CVmVarHeapSlab_slab *avail;
+    CVmVarHeapSlab_slab *full;
+
+    /* number of slabs allocated for this class */
+    size_t slab_cnt;
+
+    /* statistics: number of blocks and bytes allocated and freed */
+    ulong alloc_cnt;
+    ulong free_cnt;
+    ulong bytes_alloc;
+    ulong bytes_freed;
+};
+
+/*
+ *   Size class statistics, as reported by CVmVarHeapSlab::get_class_stats() 
+ */
+struct vm_varheap_class_stats
+{
+    /* 
+     *   the largest block size in the class (zero for the pseudo-class of
+     *   large blocks allocated directly from the system heap) 
+     */
+    size_t siz;
+
+    /* number of blocks allocated and freed */
+    ulong alloc_cnt;
+    ulong free_cnt;
+
+    /* 
+     *   number of bytes allocated and freed - this counts the full cell
+     *   size for slab blocks, since that's what the block consumes 
+     */
+    ulong bytes_alloc;
+    ulong bytes_freed;
+
+    /* number of slabs currently allocated for the class */
+    size_t slab_cnt;
+};
+
+/*
+ *   heap implementation 
+ */
+class CVmVarHeapSlab: public CVmVarHeap
+{
+public:
+    CVmVarHeapSlab(CVmObjTable *objtab);
+    ~CVmVarHeapSlab();
+
+    /* initialize */
+    void init(VMG0_) { }
+
+    /* terminate */
+    void terminate() { }
+
+    /* allocate memory */
+    void *alloc_mem(size_t siz, CVmObject *obj);
+
+    /* reallocate memory */
+    void *realloc_mem(size_t siz, void *varpart, CVmObject *obj);
+
+    /* free memory */
+    void free_mem(void *varpart);
+
+    /* end of a collection - release empty slabs, keeping one spare */
+    void finish_gc_pass() { release_empty_slabs(1); }
+
+    /* 
+     *   reset to the image file state - if arena reset is enabled, release
+     *   every empty slab, including the spares we'd normally keep, since a
+     *   restart or restore replaces most of the heap anyway 
+     */
+    void reset_to_image()
+    {
+        if (arena_reset_)
+            release_empty_slabs(0);
+    }
+
+    /* enable or disable releasing all empty slabs on reset_to_image() */
+    void set_arena_reset(int f) { arena_reset_ = f; }
+
+    /* 
+     *   Get the statistics for a size class.  The classes are numbered
+     *   from 0 to get_class_cnt()-1 in ascending order of size; the last
+     *   is the pseudo-class of large blocks.  
+     */
+    int get_class_cnt() const { return VM_SLAB_CLASS_CNT + 1; }
+    void get_class_stats(int idx, vm_varheap_class_stats *stats) const;
+
+private:
+    /* get the size class index for a block size */
+    int size_to_class(size_t siz) const
+        { return size_class_[(siz + 15) / 16]; }
+
+    /* allocate a block from a size class */
+    CVmVarHeapSlab_hdr *alloc_cell(CVmVarHeapSlab_class *cls);
+
+    /* free a slab block */
+    void free_cell(CVmVarHeapSlab_hdr *hdr);
+
+    /* allocate and free large blocks */
+    CVmVarHeapSlab_hdr *alloc_large(size_t siz);
+    void free_large(CVmVarHeapSlab_hdr *hdr);
+
+    /* get the size of a large block */
+    static size_t large_size(CVmVarHeapSlab_hdr *hdr)
+        { return ((size_t *)hdr)[-1]; }
+
+    /* move a slab into the given list */
+    void link_slab(CVmVarHeapSlab_slab *slab, CVmVarHeapSlab_slab **list);
+
+    /* release empty slabs, keeping up to 'keep' spares in each class */
+    void release_empty_slabs(size_t keep);
+
+    /* the size classes */
+    CVmVarHeapSlab_class classes_[VM_SLAB_CLASS_CNT];
+
+    /* 
+     *   size class lookup table, indexed by the block size divided by 16
+     *   (rounding up) 
+     */
+    unsigned char size_class_[VM_SLAB_MAX_SIZE/16 + 1];
+
+    /* statistics for large blocks */
+    ulong large_alloc_cnt_;
+    ulong large_free_cnt_;
+    ulong large_bytes_alloc_;
+    ulong large_bytes_freed_;
+
+    /* flag: release all empty slabs on reset_to_image() */
+    int arena_reset_;
+
+    /* object table */
+    CVmObjTable *objtab_;
+};
+
 /* ------------------------------------------------------------------------ */
 /*
  *   Memory Manager - this is the primary interface to the object memory
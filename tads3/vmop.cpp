@@ -337,3 +337,271 @@ const uchar CVmOpcodes::op_siz[] =
     1,                                                     /* 0xFE - unused */
     255                                                    /* 0xFF - unused */
 };
+
+#ifdef VM_OPSTATS
+
+/*
+ *   Table of T3 VM opcode names, for the opcode statistics report.  Unused
+ *   opcodes have null entries. 
+ */
+const char *const CVmOpcodes::op_name[] =
+{
+    0,                                      /* 0x00 */
+    "PUSH_0",                               /* 0x01 */
+    "PUSH_1",                               /* 0x02 */
+    "PUSHINT8",                             /* 0x03 */
+    "PUSHINT",                              /* 0x04 */
+    "PUSHSTR",                              /* 0x05 */
+    "PUSHLST",                              /* 0x06 */
+    "PUSHOBJ",                              /* 0x07 */
+    "PUSHNIL",                              /* 0x08 */
+    "PUSHTRUE",                             /* 0x09 */
+    "PUSHPROPID",                           /* 0x0A */
+    "PUSHFNPTR",                            /* 0x0B */
+    "PUSHSTRI",                             /* 0x0C */
+    "PUSHPARLST",                           /* 0x0D */
+    "MAKELSTPAR",                           /* 0x0E */
+    "PUSHENUM",                             /* 0x0F */
+    "PUSHBIFPTR",                           /* 0x10 */
+    0,                                      /* 0x11 */
+    0,                                      /* 0x12 */
+    0,                                      /* 0x13 */
+    0,                                      /* 0x14 */
+    0,                                      /* 0x15 */
+    0,                                      /* 0x16 */
+    0,                                      /* 0x17 */
+    0,                                      /* 0x18 */
+    0,                                      /* 0x19 */
+    0,                                      /* 0x1A */
+    0,                                      /* 0x1B */
+    0,                                      /* 0x1C */
+    0,                                      /* 0x1D */
+    0,                                      /* 0x1E */
+    0,                                      /* 0x1F */
+    "NEG",                                  /* 0x20 */
+    "BNOT",                                 /* 0x21 */
+    "ADD",                                  /* 0x22 */
+    "SUB",                                  /* 0x23 */
+    "MUL",                                  /* 0x24 */
+    "BAND",                                 /* 0x25 */
+    "BOR",                                  /* 0x26 */
+    "SHL",                                  /* 0x27 */
+    "ASHR",                                 /* 0x28 */
+    "XOR",                                  /* 0x29 */
+    "DIV",                                  /* 0x2A */
+    "MOD",                                  /* 0x2B */
+    "NOT",                                  /* 0x2C */
+    "BOOLIZE",                              /* 0x2D */
+    "INC",                                  /* 0x2E */
+    "DEC",                                  /* 0x2F */
+    "LSHR",                                 /* 0x30 */
+    0,                                      /* 0x31 */
+    0,                                      /* 0x32 */
+    0,                                      /* 0x33 */
+    0,                                      /* 0x34 */
+    0,                                      /* 0x35 */
+    0,                                      /* 0x36 */
+    0,                                      /* 0x37 */
+    0,                                      /* 0x38 */
+    0,                                      /* 0x39 */
+    0,                                      /* 0x3A */
+    0,                                      /* 0x3B */
+    0,                                      /* 0x3C */
+    0,                                      /* 0x3D */
+    0,                                      /* 0x3E */
+    0,                                      /* 0x3F */
+    "EQ",                                   /* 0x40 */
+    "NE",                                   /* 0x41 */
+    "LT",                                   /* 0x42 */
+    "LE",                                   /* 0x43 */
+    "GT",                                   /* 0x44 */
+    "GE",                                   /* 0x45 */
+    0,                                      /* 0x46 */
+    0,                                      /* 0x47 */
+    0,                                      /* 0x48 */
+    0,                                      /* 0x49 */
+    0,                                      /* 0x4A */
+    0,                                      /* 0x4B */
+    0,                                      /* 0x4C */
+    0,                                      /* 0x4D */
+    0,                                      /* 0x4E */
+    0,                                      /* 0x4F */
+    "RETVAL",                               /* 0x50 */
+    "RETNIL",                               /* 0x51 */
+    "RETTRUE",                              /* 0x52 */
+    0,                                      /* 0x53 */
+    "RET",                                  /* 0x54 */
+    0,                                      /* 0x55 */
+    "NAMEDARGPTR",                          /* 0x56 */
+    "NAMEDARGTAB",                          /* 0x57 */
+    "CALL",                                 /* 0x58 */
+    "PTRCALL",                              /* 0x59 */
+    0,                                      /* 0x5A */
+    0,                                      /* 0x5B */
+    0,                                      /* 0x5C */
+    0,                                      /* 0x5D */
+    0,                                      /* 0x5E */
+    0,                                      /* 0x5F */
+    "GETPROP",                              /* 0x60 */
+    "CALLPROP",                             /* 0x61 */
+    "PTRCALLPROP",                          /* 0x62 */
+    "GETPROPSELF",                          /* 0x63 */
+    "CALLPROPSELF",                         /* 0x64 */
+    "PTRCALLPROPSELF",                      /* 0x65 */
+    "OBJGETPROP",                           /* 0x66 */
+    "OBJCALLPROP",                          /* 0x67 */
+    "GETPROPDATA",                          /* 0x68 */
+    "PTRGETPROPDATA",                       /* 0x69 */
+    "GETPROPLCL1",                          /* 0x6A */
+    "CALLPROPLCL1",                         /* 0x6B */
+    "GETPROPR0",                            /* 0x6C */
+    "CALLPROPR0",                           /* 0x6D */
+    0,                                      /* 0x6E */
+    0,                                      /* 0x6F */
+    0,                                      /* 0x70 */
+    0,                                      /* 0x71 */
+    "INHERIT",                              /* 0x72 */
+    "PTRINHERIT",                           /* 0x73 */
+    "EXPINHERIT",                           /* 0x74 */
+    "PTREXPINHERIT",                        /* 0x75 */
+    "VARARGC",                              /* 0x76 */
+    "DELEGATE",                             /* 0x77 */
+    "PTRDELEGATE",                          /* 0x78 */
+    0,                                      /* 0x79 */
+    "SWAP2",                                /* 0x7A */
+    "SWAPN",                                /* 0x7B */
+    "GETARGN0",                             /* 0x7C */
+    "GETARGN1",                             /* 0x7D */
+    "GETARGN2",                             /* 0x7E */
+    "GETARGN3",                             /* 0x7F */
+    "GETLCL1",                              /* 0x80 */
+    "GETLCL2",                              /* 0x81 */
+    "GETARG1",                              /* 0x82 */
+    "GETARG2",                              /* 0x83 */
+    "PUSHSELF",                             /* 0x84 */
+    "GETDBLCL",                             /* 0x85 */
+    "GETDBARG",                             /* 0x86 */
+    "GETARGC",                              /* 0x87 */
+    "DUP",                                  /* 0x88 */
+    "DISC",                                 /* 0x89 */
+    "DISC1",                                /* 0x8A */
+    "GETR0",                                /* 0x8B */
+    "GETDBARGC",                            /* 0x8C */
+    "SWAP",                                 /* 0x8D */
+    "PUSHCTXELE",                           /* 0x8E */
+    "DUP2",                                 /* 0x8F */
+    "SWITCH",                               /* 0x90 */
+    "JMP",                                  /* 0x91 */
+    "JT",                                   /* 0x92 */
+    "JF",                                   /* 0x93 */
+    "JE",                                   /* 0x94 */
+    "JNE",                                  /* 0x95 */
+    "JGT",                                  /* 0x96 */
+    "JGE",                                  /* 0x97 */
+    "JLT",                                  /* 0x98 */
+    "JLE",                                  /* 0x99 */
+    "JST",                                  /* 0x9A */
+    "JSF",                                  /* 0x9B */
+    "LJSR",                                 /* 0x9C */
+    "LRET",                                 /* 0x9D */
+    "JNIL",                                 /* 0x9E */
+    "JNOTNIL",                              /* 0x9F */
+    "JR0T",                                 /* 0xA0 */
+    "JR0F",                                 /* 0xA1 */
+    "ITERNEXT",                             /* 0xA2 */
+    "GETSETLCL1R0",                         /* 0xA3 */
+    "GETSETLCL1",                           /* 0xA4 */
+    "DUPR0",                                /* 0xA5 */
+    "GETSPN",                               /* 0xA6 */
+    0,                                      /* 0xA7 */
+    0,                                      /* 0xA8 */
+    0,                                      /* 0xA9 */
+    "GETLCLN0",                             /* 0xAA */
+    "GETLCLN1",                             /* 0xAB */
+    "GETLCLN2",                             /* 0xAC */
+    "GETLCLN3",                             /* 0xAD */
+    "GETLCLN4",                             /* 0xAE */
+    "GETLCLN5",                             /* 0xAF */
+    "SAY",                                  /* 0xB0 */
+    "BUILTIN_A",                            /* 0xB1 */
+    "BUILTIN_B",                            /* 0xB2 */
+    "BUILTIN_C",                            /* 0xB3 */
+    "BUILTIN_D",                            /* 0xB4 */
+    "BUILTIN1",                             /* 0xB5 */
+    "BUILTIN2",                             /* 0xB6 */
+    "CALLEXT",                              /* 0xB7 */
+    "THROW",                                /* 0xB8 */
+    "SAYVAL",                               /* 0xB9 */
+    "INDEX",                                /* 0xBA */
+    "IDXLCL1INT8",                          /* 0xBB */
+    "IDXINT8",                              /* 0xBC */
+    0,                                      /* 0xBD */
+    0,                                      /* 0xBE */
+    0,                                      /* 0xBF */
+    "NEW1",                                 /* 0xC0 */
+    "NEW2",                                 /* 0xC1 */
+    "TRNEW1",                               /* 0xC2 */
+    "TRNEW2",                               /* 0xC3 */
+    0,                                      /* 0xC4 */
+    0,                                      /* 0xC5 */
+    0,                                      /* 0xC6 */
+    0,                                      /* 0xC7 */
+    0,                                      /* 0xC8 */
+    0,                                      /* 0xC9 */
+    0,                                      /* 0xCA */
+    0,                                      /* 0xCB */
+    0,                                      /* 0xCC */
+    0,                                      /* 0xCD */
+    0,                                      /* 0xCE */
+    0,                                      /* 0xCF */
+    "INCLCL",                               /* 0xD0 */
+    "DECLCL",                               /* 0xD1 */
+    "ADDILCL1",                             /* 0xD2 */
+    "ADDILCL4",                             /* 0xD3 */
+    "ADDTOLCL",                             /* 0xD4 */
+    "SUBFROMLCL",                           /* 0xD5 */
+    "ZEROLCL1",                             /* 0xD6 */
+    "ZEROLCL2",                             /* 0xD7 */
+    "NILLCL1",                              /* 0xD8 */
+    "NILLCL2",                              /* 0xD9 */
+    "ONELCL1",                              /* 0xDA */
+    "ONELCL2",                              /* 0xDB */
+    0,                                      /* 0xDC */
+    0,                                      /* 0xDD */
+    0,                                      /* 0xDE */
+    0,                                      /* 0xDF */
+    "SETLCL1",                              /* 0xE0 */
+    "SETLCL2",                              /* 0xE1 */
+    "SETARG1",                              /* 0xE2 */
+    "SETARG2",                              /* 0xE3 */
+    "SETIND",                               /* 0xE4 */
+    "SETPROP",                              /* 0xE5 */
+    "PTRSETPROP",                           /* 0xE6 */
+    "SETPROPSELF",                          /* 0xE7 */
+    "OBJSETPROP",                           /* 0xE8 */
+    "SETDBLCL",                             /* 0xE9 */
+    "SETDBARG",                             /* 0xEA */
+    "SETSELF",                              /* 0xEB */
+    "LOADCTX",                              /* 0xEC */
+    "STORECTX",                             /* 0xED */
+    "SETLCL1R0",                            /* 0xEE */
+    "SETINDLCL1I8",                         /* 0xEF */
+    0,                                      /* 0xF0 */
+    "BP",                                   /* 0xF1 */
+    "NOP",                                  /* 0xF2 */
+    0,                                      /* 0xF3 */
+    0,                                      /* 0xF4 */
+    0,                                      /* 0xF5 */
+    0,                                      /* 0xF6 */
+    0,                                      /* 0xF7 */
+    0,                                      /* 0xF8 */
+    0,                                      /* 0xF9 */
+    0,                                      /* 0xFA */
+    0,                                      /* 0xFB */
+    0,                                      /* 0xFC */
+    0,                                      /* 0xFD */
+    0,                                      /* 0xFE */
+    0                                       /* 0xFF */
+};
+
+#endif /* VM_OPSTATS */
@@ -38,6 +38,15 @@ public:
      *   of varying-length instructions. 
      */
     static size_t get_op_size(const uchar *op);
+
+#ifdef VM_OPSTATS
+    /* 
+     *   Opcode name table.  Index by opcode; each entry gives the name of
+     *   the instruction, or null for unused opcodes.  This is only included
+     *   in builds with opcode statistics (see vmrun.h).  
+     */
+    static const char *const op_name[];
+#endif
 };
 
 
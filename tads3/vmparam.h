@@ -135,4 +135,20 @@ Modified
 # define VM_UNDO_MAX_SAVEPTS  64
 #endif
 
+/*
+ *   Undo byte budget.  If this is non-zero, it limits the total memory that
+ *   the undo log can use, in bytes.  The record limit alone doesn't bound
+ *   the memory, because some records carry extra data whose size depends on
+ *   the change - the text removed from a StringBuffer, or the old contents
+ *   of a range of a ByteArray, for example.  With a budget, the record array
+ *   takes at most half of the budget (we reduce the record limit if
+ *   necessary), and the extra data gets the rest; the undo mechanism
+ *   discards the oldest savepoints as needed to stay within it.  This is
+ *   useful for hosts that run many sessions at once and need to know how
+ *   much memory each one can use.  Zero means no budget.  
+ */
+#ifndef VM_UNDO_MAX_BYTES
+# define VM_UNDO_MAX_BYTES  0
+#endif
+
 #endif /* VMPARAM_H */
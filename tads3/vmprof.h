@@ -54,6 +54,39 @@ Modified
 
 #endif /* VM_PROFILER */
 
+/* ------------------------------------------------------------------------ */
+/*
+ *   Enable opcode statistics by #defining VM_OPSTATS when compiling the VM.
+ *   This counts every instruction executed, and measures the time spent in
+ *   each one, so it's only appropriate for special performance-analysis
+ *   builds; when VM_OPSTATS isn't defined, none of this code is included.
+ */
+#ifdef VM_OPSTATS
+#define VM_IF_OPSTATS(x)       x
+#else
+#define VM_IF_OPSTATS(x)
+#endif
+
+/* 
+ *   Maximum number of metaclasses we distinguish in the opcode statistics.
+ *   Metaclasses with higher registration indices are lumped together in the
+ *   last slot. 
+ */
+#define VM_OPSTAT_MAX_META     64
+
+/*
+ *   Opcode statistics record.  We keep one of these per opcode, plus one
+ *   per (opcode, metaclass) pair for the property evaluation instructions.
+ */
+struct vm_opstat_rec
+{
+    /* number of executions */
+    unsigned long long cnt;
+
+    /* cumulative time in the instruction, in nanoseconds */
+    unsigned long long ns;
+};
+
 /* ------------------------------------------------------------------------ */
 /*
  *   Profiler function call record.
@@ -133,5 +166,37 @@ void os_prof_curtime(vm_prof_time *t);
 unsigned long os_prof_time_to_ms(const vm_prof_time *t);
 
 
+/* ------------------------------------------------------------------------ */
+/*
+ *   Sampling profiler.  The sampling profiler is always included in the
+ *   build, since it has no cost when it's not running.  It relies on an
+ *   OS-provided periodic timer; each timer tick is counted, and the
+ *   interpreter records the call stack with the accumulated tick count the
+ *   next time it calls or returns from a function.  
+ */
+
+/* sampling interval, in microseconds */
+#define VM_SAMPLE_INTERVAL_US  1000
+
+/* 
+ *   maximum call stack depth we record per sample - deeper stacks are
+ *   truncated at the outermost end 
+ */
+#define VM_SAMPLE_MAX_DEPTH    128
+
+/*
+ *   Start the sampling timer.  The OS code should arrange to call 'tick'
+ *   every 'interval_us' microseconds of CPU time consumed by the process,
+ *   until os_prof_stop_timer() is called.  'tick' is normally invoked from
+ *   a signal handler or equivalent asynchronous context, so it only
+ *   increments a counter.  Returns true on success, false if the OS can't
+ *   provide a timer.  
+ */
+int os_prof_start_timer(long interval_us, void (*tick)(void));
+
+/* stop the sampling timer */
+void os_prof_stop_timer(void);
+
+
 #endif /* VMPROF_H */
 
@@ -1662,6 +1662,13 @@ re_status_t CRegexParser::compile(const char *expr_str, size_t exprlen,
     pat->machine = alter_machine;
     pat->tuple_cnt = next_state_;
 
+    /* note whether the pattern can run on the automaton engine */
+    pat->nfa_ok = is_nfa_compatible(pat);
+
+    /* build the first-byte filters for searching */
+    build_first_set(pat, FALSE, &pat->first_set[0]);
+    build_first_set(pat, TRUE, &pat->first_set[1]);
+
     /* limit the group count to the maximum */
     if (pat->group_cnt > RE_GROUP_REG_CNT)
         pat->group_cnt = RE_GROUP_REG_CNT;
@@ -2478,6 +2485,315 @@ void CRegexParser::consolidate_strings(re_machine *machine)
     }
 }
 
+/* ------------------------------------------------------------------------ */
+/*
+ *   Determine if a compiled pattern can run on the automaton engine.  The
+ *   engine can't handle anything where the rest of the match depends on
+ *   the path taken to a state: back-references, assertions, and counted
+ *   intervals (whose loop counters are part of the match state).  It also
+ *   assumes that every branch choice favors the same direction, so in
+ *   longest-match mode, it can't handle shortest-match closures.  
+ */
+int CRegexParser::is_nfa_compatible(const re_compiled_pattern_base *pat) const
+{
+    for (re_state_id i = 0 ; i < next_state_ ; ++i)
+    {
+        const re_tuple *t = &tuple_arr_[i];
+        switch (t->typ)
+        {
+        case RE_GROUP_MATCH:
+        case RE_LOOKBACK_POS:
+        case RE_ASSERT_POS:
+        case RE_ASSERT_NEG:
+        case RE_ASSERT_BACKPOS:
+        case RE_ASSERT_BACKNEG:
+        case RE_ZERO_VAR:
+        case RE_LOOP_BRANCH:
+            return FALSE;
+
+        default:
+            break;
+        }
+
+        if (pat->longest_match && (t->flags & RE_STATE_SHORTEST) != 0)
+            return FALSE;
+    }
+
+    /* it's all stuff we can handle */
+    return TRUE;
+}
+
+/*
+ *   Add the bytes that can start a match to a literal character to a
+ *   first-byte filter.  With case folding, a non-ASCII character can match
+ *   ASCII letters ("\u00DF" matches "ss"), and an ASCII letter can match
+ *   non-ASCII characters (the Kelvin sign folds to "k"), so in that case we
+ *   let in every character that could conceivably be involved.  
+ */
+static void add_first_char(wchar_t ch, int case_sensitive, re_first_set *fs)
+{
+    int i;
+
+    if (ch < 0x80)
+    {
+        /* add the character itself */
+        fs->add((unsigned char)ch);
+
+        /* without case sensitivity, add its other case */
+        if (!case_sensitive)
+        {
+            if (ch >= 'a' && ch <= 'z')
+                fs->add((unsigned char)(ch - 'a' + 'A'));
+            else if (ch >= 'A' && ch <= 'Z')
+                fs->add((unsigned char)(ch - 'A' + 'a'));
+        }
+    }
+    else if (case_sensitive)
+    {
+        /* add the first byte of its UTF-8 encoding */
+        char buf[4];
+        utf8_ptr::s_putch(buf, ch);
+        fs->add((unsigned char)buf[0]);
+    }
+    else
+    {
+        /* it could match any ASCII letter it folds to */
+        for (i = 'a' ; i <= 'z' ; ++i)
+        {
+            fs->add((unsigned char)i);
+            fs->add((unsigned char)(i - 'a' + 'A'));
+        }
+    }
+
+    /* without case sensitivity, it could match any non-ASCII character */
+    if (!case_sensitive)
+    {
+        for (i = 0xC0 ; i <= 0xFF ; ++i)
+            fs->add((unsigned char)i);
+    }
+}
+
+/*
+ *   Build the first-byte filter for a compiled pattern.  We find the
+ *   character-consuming states that we can reach from the initial state
+ *   without consuming any input, and add the bytes that can start a match
+ *   to each one.  The zero-width states (assertions, word boundaries, and
+ *   so on) can only rule out matches, so we simply pass through them.  
+ */
+void CRegexParser::build_first_set(const re_compiled_pattern_base *pat,
+                                   int case_sensitive,
+                                   re_first_set *fs) const
+{
+    /* start with an empty set */
+    memset(fs, 0, sizeof(*fs));
+
+    /* 
+     *   if the initial state is the final state, the pattern matches an
+     *   empty string anywhere, so there's no filter 
+     */
+    if (pat->machine.init == pat->machine.final)
+        return;
+
+    /* 
+     *   set up a visited flag for each state, and a stack of states to
+     *   visit - we push each state at most once, so the stack needs one
+     *   entry per state 
+     */
+    re_state_id nstates = pat->tuple_cnt;
+    char *visited = (char *)t3malloc(nstates);
+    re_state_id *stk = (re_state_id *)t3malloc(
+        nstates * sizeof(stk[0]));
+    memset(visited, 0, nstates);
+
+    /* start at the initial state */
+    int sp = 0;
+    stk[sp++] = pat->machine.init;
+    visited[pat->machine.init] = TRUE;
+
+    /* 
+     *   visit states until we run out, or find that anything can match;
+     *   keep track of the number of character-consuming states we reach,
+     *   and the last one 
+     */
+    int any = FALSE;
+    int nconsume = 0;
+    const re_tuple *last_consume = 0;
+    while (sp != 0 && !any)
+    {
+        re_state_id s = stk[--sp];
+
+        /* 
+         *   if we can reach the final state, the pattern can match an
+         *   empty string, which can happen anywhere 
+         */
+        if (s == pat->machine.final)
+        {
+            any = TRUE;
+            break;
+        }
+
+        /* check the state type */
+        const re_tuple *t = &tuple_arr_[s];
+        re_state_id next2 = RE_STATE_INVALID;
+        int c;
+        switch (t->typ)
+        {
+        case RE_LITERAL:
+            add_first_char(t->info.ch, case_sensitive, fs);
+            ++nconsume;
+            last_consume = t;
+            continue;
+
+        case RE_LITSTR:
+        case RE_LITSTRA:
+            if (t->info.str.str[0] == 0)
+                any = TRUE;
+            else
+                add_first_char(t->info.str.str[0], case_sensitive, fs);
+            ++nconsume;
+            last_consume = t;
+            continue;
+
+        case RE_WORD_CHAR:
+        case RE_NON_WORD_CHAR:
+        case RE_RANGE:
+        case RE_RANGE_EXCL:
+        case RE_ALPHA:
+        case RE_DIGIT:
+        case RE_NON_DIGIT:
+        case RE_UPPER:
+        case RE_LOWER:
+        case RE_ALPHANUM:
+        case RE_SPACE:
+        case RE_NON_SPACE:
+        case RE_PUNCT:
+        case RE_NEWLINE:
+        case RE_VSPACE:
+        case RE_NON_VSPACE:
+            /* 
+             *   A character class.  Test each ASCII character against it.
+             *   A case-insensitive range could match a letter by way of a
+             *   multi-character folding, so let in all of the letters in
+             *   that case.  
+             */
+            for (c = 0 ; c < 0x80 ; ++c)
+            {
+                char ch = (char)c;
+                if (CRegexNFA::consume(t, &ch, 1, case_sensitive) > 0
+                    || (!case_sensitive
+                        && (t->typ == RE_RANGE || t->typ == RE_RANGE_EXCL)
+                        && ((c >= 'a' && c <= 'z')
+                            || (c >= 'A' && c <= 'Z'))))
+                    fs->add((unsigned char)c);
+            }
+
+            /* it could match any non-ASCII character */
+            for (c = 0xC0 ; c <= 0xFF ; ++c)
+                fs->add((unsigned char)c);
+            ++nconsume;
+            continue;
+
+        case RE_EPSILON:
+        case RE_LOOP_BRANCH:
+            /* two-way branch - visit both branches */
+            next2 = t->next_state_2;
+            break;
+
+        case RE_TEXT_BEGIN:
+        case RE_TEXT_END:
+        case RE_LOOKBACK_POS:
+        case RE_WORD_BEGIN:
+        case RE_WORD_END:
+        case RE_WORD_BOUNDARY:
+        case RE_NON_WORD_BOUNDARY:
+        case RE_GROUP_ENTER:
+        case RE_GROUP_EXIT:
+        case RE_ASSERT_POS:
+        case RE_ASSERT_NEG:
+        case RE_ASSERT_BACKPOS:
+        case RE_ASSERT_BACKNEG:
+        case RE_ZERO_VAR:
+            /* zero-width - pass through to the next state */
+            break;
+
+        default:
+            /* 
+             *   a wildcard or group match (back-reference) can start with
+             *   any character 
+             */
+            any = TRUE;
+            continue;
+        }
+
+        /* visit the next state or states */
+        if (t->next_state_1 != RE_STATE_INVALID
+            && !visited[t->next_state_1])
+        {
+            visited[t->next_state_1] = TRUE;
+            stk[sp++] = t->next_state_1;
+        }
+        if (next2 != RE_STATE_INVALID && !visited[next2])
+        {
+            visited[next2] = TRUE;
+            stk[sp++] = next2;
+        }
+    }
+
+    /* done with the scratch space */
+    t3free(visited);
+    t3free(stk);
+
+    /* 
+     *   If a match can start anywhere, or with any ASCII character, the
+     *   filter won't rule out enough to be worth using.  Otherwise, it's
+     *   ready to go.  
+     */
+    if (!any)
+    {
+        int c;
+        for (c = 0 ; c < 0x80 && fs->test((unsigned char)c) ; ++c) ;
+        any = (c == 0x80);
+    }
+    if (any)
+    {
+        memset(fs, 0, sizeof(*fs));
+        return;
+    }
+
+    /* 
+     *   If a literal character or string is the only place a match can
+     *   start, and we're matching case-sensitively, every match starts
+     *   with that literal text, so note it as the prefix.  
+     */
+    if (nconsume == 1 && last_consume != 0 && case_sensitive)
+    {
+        wchar_t ch1[1];
+        const wchar_t *lit;
+        size_t n;
+        if (last_consume->typ == RE_LITERAL)
+        {
+            ch1[0] = last_consume->info.ch;
+            lit = ch1;
+            n = 1;
+        }
+        else
+        {
+            lit = last_consume->info.str.str;
+            n = wcslen(lit);
+        }
+
+        /* encode as many characters as fit in the prefix buffer */
+        for (size_t i = 0 ; i < n ; ++i)
+        {
+            size_t csiz = utf8_ptr::s_wchar_size(lit[i]);
+            if (fs->prefix_len + csiz > sizeof(fs->prefix))
+                break;
+            fs->prefix_len += utf8_ptr::s_putch(
+                fs->prefix + fs->prefix_len, lit[i]);
+        }
+    }
+}
+
 /* ------------------------------------------------------------------------ */
 /*
  *   Compile an expression and return a newly-allocated pattern object.  
@@ -2625,6 +2941,139 @@ void CRegexParser::free_pattern(re_compiled_pattern *pattern)
     t3free(pattern);
 }
 
+/* ------------------------------------------------------------------------ */
+/*
+ *   Compiled pattern cache 
+ */
+CRegexCache::CRegexCache(CRegexParser *parser)
+{
+    /* remember our parser */
+    parser_ = parser;
+
+    /* start with all entries empty */
+    memset(ents_, 0, sizeof(ents_));
+
+    /* start the clock and statistics at zero */
+    clock_ = 0;
+    hits_ = misses_ = 0;
+}
+
+CRegexCache::~CRegexCache()
+{
+    /* free the patterns and our copies of their text */
+    for (int i = 0 ; i < RE_CACHE_SIZE ; ++i)
+    {
+        if (ents_[i].pat != 0)
+        {
+            CRegexParser::free_pattern(ents_[i].pat);
+            t3free(ents_[i].expr);
+        }
+    }
+}
+
+/*
+ *   hash a pattern string (FNV-1a) 
+ */
+unsigned int CRegexCache::hash(const char *expr, size_t len)
+{
+    unsigned int h = 2166136261U;
+    for ( ; len != 0 ; --len, ++expr)
+        h = (h ^ (unsigned char)*expr) * 16777619U;
+    return h;
+}
+
+/*
+ *   look up or compile a pattern 
+ */
+re_compiled_pattern *CRegexCache::get(const char *expr, size_t exprlen)
+{
+    unsigned int h = hash(expr, exprlen);
+
+    /* 
+     *   look for an existing entry, and in case we don't find one, note the
+     *   best entry to replace: an empty entry if there is one, otherwise
+     *   the least recently used entry that isn't in use 
+     */
+    entry *victim = 0;
+    for (int i = 0 ; i < RE_CACHE_SIZE ; ++i)
+    {
+        entry *e = &ents_[i];
+        if (e->pat == 0)
+        {
+            /* it's empty - it's the best candidate for replacement */
+            if (victim == 0 || victim->pat != 0)
+                victim = e;
+        }
+        else if (e->hash == h && e->len == exprlen
+                 && memcmp(e->expr, expr, exprlen) == 0)
+        {
+            /* got it - pin it, update its stamp, and return it */
+            ++hits_;
+            ++e->refs;
+            e->stamp = ++clock_;
+            return e->pat;
+        }
+        else if (e->refs == 0
+                 && (victim == 0
+                     || (victim->pat != 0 && e->stamp < victim->stamp)))
+        {
+            /* it's the least recently used entry so far */
+            victim = e;
+        }
+    }
+
+    /* it's not cached - compile it */
+    ++misses_;
+    re_compiled_pattern *pat;
+    if (parser_->compile_pattern(expr, exprlen, &pat) != RE_STATUS_SUCCESS)
+        return 0;
+
+    /* 
+     *   if every entry is in use, we can't cache it; simply return the new
+     *   pattern, and release() will free it 
+     */
+    if (victim == 0)
+        return pat;
+
+    /* discard the old contents of the entry */
+    if (victim->pat != 0)
+    {
+        CRegexParser::free_pattern(victim->pat);
+        t3free(victim->expr);
+    }
+
+    /* set up the entry with the new pattern, pinned for the caller */
+    victim->expr = (char *)t3malloc(exprlen != 0 ? exprlen : 1);
+    memcpy(victim->expr, expr, exprlen);
+    victim->len = exprlen;
+    victim->hash = h;
+    victim->pat = pat;
+    victim->refs = 1;
+    victim->stamp = ++clock_;
+
+    /* return the pattern */
+    return pat;
+}
+
+/*
+ *   release a pattern 
+ */
+void CRegexCache::release(re_compiled_pattern *pat)
+{
+    /* if it's in the cache, simply unpin it */
+    for (int i = 0 ; i < RE_CACHE_SIZE ; ++i)
+    {
+        if (ents_[i].pat == pat)
+        {
+            --ents_[i].refs;
+            return;
+        }
+    }
+
+    /* it's not one of ours, so it was compiled uncached - free it */
+    CRegexParser::free_pattern(pat);
+}
+
 /* ------------------------------------------------------------------------ */
 /*
  *   Register delta list.
@@ -2685,6 +3134,9 @@ CRegexSearcher::CRegexSearcher()
 {
     /* by default, use case-sensitive searches if not otherwise specified */
     default_case_sensitive_ = TRUE;
+
+    /* no step budget yet */
+    steps_left_ = -1;
 }
 
 /*
@@ -2695,47 +3147,194 @@ CRegexSearcher::~CRegexSearcher()
 }
 
 /*
- *   Match a string to a compiled expression.  Returns the length of the
- *   match if successful, or -1 if no match was found.  
+ *   Check the current character against a character range (RE_RANGE or
+ *   RE_RANGE_EXCL).  Returns true if the character is in the range.  Fills
+ *   in *matchlen with the number of bytes of input the state consumes:
+ *   this is normally just the one character, but a case-insensitive match
+ *   to a single character can match several characters of input under
+ *   full case folding.  
  */
-int CRegexSearcher::match(const char *entire_str, size_t entire_str_len,
-                          const char *str, const size_t origlen,
-                          const re_compiled_pattern_base *pattern,
-                          const re_tuple *tuple_arr,
-                          const re_machine *machine,
-                          re_group_register *regs,
-                          short *loop_vars)
+static int range_match(const re_tuple *tuple, const utf8_ptr &p,
+                       size_t curlen, int case_sensitive, size_t *matchlen)
 {
-    /* 
-     *   if the case sensitivity was specified, it overrides the current
-     *   search defaults; otherwise apply the search defaults 
-     */
-    int case_sensitive = (pattern->case_sensitivity_specified
-                          ? pattern->case_sensitive
-                          : default_case_sensitive_);
+    /* presume we'll consume just the current character */
+    *matchlen = p.charsize();
+
+    /* get this character */
+    wchar_t ch = p.getch();
+
+    /* search for the character in the range */
+    size_t i;
+    wchar_t *rp;
+    for (i = tuple->info.range.char_range_cnt,
+         rp = tuple->info.range.char_range ;
+         i != 0 ; i -= 2, rp += 2)
+    {
+        /* 
+         *   check for a class specifier; if it's not a class
+         *   specifier, treat it as a literal range, and check
+         *   case sensitivity 
+         */
+        if (rp[0] == '\0')
+        {
+            /*
+             *   The first character of the range pair is null,
+             *   which means that this isn't a literal range but
+             *   rather a class.  Check for a match to the
+             *   class.  
+             */
+            int match;
+            switch(rp[1])
+            {
+            case RE_ALPHA:
+                match = t3_is_alpha(ch);
+                break;
 
-    /* macro to perform a "local return" */
-    int _retval_;
-#define local_return(retval) \
-    _retval_ = (retval); \
-    goto do_local_return;
+            case RE_DIGIT:
+                match = t3_is_digit(ch);
+                break;
 
-    /* reset the stack */
-    stack_.reset();
+            case RE_UPPER:
+                match = t3_is_upper(ch);
+                break;
 
-    /* start at the machine's initial and final states */
-    re_state_id cur_state = machine->init;
-    re_state_id final_state = machine->final;
+            case RE_LOWER:
+                match = t3_is_lower(ch);
+                break;
 
-    /* 
-     *   if we're starting in the final state, this is a zero-length
-     *   pattern, which matches anything - immediately return success with a
-     *   zero-length match 
-     */
-    if (cur_state == final_state)
-        return 0;
+            case RE_ALPHANUM:
+                match = t3_is_alpha(ch) || t3_is_digit(ch);
+                break;
 
-    /* start at the beginning of the string */
+            case RE_SPACE:
+                match = t3_is_space(ch);
+                break;
+
+            case RE_VSPACE:
+                match = t3_is_vspace(ch);
+                break;
+
+            case RE_PUNCT:
+                match = t3_is_punct(ch);
+                break;
+
+            case RE_NEWLINE:
+                match = (ch == 0x000A
+                         || ch == 0x000D
+                         || ch == 0x000B
+                         || ch == 0x2028
+                         || ch == 0x2029);
+                break;
+                
+            case RE_NULLCHAR:
+                match = (ch == 0);
+                break;
+                
+            default:
+                /* this shouldn't happen */
+                match = FALSE;
+                break;
+            }
+            
+            /* 
+             *   if we matched, we can stop looking; otherwise,
+             *   simply keep going, since there might be another
+             *   entry that does match 
+             */
+            if (match)
+                break;
+        }
+        else if (case_sensitive)
+        {
+            /* 
+             *   the search is case-sensitive - compare the
+             *   character to the range without case conversion 
+             */
+            if (ch >= rp[0] && ch <= rp[1])
+                break;
+        }
+        else if (rp[0] == rp[1])
+        {
+            /* 
+             *   single character, case-insensitive - try
+             *   matching literally, and against the full case
+             *   folding of this one character 
+             */
+            size_t foldlen;
+            if (ch == rp[0])
+            {
+                /* exact match to the literal */
+                break;
+            }
+            if (t3_compare_case_fold(
+                &rp[0], 1, p.getptr(), curlen, &foldlen) == 0)
+            {
+                /* matched - we consume the whole folded match */
+                *matchlen = foldlen;
+
+                /* stop looking */
+                break;
+            }
+        }
+        else
+        {
+            /* 
+             *   code point range, case-sensitive - use simple
+             *   case folding for all three characters 
+             */
+            wchar_t fch = t3_simple_case_fold(ch);
+            if (fch >= t3_simple_case_fold(rp[0])
+                && fch <= t3_simple_case_fold(rp[1]))
+                break;
+        }
+    }
+
+    /* we matched if we stopped before exhausting the list */
+    return (i != 0);
+}
+
+/*
+ *   Match a string to a compiled expression.  Returns the length of the
+ *   match if successful, or -1 if no match was found.  If we run out of
+ *   steps in the step budget, returns RE_STEPS_EXHAUSTED, leaving the
+ *   group registers in an indeterminate state.  
+ */
+int CRegexSearcher::match(const char *entire_str, size_t entire_str_len,
+                          const char *str, const size_t origlen,
+                          const re_compiled_pattern_base *pattern,
+                          const re_tuple *tuple_arr,
+                          const re_machine *machine,
+                          re_group_register *regs,
+                          short *loop_vars)
+{
+    /* 
+     *   if the case sensitivity was specified, it overrides the current
+     *   search defaults; otherwise apply the search defaults 
+     */
+    int case_sensitive = case_sensitive_for(pattern);
+
+    /* macro to perform a "local return" */
+    int _retval_;
+#define local_return(retval) \
+    _retval_ = (retval); \
+    goto do_local_return;
+
+    /* reset the stack */
+    stack_.reset();
+
+    /* start at the machine's initial and final states */
+    re_state_id cur_state = machine->init;
+    re_state_id final_state = machine->final;
+
+    /* 
+     *   if we're starting in the final state, this is a zero-length
+     *   pattern, which matches anything - immediately return success with a
+     *   zero-length match 
+     */
+    if (cur_state == final_state)
+        return 0;
+
+    /* start at the beginning of the string */
     utf8_ptr p((char *)str);
     size_t curlen = origlen;
 
@@ -3050,144 +3649,11 @@ int CRegexSearcher::match(const char *entire_str, size_t entire_str_len,
                     local_return(-1);
                 }
 
-                /* get this character */
-                wchar_t ch = p.getch();
-
-                /* search for the character in the range */
-                size_t i;
-                wchar_t *rp;
-                for (i = tuple->info.range.char_range_cnt,
-                     rp = tuple->info.range.char_range ;
-                     i != 0 ; i -= 2, rp += 2)
-                {
-                    /* 
-                     *   check for a class specifier; if it's not a class
-                     *   specifier, treat it as a literal range, and check
-                     *   case sensitivity 
-                     */
-                    if (rp[0] == '\0')
-                    {
-                        /*
-                         *   The first character of the range pair is null,
-                         *   which means that this isn't a literal range but
-                         *   rather a class.  Check for a match to the
-                         *   class.  
-                         */
-                        int match;
-                        switch(rp[1])
-                        {
-                        case RE_ALPHA:
-                            match = t3_is_alpha(ch);
-                            break;
-
-                        case RE_DIGIT:
-                            match = t3_is_digit(ch);
-                            break;
-
-                        case RE_UPPER:
-                            match = t3_is_upper(ch);
-                            break;
-
-                        case RE_LOWER:
-                            match = t3_is_lower(ch);
-                            break;
-
-                        case RE_ALPHANUM:
-                            match = t3_is_alpha(ch) || t3_is_digit(ch);
-                            break;
-
-                        case RE_SPACE:
-                            match = t3_is_space(ch);
-                            break;
-
-                        case RE_VSPACE:
-                            match = t3_is_vspace(ch);
-                            break;
-
-                        case RE_PUNCT:
-                            match = t3_is_punct(ch);
-                            break;
-
-                        case RE_NEWLINE:
-                            match = (ch == 0x000A
-                                     || ch == 0x000D
-                                     || ch == 0x000B
-                                     || ch == 0x2028
-                                     || ch == 0x2029);
-                            break;
-                            
-                        case RE_NULLCHAR:
-                            match = (ch == 0);
-                            break;
-                            
-                        default:
-                            /* this shouldn't happen */
-                            match = FALSE;
-                            break;
-                        }
-                        
-                        /* 
-                         *   if we matched, we can stop looking; otherwise,
-                         *   simply keep going, since there might be another
-                         *   entry that does match 
-                         */
-                        if (match)
-                            break;
-                    }
-                    else if (case_sensitive)
-                    {
-                        /* 
-                         *   the search is case-sensitive - compare the
-                         *   character to the range without case conversion 
-                         */
-                        if (ch >= rp[0] && ch <= rp[1])
-                            break;
-                    }
-                    else if (rp[0] == rp[1])
-                    {
-                        /* 
-                         *   single character, case-insensitive - try
-                         *   matching literally, and against the full case
-                         *   folding of this one character 
-                         */
-                        size_t matchlen;
-                        if (ch == rp[0])
-                        {
-                            /* exact match to the literal */
-                            break;
-                        }
-                        if (t3_compare_case_fold(
-                            &rp[0], 1, p.getptr(), curlen, &matchlen) == 0)
-                        {
-                            /* 
-                             *   matched - skip the folded match, then back
-                             *   up one to make up for the common inc() we
-                             *   always do 
-                             */
-                            p.inc_bytes(matchlen);
-                            curlen -= matchlen;
-                            p.dec(&curlen);
+                /* check the character against the range */
+                size_t matchlen;
+                int match = range_match(tuple, p, curlen, case_sensitive,
+                                        &matchlen);
 
-                            /* stop looking */
-                            break;
-                        }
-                    }
-                    else
-                    {
-                        /* 
-                         *   code point range, case-sensitive - use simple
-                         *   case folding for all three characters 
-                         */
-                        wchar_t fch = t3_simple_case_fold(ch);
-                        if (fch >= t3_simple_case_fold(rp[0])
-                            && fch <= t3_simple_case_fold(rp[1]))
-                            break;
-                    }
-                }
-                
-                /* we matched if we stopped before exhausting the list */
-                int match = (i != 0);
-                
                 /* make sure we got what we wanted */
                 if ((tuple->typ == RE_RANGE && !match)
                     || (tuple->typ == RE_RANGE_EXCL && match))
@@ -3195,8 +3661,9 @@ int CRegexSearcher::match(const char *entire_str, size_t entire_str_len,
                     local_return(-1);
                 }
 
-                /* skip this character of the input */
-                p.inc(&curlen);
+                /* skip the matched input */
+                p.inc_bytes(matchlen);
+                curlen -= matchlen;
             }
             break;
             
@@ -3617,6 +4084,17 @@ int CRegexSearcher::match(const char *entire_str, size_t entire_str_len,
         /* we come here when we've already figured out the next state */
         ;
 
+        /* 
+         *   count the step against the budget, if we have one; if we've
+         *   used it up, let the caller hand over to the automaton engine 
+         */
+        if (steps_left_ >= 0)
+        {
+            if (steps_left_ == 0)
+                return RE_STEPS_EXHAUSTED;
+            --steps_left_;
+        }
+
         /* 
          *   If we're in the final state, it means we've matched the
          *   pattern.  Return success by indicating the length of the string
@@ -3909,6 +4387,781 @@ int CRegexSearcher::match(const char *entire_str, size_t entire_str_len,
     }
 }
 
+/*
+ *   Find the first place in [p, endp) where a match can start, according
+ *   to a first-byte filter; strend is the end of the string, for checking
+ *   a literal prefix.  Returns endp if there isn't one.  
+ */
+static const char *scan_first(const re_first_set *fs, const char *p,
+                              const char *endp, const char *strend)
+{
+    for (;;)
+    {
+        /* 
+         *   find the next byte in the set - if there's only one, let
+         *   memchr() do the work, otherwise check each byte against the map 
+         */
+        if (fs->cnt == 1)
+        {
+            p = (const char *)memchr(p, fs->single, endp - p);
+            if (p == 0)
+                return endp;
+        }
+        else
+        {
+            while (p < endp && !fs->test((unsigned char)*p))
+                ++p;
+            if (p == endp)
+                return endp;
+        }
+
+        /* if the prefix matches here too, this is a candidate */
+        if (fs->check(p, strend - p))
+            return p;
+
+        /* keep looking after this byte */
+        ++p;
+    }
+}
+
+/*
+ *   Find the last place in [begin, p] where a match can start, scanning
+ *   backwards; strend is the end of the string.  Returns null if there
+ *   isn't one.  The filter only ever holds ASCII bytes and UTF-8 lead
+ *   bytes, so we can step back a byte at a time without landing in the
+ *   middle of a character.  
+ */
+static const char *scan_first_back(const re_first_set *fs, const char *p,
+                                   const char *begin, const char *strend)
+{
+    /* a match needs at least one byte, so it can't start at the end */
+    if (p >= strend)
+    {
+        if (p == begin)
+            return 0;
+        --p;
+    }
+
+    for (;;)
+    {
+        /* find the previous byte in the set */
+        while (p != begin && !fs->test((unsigned char)*p))
+            --p;
+        if (!fs->test((unsigned char)*p))
+            return 0;
+
+        /* if the prefix matches here too, this is a candidate */
+        if (fs->check(p, strend - p))
+            return p;
+
+        /* keep looking before this byte */
+        if (p == begin)
+            return 0;
+        --p;
+    }
+}
+
+/*
+ *   Set the step budget for a match or search over 'len' bytes.  Patterns
+ *   that the automaton engine can't handle get an unlimited budget, since
+ *   there's nothing to hand them over to.  
+ */
+void CRegexSearcher::set_step_budget(const re_compiled_pattern_base *pattern,
+                                     size_t len)
+{
+    if (pattern->nfa_ok)
+    {
+        /* allow RE_STEP_FACTOR steps per character per state */
+        double b = (double)RE_STEP_FACTOR * (double)(len + 1)
+                   * (double)pattern->tuple_cnt;
+        steps_left_ = (b < 2147483647.0 ? (long)b : 2147483647L);
+    }
+    else
+        steps_left_ = -1;
+}
+
+/*
+ *   Match on the backtracker within the step budget, handing over to the
+ *   automaton engine if we run out of steps.  
+ */
+int CRegexSearcher::bounded_match(const char *entire_str, size_t entire_len,
+                                  const char *str, size_t origlen,
+                                  const re_compiled_pattern_base *pattern,
+                                  const re_tuple *tuple_arr,
+                                  const re_machine *machine,
+                                  re_group_register *regs, short *loop_vars)
+{
+    /* 
+     *   save the group registers, since the backtracker might leave them
+     *   half updated if it gives up 
+     */
+    re_group_register saved_regs[RE_GROUP_REG_CNT];
+    if (steps_left_ >= 0)
+        memcpy(saved_regs, regs, pattern->group_cnt * sizeof(regs[0]));
+
+    /* try it on the backtracker */
+    int m = match(entire_str, entire_len, str, origlen,
+                  pattern, tuple_arr, machine, regs, loop_vars);
+    if (m != RE_STEPS_EXHAUSTED)
+        return m;
+
+    /* it ran out of steps - try the automaton */
+    memcpy(regs, saved_regs, pattern->group_cnt * sizeof(regs[0]));
+    m = nfa_.match(entire_str, entire_len, str, origlen, pattern,
+                   tuple_arr, machine, regs, case_sensitive_for(pattern));
+    if (m != RE_NFA_FALLBACK)
+        return m;
+
+    /* 
+     *   the automaton can't handle this string after all, so go back to
+     *   the backtracker, without a budget this time 
+     */
+    steps_left_ = -1;
+    return match(entire_str, entire_len, str, origlen,
+                 pattern, tuple_arr, machine, regs, loop_vars);
+}
+
+/* ------------------------------------------------------------------------ */
+/*
+ *   Automaton matching engine 
+ */
+
+CRegexNFA::CRegexNFA()
+{
+    /* we don't have any scratch space yet */
+    memset(lists_, 0, sizeof(lists_));
+    pend_base_ = 0;
+    pend_max_ = 0;
+    pend_state_ = 0;
+    stk_ = 0;
+    keys_alloc_ = 0;
+    states_alloc_ = 0;
+    regs_alloc_ = 0;
+}
+
+CRegexNFA::~CRegexNFA()
+{
+    /* free our scratch space */
+    free_list(&lists_[0]);
+    free_list(&lists_[1]);
+    if (pend_state_ != 0)
+        t3free(pend_state_);
+    if (pend_base_ != 0)
+    {
+        t3free(pend_base_);
+        t3free(pend_max_);
+        t3free(stk_);
+    }
+}
+
+/*
+ *   allocate a thread list 
+ */
+void CRegexNFA::alloc_list(thread_list *l, int nkeys, int nregs)
+{
+    /* 
+     *   allocate the arrays; clear the sparse index so that we never read
+     *   uninitialized memory from it (the membership test doesn't care what
+     *   it contains, as long as it's an int) 
+     */
+    l->sparse = (int *)t3malloc(nkeys * sizeof(l->sparse[0]));
+    memset(l->sparse, 0, nkeys * sizeof(l->sparse[0]));
+    l->dense = (int *)t3malloc(nkeys * sizeof(l->dense[0]));
+    l->key = (int *)t3malloc(nkeys * sizeof(l->key[0]));
+    l->start = (int *)t3malloc(nkeys * sizeof(l->start[0]));
+    l->regs = (re_group_register *)t3malloc(
+        (nregs != 0 ? nkeys * nregs : 1) * sizeof(l->regs[0]));
+    l->cnt = 0;
+    l->nthr = 0;
+}
+
+/*
+ *   free a thread list 
+ */
+void CRegexNFA::free_list(thread_list *l)
+{
+    if (l->sparse != 0)
+    {
+        t3free(l->sparse);
+        t3free(l->dense);
+        t3free(l->key);
+        t3free(l->start);
+        t3free(l->regs);
+        l->sparse = 0;
+    }
+}
+
+/*
+ *   Make sure we have enough scratch space for a machine with the given
+ *   number of thread keys, states, and group registers.  
+ */
+void CRegexNFA::ensure_space(int nkeys, int nstates, int nregs)
+{
+    /* expand the per-state arrays if necessary */
+    if (nstates > states_alloc_)
+    {
+        /* free the old arrays */
+        if (pend_base_ != 0)
+        {
+            t3free(pend_base_);
+            t3free(pend_max_);
+            t3free(stk_);
+        }
+
+        /* 
+         *   allocate the new arrays, with some room to spare; the closure
+         *   stack needs at most three entries per state (a two-way branch
+         *   pushes two states, and a group transition pushes a state and a
+         *   register restore), plus the initial state 
+         */
+        states_alloc_ = nstates + 32;
+        pend_base_ = (int *)t3malloc(states_alloc_ * sizeof(pend_base_[0]));
+        pend_max_ = (int *)t3malloc(states_alloc_ * sizeof(pend_max_[0]));
+        stk_ = (closure_entry *)t3malloc(
+            (states_alloc_ * 3 + 1) * sizeof(stk_[0]));
+    }
+
+    /* expand the thread lists if necessary */
+    if (nkeys > keys_alloc_ || nregs > regs_alloc_)
+    {
+        /* free the old lists */
+        free_list(&lists_[0]);
+        free_list(&lists_[1]);
+        if (pend_state_ != 0)
+            t3free(pend_state_);
+
+        /* allocate the new lists */
+        if (nkeys > keys_alloc_)
+            keys_alloc_ = nkeys + 64;
+        if (nregs > regs_alloc_)
+            regs_alloc_ = nregs;
+        alloc_list(&lists_[0], keys_alloc_, regs_alloc_);
+        alloc_list(&lists_[1], keys_alloc_, regs_alloc_);
+        pend_state_ = (re_state_id *)t3malloc(
+            keys_alloc_ * sizeof(pend_state_[0]));
+    }
+}
+
+/*
+ *   Run the machine.  We start a thread at the start of 'str' and, unless
+ *   we're anchored, at each later character until we find a match.  Each
+ *   thread remembers where it started; a match that starts earlier beats
+ *   one that starts later, per <FirstBegin> rules, and among matches with
+ *   the same start, we keep the longest or shortest according to the
+ *   pattern's mode.  
+ */
+int CRegexNFA::run(const char *entire_str, size_t entire_len,
+                   const char *str, size_t len,
+                   const re_compiled_pattern_base *pattern,
+                   const re_tuple *tuple_arr, const re_machine *machine,
+                   re_group_register *regs, int case_sensitive, int anchored,
+                   int *result_len)
+{
+    /* 
+     *   if we're starting in the final state, this is a zero-length
+     *   pattern, which matches immediately 
+     */
+    if (machine->init == machine->final)
+    {
+        *result_len = 0;
+        return 0;
+    }
+
+    /* remember the machine */
+    tuples_ = tuple_arr;
+    final_ = machine->final;
+    entire_str_ = entire_str;
+    entire_len_ = entire_len;
+    nregs_ = pattern->group_cnt;
+    longest_ = pattern->longest_match;
+
+    /* 
+     *   Figure the pending thread slots.  A state that can consume up to N
+     *   characters needs N-1 slots, one for each number of characters left
+     *   to skip.  A case-insensitive character or string can match up to
+     *   three characters of input per pattern character under full case
+     *   folding. 
+     */
+    int nstates = pattern->tuple_cnt;
+    ensure_space(0, nstates, 0);
+    int nkeys = nstates;
+    re_state_id s;
+    for (s = 0 ; s < nstates ; ++s)
+    {
+        const re_tuple *t = &tuple_arr[s];
+        int maxc;
+        switch (t->typ)
+        {
+        case RE_LITSTR:
+        case RE_LITSTRA:
+            maxc = (int)wcslen(t->info.str.str) * (case_sensitive ? 1 : 3);
+            break;
+
+        case RE_LITERAL:
+        case RE_RANGE:
+            maxc = (case_sensitive ? 1 : 3);
+            break;
+
+        default:
+            maxc = 1;
+            break;
+        }
+        pend_max_[s] = maxc;
+        pend_base_[s] = nkeys;
+        nkeys += maxc - 1;
+    }
+
+    /* make sure we have room for the threads, and map the pending slots */
+    ensure_space(nkeys, nstates, nregs_);
+    for (s = 0 ; s < nstates ; ++s)
+    {
+        for (int i = 0 ; i < pend_max_[s] - 1 ; ++i)
+            pend_state_[pend_base_[s] + i - nstates] = s;
+    }
+
+    /* start with no threads and no match */
+    thread_list *clist = &lists_[0];
+    thread_list *nlist = &lists_[1];
+    clist->cnt = 0;
+    clist->nthr = 0;
+    best_start_ = -1;
+    best_end_ = -1;
+
+    /* get the first-byte filter, if we're searching */
+    const re_first_set *fs = &pattern->first_set[case_sensitive ? 1 : 0];
+    if (anchored || fs->cnt == 0)
+        fs = 0;
+
+    /* start at the beginning of the search region */
+    const char *p = str;
+    size_t rem = len;
+    int ofs = str - entire_str;
+    int seeding = TRUE;
+    for (;;)
+    {
+        /* 
+         *   if we don't have any threads going, skip ahead to the next
+         *   place where a match can start 
+         */
+        if (fs != 0 && seeding && clist->nthr == 0)
+        {
+            const char *q = scan_first(fs, p, p + rem, p + rem);
+            ofs += (int)(q - p);
+            rem -= q - p;
+            p = q;
+        }
+
+        /* 
+         *   Start a new thread here, if we're still looking for a starting
+         *   point.  Once we have a match, no later start can beat it.  This
+         *   goes at the end of the list, since a thread that started
+         *   earlier has priority.  
+         */
+        if (seeding && best_start_ < 0)
+        {
+            memcpy(work_regs_, regs, nregs_ * sizeof(regs[0]));
+            add_closure(clist, machine->init, ofs, ofs);
+        }
+        if (anchored || best_start_ >= 0)
+            seeding = FALSE;
+
+        /* stop if we're out of threads or out of input */
+        if (rem == 0 || (clist->nthr == 0 && !seeding))
+            break;
+
+        /* figure the next character position */
+        size_t csiz = utf8_ptr::s_charsize(*p);
+        if (csiz > rem)
+            csiz = rem;
+        int nofs = ofs + (int)csiz;
+
+        /* run each thread over this character, in priority order */
+        nlist->cnt = 0;
+        nlist->nthr = 0;
+        for (int i = 0 ; i < clist->nthr ; ++i)
+        {
+            /* 
+             *   skip threads that can't beat the match we already have: a
+             *   thread that started later can't win, and in shortest-match
+             *   mode, a thread from the same start can only find a longer
+             *   match 
+             */
+            int start = clist->start[i];
+            if (best_start_ >= 0
+                && (start > best_start_
+                    || (!longest_ && start == best_start_)))
+                continue;
+
+            int key = clist->key[i];
+            re_group_register *tregs = &clist->regs[i * nregs_];
+            if (key < nstates)
+            {
+                /* it's a machine state - try its transition */
+                const re_tuple *t = &tuple_arr[key];
+                int n = consume(t, p, rem, case_sensitive);
+                if (n < 0)
+                    continue;
+
+                if (n == (int)csiz)
+                {
+                    /* it consumed one character - on to the next state */
+                    memcpy(work_regs_, tregs, nregs_ * sizeof(tregs[0]));
+                    add_closure(nlist, t->next_state_1, nofs, start);
+                }
+                else
+                {
+                    /* 
+                     *   It consumed several characters, so it has to wait
+                     *   out the rest of them.  If the count is outside the
+                     *   range we planned for, leave it to the backtracker.
+                     */
+                    int chars = (int)utf8_ptr::s_len(p, n);
+                    if (chars < 2 || chars > pend_max_[key])
+                        return RE_NFA_FALLBACK;
+
+                    add_pending(nlist, pend_base_[key] + chars - 2,
+                                start, tregs);
+                }
+            }
+            else
+            {
+                /* 
+                 *   it's a pending thread - if this was the last character
+                 *   it was waiting for, it's now in its target state,
+                 *   otherwise it moves down to the next slot 
+                 */
+                re_state_id st = pend_state_[key - nstates];
+                if (key == pend_base_[st])
+                {
+                    memcpy(work_regs_, tregs, nregs_ * sizeof(tregs[0]));
+                    add_closure(nlist, tuple_arr[st].next_state_1,
+                                nofs, start);
+                }
+                else
+                    add_pending(nlist, key - 1, start, tregs);
+            }
+        }
+
+        /* move on to the next character */
+        thread_list *tmp = clist;
+        clist = nlist;
+        nlist = tmp;
+        p += csiz;
+        rem -= csiz;
+        ofs = nofs;
+    }
+
+    /* if we didn't find a match, say so */
+    if (best_start_ < 0)
+        return -1;
+
+    /* return the match and its group registers */
+    memcpy(regs, best_regs_, nregs_ * sizeof(regs[0]));
+    *result_len = best_end_ - best_start_;
+    return best_start_ - (int)(str - entire_str);
+}
+
+/*
+ *   Add a state to a thread list at the given string offset, along with
+ *   all of the states we can reach from it without consuming input.  We
+ *   visit the states depth-first, first branch first, which puts them in
+ *   the list in priority order.  The thread's group registers are in
+ *   work_regs_.  
+ */
+void CRegexNFA::add_closure(thread_list *l, re_state_id state,
+                            int ofs, int start)
+{
+    const char *p = entire_str_ + ofs;
+    const char *end = entire_str_ + entire_len_;
+
+    /* push the initial state */
+    int sp = 0;
+    stk_[sp].state = state;
+    stk_[sp].reg = -1;
+    ++sp;
+
+    /* visit states until we've exhausted the stack */
+    while (sp != 0)
+    {
+        closure_entry *e = &stk_[--sp];
+
+        /* if it's a register restore, put back the old value */
+        if (e->reg >= 0)
+        {
+            if ((e->reg & 1) == 0)
+                work_regs_[e->reg >> 1].start_ofs = e->val;
+            else
+                work_regs_[e->reg >> 1].end_ofs = e->val;
+            continue;
+        }
+
+        /* 
+         *   skip dead ends and states already in the list - a thread that
+         *   got there first has priority over this one 
+         */
+        re_state_id s = e->state;
+        if (s == RE_STATE_INVALID || l->has(s))
+            continue;
+
+        /* mark it as visited */
+        l->visit(s);
+
+        /* if it's the final state, we have a match */
+        if (s == final_)
+        {
+            add_match(start, ofs);
+            continue;
+        }
+
+        /* follow the transitions that don't consume input */
+        const re_tuple *t = &tuples_[s];
+        int ok;
+        switch (t->typ)
+        {
+        case RE_EPSILON:
+            /* push the second branch first, so that we visit it second */
+            if (t->next_state_2 != RE_STATE_INVALID)
+            {
+                stk_[sp].state = t->next_state_2;
+                stk_[sp].reg = -1;
+                ++sp;
+            }
+            ok = TRUE;
+            break;
+
+        case RE_GROUP_ENTER:
+        case RE_GROUP_EXIT:
+            /* 
+             *   set the register, if it's in range, and arrange to restore
+             *   the old value once we're done with the states that follow 
+             */
+            if ((int)t->info.ch < nregs_)
+            {
+                re_group_register *r = &work_regs_[t->info.ch];
+                stk_[sp].state = RE_STATE_INVALID;
+                if (t->typ == RE_GROUP_ENTER)
+                {
+                    stk_[sp].reg = (int)t->info.ch << 1;
+                    stk_[sp].val = r->start_ofs;
+                    r->start_ofs = ofs;
+                }
+                else
+                {
+                    stk_[sp].reg = ((int)t->info.ch << 1) | 1;
+                    stk_[sp].val = r->end_ofs;
+                    r->end_ofs = ofs;
+                }
+                ++sp;
+            }
+            ok = TRUE;
+            break;
+
+        case RE_TEXT_BEGIN:
+            ok = (p == entire_str_);
+            break;
+
+        case RE_TEXT_END:
+            ok = (p == end);
+            break;
+
+        case RE_WORD_BEGIN:
+            ok = ((p == entire_str_
+                   || !is_word_char(utf8_ptr::s_getch_before(p, 1)))
+                  && p != end && is_word_char(utf8_ptr::s_getch(p)));
+            break;
+
+        case RE_WORD_END:
+            ok = ((p == end || !is_word_char(utf8_ptr::s_getch(p)))
+                  && p != entire_str_
+                  && is_word_char(utf8_ptr::s_getch_before(p, 1)));
+            break;
+
+        case RE_WORD_BOUNDARY:
+        case RE_NON_WORD_BOUNDARY:
+            {
+                int prev_is_word = (p != entire_str_
+                                    && is_word_char(
+                                        utf8_ptr::s_getch_before(p, 1)));
+                int next_is_word = (p != end
+                                    && is_word_char(utf8_ptr::s_getch(p)));
+                int boundary = ((prev_is_word != 0) ^ (next_is_word != 0));
+                ok = ((t->typ == RE_WORD_BOUNDARY) == (boundary != 0));
+            }
+            break;
+
+        default:
+            /* 
+             *   it consumes input, so it's a live thread - add it with its
+             *   group registers, and go no further for now 
+             */
+            memcpy(&l->regs[l->add(s, start) * nregs_], work_regs_,
+                   nregs_ * sizeof(work_regs_[0]));
+            ok = FALSE;
+            break;
+        }
+
+        /* if the transition is open, visit the next state */
+        if (ok)
+        {
+            stk_[sp].state = t->next_state_1;
+            stk_[sp].reg = -1;
+            ++sp;
+        }
+    }
+}
+
+/*
+ *   Add a pending thread to a list 
+ */
+void CRegexNFA::add_pending(thread_list *l, int key, int start,
+                            const re_group_register *r)
+{
+    /* a thread that got here first has priority */
+    if (l->has(key))
+        return;
+
+    /* add it, with its registers */
+    l->visit(key);
+    memcpy(&l->regs[l->add(key, start) * nregs_], r, nregs_ * sizeof(r[0]));
+}
+
+/*
+ *   Note a match.  The first thread to reach the final state at a given
+ *   position is the highest priority one, so it's the one we want, and
+ *   positions only increase as we go.  So we keep this match if it starts
+ *   earlier than the best match so far, or if it has the same start and is
+ *   longer in longest-match mode.  (In shortest-match mode, we've already
+ *   found the shortest match for a start the first time we reach the final
+ *   state with that start.)  
+ */
+void CRegexNFA::add_match(int start, int ofs)
+{
+    if (best_start_ < 0
+        || start < best_start_
+        || (start == best_start_ && longest_ && ofs > best_end_))
+    {
+        best_start_ = start;
+        best_end_ = ofs;
+        memcpy(best_regs_, work_regs_, nregs_ * sizeof(work_regs_[0]));
+    }
+}
+
+/*
+ *   Check a character-consuming state against the input.  This follows
+ *   the corresponding cases in CRegexSearcher::match().  
+ */
+int CRegexNFA::consume(const re_tuple *tuple, const char *p, size_t rem,
+                       int case_sensitive)
+{
+    /* every consuming state needs at least one character */
+    if (rem == 0)
+        return -1;
+
+    /* get the current character and its size */
+    wchar_t ch = utf8_ptr::s_getch(p);
+    int csiz = (int)utf8_ptr::s_charsize(*p);
+
+    size_t matchlen;
+    switch (tuple->typ)
+    {
+    case RE_LITERAL:
+        /* try an exact match, then a case-folded match if appropriate */
+        if (tuple->info.ch == ch)
+            return csiz;
+        if (!case_sensitive
+            && t3_compare_case_fold(&tuple->info.ch, 1, p, rem,
+                                    &matchlen) == 0)
+            return (int)matchlen;
+        return -1;
+
+    case RE_LITSTR:
+    case RE_LITSTRA:
+        if (case_sensitive)
+        {
+            /* match character by character */
+            utf8_ptr p2((char *)p);
+            size_t rem2 = rem;
+            const wchar_t *cp = tuple->info.str.str;
+            for ( ; *cp != 0 && rem2 != 0 ; ++cp, p2.inc(&rem2))
+            {
+                if (p2.getch() != *cp)
+                    return -1;
+            }
+            return (*cp == 0 ? (int)(rem - rem2) : -1);
+        }
+        else
+        {
+            /* match with case folding */
+            if (t3_compare_case_fold(
+                tuple->info.str.str, wcslen(tuple->info.str.str),
+                p, rem, &matchlen) != 0)
+                return -1;
+            return (int)matchlen;
+        }
+
+    case RE_WILDCARD:
+        return csiz;
+
+    case RE_RANGE:
+    case RE_RANGE_EXCL:
+        {
+            utf8_ptr p2((char *)p);
+            int match = range_match(tuple, p2, rem, case_sensitive,
+                                    &matchlen);
+            if ((tuple->typ == RE_RANGE) != (match != 0))
+                return -1;
+            return (int)matchlen;
+        }
+
+    case RE_WORD_CHAR:
+        return (is_word_char(ch) ? csiz : -1);
+
+    case RE_NON_WORD_CHAR:
+        return (!is_word_char(ch) ? csiz : -1);
+
+    case RE_ALPHA:
+        return (t3_is_alpha(ch) ? csiz : -1);
+
+    case RE_DIGIT:
+        return (t3_is_digit(ch) ? csiz : -1);
+
+    case RE_NON_DIGIT:
+        return (!t3_is_digit(ch) ? csiz : -1);
+
+    case RE_UPPER:
+        return (t3_is_upper(ch) ? csiz : -1);
+
+    case RE_LOWER:
+        return (t3_is_lower(ch) ? csiz : -1);
+
+    case RE_ALPHANUM:
+        return (t3_is_alpha(ch) || t3_is_digit(ch) ? csiz : -1);
+
+    case RE_SPACE:
+        return (t3_is_space(ch) ? csiz : -1);
+
+    case RE_NON_SPACE:
+        return (!t3_is_space(ch) ? csiz : -1);
+
+    case RE_VSPACE:
+        return (t3_is_vspace(ch) ? csiz : -1);
+
+    case RE_NON_VSPACE:
+        return (!t3_is_vspace(ch) ? csiz : -1);
+
+    case RE_PUNCT:
+        return (t3_is_punct(ch) ? csiz : -1);
+
+    case RE_NEWLINE:
+        return (ch == 0x000A || ch == 0x000D || ch == 0x000B
+                || ch == 0x2028 || ch == 0x2029 ? csiz : -1);
+
+    default:
+        /* anything else doesn't consume input */
+        return -1;
+    }
+}
+
 /* ------------------------------------------------------------------------ */
 /*
  *   Search for a regular expression within a string.  Returns -1 if the
@@ -3934,7 +5187,13 @@ int CRegexSearcher::search(const char *entirestr, const char *str, size_t len,
 
     /* figure the length of the overall string */
     size_t entirelen = len + (str - entirestr);
-    
+
+    /* set the step budget for the whole search */
+    set_step_budget(pattern, len);
+
+    /* get the first-byte filter */
+    const re_first_set *fs = first_set_for(pattern);
+
     /*
      *   Starting at the first character in the string, search for the
      *   pattern at each subsequent character until we either find the
@@ -3943,9 +5202,57 @@ int CRegexSearcher::search(const char *entirestr, const char *str, size_t len,
     utf8_ptr p;
     for (p.set((char *)str) ; ; )
     {
+        /* 
+         *   skip ahead to the next place where a match can start; if there
+         *   isn't one, there's nothing more to find 
+         */
+        if (fs != 0)
+        {
+            const char *q = scan_first(fs, p.getptr(), max_start_pos,
+                                       p.getptr() + len);
+            if (q == max_start_pos)
+                break;
+            len -= q - p.getptr();
+            p.set((char *)q);
+        }
+
+        /* 
+         *   save the group registers, in case the backtracker runs out of
+         *   steps and leaves them half updated 
+         */
+        re_group_register saved_regs[RE_GROUP_REG_CNT];
+        if (steps_left_ >= 0)
+            memcpy(saved_regs, regs, pattern->group_cnt * sizeof(regs[0]));
+
         /* check for a match */
         int matchlen = match(entirestr, entirelen, p.getptr(), len,
                              pattern, tuple_arr, machine, regs, loop_vars);
+
+        /* 
+         *   If the backtracker ran out of steps, hand over to the automaton
+         *   engine.  In first-begin mode, the automaton can try all of the
+         *   remaining starting positions in a single pass, so it can
+         *   finish the whole search; otherwise we match one position at a
+         *   time as usual.  
+         */
+        if (matchlen == RE_STEPS_EXHAUSTED)
+        {
+            memcpy(regs, saved_regs, pattern->group_cnt * sizeof(regs[0]));
+            if (pattern->first_begin)
+            {
+                int m = nfa_.search(entirestr, entirelen, p.getptr(), len,
+                                    pattern, tuple_arr, machine, regs,
+                                    case_sensitive_for(pattern),
+                                    result_len);
+                if (m != RE_NFA_FALLBACK)
+                    return (m >= 0 ? (int)(p.getptr() - str) + m : -1);
+            }
+
+            matchlen = bounded_match(entirestr, entirelen, p.getptr(), len,
+                                     pattern, tuple_arr, machine, regs,
+                                     loop_vars);
+        }
+
         if (matchlen >= 0)
         {
             /* check our first-begin/first-end mode */
@@ -4117,6 +5424,12 @@ int CRegexSearcher::search_back(
      */
     len = 0;
 
+    /* set the step budget for the whole search */
+    set_step_budget(pattern, str - entirestr);
+
+    /* get the first-byte filter */
+    const re_first_set *fs = first_set_for(pattern);
+
     /*
      *   Starting at the current position, search for the pattern at each
      *   earlier character until we either find the pattern or run out of
@@ -4125,9 +5438,24 @@ int CRegexSearcher::search_back(
     utf8_ptr p;
     for (p.set((char *)str) ; ; p.dec(&len))
     {
+        /* 
+         *   back up to the nearest place where a match can start; a match
+         *   needs at least one character, so one can't start at 'str' 
+         */
+        if (fs != 0)
+        {
+            const char *q = scan_first_back(fs, p.getptr(), entirestr,
+                                            p.getptr() + len);
+            if (q == 0)
+                break;
+            len += p.getptr() - q;
+            p.set((char *)q);
+        }
+
         /* check for a match */
-        int matchlen = match(entirestr, entirelen, p.getptr(), len,
-                             pattern, tuple_arr, machine, regs, loop_vars);
+        int matchlen = bounded_match(entirestr, entirelen, p.getptr(), len,
+                                     pattern, tuple_arr, machine, regs,
+                                     loop_vars);
         if (matchlen >= 0)
         {
             /* check our first-begin/first-end mode */
@@ -4279,10 +5607,11 @@ int CRegexSearcher::match_pattern(
     short loop_vars[RE_LOOP_VARS_MAX];
 
     /* match the string */
-    return match(entirestr, searchlen + (searchstr - entirestr),
-                 searchstr, searchlen,
-                 pattern, pattern->tuples, &pattern->machine,
-                 regs, loop_vars);
+    set_step_budget(pattern, searchlen);
+    return bounded_match(entirestr, searchlen + (searchstr - entirestr),
+                         searchstr, searchlen,
+                         pattern, pattern->tuples, &pattern->machine,
+                         regs, loop_vars);
 }
 
 /* ------------------------------------------------------------------------ */
@@ -4318,9 +5647,10 @@ int CRegexSearcherSimple::compile_and_match(
     group_cnt_ = pat.group_cnt;
 
     /* match the string */
-    int m = match(entirestr, searchlen + (searchstr - entirestr),
-                  searchstr, searchlen,
-                  &pat, parser_->tuple_arr_, &pat.machine, regs_, loop_vars);
+    set_step_budget(&pat, searchlen);
+    int m = bounded_match(entirestr, searchlen + (searchstr - entirestr),
+                          searchstr, searchlen, &pat, parser_->tuple_arr_,
+                          &pat.machine, regs_, loop_vars);
 
     /* save the match information on success */
     if (m >= 0)
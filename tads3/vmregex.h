@@ -322,6 +322,64 @@ struct re_machine
 };
 
 
+/* ------------------------------------------------------------------------ */
+/*
+ *   First-byte filter.  This is the set of UTF-8 bytes that can begin a
+ *   match to a pattern, which lets a search skip quickly over the parts of
+ *   the string where no match can start.  The set can be a superset (it's
+ *   only a filter - the matcher makes the final decision), but must never
+ *   leave out a byte that can start a match.  
+ */
+struct re_first_set
+{
+    /* bit map of the bytes in the set: byte b is bit (b & 7) of map[b >> 3] */
+    unsigned char map[32];
+
+    /* 
+     *   number of bytes in the set, or zero if there's no filter (because
+     *   the pattern can match an empty string, or a match can start with
+     *   any character) 
+     */
+    int cnt;
+
+    /* the byte in the set, if there's only one */
+    unsigned char single;
+
+    /* 
+     *   Literal prefix: if every match has to start with the same literal
+     *   text (case-sensitively), this is its UTF-8 encoding, or as much of
+     *   it as fits.  prefix_len is zero if there's no prefix.  
+     */
+    char prefix[16];
+    size_t prefix_len;
+
+    /* is a byte in the set? */
+    int test(unsigned char b) const { return (map[b >> 3] >> (b & 7)) & 1; }
+
+    /* 
+     *   can a match start at p, with 'avail' bytes of string from there to
+     *   the end? 
+     */
+    int check(const char *p, size_t avail) const
+    {
+        return (avail != 0 && test((unsigned char)*p)
+                && (prefix_len <= 1
+                    || (avail >= prefix_len
+                        && memcmp(p, prefix, prefix_len) == 0)));
+    }
+
+    /* add a byte to the set */
+    void add(unsigned char b)
+    {
+        if (!test(b))
+        {
+            map[b >> 3] |= (unsigned char)(1 << (b & 7));
+            single = b;
+            ++cnt;
+        }
+    }
+};
+
 /* ------------------------------------------------------------------------ */
 /*
  *   Compiled pattern description.  This is not a complete compiled pattern,
@@ -366,6 +424,19 @@ struct re_compiled_pattern_base
      *   ambiguity; otherwise, we match the string that ends first 
      */
     unsigned int first_begin : 1;
+
+    /*
+     *   Can the pattern run on the automaton engine (CRegexNFA)?  This is
+     *   set for patterns that don't use back-references, assertions,
+     *   counted intervals, or (in <Max> mode) shortest-match closures.  
+     */
+    unsigned int nfa_ok : 1;
+
+    /* 
+     *   first-byte filters for searching, for case-insensitive ([0]) and
+     *   case-sensitive ([1]) matching 
+     */
+    re_first_set first_set[2];
 };
 
 /*
@@ -534,6 +605,13 @@ protected:
     /* consolidate runs of characters into strings */
     void consolidate_strings(re_machine *machine);
 
+    /* determine if a compiled pattern can run on the automaton engine */
+    int is_nfa_compatible(const re_compiled_pattern_base *pat) const;
+
+    /* build the first-byte filter for a compiled pattern */
+    void build_first_set(const re_compiled_pattern_base *pat,
+                         int case_sensitive, re_first_set *fs) const;
+
     /* next available state ID */
     re_state_id next_state_;
 
@@ -1041,6 +1119,317 @@ protected:
     size_t used_;
 };
 
+/* ------------------------------------------------------------------------ */
+/*
+ *   Compiled pattern cache.  Programs that pass regular expressions to the
+ *   search functions as strings would otherwise have to recompile each
+ *   pattern on every call, which is wasteful when a program alternates
+ *   among a handful of patterns.  This cache keeps the most recently used
+ *   compiled patterns, keyed on the pattern text, and discards the least
+ *   recently used pattern when it fills up.
+ *   
+ *   The key is the pattern text alone.  The compiled form doesn't depend on
+ *   anything else: case sensitivity and the other search options are
+ *   applied by the searcher, and options written into the pattern itself
+ *   (such as <nocase>) are part of the text.
+ *   
+ *   get() pins the pattern it returns, and the caller must unpin it with
+ *   release() when done.  We never evict a pinned pattern, since a caller
+ *   can hold a pattern across calls that use the cache again (a
+ *   replacement callback can do its own searches in the middle of a
+ *   replace operation, for example).  
+ */
+
+/* number of patterns we keep */
+const int RE_CACHE_SIZE = 32;
+
+class CRegexCache
+{
+public:
+    CRegexCache(class CRegexParser *parser);
+    ~CRegexCache();
+
+    /* 
+     *   Get the compiled pattern for an expression, compiling it if it's
+     *   not already in the cache.  Returns null if the expression doesn't
+     *   compile.  A non-null result must be released with release().  
+     */
+    re_compiled_pattern *get(const char *expr, size_t exprlen);
+
+    /* release a pattern obtained from get() */
+    void release(re_compiled_pattern *pat);
+
+    /* get the lookup statistics */
+    unsigned long get_hits() const { return hits_; }
+    unsigned long get_misses() const { return misses_; }
+
+protected:
+    /* cache entry */
+    struct entry
+    {
+        /* our copy of the pattern text, and its hash value */
+        char *expr;
+        size_t len;
+        unsigned int hash;
+
+        /* the compiled pattern; null if the entry is unused */
+        re_compiled_pattern *pat;
+
+        /* number of callers currently using the pattern */
+        int refs;
+
+        /* last use stamp, for choosing the least recently used entry */
+        unsigned long stamp;
+    };
+
+    /* hash a pattern string */
+    static unsigned int hash(const char *expr, size_t len);
+
+    /* the parser we use to compile patterns */
+    class CRegexParser *parser_;
+
+    /* the entries */
+    entry ents_[RE_CACHE_SIZE];
+
+    /* use counter, for the entry stamps */
+    unsigned long clock_;
+
+    /* lookup statistics */
+    unsigned long hits_;
+    unsigned long misses_;
+};
+
+/* ------------------------------------------------------------------------ */
+/*
+ *   Automaton matching engine.  The regular matcher in CRegexSearcher is a
+ *   backtracking matcher that tries every branch of the pattern, so its
+ *   running time can grow exponentially with the length of the subject
+ *   string for patterns with nested closures, such as "(a|aa)*b".  This
+ *   engine instead runs the state machine as a Thompson NFA: it advances
+ *   the set of all live states one character at a time, so its running
+ *   time is proportional to the length of the string times the number of
+ *   states.  CRegexSearcher starts each match on the backtracker, which is
+ *   faster for ordinary patterns, and hands it over to this engine if the
+ *   backtracker exceeds its step budget (see RE_STEP_FACTOR).
+ *   
+ *   We give the same results as the backtracking matcher, including the
+ *   group registers.  The backtracking matcher picks the longest (or in
+ *   <Min> mode, the shortest) match, and breaks ties in favor of the first
+ *   branch at each branch point, so the winning path is the first path in
+ *   branch order among those with the best length.  We run the live states
+ *   ("threads") in branch priority order, and when two threads arrive at
+ *   the same state at the same point in the string, we keep only the
+ *   higher priority one, since the rest of the match can't tell them
+ *   apart.
+ *   
+ *   That last point is what limits the engine to patterns without
+ *   back-references, assertions, and counted intervals (where the rest of
+ *   the match does depend on how we got to a state), and to patterns where
+ *   all branch choices go the same way (so not <Max> patterns with
+ *   shortest-match closures such as "*?").  The parser flags the patterns
+ *   we can handle in re_compiled_pattern_base::nfa_ok.
+ *   
+ *   A transition that consumes several characters (a literal string, or a
+ *   case-folded character that matches several characters) is carried
+ *   forward as a "pending" thread that waits out the extra characters.  
+ */
+
+/* return code: the engine can't handle this match; use the backtracker */
+#define RE_NFA_FALLBACK  (-2)
+
+/* 
+ *   return code from CRegexSearcher::match(): the backtracker ran out of
+ *   steps, so the match should be handed over to the automaton engine 
+ */
+#define RE_STEPS_EXHAUSTED  (-3)
+
+/* 
+ *   Backtracker step budget, per character of subject string per state of
+ *   the pattern.  For most patterns, the backtracker is faster than the
+ *   automaton engine, since it only visits the states along one path at a
+ *   time, so we start patterns that can use either engine on the
+ *   backtracker.  If it takes more than this many steps, though, it's
+ *   probably headed down an exponential path, so we give the match to the
+ *   automaton engine instead.  This bounds the total running time to a
+ *   multiple of the string length times the pattern size.  
+ */
+#define RE_STEP_FACTOR  4
+
+class CRegexNFA
+{
+public:
+    CRegexNFA();
+    ~CRegexNFA();
+
+    /*
+     *   Match a pattern at the start of 'str'.  Returns the byte length of
+     *   the match, -1 if there's no match, or RE_NFA_FALLBACK.  On success,
+     *   the pattern's group registers are set in 'regs'.  
+     */
+    int match(const char *entire_str, size_t entire_len,
+              const char *str, size_t len,
+              const re_compiled_pattern_base *pattern,
+              const re_tuple *tuple_arr, const re_machine *machine,
+              re_group_register *regs, int case_sensitive)
+    {
+        int match_len;
+        int ofs = run(entire_str, entire_len, str, len, pattern, tuple_arr,
+                      machine, regs, case_sensitive, TRUE, &match_len);
+        return (ofs >= 0 ? match_len : ofs);
+    }
+
+    /*
+     *   Search for the match that begins earliest in 'str', for patterns in
+     *   <FirstBegin> mode.  Returns the byte offset of the match from 'str'
+     *   and fills in *result_len, or returns -1 if there's no match, or
+     *   RE_NFA_FALLBACK.  
+     */
+    int search(const char *entire_str, size_t entire_len,
+               const char *str, size_t len,
+               const re_compiled_pattern_base *pattern,
+               const re_tuple *tuple_arr, const re_machine *machine,
+               re_group_register *regs, int case_sensitive,
+               int *result_len)
+    {
+        return run(entire_str, entire_len, str, len, pattern, tuple_arr,
+                   machine, regs, case_sensitive, FALSE, result_len);
+    }
+
+    /* 
+     *   check a character-consuming state against the string; returns the
+     *   number of bytes matched, or -1 if it doesn't match 
+     */
+    static int consume(const re_tuple *tuple, const char *p, size_t rem,
+                       int case_sensitive);
+
+protected:
+    /* 
+     *   Thread list.  This is a sparse set keyed by thread key: the keys
+     *   from 0 to tuple_cnt-1 are the machine states, and the keys above
+     *   that are the pending thread slots.  The list order is the thread
+     *   priority order.  
+     */
+    struct thread_list
+    {
+        /* index in dense[] of each key */
+        int *sparse;
+
+        /* keys we've visited at this position, in the order visited */
+        int *dense;
+
+        /* number of keys visited */
+        int cnt;
+
+        /* 
+         *   the live threads - the visited keys that are waiting to
+         *   consume input, in priority order - with the starting offset of
+         *   each thread's match and its group registers (nregs per thread) 
+         */
+        int *key;
+        int *start;
+        re_group_register *regs;
+
+        /* number of live threads */
+        int nthr;
+
+        /* have we visited the given key? */
+        int has(int k) const
+        {
+            int i = sparse[k];
+            return i < cnt && dense[i] == k;
+        }
+
+        /* mark a key as visited */
+        void visit(int k)
+        {
+            sparse[k] = cnt;
+            dense[cnt++] = k;
+        }
+
+        /* add a live thread, returning its index */
+        int add(int k, int start_ofs)
+        {
+            int i = nthr++;
+            key[i] = k;
+            start[i] = start_ofs;
+            return i;
+        }
+    };
+
+    /* closure stack entry - a state to visit, or a register to restore */
+    struct closure_entry
+    {
+        re_state_id state;
+        int reg;
+        int val;
+    };
+
+    /* run the machine; returns the match offset from 'str' */
+    int run(const char *entire_str, size_t entire_len,
+            const char *str, size_t len,
+            const re_compiled_pattern_base *pattern,
+            const re_tuple *tuple_arr, const re_machine *machine,
+            re_group_register *regs, int case_sensitive, int anchored,
+            int *result_len);
+
+    /* make sure our scratch space is big enough for a machine */
+    void ensure_space(int nkeys, int nstates, int nregs);
+    void alloc_list(thread_list *l, int nkeys, int nregs);
+    void free_list(thread_list *l);
+
+    /* add a state and everything reachable from it without consuming */
+    void add_closure(thread_list *l, re_state_id state, int ofs, int start);
+
+    /* add a pending thread */
+    void add_pending(thread_list *l, int key, int start,
+                     const re_group_register *r);
+
+    /* note a thread that reached the final state */
+    void add_match(int start, int ofs);
+
+    /* is a character part of a word? (as in CRegexSearcher) */
+    static int is_word_char(wchar_t c)
+        { return (t3_is_alpha(c) || t3_is_digit(c)); }
+
+    /* the current and next thread lists */
+    thread_list lists_[2];
+
+    /* 
+     *   per-state pending slot information: pend_base_[s] is the key of
+     *   the first pending slot for state s, and pend_max_[s] is the
+     *   maximum number of characters state s can consume 
+     */
+    int *pend_base_;
+    int *pend_max_;
+
+    /* the state for each pending slot (indexed from key tuple_cnt) */
+    re_state_id *pend_state_;
+
+    /* closure stack */
+    closure_entry *stk_;
+
+    /* group registers for the thread under construction */
+    re_group_register work_regs_[RE_GROUP_REG_CNT];
+
+    /* best match so far, and its group registers */
+    int best_start_;
+    int best_end_;
+    re_group_register best_regs_[RE_GROUP_REG_CNT];
+
+    /* allocated sizes */
+    int keys_alloc_;
+    int states_alloc_;
+    int regs_alloc_;
+
+    /* the machine we're running */
+    const re_tuple *tuples_;
+    re_state_id final_;
+    const char *entire_str_;
+    size_t entire_len_;
+    int nregs_;
+    int longest_;
+};
+
 /* ------------------------------------------------------------------------ */
 /*
  *   Regular Expression Searcher/Matcher.  This object encapsulates the
@@ -1120,6 +1509,39 @@ protected:
               const struct re_machine *machine,
               re_group_register *regs, short *loop_vars);
 
+    /* 
+     *   match a string to a compiled expression on the backtracker, within
+     *   the current step budget, handing it over to the automaton engine
+     *   if the backtracker runs out of steps 
+     */
+    int bounded_match(const char *entire_str, size_t entire_len,
+                      const char *str, size_t origlen,
+                      const re_compiled_pattern_base *pattern,
+                      const re_tuple *tuple_arr,
+                      const struct re_machine *machine,
+                      re_group_register *regs, short *loop_vars);
+
+    /* set the step budget for a match or search over 'len' bytes */
+    void set_step_budget(const re_compiled_pattern_base *pattern,
+                         size_t len);
+
+    /* get the first-byte filter for a pattern, or null if there isn't one */
+    const re_first_set *first_set_for(
+        const re_compiled_pattern_base *pattern) const
+    {
+        const re_first_set *fs =
+            &pattern->first_set[case_sensitive_for(pattern) ? 1 : 0];
+        return (fs->cnt != 0 ? fs : 0);
+    }
+
+    /* get the case sensitivity to use for a pattern */
+    int case_sensitive_for(const re_compiled_pattern_base *pattern) const
+    {
+        return (pattern->case_sensitivity_specified
+                ? pattern->case_sensitive
+                : default_case_sensitive_);
+    }
+
     /* search for a regular expression within a string */
     int search(const char *entire_str,
                const char *str, size_t len,
@@ -1158,6 +1580,16 @@ protected:
     /* match state stack */
     CRegexStack stack_;
 
+    /* automaton engine, for patterns that don't need backtracking */
+    CRegexNFA nfa_;
+
+    /* 
+     *   number of steps the backtracker can take before it hands the
+     *   current match or search over to the automaton engine, or -1 if
+     *   there's no limit 
+     */
+    long steps_left_;
+
     /* default case sensitivity, for patterns that don't specify it */
     unsigned int default_case_sensitive_ : 1;
 };
@@ -21,6 +21,10 @@ Modified
 */
 
 #include <stdio.h>
+#include <stdlib.h>
+#ifdef VM_OPSTATS
+#include <chrono>
+#endif
 
 #include "t3std.h"
 #include "os.h"
@@ -46,6 +50,8 @@ Modified
 #include "vmfref.h"
 #include "vmop.h"
 #include "vmbignum.h"
+#include "vmrunsym.h"
+#include "vmmcreg.h"
 
 
 /* ------------------------------------------------------------------------ */
@@ -106,6 +112,18 @@ void CVmRun::init()
     /* we have no program counter yet */
     pc_ptr_ = 0;
 
+    /* we're not running the sampling profiler */
+    sample_table_ = 0;
+    sample_file_ = 0;
+
+#ifdef VM_OPSTATS
+    /* allocate and clear the opcode statistics */
+    opstat_ops_ = (vm_opstat_rec *)t3malloc(256 * sizeof(opstat_ops_[0]));
+    opstat_meta_ = (vm_opstat_rec *)t3malloc(
+        256 * VM_OPSTAT_MAX_META * sizeof(opstat_meta_[0]));
+    reset_opstats();
+#endif
+
     /*
      *   If we're including the profiler in the build, allocate and
      *   initialize its memory structures. 
@@ -143,6 +161,33 @@ CVmRun::~CVmRun()
 
 void CVmRun::terminate()
 {
+    /* 
+     *   if the sampling profiler is still running, stop it (without writing
+     *   its results, since the image is gone by now) 
+     */
+    if (sample_table_ != 0)
+    {
+        os_prof_stop_timer();
+        delete sample_table_;
+        sample_table_ = 0;
+    }
+    if (sample_file_ != 0)
+    {
+        lib_free_str(sample_file_);
+        sample_file_ = 0;
+    }
+
+#ifdef VM_OPSTATS
+    /* delete the opcode statistics */
+    if (opstat_ops_ != 0)
+    {
+        t3free(opstat_ops_);
+        t3free(opstat_meta_);
+        opstat_ops_ = 0;
+        opstat_meta_ = 0;
+    }
+#endif
+
     /*
      *   If we're including the profiler in the build, delete its memory
      *   structures.  
@@ -751,6 +796,9 @@ public:
      */
     const uchar *get_prop(VMG0_)
     {
+        /* note the target's metaclass in the opcode statistics */
+        VM_IF_OPSTATS(G_interpreter->opstat_note_target(vmg_ &self));
+
         /* find the property without evaluating it */
         if (get_prop_no_eval(vmg0_))
             return eval_prop_val(vmg0_);
@@ -816,10 +864,15 @@ public:
         switch(self.typ)
         {
         case VM_OBJ:
-            /* get the property value from the target object */
+            /* 
+             *   get the property value from the target object, identifying
+             *   the calling instruction so that the object can use its
+             *   lookup cache 
+             */
             return vm_objp(vmg_ self.val.obj)
-                ->get_prop(vmg_ target_prop, &val, self.val.obj,
-                           &defining_obj, &argc);
+                ->get_prop_at_site(
+                    vmg_ target_prop, &val, self.val.obj, &defining_obj,
+                    &argc, G_interpreter->get_entry_ptr() + caller_ofs);
 
         case VM_LIST:
             f_const_get_prop = &CVmObjList::const_get_prop;
@@ -1134,6 +1187,96 @@ static inline void int_neg(VMG_ vm_val_t *aval)
 #endif
 
 
+/* ------------------------------------------------------------------------ */
+/*
+ *   Instruction dispatch.
+ *   
+ *   By default, we decode each instruction with a 'switch' on the opcode
+ *   byte, and each handler goes back to the top of the loop to fetch the
+ *   next instruction.  This is portable, but it funnels every instruction
+ *   through a single indirect jump, which the CPU's branch predictor can't
+ *   do much with, and some compilers add a range check on the switch value
+ *   as well.
+ *   
+ *   If the build defines VMRUN_COMPUTED_GOTO, and the compiler supports the
+ *   GNU "labels as values" extension, we use threaded dispatch instead: we
+ *   build a 256-entry table of handler label addresses, and each handler
+ *   ends by jumping directly through the table to the handler for the next
+ *   instruction.  This gives each handler its own indirect jump, which lets
+ *   the branch predictor learn common opcode sequences.  The handlers
+ *   themselves are the same code in both modes - VMRUN_CASE() attaches a
+ *   label to each case, and VMRUN_NEXT takes the place of 'continue'.
+ *   
+ *   The debugger needs to get control before each instruction, so the
+ *   debugger build always uses the switch.  
+ */
+#if defined(VMRUN_COMPUTED_GOTO) && !defined(VM_DEBUGGER) \
+    && (defined(__GNUC__) || defined(__clang__))
+# define VMRUN_THREADED
+#endif
+
+#ifdef VM_OPSTATS
+# define VMRUN_OPSTAT(op) opstat_next(op)
+#else
+# define VMRUN_OPSTAT(op)
+#endif
+
+#ifdef VMRUN_THREADED
+# define VMRUN_CASE(op) case op: vmrun_lbl_##op
+# define VMRUN_NEXT \
+    do { last_pc = p; VMRUN_OPSTAT(*p); goto *dispatch[*p++]; } while (0)
+#else
+# define VMRUN_CASE(op) case op
+# define VMRUN_NEXT continue
+#endif
+
+
+/* ------------------------------------------------------------------------ */
+/*
+ *   Opcode statistics.  The main loop calls opstat_next() just before it
+ *   dispatches each instruction, so the time between two calls is the time
+ *   spent in the earlier instruction, including any native code it invokes
+ *   (but not byte code it calls, which is timed instruction by instruction
+ *   in its own right).  
+ */
+#ifdef VM_OPSTATS
+
+/* read the statistics clock, in nanoseconds */
+static inline unsigned long long vmrun_opstat_clock()
+{
+    return (unsigned long long)std::chrono::duration_cast<
+        std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+inline void CVmRun::opstat_next(uint op)
+{
+    /* get the elapsed time in the outgoing instruction */
+    unsigned long long now = vmrun_opstat_clock();
+    unsigned long long ns = now - opstat_start_;
+
+    /* charge it to the instruction */
+    vm_opstat_rec *r = &opstat_ops_[opstat_cur_op_];
+    ++r->cnt;
+    r->ns += ns;
+
+    /* if it evaluated a property, charge the (opcode, metaclass) pair */
+    if (opstat_cur_meta_ >= 0)
+    {
+        r = &opstat_meta_[opstat_cur_op_ * VM_OPSTAT_MAX_META
+                          + opstat_cur_meta_];
+        ++r->cnt;
+        r->ns += ns;
+        opstat_cur_meta_ = -1;
+    }
+
+    /* start timing the new instruction */
+    opstat_cur_op_ = op;
+    opstat_start_ = now;
+}
+
+#endif /* VM_OPSTATS */
+
 /* ------------------------------------------------------------------------ */
 /*
  *   Execute byte code 
@@ -1163,6 +1306,191 @@ void CVmRun::run(VMG_ const uchar *start_pc)
     const uchar *last_pc = start_pc;
     const uchar **old_pc_ptr;
 
+#ifdef VMRUN_THREADED
+    /* 
+     *   Build the threaded dispatch table the first time through.  Every
+     *   opcode starts out pointing to the invalid-instruction handler, then
+     *   we fill in the handler label for each opcode we implement.  Note
+     *   that the table has to be built inside this function, since label
+     *   addresses are only meaningful within the function defining them.  
+     */
+    static const void *dispatch[256];
+    if (dispatch[0] == 0)
+    {
+        for (int i = 0 ; i < 256 ; ++i)
+            dispatch[i] = &&vmrun_lbl_invalid;
+
+#define VMRUN_SET_HANDLER(op) dispatch[op] = &&vmrun_lbl_##op
+        VMRUN_SET_HANDLER(OPC_GETARGN0);
+        VMRUN_SET_HANDLER(OPC_GETPROPSELF);
+        VMRUN_SET_HANDLER(OPC_GETR0);
+        VMRUN_SET_HANDLER(OPC_DUPR0);
+        VMRUN_SET_HANDLER(OPC_GETSETLCL1R0);
+        VMRUN_SET_HANDLER(OPC_GETSETLCL1);
+        VMRUN_SET_HANDLER(OPC_SETPROPSELF);
+        VMRUN_SET_HANDLER(OPC_SETLCL1R0);
+        VMRUN_SET_HANDLER(OPC_GETARGN1);
+        VMRUN_SET_HANDLER(OPC_GETLCLN0);
+        VMRUN_SET_HANDLER(OPC_SETLCL1);
+        VMRUN_SET_HANDLER(OPC_PUSHSELF);
+        VMRUN_SET_HANDLER(OPC_RETNIL);
+        VMRUN_SET_HANDLER(OPC_RETVAL);
+        VMRUN_SET_HANDLER(OPC_GETPROPLCL1);
+        VMRUN_SET_HANDLER(OPC_JNIL);
+        VMRUN_SET_HANDLER(OPC_RET);
+        VMRUN_SET_HANDLER(OPC_PUSHENUM);
+        VMRUN_SET_HANDLER(OPC_JMP);
+        VMRUN_SET_HANDLER(OPC_JNE);
+        VMRUN_SET_HANDLER(OPC_JR0F);
+        VMRUN_SET_HANDLER(OPC_GETARGN2);
+        VMRUN_SET_HANDLER(OPC_JGT);
+        VMRUN_SET_HANDLER(OPC_CALLPROPSELF);
+        VMRUN_SET_HANDLER(OPC_INDEX);
+        VMRUN_SET_HANDLER(OPC_DUP);
+        VMRUN_SET_HANDLER(OPC_IDXLCL1INT8);
+        VMRUN_SET_HANDLER(OPC_GETLCLN2);
+        VMRUN_SET_HANDLER(OPC_CALLPROP);
+        VMRUN_SET_HANDLER(OPC_GETLCLN1);
+        VMRUN_SET_HANDLER(OPC_GETARGN3);
+        VMRUN_SET_HANDLER(OPC_GETLCLN3);
+        VMRUN_SET_HANDLER(OPC_JNOTNIL);
+        VMRUN_SET_HANDLER(OPC_ITERNEXT);
+        VMRUN_SET_HANDLER(OPC_PUSH_0);
+        VMRUN_SET_HANDLER(OPC_GETPROP);
+        VMRUN_SET_HANDLER(OPC_GETLCLN4);
+        VMRUN_SET_HANDLER(OPC_JE);
+        VMRUN_SET_HANDLER(OPC_PUSHNIL);
+        VMRUN_SET_HANDLER(OPC_PUSHTRUE);
+        VMRUN_SET_HANDLER(OPC_PUSH_1);
+        VMRUN_SET_HANDLER(OPC_PUSHINT8);
+        VMRUN_SET_HANDLER(OPC_PUSHINT);
+        VMRUN_SET_HANDLER(OPC_INC);
+        VMRUN_SET_HANDLER(OPC_ADD);
+        VMRUN_SET_HANDLER(OPC_DEC);
+        VMRUN_SET_HANDLER(OPC_SUB);
+        VMRUN_SET_HANDLER(OPC_PUSHSTR);
+        VMRUN_SET_HANDLER(OPC_DISC);
+        VMRUN_SET_HANDLER(OPC_DISC1);
+        VMRUN_SET_HANDLER(OPC_PUSHLST);
+        VMRUN_SET_HANDLER(OPC_PUSHOBJ);
+        VMRUN_SET_HANDLER(OPC_PUSHPROPID);
+        VMRUN_SET_HANDLER(OPC_PUSHFNPTR);
+        VMRUN_SET_HANDLER(OPC_PUSHPARLST);
+        VMRUN_SET_HANDLER(OPC_MAKELSTPAR);
+        VMRUN_SET_HANDLER(OPC_NEG);
+        VMRUN_SET_HANDLER(OPC_BNOT);
+        VMRUN_SET_HANDLER(OPC_MUL);
+        VMRUN_SET_HANDLER(OPC_DIV);
+        VMRUN_SET_HANDLER(OPC_MOD);
+        VMRUN_SET_HANDLER(OPC_BAND);
+        VMRUN_SET_HANDLER(OPC_BOR);
+        VMRUN_SET_HANDLER(OPC_SHL);
+        VMRUN_SET_HANDLER(OPC_ASHR);
+        VMRUN_SET_HANDLER(OPC_LSHR);
+        VMRUN_SET_HANDLER(OPC_XOR);
+        VMRUN_SET_HANDLER(OPC_NOT);
+        VMRUN_SET_HANDLER(OPC_BOOLIZE);
+        VMRUN_SET_HANDLER(OPC_EQ);
+        VMRUN_SET_HANDLER(OPC_NE);
+        VMRUN_SET_HANDLER(OPC_LT);
+        VMRUN_SET_HANDLER(OPC_LE);
+        VMRUN_SET_HANDLER(OPC_GT);
+        VMRUN_SET_HANDLER(OPC_GE);
+        VMRUN_SET_HANDLER(OPC_VARARGC);
+        VMRUN_SET_HANDLER(OPC_NAMEDARGPTR);
+        VMRUN_SET_HANDLER(OPC_NAMEDARGTAB);
+        VMRUN_SET_HANDLER(OPC_CALL);
+        VMRUN_SET_HANDLER(OPC_PTRCALL);
+        VMRUN_SET_HANDLER(OPC_RETTRUE);
+        VMRUN_SET_HANDLER(OPC_GETPROPR0);
+        VMRUN_SET_HANDLER(OPC_CALLPROPLCL1);
+        VMRUN_SET_HANDLER(OPC_CALLPROPR0);
+        VMRUN_SET_HANDLER(OPC_PTRCALLPROP);
+        VMRUN_SET_HANDLER(OPC_PTRCALLPROPSELF);
+        VMRUN_SET_HANDLER(OPC_OBJGETPROP);
+        VMRUN_SET_HANDLER(OPC_OBJCALLPROP);
+        VMRUN_SET_HANDLER(OPC_GETLCL1);
+        VMRUN_SET_HANDLER(OPC_GETLCLN5);
+        VMRUN_SET_HANDLER(OPC_GETLCL2);
+        VMRUN_SET_HANDLER(OPC_GETARG1);
+        VMRUN_SET_HANDLER(OPC_GETARG2);
+        VMRUN_SET_HANDLER(OPC_SETSELF);
+        VMRUN_SET_HANDLER(OPC_STORECTX);
+        VMRUN_SET_HANDLER(OPC_LOADCTX);
+        VMRUN_SET_HANDLER(OPC_PUSHCTXELE);
+        VMRUN_SET_HANDLER(OPC_GETARGC);
+        VMRUN_SET_HANDLER(OPC_DUP2);
+        VMRUN_SET_HANDLER(OPC_SWITCH);
+        VMRUN_SET_HANDLER(OPC_JT);
+        VMRUN_SET_HANDLER(OPC_JR0T);
+        VMRUN_SET_HANDLER(OPC_JF);
+        VMRUN_SET_HANDLER(OPC_JGE);
+        VMRUN_SET_HANDLER(OPC_JLT);
+        VMRUN_SET_HANDLER(OPC_JLE);
+        VMRUN_SET_HANDLER(OPC_JST);
+        VMRUN_SET_HANDLER(OPC_JSF);
+        VMRUN_SET_HANDLER(OPC_LJSR);
+        VMRUN_SET_HANDLER(OPC_LRET);
+        VMRUN_SET_HANDLER(OPC_SWAP);
+        VMRUN_SET_HANDLER(OPC_SWAP2);
+        VMRUN_SET_HANDLER(OPC_SWAPN);
+        VMRUN_SET_HANDLER(OPC_GETSPN);
+        VMRUN_SET_HANDLER(OPC_SAY);
+        VMRUN_SET_HANDLER(OPC_SAYVAL);
+        VMRUN_SET_HANDLER(OPC_INHERIT);
+        VMRUN_SET_HANDLER(OPC_PTRINHERIT);
+        VMRUN_SET_HANDLER(OPC_EXPINHERIT);
+        VMRUN_SET_HANDLER(OPC_PTREXPINHERIT);
+        VMRUN_SET_HANDLER(OPC_DELEGATE);
+        VMRUN_SET_HANDLER(OPC_PTRDELEGATE);
+        VMRUN_SET_HANDLER(OPC_BUILTIN_A);
+        VMRUN_SET_HANDLER(OPC_BUILTIN_B);
+        VMRUN_SET_HANDLER(OPC_BUILTIN_C);
+        VMRUN_SET_HANDLER(OPC_BUILTIN_D);
+        VMRUN_SET_HANDLER(OPC_BUILTIN1);
+        VMRUN_SET_HANDLER(OPC_BUILTIN2);
+        VMRUN_SET_HANDLER(OPC_IDXINT8);
+        VMRUN_SET_HANDLER(OPC_NEW1);
+        VMRUN_SET_HANDLER(OPC_TRNEW1);
+        VMRUN_SET_HANDLER(OPC_NEW2);
+        VMRUN_SET_HANDLER(OPC_TRNEW2);
+        VMRUN_SET_HANDLER(OPC_NOP);
+        VMRUN_SET_HANDLER(OPC_INCLCL);
+        VMRUN_SET_HANDLER(OPC_DECLCL);
+        VMRUN_SET_HANDLER(OPC_ADDILCL1);
+        VMRUN_SET_HANDLER(OPC_ADDILCL4);
+        VMRUN_SET_HANDLER(OPC_ADDTOLCL);
+        VMRUN_SET_HANDLER(OPC_SUBFROMLCL);
+        VMRUN_SET_HANDLER(OPC_ZEROLCL1);
+        VMRUN_SET_HANDLER(OPC_ZEROLCL2);
+        VMRUN_SET_HANDLER(OPC_NILLCL1);
+        VMRUN_SET_HANDLER(OPC_NILLCL2);
+        VMRUN_SET_HANDLER(OPC_ONELCL1);
+        VMRUN_SET_HANDLER(OPC_ONELCL2);
+        VMRUN_SET_HANDLER(OPC_SETLCL2);
+        VMRUN_SET_HANDLER(OPC_SETARG1);
+        VMRUN_SET_HANDLER(OPC_SETARG2);
+        VMRUN_SET_HANDLER(OPC_SETIND);
+        VMRUN_SET_HANDLER(OPC_SETINDLCL1I8);
+        VMRUN_SET_HANDLER(OPC_SETPROP);
+        VMRUN_SET_HANDLER(OPC_PTRSETPROP);
+        VMRUN_SET_HANDLER(OPC_OBJSETPROP);
+        VMRUN_SET_HANDLER(OPC_PUSHSTRI);
+        VMRUN_SET_HANDLER(OPC_PUSHBIFPTR);
+        VMRUN_SET_HANDLER(OPC_THROW);
+        VMRUN_SET_HANDLER(OPC_GETDBARGC);
+        VMRUN_SET_HANDLER(OPC_GETDBLCL);
+        VMRUN_SET_HANDLER(OPC_GETDBARG);
+        VMRUN_SET_HANDLER(OPC_SETDBLCL);
+        VMRUN_SET_HANDLER(OPC_SETDBARG);
+        VMRUN_SET_HANDLER(OPC_GETPROPDATA);
+        VMRUN_SET_HANDLER(OPC_PTRGETPROPDATA);
+        VMRUN_SET_HANDLER(OPC_BP);
+        VMRUN_SET_HANDLER(OPC_CALLEXT);
+#undef VMRUN_SET_HANDLER
+    }
+#endif /* VMRUN_THREADED */
+
     /* save the enclosing program counter pointer, and remember the new one */
     old_pc_ptr = pc_ptr_;
     pc_ptr_ = &last_pc;
@@ -1244,6 +1572,9 @@ resume_execution:
              */
             last_pc = p;
 
+            /* count the instruction, if we're keeping opcode statistics */
+            VMRUN_OPSTAT(*p);
+
             /* 
              *   Execute the current instruction.
              *   
@@ -1258,133 +1589,141 @@ resume_execution:
              *   shouldn't do any harm relative to a randomly ordered case
              *   table.  
              */
+#ifdef VMRUN_THREADED
+            /* 
+             *   jump straight to the handler for the opcode; the 'switch'
+             *   below is then only used for its case labels 
+             */
+            goto *dispatch[*p++];
+#endif
+
             switch(*p++)
             {
-            case OPC_GETARGN0:
+            VMRUN_CASE(OPC_GETARGN0):
                 push(get_param(vmg_ 0));
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_GETPROPSELF:
+            VMRUN_CASE(OPC_GETPROPSELF):
                 /* evaluate the property of 'self' */
                 prop = get_op_uint16(&p);
                 p = propev.get_prop(
                     vmg_ p - entry_ptr_native_, get_self(vmg0_), prop);
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_GETR0:
+            VMRUN_CASE(OPC_GETR0):
                 /* push the contents of R0 */
                 push(&r0_);
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_DUPR0:
+            VMRUN_CASE(OPC_DUPR0):
                 /* push the contents of R0 twice */
                 push(&r0_);
                 push(&r0_);
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_GETSETLCL1R0:
+            VMRUN_CASE(OPC_GETSETLCL1R0):
                 /* set local from R0 and leave value on stack */
                 push(&r0_);
                 *get_local(vmg_ get_op_uint8(&p)) = r0_;
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_GETSETLCL1:
+            VMRUN_CASE(OPC_GETSETLCL1):
                 /* set local and leave value on stack */
                 *get_local(vmg_ get_op_uint8(&p)) = *get(0);
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_SETPROPSELF:
+            VMRUN_CASE(OPC_SETPROPSELF):
                 /* get the value to set */
                 pop(&val);
 
                 /* set it */
                 set_prop(vmg_ get_self(vmg0_), get_op_uint16(&p), &val);
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_SETLCL1R0:
+            VMRUN_CASE(OPC_SETLCL1R0):
                 /* store R0 in the specific local */
                 *get_local(vmg_ get_op_uint8(&p)) = r0_;
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_GETARGN1:
+            VMRUN_CASE(OPC_GETARGN1):
                 push(get_param(vmg_ 1));
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_GETLCLN0:
+            VMRUN_CASE(OPC_GETLCLN0):
                 push(get_local(vmg_ 0));
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_SETLCL1:
+            VMRUN_CASE(OPC_SETLCL1):
                 /* get a pointer to the local */
                 valp = get_local(vmg_ get_op_uint8(&p));
 
                 /* pop the value into the local */
                 pop(valp);
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_PUSHSELF:
+            VMRUN_CASE(OPC_PUSHSELF):
                 /* push 'self' */
                 push(get_self_val(vmg0_));
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_RETNIL:
+            VMRUN_CASE(OPC_RETNIL):
                 /* store nil in R0 */
                 r0_.set_nil();
 
                 /* return */
                 if ((p = do_return(vmg0_)) == 0)
                     goto exit_loop;
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_RETVAL:
+            VMRUN_CASE(OPC_RETVAL):
                 /* pop the return value into R0 */
                 pop(&r0_);
 
                 /* return */
                 if ((p = do_return(vmg0_)) == 0)
                     goto exit_loop;
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_GETPROPLCL1:
+            VMRUN_CASE(OPC_GETPROPLCL1):
                 /* get the local whose property we're evaluating */
                 propev.self = *get_local(vmg_ get_op_uint8(&p));
 
                 /* evaluate the property of the local variable */
                 prop = get_op_uint16(&p);
                 p = propev.get_prop(vmg_ p - entry_ptr_native_, prop);
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_JNIL:
+            VMRUN_CASE(OPC_JNIL):
                 /* jump if top of stack is nil */
                 valp = get(0);
                 p += (valp->typ == VM_NIL ? osrp2s(p) : 2);
 
                 /* discard the top value, regardless of what happened */
                 discard();
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_RET:
+            VMRUN_CASE(OPC_RET):
                 /* return, leaving R0 unchanged */
                 if ((p = do_return(vmg0_)) == 0)
                     goto exit_loop;
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_PUSHENUM:
+            VMRUN_CASE(OPC_PUSHENUM):
                 /* push a UINT4 operand value */
                 push()->set_enum(get_op_uint32(&p));
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_JMP:
+            VMRUN_CASE(OPC_JMP):
                 /* unconditionally jump to the given offset */
                 p += osrp2s(p);
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_JNE:
+            VMRUN_CASE(OPC_JNE):
                 /* jump if the two values at top of stack are not equal */
                 p += (!pop2_equal(vmg0_) ? osrp2s(p) : 2);
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_JR0F:
+            VMRUN_CASE(OPC_JR0F):
                 /* 
                  *   if R0 is true, or it's a non-zero numeric value, or any
                  *   non-numeric and non-boolean value, stay put; otherwise,
@@ -1400,18 +1739,18 @@ resume_execution:
                     /* it's non-zero and non-nil - do not jump */
                     p += 2;
                 }
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_GETARGN2:
+            VMRUN_CASE(OPC_GETARGN2):
                 push(get_param(vmg_ 2));
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_JGT:
+            VMRUN_CASE(OPC_JGT):
                 /* jump if greater */
                 p += (pop2_compare_gt(vmg0_) ? osrp2s(p) : 2);
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_CALLPROPSELF:
+            VMRUN_CASE(OPC_CALLPROPSELF):
                 /* get the argument count */
                 argc = get_op_uint8(&p);
 
@@ -1420,9 +1759,9 @@ resume_execution:
                 propev.self.set_obj(get_self(vmg0_));
                 prop = get_op_uint16(&p);
                 p = propev.get_prop(vmg_ p - entry_ptr_native_, prop, argc);
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_INDEX:
+            VMRUN_CASE(OPC_INDEX):
                 /* index TOS-1 by TOS, storing the result at TOS-1 */
                 valp = get(1);
                 if (apply_index(vmg_ valp, valp, get(0)))
@@ -1438,14 +1777,14 @@ resume_execution:
                                     &val, G_predef->operator_idx, 1,
                                     VMERR_CANNOT_INDEX_TYPE);
                 }
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_DUP:
+            VMRUN_CASE(OPC_DUP):
                 /* re-push the item at top of stack */
                 push(get(0));
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_IDXLCL1INT8:
+            VMRUN_CASE(OPC_IDXLCL1INT8):
                 /* get the local */
                 valp = get_local(vmg_ get_op_uint8(&p));
 
@@ -1467,13 +1806,13 @@ resume_execution:
                                     valp, G_predef->operator_idx, 1,
                                     VMERR_CANNOT_INDEX_TYPE);
                 }
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_GETLCLN2:
+            VMRUN_CASE(OPC_GETLCLN2):
                 push(get_local(vmg_ 2));
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_CALLPROP:
+            VMRUN_CASE(OPC_CALLPROP):
                 /* get the argument count */
                 argc = get_op_uint8(&p);
 
@@ -1484,30 +1823,30 @@ resume_execution:
                 /* evaluate the property given by the immediate data */
                 prop = get_op_uint16(&p);
                 p = propev.get_prop(vmg_ p - entry_ptr_native_, prop, argc);
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_GETLCLN1:
+            VMRUN_CASE(OPC_GETLCLN1):
                 push(get_local(vmg_ 1));
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_GETARGN3:
+            VMRUN_CASE(OPC_GETARGN3):
                 push(get_param(vmg_ 3));
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_GETLCLN3:
+            VMRUN_CASE(OPC_GETLCLN3):
                 push(get_local(vmg_ 3));
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_JNOTNIL:
+            VMRUN_CASE(OPC_JNOTNIL):
                 /* jump if top of stack is not nil */
                 valp = get(0);
                 p += (valp->typ != VM_NIL ? osrp2s(p) : 2);
 
                 /* discard the top value, regardless of what happened */
                 discard();
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_ITERNEXT:
+            VMRUN_CASE(OPC_ITERNEXT):
                 /* get the iterator object from the local */
                 valp = get_local(vmg_ get_op_uint16(&p));
 
@@ -1527,28 +1866,28 @@ resume_execution:
                 }
                 break;
 
-            case OPC_PUSH_0:
+            VMRUN_CASE(OPC_PUSH_0):
                 /* push the constant value 0 */
                 push()->set_int(0);
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_GETPROP:
+            VMRUN_CASE(OPC_GETPROP):
                 /* get the object whose property we're fetching */
                 pop(&propev.self);
 
                 /* evaluate the property */
                 prop = get_op_uint16(&p);
                 p = propev.get_prop(vmg_ p - entry_ptr_native_, prop);
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_GETLCLN4:
+            VMRUN_CASE(OPC_GETLCLN4):
                 push(get_local(vmg_ 4));
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_JE:
+            VMRUN_CASE(OPC_JE):
                 /* jump if the two values at top of stack are equal */
                 p += (pop2_equal(vmg0_) ? osrp2s(p) : 2);
-                continue;
+                VMRUN_NEXT;
 
                 /* 
                  *   End of case table sorting by instruction execution
@@ -1558,32 +1897,32 @@ resume_execution:
                  *   only so large.  
                  */
 
-            case OPC_PUSHNIL:
+            VMRUN_CASE(OPC_PUSHNIL):
                 /* push nil */
                 push()->set_nil();
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_PUSHTRUE:
+            VMRUN_CASE(OPC_PUSHTRUE):
                 /* push true */
                 push()->set_true();
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_PUSH_1:
+            VMRUN_CASE(OPC_PUSH_1):
                 /* push the constant value 1 */
                 push()->set_int(1);
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_PUSHINT8:
+            VMRUN_CASE(OPC_PUSHINT8):
                 /* push an SBYTE operand value */
                 push()->set_int(get_op_int8(&p));
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_PUSHINT:
+            VMRUN_CASE(OPC_PUSHINT):
                 /* push a UINT4 operand value */
                 push()->set_int(get_op_int32(&p));
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_INC:
+            VMRUN_CASE(OPC_INC):
                 /* 
                  *   Increment the value at top of stack.  We must perform
                  *   the same type conversions as the ADD instruction does.
@@ -1601,9 +1940,9 @@ resume_execution:
                     /* for other types, use the general handler */
                     p = compute_sum_inc(vmg_ p);
                 }
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_ADD:
+            VMRUN_CASE(OPC_ADD):
                 /* if they're both integers, add them the quick way */
                 valp = get(0);
                 valp2 = get(1);
@@ -1620,9 +1959,9 @@ resume_execution:
                     /* for other types, use the general handler */
                     p = compute_sum_add(vmg_ p);
                 }
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_DEC:
+            VMRUN_CASE(OPC_DEC):
                 /* 
                  *   Decrement the value at top of stack.  We must perform
                  *   the same type conversions as the SUB instruction does.
@@ -1640,9 +1979,9 @@ resume_execution:
                     /* for other types, use the general handler */
                     p = compute_diff_dec(vmg_ p);
                 }
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_SUB:
+            VMRUN_CASE(OPC_SUB):
                 /* if they're both integers, subtract them the quick way */
                 valp = get(0);
                 valp2 = get(1);
@@ -1659,44 +1998,44 @@ resume_execution:
                     /* for other types, use the general handler */
                     p = compute_diff_sub(vmg_ p);
                 }
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_PUSHSTR:
+            VMRUN_CASE(OPC_PUSHSTR):
                 /* push UINT4 offset operand as a string */
                 push()->set_sstring(get_op_uint32(&p));
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_DISC:
+            VMRUN_CASE(OPC_DISC):
                 /* discard the item at the top of the stack */
                 discard();
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_DISC1:
+            VMRUN_CASE(OPC_DISC1):
                 /* discard n items */
                 discard(get_op_uint8(&p));
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_PUSHLST:
+            VMRUN_CASE(OPC_PUSHLST):
                 /* push UINT4 offset operand as a list */
                 push()->set_list(get_op_uint32(&p));
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_PUSHOBJ:
+            VMRUN_CASE(OPC_PUSHOBJ):
                 /* push UINT4 object ID operand */
                 push()->set_obj(get_op_uint32(&p));
-                continue;
+                VMRUN_NEXT;
                 
-            case OPC_PUSHPROPID:
+            VMRUN_CASE(OPC_PUSHPROPID):
                 /* push UINT2 property ID operand */
                 push()->set_propid(get_op_uint16(&p));
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_PUSHFNPTR:
+            VMRUN_CASE(OPC_PUSHFNPTR):
                 /* push a function pointer operand */
                 push()->set_fnptr(get_op_uint32(&p));
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_PUSHPARLST:
+            VMRUN_CASE(OPC_PUSHPARLST):
                 {
                     /* get the number of fixed parameters */
                     uint cnt = *p++;
@@ -1708,13 +2047,13 @@ resume_execution:
                     /* push the new list */
                     push()->set_obj(obj);
                 }
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_MAKELSTPAR:
+            VMRUN_CASE(OPC_MAKELSTPAR):
                 makelstpar(vmg0_);
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_NEG:
+            VMRUN_CASE(OPC_NEG):
                 /* if it's an integer value, do the calculation inline */
                 if ((valp = get(0))->typ == VM_INT)
                 {
@@ -1736,9 +2075,9 @@ resume_execution:
                                     &val, G_predef->operator_neg, 0,
                                     VMERR_BAD_TYPE_NEG);
                 }
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_BNOT:
+            VMRUN_CASE(OPC_BNOT):
                 /* check the type */
                 if ((valp = get(0))->typ == VM_INT)
                 {
@@ -1753,9 +2092,9 @@ resume_execution:
                                     &val, G_predef->operator_bit_not, 0,
                                     VMERR_BAD_TYPE_BIT_NOT);
                 }
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_MUL:
+            VMRUN_CASE(OPC_MUL):
                 /* if they're both integers, this is easy */
                 valp = get(0);
                 valp2 = get(1);
@@ -1780,9 +2119,9 @@ resume_execution:
                                     &val, G_predef->operator_mul, 1,
                                     VMERR_BAD_TYPE_MUL);
                 }
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_DIV:
+            VMRUN_CASE(OPC_DIV):
                 /* if they're both integers, do the division inline */
                 valp = get(0);
                 valp2 = get(1);
@@ -1807,9 +2146,9 @@ resume_execution:
                                     &val, G_predef->operator_div, 1,
                                     VMERR_BAD_TYPE_DIV);
                 }
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_MOD:
+            VMRUN_CASE(OPC_MOD):
                 /* remainder number at (TOS-1) by number at top of stack */
                 valp = get(0);
                 valp2 = get(1);
@@ -1839,9 +2178,9 @@ resume_execution:
                                     &val, G_predef->operator_mod, 1,
                                     VMERR_BAD_TYPE_MOD);
                 }
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_BAND:
+            VMRUN_CASE(OPC_BAND):
                 /* bitwise AND two integers on top of stack */
                 valp = get(0);
                 valp2 = get(1);
@@ -1863,9 +2202,9 @@ resume_execution:
                                     &val, G_predef->operator_bit_and, 1,
                                     VMERR_BAD_TYPE_BIT_AND);
                 }
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_BOR:
+            VMRUN_CASE(OPC_BOR):
                 /* bitwise OR two integers on top of stack */
                 valp = get(0);
                 valp2 = get(1);
@@ -1887,9 +2226,9 @@ resume_execution:
                                     &val, G_predef->operator_bit_or, 1,
                                     VMERR_BAD_TYPE_BIT_OR);
                 }
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_SHL:
+            VMRUN_CASE(OPC_SHL):
                 /* 
                  *   bit-shift left integer at (TOS-1) by integer at top
                  *   of stack 
@@ -1914,9 +2253,9 @@ resume_execution:
                                     &val, G_predef->operator_shl, 1,
                                     VMERR_BAD_TYPE_SHL);
                 }
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_ASHR:
+            VMRUN_CASE(OPC_ASHR):
                 /* 
                  *   arithmetic shift right integer at (TOS-1) by integer at
                  *   top of stack 
@@ -1942,9 +2281,9 @@ resume_execution:
                                     &val, G_predef->operator_ashr, 1,
                                     VMERR_BAD_TYPE_ASHR);
                 }
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_LSHR:
+            VMRUN_CASE(OPC_LSHR):
                 /* 
                  *   logical shift right integer at (TOS-1) by integer at
                  *   top of stack 
@@ -1970,9 +2309,9 @@ resume_execution:
                                     &val, G_predef->operator_lshr, 1,
                                     VMERR_BAD_TYPE_LSHR);
                 }
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_XOR:
+            VMRUN_CASE(OPC_XOR):
                 /* XOR two values at top of stack */
                 popval_2(vmg_ &val, &val2);
                 if (!xor_and_push(vmg_ &val, &val2))
@@ -1983,9 +2322,9 @@ resume_execution:
                                     &val, G_predef->operator_xor, 1,
                                     VMERR_BAD_TYPE_XOR);
                 }
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_NOT:
+            VMRUN_CASE(OPC_NOT):
                 /* 
                  *   invert the logic value; if the value is a number,
                  *   treat 0 as nil and non-zero as true 
@@ -1996,12 +2335,12 @@ resume_execution:
                 case VM_NIL:
                     /* !nil -> true */
                     valp->set_true();
-                    continue;
+                    VMRUN_NEXT;
 
                 case VM_OBJ:
                     /* !obj -> true if obj is nil, nil otherwise */
                     valp->set_logical(valp->val.obj == VM_INVALID_OBJ);
-                    continue;
+                    VMRUN_NEXT;
 
                 case VM_TRUE:
                 case VM_PROP:
@@ -2012,19 +2351,19 @@ resume_execution:
                 case VM_ENUM:
                     /* these are all considered true, so !them -> nil */
                     valp->set_nil();
-                    continue;
+                    VMRUN_NEXT;
 
                 case VM_INT:
                     /* !int -> true if int is 0, nil otherwise */
                     valp->set_logical(valp->val.intval == 0);
-                    continue;
+                    VMRUN_NEXT;
 
                 default:
                     err_throw(VMERR_NO_LOG_CONV);
                 }
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_BOOLIZE:
+            VMRUN_CASE(OPC_BOOLIZE):
                 /* set to a boolean value */
                 valp = get(0);
                 switch(valp->typ)
@@ -2032,54 +2371,54 @@ resume_execution:
                 case VM_NIL:
                 case VM_TRUE:
                     /* it's already a logical value - leave it alone */
-                    continue;
+                    VMRUN_NEXT;
 
                 case VM_INT:
                     /* integer: 0 -> nil, non-zero -> true */
                     valp->set_logical(valp->val.intval);
-                    continue;
+                    VMRUN_NEXT;
 
                 case VM_ENUM:
                     /* an enum is always non-nil */
                     valp->set_true();
-                    continue;
+                    VMRUN_NEXT;
 
                 default:
                     err_throw(VMERR_NO_LOG_CONV);
                 }
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_EQ:
+            VMRUN_CASE(OPC_EQ):
                 /* compare two values at top of stack for equality */
                 push_bool(vmg_ pop2_equal(vmg0_));
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_NE:
+            VMRUN_CASE(OPC_NE):
                 /* compare two values at top of stack for inequality */
                 push_bool(vmg_ !pop2_equal(vmg0_));
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_LT:
+            VMRUN_CASE(OPC_LT):
                 /* compare values at top of stack - true if (TOS-1) < TOS */
                 push_bool(vmg_ pop2_compare_lt(vmg0_));
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_LE:
+            VMRUN_CASE(OPC_LE):
                 /* compare values at top of stack - true if (TOS-1) <= TOS */
                 push_bool(vmg_ pop2_compare_le(vmg0_));
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_GT:
+            VMRUN_CASE(OPC_GT):
                 /* compare values at top of stack - true if (TOS-1) > TOS */
                 push_bool(vmg_ pop2_compare_gt(vmg0_));
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_GE:
+            VMRUN_CASE(OPC_GE):
                 /* compare values at top of stack - true if (TOS-1) >= TOS */
                 push_bool(vmg_ pop2_compare_ge(vmg0_));
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_VARARGC:
+            VMRUN_CASE(OPC_VARARGC):
                 {
                     /* get the modified opcode */
                     uchar opc = *p++;
@@ -2174,12 +2513,12 @@ resume_execution:
 
                     default:
                         err_throw(VMERR_INVALID_OPCODE_MOD);
-                        continue;
+                        VMRUN_NEXT;
                     }
                 }
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_NAMEDARGPTR:
+            VMRUN_CASE(OPC_NAMEDARGPTR):
                 /* 
                  *   Pointer to named argument table.  Discard the named
                  *   arguments (the count is given by a one-byte operand),
@@ -2187,9 +2526,9 @@ resume_execution:
                  */
                 discard(get_op_uint8(&p));
                 p += 2;
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_NAMEDARGTAB:
+            VMRUN_CASE(OPC_NAMEDARGTAB):
                 /* 
                  *   Named argument table.  As with NAMEDARGPTR, we must
                  *   discard the named arguments.  Then we simply skip the
@@ -2200,9 +2539,9 @@ resume_execution:
                     discard(get_op_uint16(&p));
                     p += ofs - 2;
                 }
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_CALL:
+            VMRUN_CASE(OPC_CALL):
                 /* get the argument count */
                 argc = get_op_uint8(&p);
 
@@ -2214,9 +2553,9 @@ resume_execution:
                     /* call it */
                     p = do_call_func_nr(vmg_ p - entry_ptr_native_, ofs, argc);
                 }
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_PTRCALL:
+            VMRUN_CASE(OPC_PTRCALL):
                 /* get the argument count */
                 argc = get_op_uint8(&p);
 
@@ -2234,25 +2573,25 @@ resume_execution:
                 
                 /* call the function */
                 p = call_func_ptr(vmg_ &val, argc, 0, p - entry_ptr_native_);
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_RETTRUE:
+            VMRUN_CASE(OPC_RETTRUE):
                 /* store true in R0 */
                 r0_.set_true();
 
                 /* return */
                 if ((p = do_return(vmg0_)) == 0)
                     goto exit_loop;
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_GETPROPR0:
+            VMRUN_CASE(OPC_GETPROPR0):
                 /* evaluate the property of R0 */
                 propev.self = r0_;
                 prop = get_op_uint16(&p);
                 p = propev.get_prop(vmg_ p - entry_ptr_native_, prop);
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_CALLPROPLCL1:
+            VMRUN_CASE(OPC_CALLPROPLCL1):
                 /* get the argument count */
                 argc = get_op_uint8(&p);
 
@@ -2263,9 +2602,9 @@ resume_execution:
                 /* call the property of the local */
                 prop = get_op_uint16(&p);
                 p = propev.get_prop(vmg_ p - entry_ptr_native_, prop, argc);
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_CALLPROPR0:
+            VMRUN_CASE(OPC_CALLPROPR0):
                 /* get the argument count */
                 argc = get_op_uint8(&p);
 
@@ -2274,9 +2613,9 @@ resume_execution:
                 propev.self = r0_;
                 prop = get_op_uint16(&p);
                 p = propev.get_prop(vmg_ p - entry_ptr_native_, prop, argc);
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_PTRCALLPROP:
+            VMRUN_CASE(OPC_PTRCALLPROP):
                 /* get the argument count */
                 argc = get_op_uint8(&p);
 
@@ -2291,9 +2630,9 @@ resume_execution:
                 /* evaluate the property */
                 p = propev.get_prop(vmg_ p - entry_ptr_native_,
                                     val.val.prop, argc);
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_PTRCALLPROPSELF:
+            VMRUN_CASE(OPC_PTRCALLPROPSELF):
                 /* get the argument count */
                 argc = get_op_uint8(&p);
 
@@ -2306,18 +2645,18 @@ resume_execution:
                 propev.self.set_obj(get_self(vmg0_));
                 p = propev.get_prop(vmg_ p - entry_ptr_native_,
                                     val.val.prop, argc);
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_OBJGETPROP:
+            VMRUN_CASE(OPC_OBJGETPROP):
                 /* get the object */
                 propev.self.set_obj((vm_obj_id_t)get_op_uint32(&p));
 
                 /* evaluate the property */
                 prop = get_op_uint16(&p);
                 p = propev.get_prop(vmg_ p - entry_ptr_native_, prop);
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_OBJCALLPROP:
+            VMRUN_CASE(OPC_OBJCALLPROP):
                 /* get the argument count */
                 argc = get_op_uint8(&p);
 
@@ -2328,33 +2667,33 @@ resume_execution:
                 /* evaluate the property */
                 prop = get_op_uint16(&p);
                 p = propev.get_prop(vmg_ p - entry_ptr_native_, prop, argc);
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_GETLCL1:
+            VMRUN_CASE(OPC_GETLCL1):
                 /* push the local */
                 pushval(vmg_ get_local(vmg_ get_op_uint8(&p)));
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_GETLCLN5:
+            VMRUN_CASE(OPC_GETLCLN5):
                 pushval(vmg_ get_local(vmg_ 5));
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_GETLCL2:
+            VMRUN_CASE(OPC_GETLCL2):
                 /* push the local */
                 pushval(vmg_ get_local(vmg_ get_op_uint16(&p)));
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_GETARG1:
+            VMRUN_CASE(OPC_GETARG1):
                 /* push the argument */
                 pushval(vmg_ get_param(vmg_ get_op_uint8(&p)));
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_GETARG2:
+            VMRUN_CASE(OPC_GETARG2):
                 /* push the argument */
                 pushval(vmg_ get_param(vmg_ get_op_uint16(&p)));
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_SETSELF:
+            VMRUN_CASE(OPC_SETSELF):
                 /* retrieve the 'self' object */
                 pop(&val);
                 
@@ -2364,18 +2703,18 @@ resume_execution:
 
                 /* set 'self' */
                 set_self(vmg_ &val);
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_STORECTX:
+            VMRUN_CASE(OPC_STORECTX):
                 /* create the context object */
                 create_loadctx_obj(vmg_ push(),
                                    get_self(vmg0_),
                                    get_defining_obj(vmg0_),
                                    get_orig_target_obj(vmg0_),
                                    get_target_prop(vmg0_));
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_LOADCTX:
+            VMRUN_CASE(OPC_LOADCTX):
                 {
                     /* 
                      *   convert the context object (at top of stack) to a
@@ -2400,44 +2739,44 @@ resume_execution:
                     /* discard the context object at top of stack */
                     discard();
                 }
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_PUSHCTXELE:
+            VMRUN_CASE(OPC_PUSHCTXELE):
                 /* check our context element type */
                 switch(*p++)
                 {
                 case PUSHCTXELE_TARGPROP:
                     /* push the target property ID */
                     push(get_from_frame(frame_ptr_, VMRUN_FPOFS_PROP));
-                    continue;
+                    VMRUN_NEXT;
 
                 case PUSHCTXELE_TARGOBJ:
                     /* push the original target object ID */
                     push(get_from_frame(frame_ptr_, VMRUN_FPOFS_ORIGTARG));
-                    continue;
+                    VMRUN_NEXT;
 
                 case PUSHCTXELE_DEFOBJ:
                     /* push the defining object */
                     push(get_from_frame(frame_ptr_, VMRUN_FPOFS_DEFOBJ));
-                    continue;
+                    VMRUN_NEXT;
 
                 case PUSHCTXELE_INVOKEE:
                     /* push the invokee object */
                     push(get_from_frame(frame_ptr_, VMRUN_FPOFS_INVOKEE));
-                    continue;
+                    VMRUN_NEXT;
 
                 default:
                     /* the opcode is not valid in this VM version */
                     err_throw(VMERR_INVALID_OPCODE);
                 }
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_GETARGC:
+            VMRUN_CASE(OPC_GETARGC):
                 /* push the argument counter */
                 push_int(vmg_ get_cur_argc(vmg0_));
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_DUP2:
+            VMRUN_CASE(OPC_DUP2):
                 /* 
                  *   duplicate the top two elements: first push the
                  *   second-from-top, then push the old top (which will now
@@ -2445,9 +2784,9 @@ resume_execution:
                  */
                 pushval(vmg_ get(1));
                 pushval(vmg_ get(1));
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_SWITCH:
+            VMRUN_CASE(OPC_SWITCH):
                 {
                     /* get the control value */
                     valp = get(0);
@@ -2480,9 +2819,9 @@ resume_execution:
                     if (cnt == 0)
                         p += osrp2s(p);
                 }
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_JT:
+            VMRUN_CASE(OPC_JT):
                 /* get the value */
                 valp = get(0);
 
@@ -2503,9 +2842,9 @@ resume_execution:
 
                 /* discard the value */
                 discard();
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_JR0T:
+            VMRUN_CASE(OPC_JR0T):
                 /* 
                  *   if R0 is true, or it's a non-zero numeric value, or any
                  *   non-numeric and non-boolean value, jump 
@@ -2520,9 +2859,9 @@ resume_execution:
                     /* it's non-zero and non-nil - jump */
                     p += osrp2s(p);
                 }
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_JF:
+            VMRUN_CASE(OPC_JF):
                 /* get the value */
                 valp = get(0);
 
@@ -2544,24 +2883,24 @@ resume_execution:
 
                 /* discard the value */
                 discard();
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_JGE:
+            VMRUN_CASE(OPC_JGE):
                 /* jump if greater or equal */
                 p += (pop2_compare_ge(vmg0_) ? osrp2s(p) : 2);
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_JLT:
+            VMRUN_CASE(OPC_JLT):
                 /* jump if less */
                 p += (pop2_compare_lt(vmg0_) ? osrp2s(p) : 2);
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_JLE:
+            VMRUN_CASE(OPC_JLE):
                 /* jump if less or equal */
                 p += (pop2_compare_le(vmg0_) ? osrp2s(p) : 2);
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_JST:
+            VMRUN_CASE(OPC_JST):
                 /* get (do not remove) the element at top of stack */
                 valp = get(0);
 
@@ -2588,9 +2927,9 @@ resume_execution:
                     /* skip to the next instruction */
                     p += 2;
                 }
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_JSF:
+            VMRUN_CASE(OPC_JSF):
                 /* get (do not remove) the element at top of stack */
                 valp = get(0);
 
@@ -2611,9 +2950,9 @@ resume_execution:
                     /* skip to the next instruction */
                     p += 2;
                 }
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_LJSR:
+            VMRUN_CASE(OPC_LJSR):
                 /* 
                  *   compute and push the offset of the next instruction
                  *   (at +2 because of the branch offset operand) from our
@@ -2625,9 +2964,9 @@ resume_execution:
 
                 /* jump to the target address */
                 p += osrp2s(p);
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_LRET:
+            VMRUN_CASE(OPC_LRET):
                 /* get the indicated local variable */
                 valp = get_local(vmg_ get_op_uint16(&p));
                 
@@ -2641,9 +2980,9 @@ resume_execution:
                  *   current method header pointer 
                  */
                 p = entry_ptr_native_ + valp->val.intval;
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_SWAP:
+            VMRUN_CASE(OPC_SWAP):
                 /* swap the top two elements on the stack */
                 valp = get(0);
                 valp2 = get(1);
@@ -2656,9 +2995,9 @@ resume_execution:
 
                 /* copy the working copy of TOS over TOS-1 */
                 *valp2 = val;
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_SWAP2:
+            VMRUN_CASE(OPC_SWAP2):
                 /* swap the top two elements with the next two */
                 valp = get(0);
                 valp2 = get(1);
@@ -2674,9 +3013,9 @@ resume_execution:
                 /* copy the saved 2,3 over 0,1 */
                 *valp = val;
                 *valp2 = val2;
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_SWAPN:
+            VMRUN_CASE(OPC_SWAPN):
                 /* swap elements at two given stack indices */
                 valp = get(get_op_uint8(&p));
                 valp2 = get(get_op_uint8(&p));
@@ -2689,14 +3028,14 @@ resume_execution:
 
                 /* write the copy of val1 over val2 */
                 *valp2 = val;
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_GETSPN:
+            VMRUN_CASE(OPC_GETSPN):
                 /* push stack element at index */
                 push(get(get_op_uint8(&p)));
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_SAY:
+            VMRUN_CASE(OPC_SAY):
                 {
                     /* get the string offset */
                     pool_ofs_t ofs = get_op_int32(&p);
@@ -2705,15 +3044,15 @@ resume_execution:
                     p = disp_dstring(vmg_ ofs, p - entry_ptr_native_,
                                      get_self_check(vmg0_));
                 }
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_SAYVAL:
+            VMRUN_CASE(OPC_SAYVAL):
                 /* invoke the default string display function */
                 p = disp_string_val(vmg_ p - entry_ptr_native_,
                                     get_self_check(vmg0_));
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_INHERIT:
+            VMRUN_CASE(OPC_INHERIT):
                 /* get the argument count */
                 argc = get_op_uint8(&p);
 
@@ -2721,9 +3060,9 @@ resume_execution:
                 /* inherit the property */
                 prop = (vm_prop_id_t)get_op_uint16(&p);
                 p = inh_prop(vmg_ p - entry_ptr_native_, prop, argc);
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_PTRINHERIT:
+            VMRUN_CASE(OPC_PTRINHERIT):
                 /* get the argument count */
                 argc = get_op_uint8(&p);
 
@@ -2733,9 +3072,9 @@ resume_execution:
 
                 /* inherit it */
                 p = inh_prop(vmg_ p - entry_ptr_native_, val.val.prop, argc);
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_EXPINHERIT:
+            VMRUN_CASE(OPC_EXPINHERIT):
                 /* get the argument count */
                 argc = get_op_uint8(&p);
 
@@ -2755,9 +3094,9 @@ resume_execution:
                 val2.set_obj(get_self(vmg0_));
                 p = get_prop(vmg_ p - entry_ptr_native_,
                              &val, prop, &val2, argc, 0);
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_PTREXPINHERIT:
+            VMRUN_CASE(OPC_PTREXPINHERIT):
                 /* get the argument count */
                 argc = get_op_uint8(&p);
 
@@ -2772,9 +3111,9 @@ resume_execution:
                 val2.set_obj(get_self(vmg0_));
                 p = get_prop(vmg_ p - entry_ptr_native_,
                              &val3, val.val.prop, &val2, argc, 0);
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_DELEGATE:
+            VMRUN_CASE(OPC_DELEGATE):
                 /* get the argument count */
                 argc = get_op_uint8(&p);
 
@@ -2790,9 +3129,9 @@ resume_execution:
 
                 p = get_prop(vmg_ p - entry_ptr_native_,
                              &val, prop, &val2, argc, 0);
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_PTRDELEGATE:
+            VMRUN_CASE(OPC_PTRDELEGATE):
                 /* get the argument count */
                 argc = get_op_uint8(&p);
 
@@ -2807,9 +3146,9 @@ resume_execution:
                 val3.set_obj(get_self(vmg0_));
                 p = get_prop(vmg_ p - entry_ptr_native_,
                              &val2, val.val.prop, &val3, argc, 0);
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_BUILTIN_A:
+            VMRUN_CASE(OPC_BUILTIN_A):
                 /* get the argument count */
                 argc = get_op_uint8(&p);
 
@@ -2821,9 +3160,9 @@ resume_execution:
                     /* call the function in set #0 */
                     call_bif(vmg_ 0, idx, argc);
                 }
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_BUILTIN_B:
+            VMRUN_CASE(OPC_BUILTIN_B):
                 /* get the argument count */
                 argc = get_op_uint8(&p);
 
@@ -2835,9 +3174,9 @@ resume_execution:
                     /* call the function in set #1 */
                     call_bif(vmg_ 1, idx, argc);
                 }
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_BUILTIN_C:
+            VMRUN_CASE(OPC_BUILTIN_C):
                 /* get the argument count */
                 argc = get_op_uint8(&p);
 
@@ -2849,9 +3188,9 @@ resume_execution:
                     /* call the function in set #2 */
                     call_bif(vmg_ 2, idx, argc);
                 }
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_BUILTIN_D:
+            VMRUN_CASE(OPC_BUILTIN_D):
                 /* get the argument count */
                 argc = get_op_uint8(&p);
 
@@ -2863,9 +3202,9 @@ resume_execution:
                     /* call the function in set #3 */
                     call_bif(vmg_ 3, idx, argc);
                 }
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_BUILTIN1:
+            VMRUN_CASE(OPC_BUILTIN1):
                 /* get the argument count */
                 argc = get_op_uint8(&p);
 
@@ -2878,9 +3217,9 @@ resume_execution:
                     /* call the function */
                     call_bif(vmg_ set_idx, idx, argc);
                 }
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_BUILTIN2:
+            VMRUN_CASE(OPC_BUILTIN2):
                 /* get the argument count */
                 argc = get_op_uint8(&p);
 
@@ -2893,9 +3232,9 @@ resume_execution:
                     /* call the function in set #0 */
                     call_bif(vmg_ set_idx, idx, argc);
                 }
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_IDXINT8:
+            VMRUN_CASE(OPC_IDXINT8):
                 /* 
                  *   make a copy of the value to index, so we can overwrite
                  *   the stack slot with the result 
@@ -2918,9 +3257,9 @@ resume_execution:
                                     &val, G_predef->operator_idx, 1,
                                     VMERR_CANNOT_INDEX_TYPE);
                 }
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_NEW1:
+            VMRUN_CASE(OPC_NEW1):
                 /* get the argument count */
                 argc = get_op_uint8(&p);
 
@@ -2931,9 +3270,9 @@ resume_execution:
                     uint idx = get_op_uint8(&p);
                     p = new_and_store_r0(vmg_ p, idx, argc, FALSE);
                 }
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_TRNEW1:
+            VMRUN_CASE(OPC_TRNEW1):
                 /* get the argument count */
                 argc = get_op_uint8(&p);
 
@@ -2945,9 +3284,9 @@ resume_execution:
                     uint idx = get_op_uint8(&p);
                     p = new_and_store_r0(vmg_ p, idx, argc, TRUE);
                 }
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_NEW2:
+            VMRUN_CASE(OPC_NEW2):
                 /* get the argument count */
                 argc = get_op_uint16(&p);
 
@@ -2960,9 +3299,9 @@ resume_execution:
                     /* create the new object */
                     p = new_and_store_r0(vmg_ p, idx, argc, FALSE);
                 }
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_TRNEW2:
+            VMRUN_CASE(OPC_TRNEW2):
                 /* get the argument count */
                 argc = get_op_uint16(&p);
 
@@ -2975,13 +3314,13 @@ resume_execution:
                     /* create the new object */
                     p = new_and_store_r0(vmg_ p, idx, argc, TRUE);
                 }
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_NOP:
+            VMRUN_CASE(OPC_NOP):
                 /* NO OP - no effect */
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_INCLCL:
+            VMRUN_CASE(OPC_INCLCL):
                 /* get the local */
                 {
                     int itmp = get_op_uint16(&p);
@@ -3011,9 +3350,9 @@ resume_execution:
                         }
                     }
                 }
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_DECLCL:
+            VMRUN_CASE(OPC_DECLCL):
                 {
                     /* get the local */
                     int itmp = get_op_uint16(&p);
@@ -3043,9 +3382,9 @@ resume_execution:
                         }
                     }
                 }
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_ADDILCL1:
+            VMRUN_CASE(OPC_ADDILCL1):
                 {
                     /* get the local */
                     int itmp = get_op_uint8(&p);
@@ -3066,9 +3405,9 @@ resume_execution:
                         p = compute_sum_lcl_imm(vmg_ valp, &val2, itmp, p);
                     }
                 }
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_ADDILCL4:
+            VMRUN_CASE(OPC_ADDILCL4):
                 {
                     /* get the local */
                     int itmp = get_op_uint16(&p);
@@ -3089,9 +3428,9 @@ resume_execution:
                         p = compute_sum_lcl_imm(vmg_ valp, &val2, itmp, p);
                     }
                 }
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_ADDTOLCL:
+            VMRUN_CASE(OPC_ADDTOLCL):
                 {
                     /* get the local */
                     int itmp = get_op_uint16(&p);
@@ -3130,9 +3469,9 @@ resume_execution:
                         }
                     }
                 }
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_SUBFROMLCL:
+            VMRUN_CASE(OPC_SUBFROMLCL):
                 {
                     /* get the local */
                     int itmp = get_op_uint16(&p);
@@ -3168,63 +3507,63 @@ resume_execution:
                                         VMERR_BAD_TYPE_SUB);
                     }
                 }
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_ZEROLCL1:
+            VMRUN_CASE(OPC_ZEROLCL1):
                 /* get the local and set it to zero */
                 get_local(vmg_ get_op_uint8(&p))->set_int(0);
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_ZEROLCL2:
+            VMRUN_CASE(OPC_ZEROLCL2):
                 /* get the local and set it to zero */
                 get_local(vmg_ get_op_uint16(&p))->set_int(0);
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_NILLCL1:
+            VMRUN_CASE(OPC_NILLCL1):
                 /* get the local and set it to zero */
                 get_local(vmg_ get_op_uint8(&p))->set_nil();
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_NILLCL2:
+            VMRUN_CASE(OPC_NILLCL2):
                 /* get the local and set it to zero */
                 get_local(vmg_ get_op_uint16(&p))->set_nil();
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_ONELCL1:
+            VMRUN_CASE(OPC_ONELCL1):
                 /* get the local and set it to zero */
                 get_local(vmg_ get_op_uint8(&p))->set_int(1);
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_ONELCL2:
+            VMRUN_CASE(OPC_ONELCL2):
                 /* get the local and set it to zero */
                 get_local(vmg_ get_op_uint16(&p))->set_int(1);
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_SETLCL2:
+            VMRUN_CASE(OPC_SETLCL2):
                 /* get a pointer to the local */
                 valp = get_local(vmg_ get_op_uint16(&p));
 
                 /* pop the value into the local */
                 popval(vmg_ valp);
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_SETARG1:
+            VMRUN_CASE(OPC_SETARG1):
                 /* get a pointer to the parameter */
                 valp = get_param(vmg_ get_op_uint8(&p));
 
                 /* pop the value into the parameter */
                 popval(vmg_ valp);
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_SETARG2:
+            VMRUN_CASE(OPC_SETARG2):
                 /* get a pointer to the parameter */
                 valp = get_param(vmg_ get_op_uint16(&p));
 
                 /* pop the value into the parameter */
                 popval(vmg_ valp);
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_SETIND:
+            VMRUN_CASE(OPC_SETIND):
                 /* pop the index */
                 popval(vmg_ &val2);
 
@@ -3249,9 +3588,9 @@ resume_execution:
                                     &val, G_predef->operator_setidx, 2,
                                     VMERR_CANNOT_INDEX_TYPE);
                 }
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_SETINDLCL1I8:
+            VMRUN_CASE(OPC_SETINDLCL1I8):
                 {
                     /* get the local */
                     int itmp = get_op_uint8(&p);
@@ -3277,9 +3616,9 @@ resume_execution:
                                         VMERR_CANNOT_INDEX_TYPE);
                     }
                 }
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_SETPROP:
+            VMRUN_CASE(OPC_SETPROP):
                 /* get the object whose property we're setting */
                 pop_obj(vmg_ &val);
 
@@ -3288,9 +3627,9 @@ resume_execution:
 
                 /* set the value */
                 set_prop(vmg_ val.val.obj, get_op_uint16(&p), &val2);
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_PTRSETPROP:
+            VMRUN_CASE(OPC_PTRSETPROP):
                 /* get the property and object to set */
                 pop_prop(vmg_ &val);
                 pop_obj(vmg_ &val2);
@@ -3300,9 +3639,9 @@ resume_execution:
 
                 /* set it */
                 set_prop(vmg_ val2.val.obj, val.val.prop, &val3);
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_OBJSETPROP:
+            VMRUN_CASE(OPC_OBJSETPROP):
                 /* get the object */
                 obj = (vm_obj_id_t)get_op_uint32(&p);
 
@@ -3311,9 +3650,9 @@ resume_execution:
 
                 /* set the property */
                 set_prop(vmg_ obj, get_op_uint16(&p), &val);
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_PUSHSTRI:
+            VMRUN_CASE(OPC_PUSHSTRI):
                 /* push inline string */
                 {
                     /* get the length prefix */
@@ -3329,18 +3668,18 @@ resume_execution:
                     /* push the new string */
                     push()->set_obj(obj);
                 }
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_PUSHBIFPTR:
+            VMRUN_CASE(OPC_PUSHBIFPTR):
                 {
                     /* push pointer to built-in function */
                     uint idx = get_op_uint16(&p);
                     push()->set_bifptr(get_op_uint16(&p), (ushort)idx);
                     validate_bifptr(vmg0_);
                 }
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_THROW:
+            VMRUN_CASE(OPC_THROW):
                 /* pop the exception object */
                 pop_obj(vmg_ &val);
 
@@ -3358,11 +3697,11 @@ resume_execution:
                     /* terminate execution */
                     goto exit_loop;
                 }
-                continue;
+                VMRUN_NEXT;
 
 #ifdef VM_DEBUGGER
 
-            case OPC_GETPROPDATA:
+            VMRUN_CASE(OPC_GETPROPDATA):
                 /* get the object whose property we're fetching */
                 pop(&propev.self);
 
@@ -3383,9 +3722,9 @@ resume_execution:
 
                 /* evaluate the property given by the immediate data */
                 p = propev.get_prop(vmg_ p - entry_ptr_native_, prop);
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_PTRGETPROPDATA:
+            VMRUN_CASE(OPC_PTRGETPROPDATA):
                 /* get the property and object to evaluate */
                 pop_prop(vmg_ &val);
                 pop(&propev.self);
@@ -3404,14 +3743,14 @@ resume_execution:
 
                 /* evaluate it */
                 p = propev.get_prop(vmg_ p - entry_ptr_native_, val.val.prop);
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_GETDBARGC:
+            VMRUN_CASE(OPC_GETDBARGC):
                 /* push the argument count from the selected frame */
                 push_int(vmg_ get_argc_at_level(vmg_ get_op_uint16(&p) + 1));
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_GETDBLCL:
+            VMRUN_CASE(OPC_GETDBLCL):
                 {
                     /* get the local variable number and stack level */
                     uint idx = get_op_uint16(&p);
@@ -3420,9 +3759,9 @@ resume_execution:
                     /* push the value */
                     pushval(vmg_ get_local_at_level(vmg_ idx, level + 1));
                 }
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_GETDBARG:
+            VMRUN_CASE(OPC_GETDBARG):
                 {
                     /* get the parameter variable number and stack level */
                     uint idx = get_op_uint16(&p);
@@ -3431,9 +3770,9 @@ resume_execution:
                     /* push the value */
                     pushval(vmg_ get_param_at_level(vmg_ idx, level + 1));
                 }
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_SETDBLCL:
+            VMRUN_CASE(OPC_SETDBLCL):
                 {
                     /* get the local variable number and stack level */
                     uint idx = get_op_uint16(&p);
@@ -3445,9 +3784,9 @@ resume_execution:
                     /* pop the value into the local */
                     popval(vmg_ valp);
                 }
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_SETDBARG:
+            VMRUN_CASE(OPC_SETDBARG):
                 {
                     /* get the parameter variable number and stack level */
                     uint idx = get_op_uint16(&p);
@@ -3459,9 +3798,9 @@ resume_execution:
                     /* pop the value into the local */
                     popval(vmg_ valp);
                 }
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_BP:
+            VMRUN_CASE(OPC_BP):
                 /* step back to the breakpoint location itself */
                 --p;
 
@@ -3483,27 +3822,27 @@ resume_execution:
 
 #else /* VM_DEBUGGER */
 
-            case OPC_GETDBARGC:
-            case OPC_GETDBLCL:
-            case OPC_GETDBARG:
-            case OPC_SETDBLCL:
-            case OPC_SETDBARG:
-            case OPC_GETPROPDATA:
-            case OPC_PTRGETPROPDATA:
+            VMRUN_CASE(OPC_GETDBARGC):
+            VMRUN_CASE(OPC_GETDBLCL):
+            VMRUN_CASE(OPC_GETDBARG):
+            VMRUN_CASE(OPC_SETDBLCL):
+            VMRUN_CASE(OPC_SETDBARG):
+            VMRUN_CASE(OPC_GETPROPDATA):
+            VMRUN_CASE(OPC_PTRGETPROPDATA):
                 err_throw(VMERR_NO_DEBUGGER);
-                continue;
+                VMRUN_NEXT;
 
-            case OPC_BP:
+            VMRUN_CASE(OPC_BP):
                 /* if there's no debugger, it's an error */
                 err_throw(VMERR_BREAKPOINT);
-                continue;
+                VMRUN_NEXT;
 
 #endif /* VM_DEBUGGER */
 
-            case OPC_CALLEXT:
+            VMRUN_CASE(OPC_CALLEXT):
                 //$$$
                 err_throw(VMERR_CALLEXT_NOT_IMPL);
-                continue;
+                VMRUN_NEXT;
 
 #ifdef OS_FILL_OUT_CASE_TABLES
             /*
@@ -3651,9 +3990,19 @@ resume_execution:
             default:
                 /* unrecognized opcode */
                 err_throw(VMERR_INVALID_OPCODE);
-                continue;
+                VMRUN_NEXT;
 
 #endif /* OS_FILL_OUT_CASE_TABLES */
+
+#ifdef VMRUN_THREADED
+            vmrun_lbl_invalid:
+                /* 
+                 *   the threaded dispatch table sends every opcode that has
+                 *   no handler here 
+                 */
+                err_throw(VMERR_INVALID_OPCODE);
+                VMRUN_NEXT;
+#endif /* VMRUN_THREADED */
             }
         }
 
@@ -4472,6 +4821,10 @@ const uchar *CVmRun::do_call_func_nr(VMG_ uint caller_ofs,
     vm_val_t *fp;
     int lcl_cnt;
 
+    /* take a profiler sample if the sampling timer has ticked */
+    if (sample_ticks_ != 0)
+        take_sample(vmg0_);
+
     /* store nil in R0 */
     r0_.set_nil();
 
@@ -4642,6 +4995,10 @@ const uchar *CVmRun::do_call(VMG_ uint caller_ofs,
     vm_val_t *fp;
     int lcl_cnt;
 
+    /* take a profiler sample if the sampling timer has ticked */
+    if (sample_ticks_ != 0)
+        take_sample(vmg0_);
+
     /* store nil in R0 */
     r0_.set_nil();
 
@@ -4764,6 +5121,14 @@ const uchar *CVmRun::do_call(VMG_ uint caller_ofs,
  */
 const uchar *CVmRun::do_return(VMG0_)
 {
+    /* 
+     *   take a profiler sample if the sampling timer has ticked - do this
+     *   before we leave the frame, so that time spent in a long-running
+     *   function is charged to the function 
+     */
+    if (sample_ticks_ != 0)
+        take_sample(vmg0_);
+
     /* invalidate the frame reference object, if present */
     vm_val_t *fro = get_frameref_slot(vmg_ frame_ptr_);
     if (fro->typ == VM_OBJ
@@ -5177,6 +5542,9 @@ const uchar *CVmRun::get_prop(VMG_ uint caller_ofs,
     int found;
     vm_val_t new_self;
 
+    /* note the target's metaclass in the opcode statistics */
+    VM_IF_OPSTATS(opstat_note_target(vmg_ target_obj));
+
     /* find the property without evaluating it */
     found = get_prop_no_eval(vmg_ &target_obj, target_prop,
                              &argc, &srcobj, &val, &self, &new_self);
@@ -6454,6 +6822,588 @@ CVmHashEntryProfiler *CVmRun::prof_find_master_rec(const vm_profiler_rec *p)
 
 #endif /* VM_PROFILER */
 
+/* ------------------------------------------------------------------------ */
+/*
+ *   Sampling profiler.
+ *   
+ *   Each sample is the call stack at the time of the sample, innermost
+ *   frame first.  We identify a frame by its entrypoint, defining object,
+ *   and target property, which is enough to recover the function or method
+ *   name later.  We keep a hash table of the distinct stacks we've seen,
+ *   keyed by the concatenated frame identifiers, counting the timer ticks
+ *   recorded in each stack.  Symbol names are only looked up at the end,
+ *   when we write the results, so sampling itself involves nothing more
+ *   than a walk up the frame chain and a hash lookup.  
+ */
+
+/* size of a frame identifier in a sample key */
+const size_t VMRUN_SAMPLE_FRAME_SIZE =
+    sizeof(const uchar *) + sizeof(vm_obj_id_t) + sizeof(vm_prop_id_t);
+
+/* sampling timer ticks since the last sample */
+volatile sig_atomic_t CVmRun::sample_ticks_ = 0;
+
+/*
+ *   Sample stack table hash function.  The keys are binary strings of
+ *   pointers and IDs, so we need something better than a simple byte sum
+ *   to spread them out.  This is the FNV-1a hash.  
+ */
+class CVmHashFuncSample: public CVmHashFunc
+{
+public:
+    unsigned int compute_hash(const char *str, size_t len) const
+    {
+        unsigned long h = 2166136261UL;
+        for ( ; len != 0 ; ++str, --len)
+        {
+            h ^= (uchar)*str;
+            h = (h * 16777619UL) & 0xFFFFFFFFUL;
+        }
+        return (unsigned int)h;
+    }
+};
+
+/*
+ *   Sample stack table entry 
+ */
+class CVmHashEntrySample: public CVmHashEntryCS
+{
+public:
+    CVmHashEntrySample(const char *str, size_t len)
+        : CVmHashEntryCS(str, len, TRUE)
+    {
+        /* no ticks yet */
+        ticks_ = 0;
+    }
+
+    /* the number of timer ticks recorded in this stack */
+    unsigned long ticks_;
+};
+
+/*
+ *   Frame name cache entry.  When writing the results, we look up each
+ *   distinct frame's name once, and keep it here for the other stacks
+ *   that contain the same frame.  
+ */
+class CVmHashEntrySampleName: public CVmHashEntryCS
+{
+public:
+    CVmHashEntrySampleName(const char *str, size_t len, const char *name)
+        : CVmHashEntryCS(str, len, TRUE)
+    {
+        name_ = lib_copy_str(name);
+    }
+
+    ~CVmHashEntrySampleName() { lib_free_str(name_); }
+
+    /* the display name of the function or method */
+    char *name_;
+};
+
+/*
+ *   Start sampling 
+ */
+int CVmRun::start_sampling(VMG_ const char *fname)
+{
+    /* if we're already sampling, stop the old session */
+    if (sample_table_ != 0)
+    {
+        os_prof_stop_timer();
+        delete sample_table_;
+        sample_table_ = 0;
+    }
+
+    /* remember the output file */
+    lib_free_str(sample_file_);
+    sample_file_ = lib_copy_str(fname);
+
+    /* create the stack table */
+    sample_table_ = new CVmHashTable(1024, new CVmHashFuncSample(), TRUE);
+
+    /* clear out any stray ticks, and start the timer */
+    sample_ticks_ = 0;
+    if (!os_prof_start_timer(VM_SAMPLE_INTERVAL_US, &CVmRun::sample_tick))
+    {
+        /* no timer - we can't sample */
+        delete sample_table_;
+        sample_table_ = 0;
+        return FALSE;
+    }
+
+    /* success */
+    return TRUE;
+}
+
+/*
+ *   Record a sample 
+ */
+void CVmRun::take_sample(VMG0_)
+{
+    char key[VM_SAMPLE_MAX_DEPTH * VMRUN_SAMPLE_FRAME_SIZE];
+    char *dst = key;
+    int depth;
+
+    /* 
+     *   Claim the ticks since the last sample.  A tick that arrives between
+     *   these two statements is lost, which is harmless for a statistical
+     *   profile. 
+     */
+    unsigned long ticks = (unsigned long)sample_ticks_;
+    sample_ticks_ = 0;
+
+    /* if we're not sampling (a stray tick after we stopped), ignore it */
+    if (sample_table_ == 0)
+        return;
+
+    /* build the key from the frame chain, innermost frame first */
+    vm_val_t *fp = frame_ptr_;
+    const uchar *ep = entry_ptr_native_;
+    for (depth = 0 ; fp != 0 && depth < VM_SAMPLE_MAX_DEPTH ; ++depth)
+    {
+        /* add this frame's identifying information */
+        vm_obj_id_t obj = get_defining_obj_from_frame(vmg_ fp);
+        vm_prop_id_t prop = get_target_prop_from_frame(vmg_ fp);
+        memcpy(dst, &ep, sizeof(ep));
+        memcpy(dst + sizeof(ep), &obj, sizeof(obj));
+        memcpy(dst + sizeof(ep) + sizeof(obj), &prop, sizeof(prop));
+        dst += VMRUN_SAMPLE_FRAME_SIZE;
+
+        /* move to the enclosing frame */
+        ep = get_enclosing_entry_ptr_from_frame(vmg_ fp);
+        fp = get_enclosing_frame_ptr(vmg_ fp);
+    }
+
+    /* if there's no byte code running, there's nothing to record */
+    if (dst == key)
+        return;
+
+    /* find or create the entry for this stack, and add in the ticks */
+    CVmHashEntrySample *entry =
+        (CVmHashEntrySample *)sample_table_->find(key, dst - key);
+    if (entry == 0)
+    {
+        entry = new CVmHashEntrySample(key, dst - key);
+        sample_table_->add(entry);
+    }
+    entry->ticks_ += ticks;
+}
+
+/* context for writing the sample file */
+struct vmrun_sample_enum
+{
+    /* globals object */
+    vm_globals *globals;
+
+    /* the global symbol table, if available */
+    const CVmRuntimeSymbols *symtab;
+
+    /* frame name cache */
+    CVmHashTable *names;
+
+    /* output file */
+    osfildef *fp;
+};
+
+/*
+ *   Get the display name of a sampled frame.  'frame' is the frame's
+ *   identifier from a sample key.  
+ */
+static const char *sample_frame_name(VMG_ vmrun_sample_enum *ctx,
+                                     const char *frame)
+{
+    const uchar *ep;
+    vm_obj_id_t obj;
+    vm_prop_id_t prop;
+    char buf[256];
+    const char *p;
+    size_t len;
+
+    /* if we've already named this frame, use the cached name */
+    CVmHashEntrySampleName *entry = (CVmHashEntrySampleName *)
+        ctx->names->find(frame, VMRUN_SAMPLE_FRAME_SIZE);
+    if (entry != 0)
+        return entry->name_;
+
+    /* decode the frame */
+    memcpy(&ep, frame, sizeof(ep));
+    memcpy(&obj, frame + sizeof(ep), sizeof(obj));
+    memcpy(&prop, frame + sizeof(ep) + sizeof(obj), sizeof(prop));
+
+    if (prop != VM_INVALID_PROP)
+    {
+        char *dst;
+
+        /* it's a method - start with the object name */
+        if (obj == VM_INVALID_OBJ)
+            strcpy(buf, "<System>");
+        else if (ctx->symtab != 0
+                 && (p = ctx->symtab->find_obj_name(vmg_ obj, &len)) != 0)
+        {
+            if (len > 120)
+                len = 120;
+            memcpy(buf, p, len);
+            buf[len] = '\0';
+        }
+        else
+            sprintf(buf, "obj#%lx", (long)obj);
+
+        /* add the property name */
+        dst = buf + strlen(buf);
+        *dst++ = '.';
+        if (ctx->symtab != 0
+            && (p = ctx->symtab->find_prop_name(vmg_ prop, &len)) != 0)
+        {
+            if (len > 120)
+                len = 120;
+            memcpy(dst, p, len);
+            dst[len] = '\0';
+        }
+        else
+            sprintf(dst, "prop#%x", (int)prop);
+    }
+    else
+    {
+        /* it's a function - get its function pointer value */
+        CVmFuncPtr func(ep);
+        vm_val_t val;
+        if (!func.get_fnptr(vmg_ &val))
+            val.set_nil();
+
+        /* look up the name */
+        p = 0;
+        switch (val.typ)
+        {
+        case VM_OBJ:
+            /* a dynamic code object */
+            if (ctx->symtab != 0)
+                p = ctx->symtab->find_obj_name(vmg_ val.val.obj, &len);
+            if (p == 0)
+                sprintf(buf, "DynamicFunc#%lx", (long)val.val.obj);
+            break;
+
+        case VM_FUNCPTR:
+        case VM_CODEOFS:
+            /* a static function - the symbol table has function pointers */
+            val.set_fnptr(val.val.ofs);
+            if (ctx->symtab != 0)
+                p = ctx->symtab->find_val_name(vmg_ &val, &len);
+            if (p == 0)
+                sprintf(buf, "func#%lx", (long)val.val.ofs);
+            break;
+
+        default:
+            strcpy(buf, "<System>");
+            break;
+        }
+
+        /* if we found a symbol, copy it */
+        if (p != 0)
+        {
+            if (len > sizeof(buf) - 1)
+                len = sizeof(buf) - 1;
+            memcpy(buf, p, len);
+            buf[len] = '\0';
+        }
+    }
+
+    /* cache the name */
+    entry = new CVmHashEntrySampleName(frame, VMRUN_SAMPLE_FRAME_SIZE, buf);
+    ctx->names->add(entry);
+
+    /* return the cached copy */
+    return entry->name_;
+}
+
+/*
+ *   Callback for writing the sampled stacks 
+ */
+void CVmRun::sample_enum_cb(void *ctx0, CVmHashEntry *entry0)
+{
+    vmrun_sample_enum *ctx = (vmrun_sample_enum *)ctx0;
+    VMGLOB_PTR(ctx->globals);
+    CVmHashEntrySample *entry = (CVmHashEntrySample *)entry0;
+    const char *key = entry->getstr();
+    size_t depth = entry->getlen() / VMRUN_SAMPLE_FRAME_SIZE;
+    char buf[32];
+
+    /* 
+     *   write the frames, outermost first, separated by semicolons - this
+     *   is the "folded" format that flame graph tools read 
+     */
+    while (depth != 0)
+    {
+        --depth;
+        os_fprintz(ctx->fp, sample_frame_name(
+            vmg_ ctx, key + depth * VMRUN_SAMPLE_FRAME_SIZE));
+        if (depth != 0)
+            os_fprintz(ctx->fp, ";");
+    }
+
+    /* add the tick count */
+    sprintf(buf, " %lu\n", entry->ticks_);
+    os_fprintz(ctx->fp, buf);
+}
+
+/*
+ *   End sampling and write the results 
+ */
+int CVmRun::end_sampling(VMG_ const CVmRuntimeSymbols *symtab)
+{
+    vmrun_sample_enum ctx;
+    int ok;
+
+    /* if we're not sampling, there's nothing to do */
+    if (sample_table_ == 0)
+        return TRUE;
+
+    /* stop the timer */
+    os_prof_stop_timer();
+
+    /* open the output file */
+    ctx.fp = osfopwt(sample_file_, OSFTTEXT);
+    if ((ok = (ctx.fp != 0)) != 0)
+    {
+        /* set up the rest of the context */
+        ctx.globals = VMGLOB_ADDR;
+        ctx.symtab = symtab;
+        ctx.names = new CVmHashTable(512, new CVmHashFuncSample(), TRUE);
+
+        /* write the stacks */
+        sample_table_->enum_entries(&sample_enum_cb, &ctx);
+
+        /* done with the file and the name cache */
+        osfcls(ctx.fp);
+        delete ctx.names;
+    }
+
+    /* we're done with the stack table */
+    delete sample_table_;
+    sample_table_ = 0;
+
+    /* return the status */
+    return ok;
+}
+
+/* ------------------------------------------------------------------------ */
+/*
+ *   Opcode statistics report 
+ */
+#ifdef VM_OPSTATS
+
+/*
+ *   Clear the opcode statistics 
+ */
+void CVmRun::reset_opstats()
+{
+    int i;
+
+    /* clear the counters */
+    memset(opstat_ops_, 0, 256 * sizeof(opstat_ops_[0]));
+    memset(opstat_meta_, 0,
+           256 * VM_OPSTAT_MAX_META * sizeof(opstat_meta_[0]));
+
+    /* 
+     *   Calibrate the overhead of timing an instruction, which is basically
+     *   the cost of one clock reading.  We subtract this from the measured
+     *   times in the report, since on a fast machine it can easily be
+     *   larger than the time for a simple instruction. 
+     */
+    const int cal_cnt = 10000;
+    unsigned long long start = vmrun_opstat_clock();
+    for (i = 0 ; i < cal_cnt ; ++i)
+        opstat_start_ = vmrun_opstat_clock();
+    opstat_overhead_ = (opstat_start_ - start) / cal_cnt;
+
+    /* we're not timing an instruction yet */
+    opstat_cur_op_ = 0;
+    opstat_cur_meta_ = -1;
+    opstat_start_ = vmrun_opstat_clock();
+}
+
+/*
+ *   Note the target of a property evaluation 
+ */
+void CVmRun::opstat_note_target(VMG_ const vm_val_t *target)
+{
+    CVmMetaclass *meta;
+
+    /* only count the first evaluation in each instruction */
+    if (opstat_cur_meta_ >= 0)
+        return;
+
+    /* get the metaclass of the target value */
+    switch (target->typ)
+    {
+    case VM_OBJ:
+        meta = vm_objp(vmg_ target->val.obj)->get_metaclass_reg();
+        break;
+
+    case VM_SSTRING:
+        meta = CVmObjString::metaclass_reg_;
+        break;
+
+    case VM_LIST:
+        meta = CVmObjList::metaclass_reg_;
+        break;
+
+    default:
+        /* other types don't have properties */
+        return;
+    }
+
+    /* note its registration index */
+    opstat_cur_meta_ = meta->get_reg_idx();
+    if (opstat_cur_meta_ >= VM_OPSTAT_MAX_META)
+        opstat_cur_meta_ = VM_OPSTAT_MAX_META - 1;
+}
+
+/* sorting context for the report */
+static const vm_opstat_rec *S_opstat_sort_recs;
+
+/* sort callback - order record indices by descending time */
+static int opstat_sort_cb(const void *a0, const void *b0)
+{
+    const vm_opstat_rec *a = &S_opstat_sort_recs[*(const int *)a0];
+    const vm_opstat_rec *b = &S_opstat_sort_recs[*(const int *)b0];
+    return a->ns > b->ns ? -1 : a->ns < b->ns ? 1 : 0;
+}
+
+/*
+ *   Write the opcode statistics report 
+ */
+int CVmRun::write_opstats(const char *fname)
+{
+    osfildef *fp;
+    char buf[256];
+    int *idx;
+    int cnt;
+    int i;
+    unsigned long long total_ns = 0;
+
+    /* charge the instruction in progress */
+    opstat_next(0);
+
+    /* open the file */
+    if ((fp = osfopwt(fname, OSFTTEXT)) == 0)
+        return FALSE;
+
+    /* 
+     *   net out the timing overhead from each record, and add up the total
+     *   time (the time charged to opcode 0 is the time outside of any
+     *   instruction, so leave that out) 
+     */
+    for (i = 0 ; i < 256 * VM_OPSTAT_MAX_META ; ++i)
+    {
+        vm_opstat_rec *r = &opstat_meta_[i];
+        unsigned long long ovh = r->cnt * opstat_overhead_;
+        r->ns = (r->ns > ovh ? r->ns - ovh : 0);
+    }
+    for (i = 1 ; i < 256 ; ++i)
+    {
+        vm_opstat_rec *r = &opstat_ops_[i];
+        unsigned long long ovh = r->cnt * opstat_overhead_;
+        r->ns = (r->ns > ovh ? r->ns - ovh : 0);
+        total_ns += r->ns;
+    }
+    if (total_ns == 0)
+        total_ns = 1;
+
+    /* allocate the sorting index (big enough for either table) */
+    idx = (int *)t3malloc(256 * VM_OPSTAT_MAX_META * sizeof(int));
+
+    /* write the header */
+    sprintf(buf, "T3 VM opcode statistics (times are net of a timing "
+            "overhead of %llu ns per instruction)\n\n",
+            opstat_overhead_);
+    os_fprintz(fp, buf);
+
+    /* sort and write the opcodes */
+    for (i = 1, cnt = 0 ; i < 256 ; ++i)
+    {
+        if (opstat_ops_[i].cnt != 0)
+            idx[cnt++] = i;
+    }
+    S_opstat_sort_recs = opstat_ops_;
+    qsort(idx, cnt, sizeof(idx[0]), &opstat_sort_cb);
+    os_fprintz(fp, "Opcode                        Count      Time (ms)"
+               "   ns/exec   %Time\n");
+    for (i = 0 ; i < cnt ; ++i)
+    {
+        const vm_opstat_rec *r = &opstat_ops_[idx[i]];
+        const char *name = CVmOpcodes::op_name[idx[i]];
+        char namebuf[16];
+
+        /* use the hex opcode for anything without a name */
+        if (name == 0)
+        {
+            sprintf(namebuf, "0x%02X", idx[i]);
+            name = namebuf;
+        }
+
+        sprintf(buf, "%-16s %16llu %14.3f %9.1f %6.2f%%\n",
+                name, r->cnt, r->ns / 1000000.0, (double)r->ns / r->cnt,
+                r->ns * 100.0 / total_ns);
+        os_fprintz(fp, buf);
+    }
+
+    /* 
+     *   sort and write the (opcode, metaclass) pairs, again leaving out
+     *   opcode 0, which represents evaluations outside of any instruction 
+     */
+    for (i = VM_OPSTAT_MAX_META, cnt = 0 ; i < 256 * VM_OPSTAT_MAX_META ;
+         ++i)
+    {
+        if (opstat_meta_[i].cnt != 0)
+            idx[cnt++] = i;
+    }
+    S_opstat_sort_recs = opstat_meta_;
+    qsort(idx, cnt, sizeof(idx[0]), &opstat_sort_cb);
+    os_fprintz(fp, "\nProperty evaluations by opcode and target metaclass\n"
+               "Opcode           Metaclass                           Count"
+               "      Time (ms)   ns/exec   %Time\n");
+    for (i = 0 ; i < cnt ; ++i)
+    {
+        const vm_opstat_rec *r = &opstat_meta_[idx[i]];
+        int op = idx[i] / VM_OPSTAT_MAX_META;
+        int m = idx[i] % VM_OPSTAT_MAX_META;
+        const char *name = CVmOpcodes::op_name[op];
+        char namebuf[16];
+        const char *meta_name;
+        int j;
+
+        /* find the metaclass name */
+        for (j = 0, meta_name = "(other)" ; G_meta_reg_table[j].meta != 0 ;
+             ++j)
+        {
+            if (j == m && m != VM_OPSTAT_MAX_META - 1)
+            {
+                meta_name = (*G_meta_reg_table[j].meta)->get_meta_name();
+                break;
+            }
+        }
+
+        /* use the hex opcode for anything without a name */
+        if (name == 0)
+        {
+            sprintf(namebuf, "0x%02X", op);
+            name = namebuf;
+        }
+
+        sprintf(buf, "%-16s %-28.28s %12llu %14.3f %9.1f %6.2f%%\n",
+                name, meta_name, r->cnt,
+                r->ns / 1000000.0, (double)r->ns / r->cnt,
+                r->ns * 100.0 / total_ns);
+        os_fprintz(fp, buf);
+    }
+
+    /* done */
+    t3free(idx);
+    osfcls(fp);
+    return TRUE;
+}
+
+#endif /* VM_OPSTATS */
+
 /* ------------------------------------------------------------------------ */
 /*
  *   Footnote - for the referring code, search the code above for
@@ -20,6 +20,7 @@ Modified
 #ifndef VMRUN_H
 #define VMRUN_H
 
+#include <signal.h>
 #include "vmglob.h"
 #include "vmtype.h"
 #include "vmstack.h"
@@ -1093,6 +1094,56 @@ public:
                                        unsigned long call_cnt),
                             void *cb_ctx);
 
+    /* -------------------------------------------------------------------- */
+    /*
+     *   Start the sampling profiler.  Unlike the instrumenting profiler
+     *   above, the sampling profiler is always part of the build, and costs
+     *   almost nothing when it isn't running.  An OS timer interrupts us
+     *   periodically; at the next function call or return, we record the
+     *   byte-code call stack, weighted by the number of timer ticks that
+     *   have elapsed.  When sampling ends, we write the stacks to 'fname' in
+     *   the "folded" format used by flame graph tools.
+     *   
+     *   Returns true on success, false if the OS doesn't provide a sampling
+     *   timer.  
+     */
+    int start_sampling(VMG_ const char *fname);
+
+    /* 
+     *   End sampling and write the sample file, using the given symbol
+     *   table (normally the image loader's run-time symbol table, which is
+     *   only present when the program was compiled with debugging
+     *   information) to name the functions and methods.  Returns true on
+     *   success, false if the file couldn't be written.  This does nothing
+     *   (and returns true) if we're not sampling.  
+     */
+    int end_sampling(VMG_ const class CVmRuntimeSymbols *symtab);
+
+    /* 
+     *   Count a sampling timer tick.  This is invoked from the OS timer
+     *   interrupt, so it can't do anything but bump the counter.  
+     */
+    static void sample_tick() { sample_ticks_ = sample_ticks_ + 1; }
+
+#ifdef VM_OPSTATS
+    /* -------------------------------------------------------------------- */
+    /*
+     *   Opcode statistics.  In builds with VM_OPSTATS defined (see
+     *   vmprof.h), we count every instruction executed and measure the time
+     *   spent in it, and we break down the property evaluation instructions
+     *   by the metaclass of the target value.  These statistics are meant
+     *   to show which instructions and intrinsic methods dominate a given
+     *   program's execution, and so which are worth optimizing.
+     *   
+     *   Write the report, sorted by cumulative time, to the given file.
+     *   Returns true on success, false if the file can't be written.  
+     */
+    int write_opstats(const char *fname);
+
+    /* clear the opcode statistics */
+    void reset_opstats();
+#endif /* VM_OPSTATS */
+
     /* get the last program counter address */
     VM_REG_ACCESS const uchar *get_last_pc() VM_REG_CONST
         { return pc_ptr_ != 0 ? *pc_ptr_ : 0; }
@@ -1462,6 +1513,23 @@ protected:
     /* hash table enumeration callback for dumping profiler data */
     static void prof_enum_cb(void *ctx0, class CVmHashEntry *entry0);
 
+    /* record a sample of the call stack for the sampling profiler */
+    void take_sample(VMG0_);
+
+    /* hash table enumeration callback for writing sampling profiler data */
+    static void sample_enum_cb(void *ctx0, class CVmHashEntry *entry0);
+
+#ifdef VM_OPSTATS
+    /* 
+     *   charge the time since the last instruction began to that
+     *   instruction, and start timing the instruction 'op' 
+     */
+    inline void opstat_next(uint op);
+
+    /* note the target value of a property evaluation instruction */
+    void opstat_note_target(VMG_ const vm_val_t *target);
+#endif /* VM_OPSTATS */
+
     /* validate the built-in function pointer at top of stack */
     void validate_bifptr(VMG0_);
 
@@ -1547,6 +1615,47 @@ protected:
      *   entrypoint code offset for a function) 
      */
     class CVmHashTable *prof_master_table_;
+
+    /* 
+     *   Number of sampling profiler timer ticks since the last sample.  The
+     *   OS timer interrupt increments this; we check it on each function
+     *   call and return, and record a sample when it's non-zero.  
+     */
+    static volatile sig_atomic_t sample_ticks_;
+
+    /* 
+     *   sampling profiler stack table - one entry per distinct call stack
+     *   observed, keyed by the stack's frame identifiers, with the number
+     *   of ticks recorded in the stack (null when we're not sampling) 
+     */
+    class CVmHashTable *sample_table_;
+
+    /* sampling profiler output file name */
+    char *sample_file_;
+
+#ifdef VM_OPSTATS
+    /* per-opcode statistics, indexed by opcode */
+    struct vm_opstat_rec *opstat_ops_;
+
+    /* 
+     *   per-(opcode, metaclass) statistics, indexed by opcode times
+     *   VM_OPSTAT_MAX_META plus the metaclass registration index 
+     */
+    struct vm_opstat_rec *opstat_meta_;
+
+    /* the instruction we're currently timing, and its start time */
+    uint opstat_cur_op_;
+    unsigned long long opstat_start_;
+
+    /* 
+     *   metaclass index of the current instruction's property evaluation
+     *   target, or -1 if it hasn't evaluated a property 
+     */
+    int opstat_cur_meta_;
+
+    /* calibrated overhead of timing one instruction, in nanoseconds */
+    unsigned long long opstat_overhead_;
+#endif /* VM_OPSTATS */
 };
 
 #endif /* VMRUN_H */
@@ -33,8 +33,18 @@ Modified
  *.    <? bytes>   - image file name; length given by preceding UINT2
  *.    UINT2       - number of bytes in metadata table
  *.    <? bytes>   - metadata table
+ *.    UINT2       - flags (VMSAVEFILE_FLAG_xxx)
  *.    <? bytes>   - object stream data
  *   
+ *   If the VMSAVEFILE_FLAG_LZ flag is set, the object stream data is
+ *   compressed, in the format described in vmlz.h.  The stream size and
+ *   checksum in the header cover the data as stored in the file, so we can
+ *   check them without decompressing anything.
+ *   
+ *   Version 000A files have the same layout, except that they have no flags
+ *   field, and the object stream data is never compressed.  We can still
+ *   restore these.
+ *   
  *   The metadata table contains any number of name/value string pairs.
  *   These are arbitrary values that allow the game to store descriptive
  *   information about the saved game that the interpreter and other tools
@@ -66,6 +76,7 @@ Modified
 #include "vmundo.h"
 #include "vmmeta.h"
 #include "vmcrc.h"
+#include "vmlz.h"
 #include "vmlookup.h"
 #include "vmstr.h"
 
@@ -88,7 +99,16 @@ Modified
  *   positions as a precaution against later getting into unwinnable
  *   states).  
  */
-#define VMSAVEFILE_SIG "T3-state-v000A\015\012\032"
+#define VMSAVEFILE_SIG "T3-state-v000B\015\012\032"
+
+/* 
+ *   The previous version's signature.  Version 000B only adds the flags
+ *   field, so we can still read these files. 
+ */
+#define VMSAVEFILE_SIG_000A "T3-state-v000A\015\012\032"
+
+/* saved state flags */
+#define VMSAVEFILE_FLAG_LZ  0x0001      /* object stream data is compressed */
 
 
 /* ------------------------------------------------------------------------ */
@@ -237,11 +257,48 @@ void CVmSaveFile::save(VMG_ CVmFile *fp, CVmObjLookupTable *metatab)
         fp->write_uint2(0);
     }
 
-    /* save all modified object state */
-    G_obj_table->save(vmg_ fp);
+    /* write the flags - we always compress the object stream */
+    fp->write_uint2(VMSAVEFILE_FLAG_LZ);
 
-    /* save the synthesized exports */
-    G_image_loader->save_synth_exports(vmg_ fp);
+    /* 
+     *   Save the object state and synthesized exports.  The writers for
+     *   these go back and fix up sizes as they go, which a compressed
+     *   stream can't do, so we write them to a memory stream first, then
+     *   compress the memory stream's contents into the file.  
+     */
+    CVmExpandableMemoryStream *memstr =
+        new CVmExpandableMemoryStream(64*1024);
+    CVmFile *memfp = 0;
+    CVmLZWriteStream *lzstr = 0;
+    err_try
+    {
+        /* save the object state and synthesized exports */
+        memfp = new CVmFile(memstr);
+        save_state(vmg_ memfp);
+
+        /* compress it all into the file */
+        lzstr = new CVmLZWriteStream(fp);
+        memstr->set_seek_pos(0);
+        for (;;)
+        {
+            char buf[4096];
+            size_t len = memstr->read_nbytes(buf, sizeof(buf));
+            if (len == 0)
+                break;
+            lzstr->write_bytes(buf, len);
+        }
+        lzstr->finish();
+    }
+    err_finally
+    {
+        /* done with the streams */
+        if (lzstr != 0)
+            delete lzstr;
+        if (memfp != 0)
+            delete memfp;
+        delete memstr;
+    }
+    err_end;
 
     /* remember where the file ends */
     long endpos = fp->get_pos();
@@ -274,6 +331,19 @@ void CVmSaveFile::save(VMG_ CVmFile *fp, CVmObjLookupTable *metatab)
     fp->set_pos(endpos);
 }
 
+/*
+ *   Save the object stream data: the modified object state and the
+ *   synthesized exports 
+ */
+void CVmSaveFile::save_state(VMG_ CVmFile *fp)
+{
+    /* save all modified object state */
+    G_obj_table->save(vmg_ fp);
+
+    /* save the synthesized exports */
+    G_image_loader->save_synth_exports(vmg_ fp);
+}
+
 /* ------------------------------------------------------------------------ */
 /*
  *   Given a saved state file, get the name of the image file that was
@@ -287,8 +357,9 @@ int CVmSaveFile::restore_get_image(osfildef *fp,
     if (osfrb(fp, buf, sizeof(VMSAVEFILE_SIG)-1 + 8 + 24))
         return VMERR_READ_FILE;
 
-    /* check the signature */
-    if (memcmp(buf, VMSAVEFILE_SIG, sizeof(VMSAVEFILE_SIG)-1) != 0)
+    /* check the signature - we can read the current and prior versions */
+    if (memcmp(buf, VMSAVEFILE_SIG, sizeof(VMSAVEFILE_SIG)-1) != 0
+        && memcmp(buf, VMSAVEFILE_SIG_000A, sizeof(VMSAVEFILE_SIG)-1) != 0)
         return VMERR_NOT_SAVED_STATE;
 
     /* read the length of the image file name */
@@ -320,15 +391,18 @@ int CVmSaveFile::restore_get_image(osfildef *fp,
  */
 int CVmSaveFile::restore(VMG_ CVmFile *fp)
 {
-    /* we don't have a fixup table yet (the object loader will create one) */
-    CVmObjFixup *fixups = 0;
-
     /* read the file's signature */
     char buf[128];
     fp->read_bytes(buf, sizeof(VMSAVEFILE_SIG)-1);
 
-    /* check the signature */
-    if (memcmp(buf, VMSAVEFILE_SIG, sizeof(VMSAVEFILE_SIG)-1) != 0)
+    /* 
+     *   check the signature - we can read the current and prior versions;
+     *   note which one this is, since the prior version has no flags 
+     */
+    int has_flags = (memcmp(buf, VMSAVEFILE_SIG,
+                            sizeof(VMSAVEFILE_SIG)-1) == 0);
+    if (!has_flags
+        && memcmp(buf, VMSAVEFILE_SIG_000A, sizeof(VMSAVEFILE_SIG)-1) != 0)
         return VMERR_NOT_SAVED_STATE;
 
     /* read the size/checksum fields */
@@ -370,6 +444,50 @@ int CVmSaveFile::restore(VMG_ CVmFile *fp)
      */
     fp->set_pos_from_cur(fp->read_int2());
 
+    /* read the flags, if present; reject any flags we don't know about */
+    uint flags = (has_flags ? fp->read_uint2() : 0);
+    if ((flags & ~VMSAVEFILE_FLAG_LZ) != 0)
+        return VMERR_BAD_SAVED_STATE;
+
+    /* 
+     *   if the object stream is compressed, read it through a decompressor,
+     *   which expands the data incrementally as the loaders read it 
+     */
+    CVmLZReadStream *lzstr = 0;
+    CVmFile *objfp = fp;
+    if ((flags & VMSAVEFILE_FLAG_LZ) != 0)
+    {
+        lzstr = new CVmLZReadStream(fp);
+        objfp = new CVmFile(lzstr);
+    }
+
+    /* read the object stream data */
+    int err = restore_state(vmg_ objfp);
+
+    /* done with the decompressor */
+    if (lzstr != 0)
+    {
+        delete objfp;
+        delete lzstr;
+    }
+
+    /* if any error occurred, throw the error */
+    if (err != 0)
+        err_throw(err);
+
+    /* success */
+    return 0;
+}
+
+/*
+ *   Restore the object stream data.  Returns zero on success, or a
+ *   VMERR_xxx code on failure. 
+ */
+int CVmSaveFile::restore_state(VMG_ CVmFile *fp)
+{
+    /* we don't have a fixup table yet (the object loader will create one) */
+    CVmObjFixup *fixups = 0;
+
     /* 
      *   discard all undo information - any undo information we currently
      *   have obviously can't be applied to the restored state 
@@ -428,9 +546,9 @@ int CVmSaveFile::restore(VMG_ CVmFile *fp)
     /* restore the garbage collector's enabled state */
     G_obj_table->enable_gc(vmg_ old_gc_enabled);
 
-    /* if any error occurred, throw the error */
+    /* if an error occurred, return it */
     if (err != 0)
-        err_throw(err);
+        return err;
 
     /* 
      *   explicitly run garbage collection, since any dynamic objects that
@@ -450,6 +568,33 @@ int CVmSaveFile::restore(VMG_ CVmFile *fp)
  */
 void CVmSaveFile::reset(VMG0_)
 {
+    /* 
+     *   If we've already reset once, we have a snapshot of the state as of
+     *   the end of the reset, so we can simply restore that.  That skips
+     *   re-linking and running the static initializers, and restoring only
+     *   has to touch the objects that changed since the snapshot.  
+     */
+    CVmStream *snapshot = G_image_loader->get_restart_state();
+    if (snapshot != 0)
+    {
+        /* restore the snapshot, reading from the start of the stream */
+        CVmFile *fp = new CVmFile(snapshot);
+        snapshot->set_seek_pos(0);
+        int err = restore_state(vmg_ fp);
+        delete fp;
+
+        /* if that worked, we're done */
+        if (err == 0)
+            return;
+
+        /* 
+         *   The snapshot couldn't be restored, which should never happen.
+         *   Discard it, and do a full reset instead, which leaves us with a
+         *   usable state no matter how far the restore got.  
+         */
+        G_image_loader->set_restart_state(0);
+    }
+
     /* 
      *   discard undo information, since it applies only to the current VM
      *   state and obviously is no longer relevant after we reset to the
@@ -509,5 +654,36 @@ void CVmSaveFile::reset(VMG0_)
 
     /* run the static initializers */
     G_image_loader->run_static_init(vmg0_);
-}
 
+    /* 
+     *   Take a snapshot of the initial state for the next reset.  This is
+     *   the same thing as a saved game, minus the file header, so it only
+     *   has to hold the objects that differ from the image file.  We don't
+     *   compress it, since it stays in memory, and it's small to begin
+     *   with: in a typical game, preinit has already done most of the
+     *   startup work, and its results are in the image file.  
+     */
+    CVmExpandableMemoryStream *memstr =
+        new CVmExpandableMemoryStream(64*1024);
+    CVmFile *memfp = new CVmFile(memstr);
+    err_try
+    {
+        /* save the state, and hand the stream over to the image loader */
+        save_state(vmg_ memfp);
+        G_image_loader->set_restart_state(memstr);
+        memstr = 0;
+    }
+    err_catch_disc
+    {
+        /* 
+         *   we couldn't take the snapshot; that's not fatal, since it only
+         *   means that the next reset will be a full one again 
+         */
+    }
+    err_end;
+
+    /* done with the file; delete the stream if we didn't hand it over */
+    delete memfp;
+    if (memstr != 0)
+        delete memstr;
+}
@@ -58,10 +58,17 @@ public:
      */
     static int restore(VMG_ class CVmFile *fp);
 
-    /* reset the VM to the initial image file state */
+    /* 
+     *   Reset the VM to the initial image file state.  The first reset
+     *   leaves a snapshot of the resulting state with the image loader, and
+     *   later resets simply restore the snapshot.  
+     */
     static void reset(VMG0_);
 
 protected:
+    /* save/restore the object stream data, without the file header */
+    static void save_state(VMG_ class CVmFile *fp);
+    static int restore_state(VMG_ class CVmFile *fp);
 };
 
 #endif /* VMSAVE_H */
@@ -106,6 +106,115 @@ int (*CVmObjString::func_table_[])(VMG_ vm_val_t *retval,
 /* static property indices */
 const int PROPIDX_packBytes = 20;
 
+/* ------------------------------------------------------------------------ */
+/*
+ *   String character index cache 
+ */
+
+/*
+ *   delete 
+ */
+CVmStrIndexCache::~CVmStrIndexCache()
+{
+    /* free the checkpoint arrays */
+    for (int i = 0 ; i < VMSTR_INDEX_SIZE ; ++i)
+        clear(&ents_[i]);
+}
+
+/*
+ *   clear an entry 
+ */
+void CVmStrIndexCache::clear(vmstr_index_entry *e)
+{
+    if (e->ckpt != 0)
+        t3free(e->ckpt);
+    e->ckpt = 0;
+    e->str = 0;
+}
+
+/*
+ *   Build the index for a string, replacing whatever was in the entry
+ *   before.  We scan the text once, counting characters and recording a
+ *   checkpoint every VMSTR_INDEX_STRIDE characters.  If it turns out that
+ *   every character was a single byte, the checkpoints are just multiples
+ *   of the stride, so we discard them and mark the string as ASCII.  
+ */
+const vmstr_index_entry *CVmStrIndexCache::build(vmstr_index_entry *e,
+                                                 const char *str)
+{
+    /* drop the old entry */
+    clear(e);
+
+    /* get the text */
+    size_t bytelen = vmb_get_len(str);
+    const char *start = str + VMB_LEN;
+    const char *end = start + bytelen;
+
+    /* 
+     *   allocate the checkpoint array - there can't be more characters than
+     *   bytes, so allow for the worst case 
+     */
+    uint16_t *ckpt = (uint16_t *)t3malloc(
+        (bytelen / VMSTR_INDEX_STRIDE + 1) * sizeof(uint16_t));
+
+    /* scan the text */
+    size_t charlen;
+    const char *p;
+    int ascii = TRUE;
+    for (p = start, charlen = 0 ; p < end ; ++charlen)
+    {
+        /* record a checkpoint at each stride */
+        if (charlen % VMSTR_INDEX_STRIDE == 0)
+            ckpt[charlen / VMSTR_INDEX_STRIDE] = (uint16_t)(p - start);
+
+        /* skip this character, noting if it's multi-byte */
+        size_t csiz = utf8_ptr::s_charsize(*p);
+        if (csiz != 1)
+            ascii = FALSE;
+        p += csiz;
+    }
+
+    /* add the checkpoint for the end position if it falls on a stride */
+    if (charlen % VMSTR_INDEX_STRIDE == 0)
+        ckpt[charlen / VMSTR_INDEX_STRIDE] = (uint16_t)bytelen;
+
+    /* an ASCII string doesn't need the checkpoints */
+    if (ascii)
+    {
+        t3free(ckpt);
+        ckpt = 0;
+    }
+
+    /* fill in the entry */
+    e->str = str;
+    e->bytelen = bytelen;
+    e->charlen = charlen;
+    e->ascii = ascii;
+    e->ckpt = ckpt;
+
+    /* return the new entry */
+    return e;
+}
+
+/*
+ *   Forget the index for a string buffer that's about to be freed or
+ *   reallocated.  
+ */
+static inline void str_index_forget(VMG_ const char *str)
+{
+    if (G_str_index != 0)
+        G_str_index->forget(str);
+}
+
+/*
+ *   Get the index for a string, if it's long enough to be worth indexing. 
+ */
+static inline const vmstr_index_entry *str_index_get(VMG_ const char *str)
+{
+    return G_str_index != 0 ? G_str_index->get(str) : 0;
+}
+
+
 /* ------------------------------------------------------------------------ */
 /*
  *   Static creation methods 
@@ -350,6 +459,7 @@ char *CVmObjString::cons_ensure_space(VMG_ char *ptr, size_t len,
 
     /* expand to the needed size plus the margin */
     size_t newlen = need + margin;
+    str_index_forget(vmg_ ext_);
     ext_ = (char *)G_mem->get_var_heap()->realloc_mem(
         newlen + VMB_LEN, ext_, this);
 
@@ -408,6 +518,7 @@ void CVmObjString::cons_shrink_buffer(VMG_ char *ptr)
     if (vmb_get_len(ext_) - siz >= 256)
     {
         /* reallocate at the new size */
+        str_index_forget(vmg_ ext_);
         ext_ = (char *)G_mem->get_var_heap()->realloc_mem(
             siz + VMB_LEN, ext_, this);
     }
@@ -426,7 +537,10 @@ void CVmObjString::notify_delete(VMG_ int in_root_set)
 {
     /* free our extension */
     if (ext_ != 0 && !in_root_set)
+    {
+        str_index_forget(vmg_ ext_);
         G_mem->get_var_heap()->free_mem(ext_);
+    }
 }
 
 /* ------------------------------------------------------------------------ */
@@ -470,11 +584,12 @@ void CVmObjString::set_prop(VMG_ CVmUndo *, vm_obj_id_t,
  */
 void CVmObjString::save_to_file(VMG_ CVmFile *fp)
 {
-    /* get our length */
-    size_t len = vmb_get_len(ext_);
+    /* get our text and its length */
+    const char *str = get_as_string(vmg0_);
+    size_t len = vmb_get_len(str);
 
     /* write the length prefix and the string */
-    fp->write_bytes(ext_, len + VMB_LEN);
+    fp->write_bytes(str, len + VMB_LEN);
 }
 
 /*
@@ -489,6 +604,7 @@ void CVmObjString::restore_from_file(VMG_ vm_obj_id_t,
     /* free any existing extension */
     if (ext_ != 0)
     {
+        str_index_forget(vmg_ ext_);
         G_mem->get_var_heap()->free_mem(ext_);
         ext_ = 0;
     }
@@ -518,7 +634,8 @@ long CVmObjString::cast_to_int(VMG0_) const
      *   explicit int cast, so don't allow BigNumber promotions 
      */
     vm_val_t val;
-    parse_num_val(vmg_ &val, ext_ + VMB_LEN, vmb_get_len(ext_), 10, TRUE);
+    const char *str = get_as_string(vmg0_);
+    parse_num_val(vmg_ &val, str + VMB_LEN, vmb_get_len(str), 10, TRUE);
 
     /* return the integer value */
     return val.val.intval;
@@ -534,7 +651,8 @@ void CVmObjString::cast_to_num(VMG_ vm_val_t *val, vm_obj_id_t self) const
      *   return whatever numeric type is needed to represent the value, so
      *   allow BigNumber promotions if necessary. 
      */
-    parse_num_val(vmg_ val, ext_ + VMB_LEN, vmb_get_len(ext_), 10, FALSE);
+    const char *str = get_as_string(vmg0_);
+    parse_num_val(vmg_ val, str + VMB_LEN, vmb_get_len(str), 10, FALSE);
 }
 
 /*
@@ -721,7 +839,9 @@ int CVmObjString::add_val(VMG_ vm_val_t *result,
  *   
  *   Note that we *always* create a new object to hold the result, even if
  *   the new string is identical to the first, so that we consistently
- *   return a distinct reference from the original.  
+ *   return a distinct reference from the original.  If the result is at
+ *   least VMSTR_ROPE_MIN bytes long, the new object is a rope that refers
+ *   to the two operands, rather than a copy of their text.  
  */
 void CVmObjString::add_to_str(VMG_ vm_val_t *result,
                               const vm_val_t *self, const vm_val_t *val)
@@ -734,16 +854,32 @@ void CVmObjString::add_to_str(VMG_ vm_val_t *result,
     vm_val_t new_obj2;
 
     /* 
-     *   Get the string buffer pointers.  The left value is already a string,
-     *   or we wouldn't be here.  The right value can be anything, though, so
-     *   we need to apply an implicit string conversion if it's another type.
+     *   Get the length of the left value.  This is already a string, or we
+     *   wouldn't be here, but it might be a rope, so get the length without
+     *   flattening it.  
      */
-    strval1 = self->get_as_string(vmg0_);
-    strval2 = cvt_to_str(vmg_ &new_obj2, buf, sizeof(buf), val, 10, 0);
+    len1 = CVmObjStringRope::get_val_len(vmg_ self);
 
-    /* get the lengths of the two strings */
-    len1 = vmb_get_len(strval1);
-    len2 = vmb_get_len(strval2);
+    /* 
+     *   Get the right value's string buffer.  This can be anything, so we
+     *   need to apply an implicit string conversion if it's another type.
+     *   If it's a rope, though, leave it as it is - we'll just build a new
+     *   rope node on top of it.  
+     */
+    if (CVmObjStringRope::get_val_rope(vmg_ val) != 0)
+    {
+        strval2 = 0;
+        new_obj2.set_nil();
+        len2 = CVmObjStringRope::get_val_len(vmg_ val);
+    }
+    else
+    {
+        strval2 = cvt_to_str(vmg_ &new_obj2, buf, sizeof(buf), val, 10, 0);
+        len2 = vmb_get_len(strval2);
+    }
+
+    /* note if the right value is already a string (constant or object) */
+    int val_is_str = (strval2 == 0 || val->get_as_string(vmg0_) != 0);
 
     /*
      *   If the right-hand value is zero length, or it's nil, simply return
@@ -757,7 +893,7 @@ void CVmObjString::add_to_str(VMG_ vm_val_t *result,
         /* we're appending nothing to the string; just return 'self' */
         *result = *self;
     }
-    else if (len1 == 0 && val->get_as_string(vmg0_) != 0)
+    else if (len1 == 0 && val_is_str)
     {
         /* 
          *   we're appending the right value to an empty string, AND the
@@ -766,8 +902,47 @@ void CVmObjString::add_to_str(VMG_ vm_val_t *result,
          */
         *result = *val;
     }
+    else if (len1 + len2 >= VMSTR_ROPE_MIN)
+    {
+        vm_val_t right;
+
+        /* make sure the result is within the string length limit */
+        if (len1 + len2 > 65535)
+            err_throw(VMERR_STR_TOO_LONG);
+
+        /* protect 'self' and the converted value from garbage collection */
+        G_stk->push(self);
+        G_stk->push(&new_obj2);
+
+        /* 
+         *   The result is long enough that copying it could get expensive
+         *   if we're being called in a loop, so build a rope instead.  The
+         *   right operand is the original value if it's a string, otherwise
+         *   the converted string, which we might have to turn into an
+         *   object if the conversion only used our temporary buffer.  
+         */
+        if (val_is_str)
+            right = *val;
+        else if (new_obj2.typ == VM_OBJ)
+            right = new_obj2;
+        else
+            right.set_obj(create(vmg_ FALSE, strval2 + VMB_LEN, len2));
+
+        /* create the rope, protecting the right operand while we work */
+        G_stk->push(&right);
+        result->set_obj(CVmObjStringRope::create(vmg_ self, &right));
+
+        /* we're done with the garbage collection protection */
+        G_stk->discard(3);
+    }
     else
     {
+        /* 
+         *   the result is short, so neither value is a rope; get the left
+         *   value's string buffer 
+         */
+        strval1 = self->get_as_string(vmg0_);
+
         /* 
          *   push the new string (if any) and self, to protect the two
          *   strings from garbage collection 
@@ -792,6 +967,202 @@ void CVmObjString::add_to_str(VMG_ vm_val_t *result,
 }
 
 
+/* ------------------------------------------------------------------------ */
+/*
+ *   Rope strings 
+ */
+
+/*
+ *   allocate the rope extension 
+ */
+vmstr_rope_ext *vmstr_rope_ext::alloc_ext(VMG_ CVmObjStringRope *self,
+                                          const vm_val_t *left,
+                                          const vm_val_t *right,
+                                          size_t len, uint depth)
+{
+    /* allocate the memory */
+    vmstr_rope_ext *ext = (vmstr_rope_ext *)G_mem->get_var_heap()->alloc_mem(
+        sizeof(vmstr_rope_ext), self);
+
+    /* we haven't been flattened yet */
+    ext->flat = 0;
+
+    /* remember the operands, the total length, and the tree depth */
+    ext->left = *left;
+    ext->right = *right;
+    ext->len = len;
+    ext->depth = depth;
+
+    /* return the new extension */
+    return ext;
+}
+
+/*
+ *   create 
+ */
+vm_obj_id_t CVmObjStringRope::create(VMG_ const vm_val_t *left,
+                                     const vm_val_t *right)
+{
+    /* get the operands' rope extensions, if they're unflattened ropes */
+    vmstr_rope_ext *lr = get_val_rope(vmg_ left);
+    vmstr_rope_ext *rr = get_val_rope(vmg_ right);
+
+    /* figure the depth of the new tree */
+    uint ldepth = (lr != 0 ? lr->depth : 0);
+    uint rdepth = (rr != 0 ? rr->depth : 0);
+    uint depth = (ldepth > rdepth ? ldepth : rdepth) + 1;
+
+    /* figure the total length */
+    size_t len = get_val_len(vmg_ left) + get_val_len(vmg_ right);
+
+    /* 
+     *   create the object - unlike an ordinary string, we reference the
+     *   operand objects 
+     */
+    vm_obj_id_t id = vm_new_id(vmg_ FALSE, TRUE, FALSE);
+    new (vmg_ id) CVmObjStringRope(vmg_ left, right, len, depth);
+    return id;
+}
+
+/*
+ *   construct 
+ */
+CVmObjStringRope::CVmObjStringRope(VMG_ const vm_val_t *left,
+                                   const vm_val_t *right,
+                                   size_t len, uint depth)
+{
+    ext_ = (char *)vmstr_rope_ext::alloc_ext(
+        vmg_ this, left, right, len, depth);
+}
+
+/*
+ *   receive notification of deletion 
+ */
+void CVmObjStringRope::notify_delete(VMG_ int in_root_set)
+{
+    vmstr_rope_ext *r = (vmstr_rope_ext *)ext_;
+
+    /* free the flattened buffer, if any, and the extension */
+    if (r != 0 && !in_root_set)
+    {
+        if (r->flat != 0)
+        {
+            str_index_forget(vmg_ r->flat);
+            G_mem->get_var_heap()->free_mem(r->flat);
+        }
+        G_mem->get_var_heap()->free_mem(r);
+    }
+}
+
+/*
+ *   mark references 
+ */
+void CVmObjStringRope::mark_refs(VMG_ uint state)
+{
+    vmstr_rope_ext *r = (vmstr_rope_ext *)ext_;
+
+    /* 
+     *   mark the operands, if they're objects (they'll be nil once we've
+     *   been flattened) 
+     */
+    if (r->left.typ == VM_OBJ)
+        G_obj_table->mark_all_refs(r->left.val.obj, state);
+    if (r->right.typ == VM_OBJ)
+        G_obj_table->mark_all_refs(r->right.val.obj, state);
+}
+
+/*
+ *   Flatten the rope.  We build the full text into a new buffer, which
+ *   becomes our string value from now on, then forget our operands.  
+ */
+const char *CVmObjStringRope::flatten(VMG0_) const
+{
+    vmstr_rope_ext *r = (vmstr_rope_ext *)ext_;
+
+    /* allocate the buffer and set its length prefix */
+    char *buf = (char *)G_mem->get_var_heap()->alloc_mem(
+        r->len + VMB_LEN, (CVmObject *)this);
+    vmb_put_len(buf, r->len);
+
+    /* copy the text of the whole tree */
+    copy_flat(vmg_ r, buf + VMB_LEN);
+
+    /* 
+     *   this is our text from now on; we no longer need the operands, so
+     *   let them go 
+     */
+    r->flat = buf;
+    r->left.set_nil();
+    r->right.set_nil();
+
+    /* return the flattened string */
+    return buf;
+}
+
+/*
+ *   Copy the text of a rope tree into a buffer.  A chain of appends builds
+ *   a tree that's as deep as it is long, so we can't simply recurse into
+ *   both sides.  Instead, we copy flat operands directly, recurse into the
+ *   shallower rope operand, and loop on the deeper one.  Since a subtree
+ *   has to contain at least 2^d nodes for both of its sides to be at
+ *   least d deep, this keeps the recursion depth logarithmic in the size
+ *   of the tree.  
+ */
+void CVmObjStringRope::copy_flat(VMG_ const vmstr_rope_ext *r, char *dst)
+{
+    for (;;)
+    {
+        /* get the operands' rope extensions, if they're unflattened */
+        vmstr_rope_ext *lr = get_val_rope(vmg_ &r->left);
+        vmstr_rope_ext *rr = get_val_rope(vmg_ &r->right);
+
+        /* figure where the right operand's text goes */
+        const char *lstr = (lr == 0 ? r->left.get_as_string(vmg0_) : 0);
+        char *rdst = dst + (lr != 0 ? lr->len : vmb_get_len(lstr));
+
+        /* copy the flat operands directly */
+        if (lr == 0)
+            memcpy(dst, lstr + VMB_LEN, vmb_get_len(lstr));
+        if (rr == 0)
+        {
+            const char *rstr = r->right.get_as_string(vmg0_);
+            memcpy(rdst, rstr + VMB_LEN, vmb_get_len(rstr));
+        }
+
+        /* continue with the rope operands */
+        if (lr == 0 && rr == 0)
+        {
+            /* both operands were flat, so we're done */
+            return;
+        }
+        else if (rr == 0)
+        {
+            /* only the left side is a rope - continue with it */
+            r = lr;
+        }
+        else if (lr == 0)
+        {
+            /* only the right side is a rope - continue with it */
+            r = rr;
+            dst = rdst;
+        }
+        else if (lr->depth >= rr->depth)
+        {
+            /* recurse into the shallower right side, then do the left */
+            copy_flat(vmg_ rr, rdst);
+            r = lr;
+        }
+        else
+        {
+            /* recurse into the shallower left side, then do the right */
+            copy_flat(vmg_ lr, dst);
+            r = rr;
+            dst = rdst;
+        }
+    }
+}
+
+
 /* ------------------------------------------------------------------------ */
 /*
  *   Allocate a string buffer large enough to hold a given value.  We'll
@@ -1088,7 +1459,7 @@ int CVmObjString::equals(VMG_ vm_obj_id_t self,
      *   use the constant string comparison routine, using our underlying
      *   string as the constant string data 
      */
-    return const_equals(vmg_ ext_, val);
+    return const_equals(vmg_ get_as_string(vmg0_), val);
 }
 
 /*
@@ -1127,7 +1498,7 @@ int CVmObjString::const_equals(VMG_ const char *str, const vm_val_t *val)
  */
 uint CVmObjString::calc_hash(VMG_ vm_obj_id_t self, int /*depth*/) const
 {
-    return const_calc_hash(ext_);
+    return const_calc_hash(get_as_string(vmg0_));
 }
 
 /*
@@ -1160,7 +1531,7 @@ int CVmObjString::compare_to(VMG_ vm_obj_id_t /*self*/,
                              const vm_val_t *val) const
 {
     /* use the static string magnitude comparison routine */
-    return const_compare(vmg_ ext_, val);
+    return const_compare(vmg_ get_as_string(vmg0_), val);
 }
 
 /*
@@ -1425,7 +1796,8 @@ int CVmObjString::get_prop(VMG_ vm_prop_id_t prop, vm_val_t *retval,
     
     /* use the constant evaluator */
     self_val.set_obj(self);
-    if (const_get_prop(vmg_ retval, &self_val, ext_, prop, source_obj, argc))
+    if (const_get_prop(vmg_ retval, &self_val, get_as_string(vmg0_),
+                       prop, source_obj, argc))
     {
         *source_obj = metaclass_reg_->get_class_obj(vmg0_);
         return TRUE;
@@ -1486,6 +1858,14 @@ int CVmObjString::getp_len(VMG_ vm_val_t *retval, const vm_val_t *self_val,
     if (get_prop_check_argc(retval, argc, &desc))
         return TRUE;
 
+    /* if the string is indexed, the index has the character length */
+    const vmstr_index_entry *ix = str_index_get(vmg_ str);
+    if (ix != 0)
+    {
+        retval->set_int(ix->charlen);
+        return TRUE;
+    }
+
     /* set up a utf-8 pointer to the string's contents */
     utf8_ptr p;
     p.set((char *)str + VMB_LEN);
@@ -1529,6 +1909,38 @@ int CVmObjString::getp_substr(VMG_ vm_val_t *retval, const vm_val_t *self_val,
     /* push a self-reference to protect against GC */
     G_stk->push(self_val);
 
+    /* 
+     *   If the string is indexed, we can figure the starting and ending
+     *   character indices arithmetically, and then look up their byte
+     *   offsets, rather than walking the string.  
+     */
+    const vmstr_index_entry *ix = str_index_get(vmg_ str);
+    if (ix != 0)
+    {
+        long clen = (long)ix->charlen;
+
+        /* figure the 0-based starting character index */
+        long sc = (start > 0 ? (start - 1 < clen ? start - 1 : clen) :
+                   start < 0 ? (clen + start > 0 ? clen + start : 0) :
+                   0);
+
+        /* figure the ending character index */
+        long ec = clen;
+        if (argc >= 2)
+            ec = (len >= 0 ? (len < clen - sc ? sc + len : clen) :
+                  (clen + len > sc ? clen + len : sc));
+
+        /* create the new string from the byte range */
+        size_t sb = ix->byte_ofs(sc);
+        obj = CVmObjString::create(vmg_ FALSE, str + VMB_LEN + sb,
+                                   ix->byte_ofs(ec) - sb);
+        retval->set_obj(obj);
+
+        /* discard the GC protection and we're done */
+        G_stk->discard();
+        return TRUE;
+    }
+
     /* set up a utf8 pointer to traverse the string */
     p.set((char *)str + VMB_LEN);
 
@@ -1750,6 +2162,9 @@ template<int dir> inline int CVmObjString::find_common(
     if (get_prop_check_argc(retval, argc, &desc))
         return TRUE;
 
+    /* get the character index, if the string is long enough to have one */
+    const vmstr_index_entry *ix = str_index_get(vmg_ str);
+
     /* get the string length and buffer pointer */
     size_t len = vmb_get_len(str);
     str += VMB_LEN;
@@ -1794,30 +2209,59 @@ template<int dir> inline int CVmObjString::find_common(
          *   position past the last character.  In any case, adjust to a
          *   zero-based index.
          */
-        start_idx += (start_idx == 0 && dir < 0 ? (int)strp.len(len) :
-                      start_idx < 0 ? (int)strp.len(len) :
-                      -1);
+        if (start_idx < 0 || (start_idx == 0 && dir < 0))
+            start_idx += (int)(ix != 0 ? ix->charlen : strp.len(len));
+        else
+            start_idx -= 1;
 
         /* if there's a substring, we can limit the skip */
         size_t min_len = (dir > 0 && str2 != 0 ? vmb_get_len(str2) : 0);
 
         /* skip that many characters */
-        int32_t i;
-        for (i = 0 ; i < start_idx && len > min_len ; ++i, strp.inc(&len)) ;
-
-        /* 
-         *   if the start index was past the end of the string (or past the
-         *   point where the remaining subject string is too short for the
-         *   target string), we definitely can't match 
-         */
-        if (i < start_idx)
+        if (ix != 0)
         {
-            retval->set_nil();
-            goto done;
+            /* 
+             *   Use the index to find the starting point.  The search can't
+             *   match if the start index is past the end of the string, or
+             *   if the remaining subject string from the character before
+             *   the start index is too short for the target string. 
+             */
+            if (start_idx > 0
+                && ((size_t)start_idx - 1 >= ix->charlen
+                    || len - ix->byte_ofs(start_idx - 1) <= min_len))
+            {
+                retval->set_nil();
+                goto done;
+            }
+
+            /* start the search here */
+            if (start_idx > 0)
+            {
+                size_t ofs = ix->byte_ofs(start_idx);
+                str += ofs;
+                len -= ofs;
+            }
         }
+        else
+        {
+            int32_t i;
+            for (i = 0 ; i < start_idx && len > min_len ;
+                 ++i, strp.inc(&len)) ;
 
-        /* start the search here */
-        str = strp.getptr();
+            /* 
+             *   if the start index was past the end of the string (or past
+             *   the point where the remaining subject string is too short
+             *   for the target string), we definitely can't match 
+             */
+            if (i < start_idx)
+            {
+                retval->set_nil();
+                goto done;
+            }
+
+            /* start the search here */
+            str = strp.getptr();
+        }
     }
     else if (dir < 0)
     {
@@ -1826,7 +2270,7 @@ template<int dir> inline int CVmObjString::find_common(
          *   starting point is the end of the string 
          */
         str = str + len;
-        start_idx = utf8_ptr::s_len(basestr, len);
+        start_idx = (ix != 0 ? ix->charlen : utf8_ptr::s_len(basestr, len));
         len = 0;
     }
 
@@ -2248,13 +2692,34 @@ int CVmObjString::getp_to_uni(VMG_ vm_val_t *retval,
     /* set up a utf8 pointer to the string */
     p.set((char *)str);
 
+    /* get the character index, if the string is long enough to have one */
+    const vmstr_index_entry *ix = str_index_get(vmg_ str - VMB_LEN);
+
     /* if the index is negative, it's an index from the end of the string */
     if (idx < 0)
-        idx += p.len(bytelen) + 1;
+        idx += (ix != 0 ? ix->charlen : p.len(bytelen)) + 1;
 
     /* check for an index argument */
     if (argc >= 1)
     {
+        /* if we have an index, use it to find the character */
+        if (ix != 0 && idx > 1)
+        {
+            if ((size_t)idx > ix->charlen)
+            {
+                /* past the end of the string */
+                bytelen = 0;
+            }
+            else
+            {
+                /* go directly to the character */
+                size_t ofs = ix->byte_ofs(idx - 1);
+                p.set((char *)str + ofs);
+                bytelen -= ofs;
+            }
+            idx = 1;
+        }
+
         /* skip through the string until we get to the desired index */
         for ( ; idx > 1 && bytelen != 0 ; --idx, p.inc(&bytelen)) ;
 
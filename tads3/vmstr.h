@@ -20,8 +20,11 @@ Modified
 #ifndef VMSTR_H
 #define VMSTR_H
 
+#include <string.h>
+
 #include "vmglob.h"
 #include "vmobj.h"
+#include "utf8.h"
 
 
 /*
@@ -220,6 +223,13 @@ public:
     /* get the underlying string */
     const char *get_as_string(VMG0_) const { return ext_; }
 
+    /*
+     *   Get my rope extension, if I'm a concatenation that hasn't been
+     *   flattened yet (see CVmObjStringRope below).  Returns null for an
+     *   ordinary string.  
+     */
+    virtual struct vmstr_rope_ext *get_rope_ext() const { return 0; }
+
     /* cast to integer */
     virtual long cast_to_int(VMG0_) const;
 
@@ -643,6 +653,261 @@ protected:
 };
 
 
+/* ------------------------------------------------------------------------ */
+/*
+ *   Rope strings.  Building a long string with a series of '+' operations
+ *   would copy the whole left-hand string on every step, which makes the
+ *   loop quadratic in the final length.  So once the result of a
+ *   concatenation reaches VMSTR_ROPE_MIN bytes, we don't copy anything;
+ *   instead we create a rope string, which simply remembers its two
+ *   operands and its total length.  A chain of appends thus builds a tree
+ *   of rope nodes in constant time per step.
+ *   
+ *   A rope is flattened into an ordinary string buffer the first time
+ *   anyone needs its actual text: property evaluation (substr, find, etc),
+ *   comparisons, hashing, conversions, and any caller of get_as_string()
+ *   or cast_to_string().  Flattening copies the text of the whole tree
+ *   once, then drops the operand references, so the operands can be
+ *   collected if nothing else is using them.
+ *   
+ *   Ropes are purely a run-time representation.  A rope is an instance of
+ *   the String metaclass like any other string, and it saves and rebuilds
+ *   as an ordinary string (with its flattened text), so it always restores
+ *   as an ordinary string.  
+ */
+
+/* minimum concatenation result length, in bytes, for creating a rope */
+#define VMSTR_ROPE_MIN  256
+
+/* rope extension */
+struct vmstr_rope_ext
+{
+    /* allocate the extension */
+    static vmstr_rope_ext *alloc_ext(VMG_ class CVmObjStringRope *self,
+                                     const vm_val_t *left,
+                                     const vm_val_t *right,
+                                     size_t len, uint depth);
+
+    /* the flattened string, in VMB_LEN-prefixed format; null until built */
+    char *flat;
+
+    /* the left and right operands; nil once we've flattened */
+    vm_val_t left;
+    vm_val_t right;
+
+    /* total byte length of the string */
+    size_t len;
+
+    /* 
+     *   depth of the tree under this node: 1 if both operands are flat
+     *   strings, otherwise one more than the deeper operand 
+     */
+    uint depth;
+};
+
+class CVmObjStringRope: public CVmObjString
+{
+public:
+    /* 
+     *   Create a rope representing the concatenation of two string values.
+     *   The caller is responsible for ensuring that both values are strings
+     *   (constant or object), and that the total length is within the
+     *   string length limit.  
+     */
+    static vm_obj_id_t create(VMG_ const vm_val_t *left,
+                              const vm_val_t *right);
+
+    /* 
+     *   Get the unflattened rope extension for a value, if the value is a
+     *   rope string that hasn't been flattened yet; otherwise null. 
+     */
+    static vmstr_rope_ext *get_val_rope(VMG_ const vm_val_t *val)
+    {
+        return (val->typ == VM_OBJ && is_string_obj(vmg_ val->val.obj)
+                ? ((CVmObjString *)vm_objp(vmg_ val->val.obj))
+                  ->get_rope_ext()
+                : 0);
+    }
+
+    /* get the byte length of a string value, without flattening it */
+    static size_t get_val_len(VMG_ const vm_val_t *val)
+    {
+        vmstr_rope_ext *r = get_val_rope(vmg_ val);
+        return r != 0 ? r->len : vmb_get_len(val->get_as_string(vmg0_));
+    }
+
+    /* get my unflattened rope extension */
+    vmstr_rope_ext *get_rope_ext() const
+    {
+        vmstr_rope_ext *r = (vmstr_rope_ext *)ext_;
+        return r->flat == 0 ? r : 0;
+    }
+
+    /* get the underlying string - this flattens the rope */
+    const char *get_as_string(VMG0_) const
+    {
+        vmstr_rope_ext *r = (vmstr_rope_ext *)ext_;
+        return r->flat != 0 ? r->flat : flatten(vmg0_);
+    }
+
+    /* cast to string - this flattens the rope */
+    const char *cast_to_string(VMG_ vm_obj_id_t self,
+                               vm_val_t *new_str) const
+    {
+        new_str->set_obj(self);
+        return get_as_string(vmg0_);
+    }
+
+    /* notify of deletion */
+    void notify_delete(VMG_ int in_root_set);
+
+    /* mark references - we reference our operands until we're flattened */
+    void mark_refs(VMG_ uint state);
+
+    /* our references never change after construction, except to go away */
+    int has_write_barrier() const { return TRUE; }
+
+protected:
+    /* construct */
+    CVmObjStringRope(VMG_ const vm_val_t *left, const vm_val_t *right,
+                     size_t len, uint depth);
+
+    /* flatten the rope into an ordinary string buffer */
+    const char *flatten(VMG0_) const;
+
+    /* copy the text of a rope tree into a buffer */
+    static void copy_flat(VMG_ const struct vmstr_rope_ext *r, char *dst);
+};
+
+
+/* ------------------------------------------------------------------------ */
+/*
+ *   String character index cache.  Strings are stored in UTF-8, so the
+ *   character-oriented methods (length, substr, find with a starting index,
+ *   and so on) have to walk the string from the beginning to convert a
+ *   character index to a byte offset, which makes a loop that indexes
+ *   through a long string quadratic.
+ *   
+ *   The portable string format is just a length prefix followed by the
+ *   bytes, and it's shared with the constant pool and the image file, so
+ *   there's no room in the string itself for any extra information.
+ *   Instead, we keep a small cache of index information keyed by string
+ *   buffer address.  The first time a long string is indexed, we scan it
+ *   once to get its character length and to note whether it's pure ASCII,
+ *   in which case character and byte offsets are the same.  If it isn't,
+ *   we also record the byte offset of every VMSTR_INDEX_STRIDE'th
+ *   character, so that we can find any character with a short walk from
+ *   the nearest checkpoint.
+ *   
+ *   String buffers don't change once they're constructed, so an entry
+ *   stays valid until its buffer is freed.  Anything that frees or
+ *   reallocates a string buffer must call forget() on it.  
+ */
+
+/* minimum byte length of a string for indexing */
+#define VMSTR_INDEX_MIN     128
+
+/* number of characters between checkpoints in a non-ASCII index */
+#define VMSTR_INDEX_STRIDE  64
+
+/* number of cache entries - this must be a power of 2 */
+#define VMSTR_INDEX_SIZE    128
+
+/* index cache entry */
+struct vmstr_index_entry
+{
+    /* 
+     *   get the byte offset, from the start of the text, of the character
+     *   at the given index; the index must be no greater than 'charlen' 
+     */
+    size_t byte_ofs(size_t idx) const
+    {
+        /* for a pure ASCII string, characters and bytes are the same */
+        if (ascii)
+            return idx;
+
+        /* start at the nearest checkpoint, and walk the rest of the way */
+        const char *p = str + VMB_LEN + ckpt[idx / VMSTR_INDEX_STRIDE];
+        for (idx %= VMSTR_INDEX_STRIDE ; idx != 0 ; --idx)
+            p += utf8_ptr::s_charsize(*p);
+
+        /* 
+         *   return the offset, limited to the byte length in case the
+         *   string ends with a truncated character 
+         */
+        size_t ofs = p - (str + VMB_LEN);
+        return ofs < bytelen ? ofs : bytelen;
+    }
+
+    /* the string buffer, with its length prefix; null if not in use */
+    const char *str;
+
+    /* the byte and character lengths of the text */
+    size_t bytelen;
+    size_t charlen;
+
+    /* is the text pure ASCII? */
+    int ascii;
+
+    /* 
+     *   byte offsets of characters 0, VMSTR_INDEX_STRIDE, etc; null if the
+     *   string is pure ASCII 
+     */
+    uint16_t *ckpt;
+};
+
+class CVmStrIndexCache
+{
+public:
+    CVmStrIndexCache() { memset(ents_, 0, sizeof(ents_)); }
+    ~CVmStrIndexCache();
+
+    /* 
+     *   Get the index for a string (in portable format, with its length
+     *   prefix).  Returns null if the string is too short to bother
+     *   indexing, in which case the caller should just walk the string. 
+     */
+    const vmstr_index_entry *get(const char *str)
+    {
+        /* don't bother with short strings */
+        size_t len = vmb_get_len(str);
+        if (len < VMSTR_INDEX_MIN)
+            return 0;
+
+        /* if we have a matching entry, use it; otherwise build one */
+        vmstr_index_entry *e = &ents_[slot_for(str)];
+        if (e->str == str && e->bytelen == len)
+            return e;
+        return build(e, str);
+    }
+
+    /* forget any index for a string buffer that's being freed */
+    void forget(const char *str)
+    {
+        vmstr_index_entry *e = &ents_[slot_for(str)];
+        if (e->str == str)
+            clear(e);
+    }
+
+protected:
+    /* get the cache slot for a string buffer */
+    static uint slot_for(const char *str)
+    {
+        ulong a = (ulong)str;
+        return (uint)((a ^ (a >> 7) ^ (a >> 15)) & (VMSTR_INDEX_SIZE - 1));
+    }
+
+    /* build the index for a string into the given entry */
+    const vmstr_index_entry *build(vmstr_index_entry *e, const char *str);
+
+    /* clear an entry */
+    static void clear(vmstr_index_entry *e);
+
+    /* the cache entries */
+    vmstr_index_entry ents_[VMSTR_INDEX_SIZE];
+};
+
+
 /* ------------------------------------------------------------------------ */
 /*
  *   Registration table object 
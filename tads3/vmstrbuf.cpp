@@ -544,7 +544,7 @@ void CVmObjStringBuffer::add_undo_rec(
      */
     vm_val_t nilval;
     nilval.set_nil();
-    if (!G_undo->add_new_record_ptr_key(vmg_ self, rec, &nilval))
+    if (!G_undo->add_new_record_ptr_key(vmg_ self, rec, &nilval, siz))
     {
         /* 
          *   we didn't add an undo record, so our extra undo information
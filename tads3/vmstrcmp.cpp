@@ -741,6 +741,7 @@ struct StrCompHashAdder
         this->trunc_len = trunc_len;
         this->has_trunc = (trunc_len != 0);
         hash = 0;
+        key = 2166136261U;
     }
 
     int add(wchar_t ch)
@@ -749,6 +750,10 @@ struct StrCompHashAdder
         hash += ch;
         hash &= 0xFFFF;
 
+        /* mix it into the key hash as well (this is FNV-1a) */
+        key ^= (unsigned int)ch;
+        key *= 16777619U;
+
         /* if there's a truncation limit, count this against the limit */
         if (has_trunc && --trunc_len == 0)
         {
@@ -772,12 +777,40 @@ struct StrCompHashAdder
 
     /* the hash code */
     unsigned int hash;
+
+    /* 
+     *   the key hash - this covers the same characters as the hash code,
+     *   but depends on their order as well as their values, so it's much
+     *   less prone to collisions 
+     */
+    unsigned int key;
 };
 
 /*
  *   Calculate a hash value 
  */
 unsigned int CVmObjStrComp::calc_str_hash(const char *strp, size_t len)
+{
+    StrCompHashAdder hash(get_ext()->trunc_len);
+    add_str_hash(strp, len, &hash);
+    return hash.hash;
+}
+
+/*
+ *   Calculate a key hash value 
+ */
+unsigned int CVmObjStrComp::calc_key_hash(const char *strp, size_t len)
+{
+    StrCompHashAdder hash(get_ext()->trunc_len);
+    add_str_hash(strp, len, &hash);
+    return hash.key;
+}
+
+/*
+ *   Add the canonical characters of a string to a hash adder 
+ */
+void CVmObjStrComp::add_str_hash(const char *strp, size_t len,
+                                 StrCompHashAdder *hash)
 {
     /* get my extension */
     vmobj_strcmp_ext *ext = get_ext();
@@ -793,7 +826,6 @@ unsigned int CVmObjStrComp::calc_str_hash(const char *strp, size_t len)
      *   a longer string it matches; all matching strings are required to go
      *   into the same bucket, so we can't have such a hash mismatch.
      */
-    StrCompHashAdder hash(ext->trunc_len);
     for ( ; len != 0 ; p.inc(&len))
     {
         vmobj_strcmp_equiv **t1, *eq;
@@ -850,14 +882,14 @@ unsigned int CVmObjStrComp::calc_str_hash(const char *strp, size_t len)
                     /* add the folded expansion to the hash */
                     for (const wchar_t *f = t3_to_fold(ch) ; *f != 0 ; ++f)
                     {
-                        if (!hash.add(*f))
-                            return hash.hash;
+                        if (!hash->add(*f))
+                            return;
                     }
                 }
                 else
                 {
-                    if (!hash.add(ch))
-                        return hash.hash;
+                    if (!hash->add(ch))
+                        return;
                 }
             }
         }
@@ -874,21 +906,18 @@ unsigned int CVmObjStrComp::calc_str_hash(const char *strp, size_t len)
                 /* add the folded expansion to the hash */
                 for (const wchar_t *f = t3_to_fold(ch) ; *f != 0 ; ++f)
                 {
-                    if (!hash.add(*f))
-                        return hash.hash;
+                    if (!hash->add(*f))
+                        return;
                 }
             }
             else
             {
                 /* exact case only - add the character as-is */
-                if (!hash.add(ch))
-                    return hash.hash;
+                if (!hash->add(ch))
+                    return;
             }
         }
     }
-
-    /* return the hash code */
-    return hash.hash;
 }
 
 /* ------------------------------------------------------------------------ */
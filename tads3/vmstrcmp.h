@@ -229,6 +229,15 @@ public:
     /* calculate a hash value for a constant string */
     virtual unsigned int calc_str_hash(const char *str, size_t len);
 
+    /* 
+     *   Calculate a key hash value for a constant string.  This is like
+     *   calc_str_hash(), in that any two strings that match have the same
+     *   key hash, but it's not visible to byte code, so it's free to use a
+     *   better mixing function.  The Dictionary uses this to index its
+     *   words.  
+     */
+    virtual unsigned int calc_key_hash(const char *str, size_t len);
+
     /* match two strings */
     virtual unsigned long match_strings(const char *valstr, size_t vallen,
                                         const char *refstr, size_t reflen);
@@ -255,6 +264,10 @@ protected:
     /* get my extension data */
     vmobj_strcmp_ext *get_ext() const { return (vmobj_strcmp_ext *)ext_; }
 
+    /* add the canonical characters of a string to a hash adder */
+    void add_str_hash(const char *str, size_t len,
+                      struct StrCompHashAdder *hash);
+
     /* load from an abstact stream object */
     void load_from_stream(VMG_ class CVmStream *str);
 
@@ -51,48 +51,23 @@ vm_tadsobj_hdr *vm_tadsobj_hdr::alloc(VMG_ CVmObjTads *self,
                                       unsigned short sc_cnt,
                                       unsigned short prop_cnt)
 {
-    ushort hash_siz;
+    unsigned int slot_cnt;
+    unsigned short slot_shift;
     size_t siz;
-    size_t i;
     vm_tadsobj_hdr *hdr;
     char *mem;
-    vm_tadsobj_prop **hashp;
     
-    /* 
-     *   Figure the size of the hash table to allocate.  Empirically, a good
-     *   size seems to be about one hash slot per property. 
-     */
-    if (prop_cnt <= 2)
-        hash_siz = 2;
-    else if (prop_cnt <= 4)
-        hash_siz = 4;
-    else if (prop_cnt <= 8)
-        hash_siz = 8;
-    else if (prop_cnt <= 16)
-        hash_siz = 16;
-    else if (prop_cnt <= 32)
-        hash_siz = 32;
-    else if (prop_cnt <= 64)
-        hash_siz = 64;
-    else if (prop_cnt <= 128)
-        hash_siz = 128;
-    else
-        hash_siz = 256;
+    /* round small property counts up to a power of two */
+    prop_cnt = (unsigned short)round_prop_cnt(prop_cnt);
 
-    /* 
-     *   increase the requested property count to the hash size at a minimum
-     *   - this will avoid the need to reallocate the object to make room
-     *   for more properties until we'd have to resize the hash table, at
-     *   which point we have to reallocate the object anyway 
-     */
-    if (prop_cnt < hash_siz)
-        prop_cnt = hash_siz;
+    /* figure the size of the property index, if we need one */
+    slot_cnt = calc_slot_cnt(prop_cnt, &slot_shift);
 
     /* figure the size of the structure we need */
     siz = sizeof(vm_tadsobj_hdr)
           + (sc_cnt - 1) * sizeof(hdr->sc[0])
-          + (hash_siz) * sizeof(hdr->hash_arr[0])
-          + prop_cnt * sizeof(hdr->prop_entry_arr[0]);
+          + prop_cnt * sizeof(hdr->prop_entry_arr[0])
+          + slot_cnt * sizeof(hdr->slot_arr[0]);
 
     /* allocate the memory */
     hdr = (vm_tadsobj_hdr *)G_mem->get_var_heap()->alloc_mem(siz, self);
@@ -110,24 +85,28 @@ vm_tadsobj_hdr *vm_tadsobj_hdr::alloc(VMG_ CVmObjTads *self,
     /* the object has no precalculated inheritance path yet */
     hdr->inh_path = 0;
 
-    /* suballocate the hash buckets */
-    hdr->hash_siz = hash_siz;
-    hdr->hash_arr = (vm_tadsobj_prop **)mem;
-
-    /* clear out the hash buckets */
-    for (hashp = hdr->hash_arr, i = hash_siz ; i != 0 ; ++hashp, --i)
-        *hashp = 0;
-
-    /* move past the memory taken by the hash buckets */
-    mem = (char *)(hdr->hash_arr + hash_siz);
-
-    /* suballocate the array of hash entries */
+    /* 
+     *   suballocate the array of property entries (this comes first, since
+     *   the entries have the strictest alignment requirements) 
+     */
     hdr->prop_entry_cnt = prop_cnt;
     hdr->prop_entry_arr = (vm_tadsobj_prop *)mem;
+    mem = (char *)(hdr->prop_entry_arr + prop_cnt);
 
     /* all entries are currently free, so point to the first entry */
     hdr->prop_entry_free = 0;
 
+    /* suballocate and clear the index, if we have one */
+    hdr->slot_cnt = slot_cnt;
+    hdr->slot_shift = slot_shift;
+    if (slot_cnt != 0)
+    {
+        hdr->slot_arr = (vm_tadsobj_slot *)mem;
+        memset(hdr->slot_arr, 0, slot_cnt * sizeof(hdr->slot_arr[0]));
+    }
+    else
+        hdr->slot_arr = 0;
+
     /* remember the superclass count */
     hdr->sc_cnt = sc_cnt;
 
@@ -218,6 +197,9 @@ vm_tadsobj_hdr *vm_tadsobj_hdr::expand_to(VMG_ CVmObjTads *self,
 
     /* delete the old header */
     G_mem->get_var_heap()->free_mem(hdr);
+
+    /* the property entries have moved, so drop cached lookups */
+    G_tadsobj_ic->inval();
     
     /* return the new header */
     return new_hdr;
@@ -233,18 +215,13 @@ vm_tadsobj_hdr *vm_tadsobj_hdr::expand_to(VMG_ CVmObjTads *self,
 vm_tadsobj_prop *vm_tadsobj_hdr::alloc_prop_entry(
     vm_prop_id_t prop, const vm_val_t *val, unsigned int flags)
 {
-    /* get the hash code for the property */
-    unsigned int hash = calc_hash(prop);
-
     /* use the next free entry */
-    vm_tadsobj_prop *entry = &prop_entry_arr[prop_entry_free];
-
-    /* link this entry into the list for its hash bucket */
-    entry->nxt = hash_arr[hash];
-    hash_arr[hash] = entry;
+    unsigned short idx = prop_entry_free++;
+    vm_tadsobj_prop *entry = &prop_entry_arr[idx];
 
-    /* count our use of the free entry */
-    ++prop_entry_free;
+    /* add it to the index, if we have one */
+    if (slot_arr != 0)
+        add_slot(prop, idx);
     
     /* set the new entry's property ID */
     entry->prop = prop;
@@ -262,9 +239,27 @@ vm_tadsobj_prop *vm_tadsobj_hdr::alloc_prop_entry(
  */
 vm_tadsobj_prop *vm_tadsobj_hdr::find_prop_entry(uint prop)
 {
-    /* scan the list of entries in this bucket */
-    for (vm_tadsobj_prop *entry = hash_arr[calc_hash(prop)] ;
-         entry != 0 ; entry = entry->nxt)
+    /* if we have an index, probe it */
+    if (slot_arr != 0)
+    {
+        /* 
+         *   probe from the home slot until we find the property or reach an
+         *   empty slot - the index is never full, so this terminates 
+         */
+        unsigned int mask = slot_cnt - 1;
+        for (unsigned int i = calc_hash(prop) ; ; i = (i + 1) & mask)
+        {
+            vm_tadsobj_slot *slot = &slot_arr[i];
+            if (slot->prop == prop)
+                return &prop_entry_arr[slot->idx];
+            if (slot->prop == VM_INVALID_PROP)
+                return 0;
+        }
+    }
+
+    /* no index - scan the entries directly */
+    vm_tadsobj_prop *entry = prop_entry_arr;
+    for (size_t i = prop_entry_free ; i != 0 ; --i, ++entry)
     {
         /* if this entry matches, return it */
         if (entry->prop == prop)
@@ -275,6 +270,83 @@ vm_tadsobj_prop *vm_tadsobj_hdr::find_prop_entry(uint prop)
     return 0;
 }
 
+/*
+ *   Delete the last entry
+ */
+void vm_tadsobj_hdr::free_last_prop_entry()
+{
+    /* return the entry to the free pool */
+    --prop_entry_free;
+
+    /* 
+     *   Removing a key from a linear-probing table requires moving any
+     *   later members of its probe cluster, which amounts to re-adding
+     *   them; since this only happens on undo, just rebuild the index. 
+     */
+    if (slot_arr != 0)
+        rebuild_slots();
+}
+
+/*
+ *   Discard all entries 
+ */
+void vm_tadsobj_hdr::clear_props()
+{
+    prop_entry_free = 0;
+    if (slot_arr != 0)
+        memset(slot_arr, 0, slot_cnt * sizeof(slot_arr[0]));
+}
+
+/*
+ *   Adopt a prebuilt index from the image file 
+ */
+int vm_tadsobj_hdr::adopt_image_index(const char *p, size_t len)
+{
+    /* 
+     *   make sure we have an index in our format, for a table of exactly
+     *   our size, since the slot positions depend on both 
+     */
+    if (slot_arr == 0
+        || len < 4
+        || osrp2(p) != VMTOBJ_IMGIDX_FMT
+        || osrp2(p + 2) != slot_cnt
+        || len - 4 < prop_entry_free)
+        return FALSE;
+
+    /* 
+     *   Fill in the slot for each entry.  The index starts out empty, so
+     *   we can tell if a damaged index uses a slot twice; as long as it
+     *   doesn't, the index has the same number of empty slots as one we'd
+     *   build ourselves, so a probe can't go around the table forever.  
+     */
+    p += 4;
+    for (unsigned short i = 0 ; i < prop_entry_free ; ++i)
+    {
+        unsigned int j = (unsigned char)p[i];
+        if (j >= slot_cnt || slot_arr[j].prop != VM_INVALID_PROP)
+            return FALSE;
+
+        slot_arr[j].prop = prop_entry_arr[i].prop;
+        slot_arr[j].idx = i;
+    }
+
+    /* success */
+    return TRUE;
+}
+
+/*
+ *   Rebuild the index 
+ */
+void vm_tadsobj_hdr::rebuild_slots()
+{
+    /* clear the index */
+    memset(slot_arr, 0, slot_cnt * sizeof(slot_arr[0]));
+
+    /* add each entry in use */
+    for (unsigned short i = 0 ; i < prop_entry_free ; ++i)
+        add_slot(prop_entry_arr[i].prop, i);
+}
+
 /* ------------------------------------------------------------------------ */
 /*
  *   statics 
@@ -321,6 +393,11 @@ void CVmObjTads::class_init(VMG0_)
     VM_IFELSE_ALLOC_PRE_GLOBAL(
         G_tadsobj_queue = new CVmObjTadsInhQueue(),
         G_tadsobj_queue->init());
+
+    /* allocate the inline property cache */
+    VM_IFELSE_ALLOC_PRE_GLOBAL(
+        G_tadsobj_ic = new CVmObjTadsPropCache(),
+        G_tadsobj_ic->init());
 }
 
 /*
@@ -332,6 +409,9 @@ void CVmObjTads::class_term(VMG0_)
     VM_IF_ALLOC_PRE_GLOBAL(
         delete G_tadsobj_queue;
         G_tadsobj_queue = 0;
+
+        delete G_tadsobj_ic;
+        G_tadsobj_ic = 0;
     )
 }
 
@@ -647,6 +727,14 @@ void CVmObjTads::notify_delete(VMG_ int in_root_set)
 
         /* delete the extension */
         G_mem->get_var_heap()->free_mem(ext_);
+
+        /* 
+         *   drop any cached lookups that refer to our properties (the cache
+         *   can already be gone if we're deleting objects at termination) 
+         */
+        VM_IFELSE_ALLOC_PRE_GLOBAL(
+            if (G_tadsobj_ic != 0) G_tadsobj_ic->inval(),
+            G_tadsobj_ic->inval());
     }
 }
 
@@ -795,6 +883,12 @@ void CVmObjTads::set_prop(VMG_ CVmUndo *undo, vm_obj_id_t self,
         /* allocate a new entry */
         entry = hdr->alloc_prop_entry(prop, val, 0);
 
+        /* 
+         *   the new entry could override a property that cached lookups
+         *   found in one of our superclasses 
+         */
+        G_tadsobj_ic->inval();
+
         /* 
          *   The old value didn't exist, so mark it emtpy, with an intval of
          *   zero.  The zero indicates that this is a newly created property
@@ -804,6 +898,9 @@ void CVmObjTads::set_prop(VMG_ CVmUndo *undo, vm_obj_id_t self,
         oldval.val.intval = 0;
     }
 
+    /* tell the garbage collector about the store */
+    G_obj_table->note_ref_store(self, val);
+
     /*
      *   If we already have undo for this property for the current
      *   savepoint, as indicated by the undo flag for the property, we don't
@@ -1256,6 +1353,66 @@ int CVmObjTads::get_prop(VMG_ vm_prop_id_t prop, vm_val_t *val,
     return CVmObject::get_prop(vmg_ prop, val, self, source_obj, argc);
 }
 
+/*
+ *   Get a property on behalf of a property evaluation instruction.  This
+ *   does the same search as get_prop(), but uses the inline property cache
+ *   for properties inherited from superclasses.  
+ */
+int CVmObjTads::get_prop_at_site(VMG_ vm_prop_id_t prop, vm_val_t *val,
+                                 vm_obj_id_t self, vm_obj_id_t *source_obj,
+                                 uint *argc, const uchar *site)
+{
+    /* get my header */
+    vm_tadsobj_hdr *hdr = get_hdr();
+
+    /* 
+     *   Check my own property table first.  The cache only covers the
+     *   superclass search, since that depends only on the superclass list,
+     *   which we share with every other instance of the same classes.  
+     */
+    vm_tadsobj_prop *entry = hdr->find_prop_entry(prop);
+    if (entry != 0)
+    {
+        *val = entry->val;
+        *source_obj = self;
+        return TRUE;
+    }
+
+    /* check for a cached result from this site for our superclass list */
+    vm_tadsobj_ic_entry *ic = G_tadsobj_ic->find(site, prop, hdr);
+    if (ic != 0)
+    {
+        *val = ic->entry->val;
+        *source_obj = ic->defining_obj;
+        return TRUE;
+    }
+
+    /* search our superclasses */
+    tadsobj_sc_search_ctx curpos(vmg_ self, this);
+    while (curpos.to_next(vmg0_))
+    {
+        /* look for this property in the current superclass */
+        entry = curpos.curhdr->find_prop_entry(prop);
+        if (entry != 0)
+        {
+            /* found it - cache it and return it */
+            G_tadsobj_ic->add(site, prop, hdr, curpos.cur, entry);
+            *val = entry->val;
+            *source_obj = curpos.cur;
+            return TRUE;
+        }
+    }
+
+    /* 
+     *   it's not in any property list, so try the intrinsic class methods,
+     *   then the base metaclass, just as get_prop() does 
+     */
+    if (get_prop_intrinsic(vmg_ prop, val, self, source_obj, argc))
+        return TRUE;
+
+    return CVmObject::get_prop(vmg_ prop, val, self, source_obj, argc);
+}
+
 /*
  *   Inherit a property.  
  */
@@ -1495,9 +1652,6 @@ void CVmObjTads::apply_undo(VMG_ CVmUndoRecord *rec)
         /* if the old value is 'empty', it requires special handling */
         if (rec->oldval.typ == VM_EMPTY)
         {
-            vm_tadsobj_prop *cur, **prv;
-            unsigned int hash = hdr->calc_hash(rec->id.prop);
-            
             /* 
              *   We use 'empty' records for multiple purposes, with the
              *   specific one indicated by the intval field. 
@@ -1507,22 +1661,17 @@ void CVmObjTads::apply_undo(VMG_ CVmUndoRecord *rec)
             case 0:
                 /*
                  *   Empty with intval 0 indicates a property addition, which
-                 *   we undo by deleting the property.  First, find it in the
-                 *   hash chain.  
+                 *   we undo by deleting the property.  Property additions
+                 *   are undone in reverse order, so this is always the last
+                 *   entry in the table.  
                  */
-                for (prv = &hdr->hash_arr[hash] ;
-                     (cur = *prv) != 0 && cur != entry ;
-                     prv = &cur->nxt) ;
-                
-                /* make sure we found it */
-                if (cur == entry)
+                if (entry == &hdr->prop_entry_arr[hdr->prop_entry_free - 1])
                 {
-                    /* unlink it */
-                    *prv = entry->nxt;
-                    
-                    /* return it to the free list */
-                    hdr->prop_entry_free -= 1;
-                    assert(entry == &hdr->prop_entry_arr[hdr->prop_entry_free]);
+                    /* return it to the free pool */
+                    hdr->free_last_prop_entry();
+
+                    /* cached lookups might refer to the deleted entry */
+                    G_tadsobj_ic->inval();
                 }
                 else
                 {
@@ -1716,17 +1865,18 @@ void CVmObjTads::restore_from_file(VMG_ vm_obj_id_t self,
         sc = fixups->get_new_id(vmg_ sc);
 
         /* 
-         *   store it - as when loading from the image file, we can't count
-         *   on the superclass having been loaded yet, so we can only store
-         *   the superclass's ID, not its actual object pointer 
+         *   Store it.  The superclass might not have been restored yet, but
+         *   unlike when loading from the image file, every object in the
+         *   saved state already has its ID (and hence its object table
+         *   slot) by the time we read any object data, so we can cache the
+         *   superclass's object pointer right away.  That saves a post-load
+         *   initialization request for every restored object, which adds
+         *   up in a large saved game.  
          */
         hdr->sc[i].id = sc;
-        hdr->sc[i].objp = 0;
+        hdr->sc[i].objp = (CVmObjTads *)vm_objp(vmg_ sc);
     }
 
-    /* request post-load initialization, to set up the superclass list */
-    G_obj_table->request_post_load_init(self);
-
     /* 
      *   invalidate any existing inheritance path, in case the superclass
      *   list changed 
@@ -1823,8 +1973,26 @@ void CVmObjTads::load_from_image(VMG_ vm_obj_id_t self,
     /* load the image file properties */
     load_image_props_and_scs(vmg_ ptr, siz);
 
-    /* request post-load initialization, to set up the superclass list */
-    G_obj_table->request_post_load_init(self);
+    /* 
+     *   If our superclasses have all been loaded already, which is the
+     *   usual case, since a class is normally defined ahead of its
+     *   instances, cache their object pointers now.  Otherwise, request
+     *   post-load initialization, to set up the superclass list once
+     *   everything is loaded.  Post-load initialization runs again on every
+     *   restart and restore, so it's worth keeping the list of objects that
+     *   need it short.  
+     */
+    int i;
+    for (i = 0 ; i < hdr->sc_cnt ; ++i)
+    {
+        /* stop if this superclass hasn't been loaded yet */
+        if (!G_obj_table->is_obj_id_valid(hdr->sc[i].id))
+            break;
+    }
+    if (i == hdr->sc_cnt)
+        post_load_init(vmg_ self);
+    else
+        G_obj_table->request_post_load_init(self);
 }
 
 /*
@@ -1837,9 +2005,23 @@ void CVmObjTads::reload_from_image(VMG_ vm_obj_id_t self,
     /* get my header */
     vm_tadsobj_hdr *hdr = get_hdr();
 
+    /* 
+     *   If we haven't been modified since we were loaded, our property
+     *   table and superclass list still hold exactly the image file data,
+     *   so there's nothing to reload.  In a large game, most objects are
+     *   never touched between resets, so this saves reloading all of them.
+     */
+    if ((hdr->intern_obj_flags & VMTO_OBJ_MOD) == 0)
+        return;
+
     /* get the number of superclasses */
     ushort sc_cnt = osrp2(ptr);
 
+    /* note whether our superclass list has changed from the image file's */
+    int sc_changed = (sc_cnt != hdr->sc_cnt);
+    for (int i = 0 ; i < sc_cnt && !sc_changed ; ++i)
+        sc_changed = (hdr->sc[i].id != (vm_obj_id_t)t3rp4u(ptr + 6 + i*4));
+
     /* 
      *   Clear the property table.  We don't have to worry about the new
      *   property table being larger than the existing property table,
@@ -1847,8 +2029,10 @@ void CVmObjTads::reload_from_image(VMG_ vm_obj_id_t self,
      *   all we need to do is mark all property entries as free and clear
      *   out the hash table.  
      */
-    hdr->prop_entry_free = 0;
-    memset(hdr->hash_arr, 0, hdr->hash_siz * sizeof(hdr->hash_arr[0]));
+    hdr->clear_props();
+
+    /* this discards all of our property entries */
+    G_tadsobj_ic->inval();
 
     /* if we need space for more superclasses, reallocate the header */
     if (sc_cnt > hdr->sc_cnt)
@@ -1856,16 +2040,38 @@ void CVmObjTads::reload_from_image(VMG_ vm_obj_id_t self,
         /* allocate the new header */
         ext_ = (char *)vm_tadsobj_hdr::expand_to(
             vmg_ this, hdr, sc_cnt, hdr->prop_entry_cnt);
+
+        /* get the new header */
+        hdr = get_hdr();
     }
 
     /* reload the image properties and superclasses */
     load_image_props_and_scs(vmg_ ptr, siz);
+    hdr->sc_cnt = sc_cnt;
+
+    /* 
+     *   if we're going back to the original superclasses, the cached
+     *   inheritance paths for us and our subclasses are out of date 
+     */
+    if (sc_changed)
+    {
+        hdr->inval_inh_path();
+        inval_inh_paths_with(vmg_ self);
+    }
 
     /* we're now unmodified from the image file state */
     hdr->intern_obj_flags &= ~VMTO_OBJ_MOD;
 
-    /* request post-load initialization, to set up the superclass list */
-    G_obj_table->request_post_load_init(self);
+    /* 
+     *   Cache the superclass object pointers.  Every image file object is
+     *   already loaded at this point, so we don't need to wait for post-load
+     *   initialization, and we're still registered for it from the original
+     *   load in any case, so there's no need to request it again.  (Looking
+     *   up the registration for every object is surprisingly costly in a
+     *   large game.)  
+     */
+    for (int i = 0 ; i < hdr->sc_cnt ; ++i)
+        hdr->sc[i].objp = (CVmObjTads *)vm_objp(vmg_ hdr->sc[i].id);
 }
 
 /*
@@ -1899,17 +2105,32 @@ void CVmObjTads::load_image_props_and_scs(VMG_ const char *ptr, size_t siz)
         hdr->sc[i].objp = 0;
     }
 
-    /* read the properties from the load image and store them */
-    for (i = 0 ; i < li_cnt ; ++i, p += 2 + VMB_DATAHOLDER)
+    /* 
+     *   Read the properties from the load image and store them.  We start
+     *   with an empty table, so we can fill in the entries directly, and
+     *   set up the index once we have them all.  
+     */
+    vm_tadsobj_prop *entry = hdr->prop_entry_arr;
+    for (i = 0 ; i < li_cnt ; ++i, ++entry, p += 2 + VMB_DATAHOLDER)
     {
-        /* decode the property data */
-        vm_prop_id_t prop = (vm_prop_id_t)osrp2(p);
-        vm_val_t val;
-        vmb_get_dh(p + 2, &val);
-
-        /* store the property */
-        hdr->alloc_prop_entry(prop, &val, 0);
+        entry->prop = (vm_prop_id_t)osrp2(p);
+        entry->flags = 0;
+        vmb_get_dh(p + 2, &entry->val);
     }
+    hdr->prop_entry_free = li_cnt;
+
+    /* 
+     *   if the object needs an index, use the prebuilt index from the image
+     *   file if there is one, otherwise build it (the index is empty at
+     *   this point, since we just allocated or cleared the table) 
+     */
+    size_t used = (size_t)(p - ptr);
+    if (hdr->slot_arr != 0
+        && !hdr->adopt_image_index(p, used < siz ? siz - used : 0))
+        hdr->rebuild_slots();
+
+    /* we've replaced our property table, so drop cached lookups */
+    G_tadsobj_ic->inval();
 }
 
 /* ------------------------------------------------------------------------ */
@@ -2105,6 +2326,15 @@ void CVmObjTads::set_sc_cb(VMG_ vm_obj_id_t obj, void *ctx0)
     }
 }
 
+/*
+ *   Invalidate the cached inheritance paths involving an object 
+ */
+void CVmObjTads::inval_inh_paths_with(VMG_ vm_obj_id_t obj)
+{
+    set_sc_cb_ctx ctx(obj);
+    G_obj_table->for_each(vmg_ &set_sc_cb, &ctx);
+}
+
 /* ------------------------------------------------------------------------ */
 /*
  *   Property evaluator - setSuperclassList 
@@ -2205,6 +2435,7 @@ int CVmObjTads::getp_set_sc_list(VMG_ vm_obj_id_t self,
     }
 
     /* update the superclass list with the given list */
+    G_obj_table->remember_obj(self);
     change_superclass_list(vmg_ lst, sc_cnt);
 
     /* discard arguments */
@@ -2214,8 +2445,7 @@ int CVmObjTads::getp_set_sc_list(VMG_ vm_obj_id_t self,
     retval->set_nil();
 
     /* we need to clear all cached superclass path lists involving 'self' */
-    set_sc_cb_ctx ctx(self);
-    G_obj_table->for_each(vmg_ &set_sc_cb, &ctx);
+    inval_inh_paths_with(vmg_ self);
 
     /* handled */
     return TRUE;
@@ -2266,6 +2496,9 @@ void CVmObjTads::change_superclass_list(VMG_ const vm_val_t *lst, int cnt)
 
     /* invalidate the cached inheritance path */
     hdr->inval_inh_path();
+
+    /* this changes the results of inherited lookups */
+    G_tadsobj_ic->inval();
 }
 
 /* ------------------------------------------------------------------------ */
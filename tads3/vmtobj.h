@@ -64,8 +64,39 @@ class CVmObjTads;
  *.  ...
  *.  UINT2 load_image_property_ID_N
  *.  DATAHOLDER load_image_property_value_N 
+ *   
+ *   The property list can be followed by a prebuilt property index, which
+ *   lets us set up the object's in-memory index without hashing and
+ *   probing for each property at load time:
+ *   
+ *.  UINT2 index_format (VMTOBJ_IMGIDX_FMT)
+ *.  UINT2 slot_count
+ *.  UBYTE slot_for_property_1
+ *.  ...
+ *.  UBYTE slot_for_property_N
+ *   
+ *   The slot bytes give the index slot of each property in the property
+ *   list, in the same order.  The index is only useful if it was built with
+ *   the same hash function and table size that we use, so the format code
+ *   identifies the hash function, and we ignore an index with a format or
+ *   size we don't expect, and build the index ourselves instead.  Older
+ *   interpreters ignore the extra data entirely.
  */  
 
+/*
+ *   Prebuilt property index format code.  Change this whenever the index
+ *   hash function or the index sizing changes.  
+ */
+#define VMTOBJ_IMGIDX_FMT  1
+
+/* 
+ *   Maximum property count for a prebuilt index (so that the index has at
+ *   most 256 slots, and each slot number fits in a byte), and the largest
+ *   prebuilt index that can result 
+ */
+#define VMTOBJ_IMGIDX_MAX_PROPS  127
+#define VMTOBJ_IMGIDX_MAX_SIZE   (4 + VMTOBJ_IMGIDX_MAX_PROPS)
+
 /* superclass structure for object extension */
 struct vm_tadsobj_sc
 {
@@ -74,10 +105,34 @@ struct vm_tadsobj_sc
 };
 
 
+/*
+ *   Property index slot.  Larger objects keep an open-addressed index of
+ *   these alongside their property entries: each slot holds a property ID
+ *   and the index of its entry in prop_entry_arr.  A slot with property ID
+ *   VM_INVALID_PROP is empty.  The slots are deliberately tiny (four bytes)
+ *   so that a probe sequence usually stays within a single cache line, and
+ *   a lookup only touches the property entry itself on a hit.  
+ */
+struct vm_tadsobj_slot
+{
+    vm_prop_id_t prop;
+    unsigned short idx;
+};
+
+/*
+ *   Maximum number of property entries for which we don't bother building a
+ *   slot index.  For an object this small, a linear scan of the entry array
+ *   touches no more memory than a probe would, so we store the entries
+ *   inline in the header block and search them directly.  
+ */
+#define VMTOBJ_INLINE_PROPS  8
+
 /*
  *   For our in-memory object extension, we use a structure that stores the
- *   object data.  We store the properties in a hash table keyed on property
- *   ID.  
+ *   object data.  The properties are stored in a flat array of entries,
+ *   allocated in the same memory block as the header; objects with more
+ *   than VMTOBJ_INLINE_PROPS entries also have an open-addressed index
+ *   (with linear probing) keyed on property ID.  
  */
 struct vm_tadsobj_hdr
 {
@@ -116,18 +171,132 @@ struct vm_tadsobj_hdr
     /* find a property entry */
     struct vm_tadsobj_prop *find_prop_entry(uint prop);
 
-    /* allocate a new hash entry */
+    /* allocate a new property entry */
     vm_tadsobj_prop *alloc_prop_entry(vm_prop_id_t prop,
                                       const vm_val_t *val,
                                       unsigned int flags);
 
-    /* calculate the hash code for a property */
+    /* 
+     *   delete the most recently allocated property entry (used to undo a
+     *   property addition) 
+     */
+    void free_last_prop_entry();
+
+    /* 
+     *   discard all property entries, leaving the table allocated at its
+     *   current size 
+     */
+    void clear_props();
+
+    /* calculate the starting index slot for a property */
     unsigned int calc_hash(uint prop) const
+        { return hash_prop(prop, slot_shift); }
+
+    /* 
+     *   Calculate the starting index slot for a property, given the hash
+     *   shift for the index size.  If this changes, VMTOBJ_IMGIDX_FMT has to
+     *   change with it.  
+     */
+    static unsigned int hash_prop(uint prop, unsigned short shift)
     {
-        /* simply take the property ID modulo the table size */
-        return (unsigned int)(prop & (hash_siz - 1));
+        /* 
+         *   Use Fibonacci hashing, taking the high bits of the product.
+         *   Property IDs are assigned sequentially, so the objects of a
+         *   class often define runs of adjacent IDs; scrambling them keeps
+         *   those runs from forming long probe clusters.  
+         */
+        return (unsigned int)(((prop * 0x9E3779B1U) & 0xFFFFFFFFU) >> shift);
     }
 
+    /* 
+     *   Round a property count up to the number of entries we allocate.
+     *   Small counts are rounded up to the next power of two, to avoid
+     *   having to reallocate the object every time a property is added to
+     *   a small object.  
+     */
+    static size_t round_prop_cnt(size_t prop_cnt)
+    {
+        if (prop_cnt <= 2)
+            return 2;
+        if (prop_cnt > 256)
+            return prop_cnt;
+
+        size_t n;
+        for (n = 4 ; n < prop_cnt ; n <<= 1) ;
+        return n;
+    }
+
+    /* 
+     *   Figure the size of the property index for a table of the given
+     *   number of entries, and the hash shift for that size.  Returns zero
+     *   if the table is small enough to search linearly, in which case we
+     *   don't build an index at all.  Otherwise, the index size is the
+     *   smallest power of two that's at least twice the entry count, so
+     *   that the index never gets more than half full, and the hash shift
+     *   is 32 minus the log2 of the index size.  
+     */
+    static unsigned int calc_slot_cnt(size_t prop_cnt, unsigned short *shift)
+    {
+        unsigned int slot_cnt;
+
+        *shift = 31;
+        if (prop_cnt <= VMTOBJ_INLINE_PROPS)
+            return 0;
+
+        for (slot_cnt = 1 ; slot_cnt < 2U*prop_cnt ; slot_cnt <<= 1)
+            --*shift;
+        ++*shift;
+        return slot_cnt;
+    }
+
+    /*
+     *   Build a prebuilt property index for an image file object, given
+     *   its property list in image file format.  Fills in 'dst' (which must
+     *   have room for VMTOBJ_IMGIDX_MAX_SIZE bytes) and returns the length
+     *   of the index data, or zero if the object doesn't need an index.
+     *   This must place each property exactly as add_slot() would when we
+     *   load the object, so that we can adopt the index as-is.  
+     */
+    static size_t build_image_index(char *dst, const char *props,
+                                    size_t prop_cnt)
+    {
+        unsigned short shift;
+        unsigned int slot_cnt;
+        char used[256];
+
+        /* figure the size of the index the loaded object will have */
+        slot_cnt = calc_slot_cnt(round_prop_cnt(prop_cnt), &shift);
+        if (slot_cnt == 0 || prop_cnt > VMTOBJ_IMGIDX_MAX_PROPS)
+            return 0;
+
+        /* write the header */
+        oswp2(dst, VMTOBJ_IMGIDX_FMT);
+        oswp2(dst + 2, slot_cnt);
+
+        /* place each property, in the order the loader will add them */
+        memset(used, 0, slot_cnt);
+        for (size_t i = 0 ; i < prop_cnt ; ++i, props += 2 + VMB_DATAHOLDER)
+        {
+            unsigned int j;
+            for (j = hash_prop(osrp2(props), shift) ; used[j] ;
+                 j = (j + 1) & (slot_cnt - 1)) ;
+            used[j] = 1;
+            dst[4 + i] = (char)j;
+        }
+
+        /* return the index size */
+        return 4 + prop_cnt;
+    }
+
+    /* 
+     *   Set up our property index from a prebuilt index from the image
+     *   file, after loading the property entries into an empty table.  'p'
+     *   points to the data following the property list, and 'len' is its
+     *   length.  Returns true on success, false if there's no usable index,
+     *   in which case the caller must rebuild the index.  
+     */
+    int adopt_image_index(const char *p, size_t len);
+
     /* check to see if we have the required number of free entries */
     int has_free_entries(size_t cnt) const
         { return cnt <= (size_t)(prop_entry_free - prop_entry_cnt); }
@@ -145,48 +314,48 @@ struct vm_tadsobj_hdr
      */
     struct tadsobj_objid_and_ptr *inh_path;
 
-    /* load image object flags (a combination of VMTOBJ_OBJF_xxx values) */
-    unsigned short li_obj_flags;
-
-    /* internal object flags (a combination of VMTO_OBJ_xxx values) */
-    unsigned short intern_obj_flags;
-
     /* 
-     *   Number of hash buckets, and a pointer to the bucket array.  (The
-     *   hash bucket array is allocated as part of the same memory block as
-     *   this structure - we suballocate it from the memory block when
-     *   allocating the structure.)  'hash_arr[hash]' points to the head of
-     *   a list of property entries with the given hash value.
+     *   Pointer to the property index.  This is null for objects with no
+     *   more than VMTOBJ_INLINE_PROPS entries, in which case we search the
+     *   entry array directly.  Otherwise it's an array of slot_cnt slots
+     *   (always a power of two, and at least twice prop_entry_cnt, so the
+     *   table is never more than half full), suballocated from the same
+     *   memory block as this structure.  
      */
-    unsigned short hash_siz;
-    struct vm_tadsobj_prop **hash_arr;
+    struct vm_tadsobj_slot *slot_arr;
 
     /*
-     *   Pointer to our allocation array of hash buckets.  We suballocate
-     *   this out of our allocation block.  (Note that this isn't the hash
-     *   table; this is the pool of elements out of which hash table entries
-     *   - not buckets, but the entries in the lists pointed to by the
-     *   buckets - are allocated.)  
+     *   Pointer to our array of property entries.  We suballocate this out
+     *   of our allocation block.  Entries are allocated in order from the
+     *   start of the array, so the entries in use are always contiguous,
+     *   and an entry never moves until the whole header is reallocated.  
      */
     struct vm_tadsobj_prop *prop_entry_arr;
 
-    /* total number of hash entries allocated */
+    /* number of index slots, and the hash shift for that size */
+    unsigned int slot_cnt;
+    unsigned short slot_shift;
+
+    /* load image object flags (a combination of VMTOBJ_OBJF_xxx values) */
+    unsigned short li_obj_flags;
+
+    /* internal object flags (a combination of VMTO_OBJ_xxx values) */
+    unsigned short intern_obj_flags;
+
+    /* total number of property entries allocated */
     unsigned short prop_entry_cnt;
 
     /* 
-     *   Index of next available hash entry.  Hash entries are never
-     *   deleted, so we don't have to worry about returning entries to the
-     *   free pool.  So, the free pool simply consists of entries from this
+     *   Index of next available property entry.  Entries are only ever
+     *   removed from the end of the array (when undoing a property
+     *   addition), so the free pool simply consists of entries from this
      *   index to the maximum index (prop_entry_cnt - 1).
      *   
      *   When we run out of entries, we must reallocate this entire
      *   structure to make room for more.  This means that reallocation is
      *   fairly expensive, but this is acceptable because we will always
-     *   want to resize the hash table at the same time anyway.  We always
-     *   resize the hash table on exhausting our current allocation size
-     *   because we pick the hash table size based on the expected maximum
-     *   number of entries; once we exceed that maximum, we must reconsider
-     *   the hash table size.  
+     *   want to resize the index at the same time anyway, since we size the
+     *   index based on the maximum number of entries.  
      */
     unsigned short prop_entry_free;
     
@@ -198,20 +367,34 @@ struct vm_tadsobj_hdr
      */
     unsigned short sc_cnt;
     vm_tadsobj_sc sc[1];
+
+    /* add an entry to the property index */
+    void add_slot(vm_prop_id_t prop, unsigned short idx)
+    {
+        /* probe from the home slot to the first empty slot */
+        unsigned int mask = slot_cnt - 1;
+        unsigned int i;
+        for (i = calc_hash(prop) ; slot_arr[i].prop != VM_INVALID_PROP ;
+             i = (i + 1) & mask) ;
+
+        /* fill in the slot */
+        slot_arr[i].prop = prop;
+        slot_arr[i].idx = idx;
+    }
+
+    /* rebuild the property index from the entry array */
+    void rebuild_slots();
 };
 
 /*
- *   Tads-object property entry.  Each hash table entry points to a linked
- *   list of these entries.  
+ *   Tads-object property entry.  The flags are stored next to the
+ *   property ID so that they share the padding ahead of the value.  
  */
 struct vm_tadsobj_prop
 {
     /* my property ID */
     vm_prop_id_t prop;
 
-    /* pointer to the next entry at the same hash value */
-    vm_tadsobj_prop *nxt;
-
     /* flags */
     unsigned char flags;
 
@@ -327,7 +510,7 @@ public:
     virtual int equals(VMG_ vm_obj_id_t self, const vm_val_t *val,
                        int depth) const
     {
-        if (((vm_tadsobj_hdr *)ext_)->hash_siz == 0)
+        if (((vm_tadsobj_hdr *)ext_)->prop_entry_cnt == 0)
             return TRUE;
         else
             return (val->typ == VM_OBJ && val->val.obj == self);
@@ -335,7 +518,7 @@ public:
 
     virtual uint calc_hash(VMG_ vm_obj_id_t self, int /*depth*/) const
     {
-        if (((vm_tadsobj_hdr *)ext_)->hash_siz == 0)
+        if (((vm_tadsobj_hdr *)ext_)->prop_entry_cnt == 0)
             return 0;
         else
             return (uint)(((ulong)self & 0xffff)
@@ -398,6 +581,11 @@ public:
     int get_prop(VMG_ vm_prop_id_t prop, vm_val_t *val,
                  vm_obj_id_t self, vm_obj_id_t *source_obj, uint *argc);
 
+    /* get a property, using the inline property cache */
+    int get_prop_at_site(VMG_ vm_prop_id_t prop, vm_val_t *val,
+                         vm_obj_id_t self, vm_obj_id_t *source_obj,
+                         uint *argc, const uchar *site);
+
     /* inherit a property */
     int inh_prop(VMG_ vm_prop_id_t prop, vm_val_t *val,
                  vm_obj_id_t self,
@@ -442,6 +630,9 @@ public:
      */
     void remove_stale_weak_refs(VMG0_) { }
 
+    /* we notify the object table of reference stores */
+    int has_write_barrier() const { return TRUE; }
+
     /* load from an image file */
     void load_from_image(VMG_ vm_obj_id_t self, const char *ptr, size_t siz);
 
@@ -622,6 +813,12 @@ protected:
     /* object table iteration callback for setSuperclassList */
     static void set_sc_cb(VMG_ vm_obj_id_t obj, void *ctx);
 
+    /* 
+     *   invalidate the cached inheritance paths of all objects that have
+     *   'obj' in their paths, after changing obj's superclass list 
+     */
+    static void inval_inh_paths_with(VMG_ vm_obj_id_t obj);
+
     /* property evaluator - getMethod */
     int getp_get_method(VMG_ vm_obj_id_t self,
                         vm_val_t *retval, uint *in_argc);
@@ -729,6 +926,15 @@ public:
     int get_prop(VMG_ vm_prop_id_t prop, vm_val_t *val,
                  vm_obj_id_t self, vm_obj_id_t *source_obj, uint *argc);
 
+    /* 
+     *   get a property at a call site - we resolve properties differently
+     *   from a regular TadsObject, so don't use the inline cache 
+     */
+    int get_prop_at_site(VMG_ vm_prop_id_t prop, vm_val_t *val,
+                         vm_obj_id_t self, vm_obj_id_t *source_obj,
+                         uint *argc, const uchar *)
+        { return get_prop(vmg_ prop, val, self, source_obj, argc); }
+
     /* inherit a property */
     int inh_prop(VMG_ vm_prop_id_t prop, vm_val_t *val,
                  vm_obj_id_t self,
@@ -1073,7 +1279,178 @@ protected:
     pfq_page *alloc_;
 };
 
+/* ------------------------------------------------------------------------ */
+/*
+ *   Inline property cache.  This remembers the results of inherited
+ *   property lookups made by the GETPROP/CALLPROP family of instructions, so
+ *   that a call site that keeps evaluating the same property of objects of
+ *   the same class can skip the walk up the superclass tree.
+ *   
+ *   Each entry is keyed on the calling instruction, the property, and the
+ *   superclass list of the target object.  We only consult the cache after
+ *   checking the target object's own property table, so the result of the
+ *   superclass search depends only on the superclass list.  We only cache
+ *   objects with a small number of superclasses, so that the key has a
+ *   fixed size.  The cache is set-associative: each instruction hashes to a
+ *   set of a few entries, which lets a polymorphic call site keep results
+ *   for several classes at once.
+ *   
+ *   An entry points directly to the property table entry where the search
+ *   found the property, rather than holding a copy of the value.  This means
+ *   that changing the value of an existing property in a class doesn't
+ *   affect cached results.  Anything that changes the outcome of a search
+ *   or moves a property entry - adding or deleting a property entry,
+ *   reallocating an object header, changing a superclass list, deleting an
+ *   object - must call inval(), which invalidates every cached entry at once
+ *   by advancing the cache generation number.  These operations are rare
+ *   compared to property lookups.  
+ */
+
+/* maximum number of superclasses in a cache key */
+const int VMTOBJ_IC_MAX_SC = 4;
+
+/* number of entries per set */
+const int VMTOBJ_IC_WAYS = 4;
+
+/* number of sets - this must be a power of 2 */
+const int VMTOBJ_IC_SETS = 512;
 
+/* cache entry */
+struct vm_tadsobj_ic_entry
+{
+    /* cache generation number when we added the entry */
+    ulong gen;
+
+    /* the calling instruction */
+    const uchar *site;
+
+    /* the property */
+    vm_prop_id_t prop;
+
+    /* superclass count and superclass list of the target object */
+    unsigned short sc_cnt;
+    vm_obj_id_t sc[VMTOBJ_IC_MAX_SC];
+
+    /* the object that defines the property, and its property entry */
+    vm_obj_id_t defining_obj;
+    vm_tadsobj_prop *entry;
+};
+
+class CVmObjTadsPropCache
+{
+public:
+    CVmObjTadsPropCache()
+    {
+        init();
+    }
+
+    void init()
+    {
+        /* clear all entries and start at generation 1 */
+        memset(ents_, 0, sizeof(ents_));
+        memset(victim_, 0, sizeof(victim_));
+        gen_ = 1;
+    }
+
+    /* invalidate all cached entries */
+    void inval()
+    {
+        /* 
+         *   advance the generation; in the unlikely event that we wrap
+         *   around, clear the table so that old entries can't match again 
+         */
+        if (++gen_ == 0)
+            init();
+    }
+
+    /* 
+     *   Find the cached entry for the given property at the given call site,
+     *   for an object with the given header.  Returns null if there's no
+     *   valid cache entry.  
+     */
+    vm_tadsobj_ic_entry *find(const uchar *site, vm_prop_id_t prop,
+                              const vm_tadsobj_hdr *hdr)
+    {
+        vm_tadsobj_ic_entry *e = ents_[set_for(site)];
+        for (int i = 0 ; i < VMTOBJ_IC_WAYS ; ++i, ++e)
+        {
+            if (e->site == site && e->prop == prop && e->gen == gen_
+                && key_matches(e, hdr))
+                return e;
+        }
+
+        /* not found */
+        return 0;
+    }
+
+    /* 
+     *   Add an entry.  If the object has too many superclasses to use as a
+     *   key, we simply don't cache the result.  
+     */
+    void add(const uchar *site, vm_prop_id_t prop, const vm_tadsobj_hdr *hdr,
+             vm_obj_id_t defining_obj, vm_tadsobj_prop *entry)
+    {
+        /* if the superclass list is too long for a key, skip it */
+        if (hdr->sc_cnt > VMTOBJ_IC_MAX_SC)
+            return;
+
+        /* 
+         *   pick the entry to replace - use an expired entry if there is
+         *   one, otherwise take the next entry in round-robin order 
+         */
+        uint set = set_for(site);
+        vm_tadsobj_ic_entry *e = ents_[set];
+        int i;
+        for (i = 0 ; i < VMTOBJ_IC_WAYS && e[i].gen == gen_ ; ++i) ;
+        if (i == VMTOBJ_IC_WAYS)
+        {
+            i = victim_[set];
+            victim_[set] = (uchar)((i + 1) % VMTOBJ_IC_WAYS);
+        }
+        e += i;
+
+        /* fill in the entry */
+        e->gen = gen_;
+        e->site = site;
+        e->prop = prop;
+        e->sc_cnt = hdr->sc_cnt;
+        for (i = 0 ; i < hdr->sc_cnt ; ++i)
+            e->sc[i] = hdr->sc[i].id;
+        e->defining_obj = defining_obj;
+        e->entry = entry;
+    }
+
+protected:
+    /* get the set index for a call site */
+    static uint set_for(const uchar *site)
+    {
+        ulong a = (ulong)site;
+        return (uint)((a ^ (a >> 9)) & (VMTOBJ_IC_SETS - 1));
+    }
+
+    /* does the entry's key match the given object's superclass list? */
+    static int key_matches(const vm_tadsobj_ic_entry *e,
+                           const vm_tadsobj_hdr *hdr)
+    {
+        if (e->sc_cnt != hdr->sc_cnt)
+            return FALSE;
+        for (int i = 0 ; i < e->sc_cnt ; ++i)
+        {
+            if (e->sc[i] != hdr->sc[i].id)
+                return FALSE;
+        }
+        return TRUE;
+    }
+
+    /* the cache entries, arranged by set */
+    vm_tadsobj_ic_entry ents_[VMTOBJ_IC_SETS][VMTOBJ_IC_WAYS];
+
+    /* next entry to replace in each set */
+    uchar victim_[VMTOBJ_IC_SETS];
+
+    /* current generation number */
+    ulong gen_;
+};
 
 
 #endif /* VMTOBJ_H */
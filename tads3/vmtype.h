@@ -775,6 +775,12 @@ inline void vmb_put_dh_prop(char *buf, vm_prop_id_t prop)
 /* get the value portion of a vm_val_t from a portable dataholder */
 void vmb_get_dh_val(const char *buf, vm_val_t *val);
 
+/* 
+ *   determine if two portable dataholders hold the identical value - the
+ *   same type and the same value, ignoring any bytes the type doesn't use 
+ */
+int vmb_dh_same(const char *a, const char *b);
+
 /* get the type from a portable dataholder */
 inline vm_datatype_t vmb_get_dh_type(const char *buf)
     { return (vm_datatype_t)buf[0]; }
@@ -86,6 +86,48 @@ void vmb_put_dh(char *buf, const vm_val_t *val)
     }
 }
 
+/*
+ *   Determine if two portable data holders hold the identical value 
+ */
+int vmb_dh_same(const char *a, const char *b)
+{
+    size_t len;
+
+    /* if the types differ, the values differ */
+    if (a[0] != b[0])
+        return FALSE;
+
+    /* figure the number of value bytes the type uses */
+    switch((vm_datatype_t)a[0])
+    {
+    case VM_PROP:
+        len = 2;
+        break;
+
+    case VM_OBJ:
+    case VM_OBJX:
+    case VM_INT:
+    case VM_BIFPTR:
+    case VM_BIFPTRX:
+    case VM_ENUM:
+    case VM_SSTRING:
+    case VM_DSTRING:
+    case VM_LIST:
+    case VM_CODEOFS:
+    case VM_FUNCPTR:
+        len = 4;
+        break;
+
+    default:
+        /* other types have no extra data */
+        len = 0;
+        break;
+    }
+
+    /* compare the value bytes */
+    return memcmp(a + 1, b + 1, len) == 0;
+}
+
 /*
  *   Get only the value portion of a vm_val_t from a portable data holder 
  */
@@ -25,10 +25,14 @@ Modified
 #include "vmobj.h"
 #include "vmundo.h"
 
+
+/* initial size of the saved-key index (must be a power of two) */
+const size_t VMUNDO_KEYS_INIT = 64;
+
 /*
  *   create the undo manager 
  */
-CVmUndo::CVmUndo(size_t undo_record_cnt, uint max_savepts)
+CVmUndo::CVmUndo(size_t undo_record_cnt, uint max_savepts, size_t max_bytes)
 {
     /* remember the maximum number of savepoints */
     max_savepts_ = (vm_savept_t)max_savepts;
@@ -42,19 +46,67 @@ CVmUndo::CVmUndo(size_t undo_record_cnt, uint max_savepts)
     /* no savepoints have been created yet */
     savept_cnt_ = 0;
 
-    /* create the undo record array */
-    rec_arr_size_ = undo_record_cnt;
-    rec_arr_ = (CVmUndoMeta *)t3malloc(rec_arr_size_
-                                       * sizeof(rec_arr_[0]));
-
     /* we have no records at all yet, so we have no "firsts" */
     cur_first_ = 0;
     oldest_first_ = 0;
 
+    /* we don't allocate the saved-key index until we need it */
+    keys_ = 0;
+    keys_size_ = 0;
+    keys_cnt_ = 0;
+
+    /* create the undo record array */
+    rec_arr_cnt_ = undo_record_cnt;
+    rec_arr_ = 0;
+    alloc_rec_arr(max_bytes);
+}
+
+/*
+ *   Allocate the record array for the given byte budget 
+ */
+void CVmUndo::alloc_rec_arr(size_t max_bytes)
+{
+    /* 
+     *   Remember the byte budget.  If we have one, limit the record array
+     *   to half of it, so that there's room for the records' extra data.  
+     */
+    max_bytes_ = max_bytes;
+    extra_bytes_ = 0;
+    size_t cnt = rec_arr_cnt_;
+    if (max_bytes != 0 && cnt > max_bytes / 2 / sizeof(CVmUndoMeta))
+    {
+        /* use what fits, but keep enough records to be useful */
+        cnt = max_bytes / 2 / sizeof(CVmUndoMeta);
+        if (cnt < 64)
+            cnt = 64;
+    }
+
+    /* create the undo record array */
+    if (rec_arr_ != 0)
+        t3free(rec_arr_);
+    rec_arr_size_ = cnt;
+    rec_arr_ = (CVmUndoMeta *)t3malloc(rec_arr_size_
+                                       * sizeof(rec_arr_[0]));
+
     /* start allocating from the first entry in the array */
     next_free_ = rec_arr_;
 }
 
+/*
+ *   Set the byte budget 
+ */
+void CVmUndo::set_max_bytes(VMG_ size_t max_bytes)
+{
+    /* 
+     *   discard all undo, since the records might not fit in the new array
+     *   or the new budget 
+     */
+    drop_undo(vmg0_);
+
+    /* set up the record array for the new budget */
+    alloc_rec_arr(max_bytes);
+}
+
 /*
  *   delete the undo manager 
  */
@@ -62,6 +114,10 @@ CVmUndo::~CVmUndo()
 {
     /* delete the array of undo records */
     t3free(rec_arr_);
+
+    /* delete the saved-key index */
+    if (keys_ != 0)
+        t3free(keys_);
 }
 
 /*
@@ -124,6 +180,9 @@ void CVmUndo::create_savept(VMG0_)
     /* count the new savepoint */
     ++savept_cnt_;
 
+    /* keys saved in the old savepoint don't apply to the new one */
+    clear_saved_keys();
+
     /* notify the objects that we're starting a new savepoint */
     G_obj_table->notify_new_savept();
 }
@@ -153,7 +212,10 @@ void CVmUndo::drop_oldest_savept(VMG0_)
         {
             /* discard this entry, if it still exists */
             if (meta->rec.obj != VM_INVALID_OBJ)
+            {
                 vm_objp(vmg_ meta->rec.obj)->discard_undo(vmg_ &meta->rec);
+                release_extra(&meta->rec);
+            }
             
             /* advance to the next record */
             inc_rec_ptr(&meta);
@@ -167,9 +229,15 @@ void CVmUndo::drop_oldest_savept(VMG0_)
             oldest_first_->link.prev_first = 0;
     }
 
-    /* if we don't have an oldest, we also don't have a current */
+    /* 
+     *   if we don't have an oldest, we also don't have a current, so any
+     *   keys we noted for it are gone 
+     */
     if (oldest_first_ == 0)
+    {
         cur_first_ = 0;
+        clear_saved_keys();
+    }
 }
 
 /*
@@ -190,6 +258,10 @@ void CVmUndo::drop_undo(VMG0_)
 
     /* start allocating from the start of the array */
     next_free_ = rec_arr_;
+
+    /* there's no extra data left, and no saved keys */
+    extra_bytes_ = 0;
+    clear_saved_keys();
 }
 
 /*
@@ -264,13 +336,14 @@ void CVmUndo::add_new_record_prop_key(VMG_ vm_obj_id_t obj, vm_prop_id_t key,
     CVmUndoRecord *rec;
 
     /* allocate the new record */
-    rec = add_new_record(vmg_ obj);
+    rec = add_new_record(vmg_ obj, 0);
 
     /* if we successfully allocated a record, set it up */
     if (rec != 0)
     {
         /* set the object */
         rec->obj = obj;
+        rec->extra_bytes = 0;
         
         /* set the key */
         rec->id.prop = key;
@@ -289,16 +362,16 @@ void CVmUndo::add_new_record_int_key(VMG_ vm_obj_id_t obj, uint32_t key,
     CVmUndoRecord *rec;
 
     /* allocate the new record */
-    rec = add_new_record(vmg_ obj);
+    rec = add_new_record(vmg_ obj, 0);
 
     /* if we successfully allocated a record, set it up */
     if (rec != 0)
     {
         /* set the object */
         rec->obj = obj;
+        rec->extra_bytes = 0;
         
         /* set the key */
-
         rec->id.intval = key;
 
         /* set the value */
@@ -310,12 +383,12 @@ void CVmUndo::add_new_record_int_key(VMG_ vm_obj_id_t obj, uint32_t key,
  *   Add a new record with a pointer key
  */
 int CVmUndo::add_new_record_ptr_key(VMG_ vm_obj_id_t obj, void *key,
-                                    const vm_val_t *val)
+                                    const vm_val_t *val, size_t extra_bytes)
 {
     CVmUndoRecord *rec;
 
     /* allocate the new record */
-    rec = add_new_record(vmg_ obj);
+    rec = add_new_record(vmg_ obj, extra_bytes);
 
     /* if we successfully allocated a record, set it up */
     if (rec != 0)
@@ -323,6 +396,10 @@ int CVmUndo::add_new_record_ptr_key(VMG_ vm_obj_id_t obj, void *key,
         /* set the object */
         rec->obj = obj;
 
+        /* count the extra data */
+        rec->extra_bytes = (uint32_t)extra_bytes;
+        extra_bytes_ += extra_bytes;
+
         /* set the key */
         rec->id.ptrval = key;
 
@@ -337,7 +414,8 @@ int CVmUndo::add_new_record_ptr_key(VMG_ vm_obj_id_t obj, void *key,
 /*
  *   Add a new undo record 
  */
-CVmUndoRecord *CVmUndo::add_new_record(VMG_ vm_obj_id_t controlling_obj)
+CVmUndoRecord *CVmUndo::add_new_record(VMG_ vm_obj_id_t controlling_obj,
+                                       size_t extra_bytes)
 {
     CVmUndoMeta *meta;
     
@@ -353,6 +431,24 @@ CVmUndoRecord *CVmUndo::add_new_record(VMG_ vm_obj_id_t controlling_obj)
      */
     if (!G_obj_table->is_obj_in_undo(controlling_obj))
         return 0;
+
+    /* 
+     *   If we have a byte budget, make room for the extra data by
+     *   discarding the oldest savepoints.  If the extra data doesn't fit
+     *   even with the current savepoint alone, we can't keep the current
+     *   savepoint complete, so it's no longer valid - discard it too.  
+     */
+    if (max_bytes_ != 0 && extra_bytes != 0)
+    {
+        size_t arr_bytes = rec_arr_size_ * sizeof(rec_arr_[0]);
+        while (savept_cnt_ != 0
+               && arr_bytes + extra_bytes_ + extra_bytes > max_bytes_)
+            drop_oldest_savept(vmg0_);
+
+        /* if that left us without a savepoint, we can't keep undo */
+        if (savept_cnt_ == 0)
+            return 0;
+    }
     
     /* allocate a new record */
     meta = alloc_rec(vmg0_);
@@ -396,6 +492,9 @@ void CVmUndo::undo_to_savept(VMG0_)
 
         /* apply this undo record */
         G_obj_table->apply_undo(vmg_ &meta->rec);
+
+        /* the record's extra data is gone now */
+        release_extra(&meta->rec);
     }
 
     /*
@@ -424,6 +523,9 @@ void CVmUndo::undo_to_savept(VMG0_)
     /* the savepoint link we just removed is now the next free record */
     next_free_ = meta;
 
+    /* the keys we noted were for the savepoint we just applied */
+    clear_saved_keys();
+
     /* 
      *   notify objects that a new savepoint is in effect - the savepoint
      *   isn't new in the sense of being newly created, but in the sense of
@@ -506,6 +608,13 @@ void CVmUndo::gc_remove_stale_weak_refs(VMG0_)
     CVmUndoMeta *cur;
     CVmUndoMeta *next_link;
 
+    /* 
+     *   Forget the saved keys.  We might be about to delete weak references
+     *   from the records that the keys stand for, which would make the
+     *   records stop restoring their old values.  
+     */
+    clear_saved_keys();
+
     /* if we don't have any records, there's nothing to do */
     if (oldest_first_ == 0)
         return;
@@ -554,6 +663,7 @@ void CVmUndo::gc_remove_stale_weak_refs(VMG0_)
                  *   setting the owning object to 'invalid' 
                  */
                 cur->rec.obj = VM_INVALID_OBJ;
+                release_extra(&cur->rec);
             }
         }
 
@@ -568,3 +678,118 @@ void CVmUndo::gc_remove_stale_weak_refs(VMG0_)
     }
 }
 
+/* ------------------------------------------------------------------------ */
+/*
+ *   Saved-key index 
+ */
+
+/* hash an object/key pair into the saved-key index */
+static inline size_t undo_key_hash(vm_obj_id_t obj, uint32_t key)
+{
+    uint32_t h = (uint32_t)obj * 0x9E3779B1U;
+    return (size_t)((h ^ (key + 0x7F4A7C15U + (h << 6) + (h >> 2)))
+                    * 0x85EBCA6BU);
+}
+
+/*
+ *   Did we note a record for this object and key in the current savepoint? 
+ */
+int CVmUndo::is_key_saved(vm_obj_id_t obj, uint32_t key) const
+{
+    /* if the index is empty, there's nothing to find */
+    if (keys_cnt_ == 0)
+        return FALSE;
+
+    /* probe from the hash position until we find the key or an empty slot */
+    size_t mask = keys_size_ - 1;
+    for (size_t i = undo_key_hash(obj, key) & mask ; ; i = (i + 1) & mask)
+    {
+        if (keys_[i].obj == obj && keys_[i].key == key)
+            return TRUE;
+        if (keys_[i].obj == VM_INVALID_OBJ)
+            return FALSE;
+    }
+}
+
+/*
+ *   Note that we've saved a record for an object and key in the current
+ *   savepoint 
+ */
+void CVmUndo::note_key_saved(vm_obj_id_t obj, uint32_t key)
+{
+    /* if there's no savepoint, there's nothing to note */
+    if (savept_cnt_ == 0)
+        return;
+
+    /* grow the table if adding this key would make it over half full */
+    if ((keys_cnt_ + 1) * 2 > keys_size_)
+    {
+        saved_key *old_keys = keys_;
+        size_t old_size = keys_size_;
+
+        /* allocate the new table, with every slot empty */
+        keys_size_ = (old_size == 0 ? VMUNDO_KEYS_INIT : old_size * 2);
+        keys_ = (saved_key *)t3malloc(keys_size_ * sizeof(keys_[0]));
+        memset(keys_, 0, keys_size_ * sizeof(keys_[0]));
+
+        /* move the old keys into the new table */
+        size_t mask = keys_size_ - 1;
+        for (size_t j = 0 ; j < old_size ; ++j)
+        {
+            if (old_keys[j].obj != VM_INVALID_OBJ)
+            {
+                size_t i = undo_key_hash(old_keys[j].obj, old_keys[j].key);
+                for (i &= mask ; keys_[i].obj != VM_INVALID_OBJ ;
+                     i = (i + 1) & mask) ;
+                keys_[i] = old_keys[j];
+            }
+        }
+
+        /* done with the old table */
+        if (old_keys != 0)
+            t3free(old_keys);
+    }
+
+    /* find the key's slot, or the empty slot where it goes */
+    size_t mask = keys_size_ - 1;
+    size_t i;
+    for (i = undo_key_hash(obj, key) & mask ;
+         keys_[i].obj != VM_INVALID_OBJ ; i = (i + 1) & mask)
+    {
+        /* if it's already here, there's nothing more to do */
+        if (keys_[i].obj == obj && keys_[i].key == key)
+            return;
+    }
+
+    /* add it */
+    keys_[i].obj = obj;
+    keys_[i].key = key;
+    ++keys_cnt_;
+}
+
+/*
+ *   Forget all saved keys 
+ */
+void CVmUndo::clear_saved_keys()
+{
+    /* if the index is already empty, there's nothing to do */
+    if (keys_cnt_ == 0)
+        return;
+
+    /* 
+     *   If the table has grown past its initial size, free it, so that one
+     *   busy savepoint doesn't leave us clearing a big table at every
+     *   savepoint from now on; otherwise just empty it out.  
+     */
+    if (keys_size_ > VMUNDO_KEYS_INIT)
+    {
+        t3free(keys_);
+        keys_ = 0;
+        keys_size_ = 0;
+    }
+    else
+        memset(keys_, 0, keys_size_ * sizeof(keys_[0]));
+
+    /* there are no keys now */
+    keys_cnt_ = 0;
+}
@@ -39,6 +39,13 @@ struct CVmUndoRecord
      */
     vm_obj_id_t obj;
 
+    /*
+     *   Number of bytes of separately allocated memory attached to the
+     *   record by its owner, such as the private record that a pointer key
+     *   points to.  We count this against the undo byte budget.  
+     */
+    uint32_t extra_bytes;
+
     /* 
      *   Identifier - the meaning of this member is defined by the object
      *   that created the record.  For TADS objects, this is a property ID
@@ -101,10 +108,25 @@ class CVmUndo
 {
 public:
     /* 
-     *   create the undo manager, specifying the upper limit for memory
-     *   usage and retained savepoints 
+     *   Create the undo manager, specifying the upper limit for memory
+     *   usage and retained savepoints.
+     *   
+     *   If max_bytes is non-zero, it's a budget for the total memory that
+     *   undo can use, counting the record array and any extra data that
+     *   objects attach to their records (saved text, byte blocks, and so
+     *   on).  The record array is limited to half of the budget, to leave
+     *   the rest for the extra data; when a new record would exceed the
+     *   budget, we discard the oldest savepoints until it fits.  Zero means
+     *   that only the record count and savepoint limits apply.  
+     */
+    CVmUndo(size_t undo_record_cnt, uint max_savepts, size_t max_bytes = 0);
+
+    /* 
+     *   Change the byte budget (zero for none).  This discards all undo,
+     *   so it's meant for setting up the VM configuration before the
+     *   program starts running.  
      */
-    CVmUndo(size_t undo_record_cnt, uint max_savepts);
+    void set_max_bytes(VMG_ size_t max_bytes);
 
     /* delete the undo manager */
     ~CVmUndo();
@@ -145,22 +167,47 @@ public:
      *   add_new_record_xxx_key returns an indication of success because
      *   the pointer value might have been allocated, in which case the
      *   caller must deallocate the value if we didn't add an undo
-     *   record.) 
+     *   record.)
+     *   
+     *   'extra_bytes' is the size of the memory that the pointer key refers
+     *   to, if the caller allocated it for the record.  This counts against
+     *   the byte budget for as long as we keep the record.  
      */
     int add_new_record_ptr_key(VMG_ vm_obj_id_t obj, void *key,
-                               const vm_val_t *val);
+                               const vm_val_t *val, size_t extra_bytes);
 
     /* add a new record with a pointer key and no separate value data */
-    int add_new_record_ptr_key(VMG_ vm_obj_id_t obj, void *key)
+    int add_new_record_ptr_key(VMG_ vm_obj_id_t obj, void *key,
+                               size_t extra_bytes)
     {
         /* set up a nil value to fill the value slot in the record */
         vm_val_t nilval;
         nilval.set_nil();
 
         /* save the record */
-        return add_new_record_ptr_key(vmg_ obj, key, &nilval);
+        return add_new_record_ptr_key(vmg_ obj, key, &nilval, extra_bytes);
     }
 
+    /*
+     *   Saved-key index.  Many undo records simply restore an old value for
+     *   some key within an object - an element of a collection, say.  Only
+     *   the oldest such record for a key within a savepoint matters, since
+     *   undo applies the records in reverse order, so the oldest one is
+     *   applied last and overwrites whatever the later ones restored.  An
+     *   object can note that it has saved such a record for a key, and can
+     *   then skip saving more records for the same key until the next
+     *   savepoint.  (This does the same job as the per-property and
+     *   per-element undo flags that TadsObject and Vector keep in their own
+     *   data, for objects that have nowhere to keep such flags.)
+     *   
+     *   The keys are private to each object.  We forget all of the keys
+     *   whenever the current savepoint changes, and after garbage
+     *   collection deletes weak references from undo records, so a key is
+     *   only ever noted while its record is still in effect.  
+     */
+    int is_key_saved(vm_obj_id_t obj, uint32_t key) const;
+    void note_key_saved(vm_obj_id_t obj, uint32_t key);
+
     /*
      *   Apply undo to the latest savepoint.  After applying the undo
      *   records, we delete all undo records to the savepoint; this leaves
@@ -211,12 +258,32 @@ private:
     /*
      *   Add a new record and return the new record.  If we don't have an
      *   active savepoint, this will return null, since there's no need to
-     *   keep undo.  
+     *   keep undo.  'extra_bytes' is the size of any extra memory that the
+     *   caller attaches to the record; this also returns null if the record
+     *   can't fit within the byte budget even after discarding all of the
+     *   older savepoints.  
      */
-    CVmUndoRecord *add_new_record(VMG_ vm_obj_id_t controlling_obj);
+    CVmUndoRecord *add_new_record(VMG_ vm_obj_id_t controlling_obj,
+                                  size_t extra_bytes);
 
     /* discard the oldest savepoint */
     void drop_oldest_savept(VMG0_);
+
+    /* allocate the record array for the given byte budget */
+    void alloc_rec_arr(size_t max_bytes);
+
+    /* forget all saved keys */
+    void clear_saved_keys();
+
+    /* 
+     *   Release the extra memory counted for a record that we're applying
+     *   or discarding 
+     */
+    void release_extra(CVmUndoRecord *rec)
+    {
+        extra_bytes_ -= rec->extra_bytes;
+        rec->extra_bytes = 0;
+    }
     
     /* current savepoint ID */
     vm_savept_t cur_savept_;
@@ -262,6 +329,34 @@ private:
      */
     CVmUndoMeta *rec_arr_;
     size_t rec_arr_size_;
+
+    /* 
+     *   the number of records requested at creation (the array can be
+     *   smaller, to fit within the byte budget) 
+     */
+    size_t rec_arr_cnt_;
+
+    /* 
+     *   The byte budget (zero if we have none), and the total extra bytes
+     *   attached to the records we're currently keeping 
+     */
+    size_t max_bytes_;
+    size_t extra_bytes_;
+
+    /*
+     *   The saved-key index.  This is an open-addressed hash table of
+     *   object/key pairs, with VM_INVALID_OBJ marking empty slots.  The
+     *   table size is always a power of two, and we keep it at most half
+     *   full.  
+     */
+    struct saved_key
+    {
+        vm_obj_id_t obj;
+        uint32_t key;
+    };
+    saved_key *keys_;
+    size_t keys_size_;
+    size_t keys_cnt_;
 };
 
 
@@ -591,6 +591,7 @@ void CVmObjVector::append_element(VMG_ vm_obj_id_t self, const vm_val_t *val)
 
     /* set the element */
     set_element(cnt, val);
+    G_obj_table->note_ref_store(self, val);
 
     /* count it in the vector */
     set_element_count(cnt+1);
@@ -855,6 +856,34 @@ void CVmObjVector::load_image_data(VMG_ const char *ptr, size_t siz)
     clear_undo_bits();
 }
 
+/*
+ *   Determine if we still match our image file data.  The allocated size
+ *   doesn't matter; we match if we have the same elements. 
+ */
+int CVmObjVector::matches_image_data(VMG_ const char *ptr, size_t siz) const
+{
+    size_t ele_cnt = vmb_get_len(ptr + VMB_LEN);
+    size_t i;
+
+    /* 
+     *   we must have the same number of elements, and the image data must
+     *   supply all of them (if it's short, don't bother checking) 
+     */
+    if (ele_cnt != get_element_count()
+        || siz < VMB_LEN*2 + (VMB_DATAHOLDER * ele_cnt))
+        return FALSE;
+
+    /* compare the elements */
+    for (i = 0, ptr += VMB_LEN*2 ; i < ele_cnt ; ++i, ptr += VMB_DATAHOLDER)
+    {
+        if (!vmb_dh_same(get_element_ptr(i), ptr))
+            return FALSE;
+    }
+
+    /* everything matches */
+    return TRUE;
+}
+
 /* ------------------------------------------------------------------------ */
 /* 
  *   index the vector
@@ -927,6 +956,7 @@ int CVmObjVector::set_index_val_q(VMG_ vm_val_t *new_container,
          *   expand the vector to make room for it 
          */
         set_element(idx - 1, new_val);
+        G_obj_table->note_ref_store(self, new_val);
     }
     else
     {
@@ -969,6 +999,7 @@ void CVmObjVector::set_element_undo(VMG_ vm_obj_id_t self,
 
     /* get the indexed element and store it in the result */
     set_element(idx, new_val);
+    G_obj_table->note_ref_store(self, new_val);
 }
 
 /* ------------------------------------------------------------------------ */
@@ -2523,7 +2554,10 @@ int CVmObjVector::getp_insert_at(VMG_ vm_obj_id_t self, vm_val_t *retval,
         if (idx < old_cnt)
             set_element_undo(vmg_ self, idx, &val);
         else
+        {
             set_element(idx, &val);
+            G_obj_table->note_ref_store(self, &val);
+        }
     }
 
     /* handled */
@@ -2552,6 +2586,7 @@ int CVmObjVector::getp_prepend(VMG_ vm_obj_id_t self, vm_val_t *retval,
      *   being created anew here) 
      */
     set_element(0, G_stk->get(0));
+    G_obj_table->note_ref_store(self, G_stk->get(0));
 
     /* the return value is 'self' */
     retval->set_obj(self);
@@ -2810,6 +2845,7 @@ int CVmObjVector::getp_append_all(VMG_ vm_obj_id_t self, vm_val_t *retval,
          *   element 
          */
         set_element(cnt + i - 1, &ele);
+        G_obj_table->note_ref_store(self, &ele);
     }
 
     /* discard the argument and gc protection */
@@ -2892,7 +2928,10 @@ int CVmObjVector::getp_splice(VMG_ vm_obj_id_t self, vm_val_t *retval,
         if (i < old_cnt)
             set_element_undo(vmg_ self, start_idx + i, ins);
         else
+        {
             set_element(start_idx + i, ins);
+            G_obj_table->note_ref_store(self, ins);
+        }
     }
 
     /* discard the arguments and gc protection */
@@ -2947,7 +2986,10 @@ void CVmObjVector::insert_elements_undo(VMG_ vm_obj_id_t self,
             if (new_idx < old_cnt)
                 set_element_undo(vmg_ self, new_idx, &ele);
             else
+            {
                 set_element(new_idx, &ele);
+                G_obj_table->note_ref_store(self, &ele);
+            }
         }
     }
 }
@@ -165,6 +165,12 @@ public:
      */
     void remove_stale_weak_refs(VMG0_) { }
 
+    /* 
+     *   we notify the object table of reference stores (other than while
+     *   constructing a new vector) 
+     */
+    int has_write_barrier() const { return TRUE; }
+
     /* rebuild for image file */
     virtual ulong rebuild_image(VMG_ char *buf, ulong buflen);
 
@@ -213,6 +219,9 @@ public:
      */
     int is_changed_since_load() const { return TRUE; }
 
+    /* check to see if we still match our image file data */
+    int matches_image_data(VMG_ const char *ptr, size_t siz) const;
+
     /* 
      *   get the allocated number of elements of the vector - this will be
      *   greater than or equal to get_element_count(), and reflects the